@@ -14,6 +14,9 @@
 #include "jsscope.h"
 #include "jsscript.h"
 
+#include "ion/IonCode.h"
+#include "ion/PSVersionCache.h"
+
 #include "jsobjinlines.h"
 
 #ifdef JS_THREADSAFE
@@ -175,6 +178,8 @@ StatsCellCallback(JSRuntime *rt, void *data, void *thing, JSGCTraceKind traceKin
 # ifdef JS_ION
         if (script->hasIonScript())
             cStats->mjitData += script->ion->size();
+        if (script->psVersions)
+            cStats->mjitData += script->psVersions->sizeOfIncludingThis(rtStats->mallocSizeOf);
 # endif
 #endif
         break;
@@ -13,6 +13,8 @@
 #include "Ion.h"
 #include "IonSpewer.h"
 
+#include "jsinferinlines.h"
+
 using namespace js;
 using namespace js::ion;
 
@@ -47,6 +49,214 @@ class AliasSetIterator
     }
 };
 
+// Returns the object whose fixed slots, slots or elements are accessed by a
+// load or a store, or NULL if it is not known.
+static MDefinition *
+AccessedObject(MDefinition *ins)
+{
+    MDefinition *vector;
+    switch (ins->op()) {
+      case MDefinition::Op_LoadFixedSlot:
+        return ins->toLoadFixedSlot()->object();
+      case MDefinition::Op_StoreFixedSlot:
+        return ins->toStoreFixedSlot()->object();
+      case MDefinition::Op_LoadSlot:
+        vector = ins->toLoadSlot()->slots();
+        return vector->isSlots() ? vector->toSlots()->object() : NULL;
+      case MDefinition::Op_StoreSlot:
+        vector = ins->toStoreSlot()->slots();
+        return vector->isSlots() ? vector->toSlots()->object() : NULL;
+      case MDefinition::Op_LoadElement:
+        vector = ins->toLoadElement()->elements();
+        break;
+      case MDefinition::Op_LoadElementHole:
+        vector = ins->toLoadElementHole()->elements();
+        break;
+      case MDefinition::Op_StoreElement:
+        vector = ins->toStoreElement()->elements();
+        break;
+      case MDefinition::Op_StoreElementHole:
+        vector = ins->toStoreElementHole()->elements();
+        break;
+      default:
+        return NULL;
+    }
+    return vector->isElements() ? vector->toElements()->object() : NULL;
+}
+
+// Finds the type objects an object may have: either a single one, for
+// constants and allocations, or those of the type set guarded by a type
+// barrier or by the argument checks. Returns false if they are not known.
+static bool
+GetObjectTypes(MDefinition *obj, types::TypeObjectKey **single, types::TypeSet **set)
+{
+    *single = NULL;
+    *set = NULL;
+
+    if (obj->isUnbox())
+        obj = obj->toUnbox()->input();
+
+    JSObject *templateObject = NULL;
+    switch (obj->op()) {
+      case MDefinition::Op_Constant:
+        if (!obj->toConstant()->value().isObject())
+            return false;
+        *single = types::Type::ObjectType(&obj->toConstant()->value().toObject()).objectKey();
+        return true;
+      case MDefinition::Op_NewObject:
+        templateObject = obj->toNewObject()->templateObject();
+        break;
+      case MDefinition::Op_NewArray:
+        templateObject = obj->toNewArray()->templateObject();
+        break;
+      case MDefinition::Op_TypeBarrier:
+        *set = obj->toTypeBarrier()->typeSet();
+        break;
+      case MDefinition::Op_Parameter:
+        *set = obj->toParameter()->typeSet();
+        break;
+      default:
+        return false;
+    }
+
+    // Singleton templates are cloned, so allocations only have a known type
+    // object when it is shared.
+    if (templateObject) {
+        if (templateObject->hasSingletonType())
+            return false;
+        *single = types::Type::ObjectType(templateObject).objectKey();
+        return true;
+    }
+
+    // Type sets keep changing on the main thread while compilations run off
+    // of it, without any context.
+    if (!GetIonContext()->cx)
+        return false;
+
+    return *set && !(*set)->unknownObject() && (*set)->getObjectCount() > 0;
+}
+
+static bool
+HasObjectType(types::TypeObjectKey *single, types::TypeSet *set, types::TypeObjectKey *key)
+{
+    if (single)
+        return single == key;
+    for (unsigned i = 0; i < set->getObjectCount(); i++) {
+        if (set->getObject(i) == key)
+            return true;
+    }
+    return false;
+}
+
+// Objects whose type objects differ are distinct, and so are their slots and
+// elements.
+static bool
+ObjectsMightAlias(MDefinition *lhs, MDefinition *rhs)
+{
+    if (!lhs || !rhs || lhs == rhs)
+        return true;
+
+    types::TypeObjectKey *lhsSingle, *rhsSingle;
+    types::TypeSet *lhsSet, *rhsSet;
+    if (!GetObjectTypes(lhs, &lhsSingle, &lhsSet) || !GetObjectTypes(rhs, &rhsSingle, &rhsSet))
+        return true;
+
+    if (lhsSingle)
+        return HasObjectType(rhsSingle, rhsSet, lhsSingle);
+    for (unsigned i = 0; i < lhsSet->getObjectCount(); i++) {
+        types::TypeObjectKey *key = lhsSet->getObject(i);
+        if (key && HasObjectType(rhsSingle, rhsSet, key))
+            return true;
+    }
+    return false;
+}
+
+static bool
+IndicesMightAlias(MDefinition *lhs, MDefinition *rhs)
+{
+    if (!lhs->isConstant() || !rhs->isConstant())
+        return true;
+    return lhs->toConstant()->value() == rhs->toConstant()->value();
+}
+
+// Refines the alias sets of a load and a store, which share a category: the
+// store may only change the value loaded if it writes the same kind of slot,
+// at the same index, of an object with the same type.
+bool
+ion::MightAlias(MDefinition *load, MDefinition *store)
+{
+    switch (load->op()) {
+      case MDefinition::Op_LoadFixedSlot:
+        // Fixed slots are stored inline, and never alias dynamic slots.
+        if (store->isStoreSlot())
+            return false;
+        if (!store->isStoreFixedSlot())
+            return true;
+        if (load->toLoadFixedSlot()->slot() != store->toStoreFixedSlot()->slot())
+            return false;
+        break;
+      case MDefinition::Op_LoadSlot:
+        if (store->isStoreFixedSlot())
+            return false;
+        if (!store->isStoreSlot())
+            return true;
+        if (load->toLoadSlot()->slot() != store->toStoreSlot()->slot())
+            return false;
+        break;
+      case MDefinition::Op_LoadElement:
+      case MDefinition::Op_LoadElementHole: {
+        MDefinition *index = load->isLoadElement()
+                             ? load->toLoadElement()->index()
+                             : load->toLoadElementHole()->index();
+        if (store->isStoreElement()) {
+            if (!IndicesMightAlias(index, store->toStoreElement()->index()))
+                return false;
+        } else if (store->isStoreElementHole()) {
+            if (!IndicesMightAlias(index, store->toStoreElementHole()->index()))
+                return false;
+        } else {
+            return true;
+        }
+        break;
+      }
+      case MDefinition::Op_LoadTypedArrayElement: {
+        // Typed arrays of different types may share their buffer, so only
+        // accesses of the same type at different indices are told apart.
+        if (!store->isStoreTypedArrayElement())
+            return true;
+        MLoadTypedArrayElement *ins = load->toLoadTypedArrayElement();
+        MStoreTypedArrayElement *other = store->toStoreTypedArrayElement();
+        return ins->arrayType() != other->arrayType() ||
+               IndicesMightAlias(ins->index(), other->index());
+      }
+      default:
+        return true;
+    }
+
+    return ObjectsMightAlias(AccessedObject(load), AccessedObject(store));
+}
+
+// Whether control may flow from the end of |src| to |dest|, without looking
+// past branches.
+static bool
+BlockMightReach(MBasicBlock *src, MBasicBlock *dest)
+{
+    while (src->id() <= dest->id()) {
+        if (src == dest)
+            return true;
+        switch (src->numSuccessors()) {
+          case 0:
+            return false;
+          case 1:
+            src = src->getSuccessor(0);
+            break;
+          default:
+            return true;
+        }
+    }
+    return false;
+}
+
 AliasAnalysis::AliasAnalysis(MIRGraph &graph)
   : graph_(graph),
     loop_(NULL)
@@ -67,15 +277,22 @@ AliasAnalysis::AliasAnalysis(MIRGraph &graph)
 //
 // The algorithm depends on the invariant that both control instructions and effectful
 // instructions (stores) are never hoisted.
+//
+// With alias refinement, all the stores seen so far are kept for each category,
+// and a load depends on the most recent one which may write the location it
+// reads, and may reach it. Loads which only differ from each other by stores
+// to other slots, indices or types of objects are then congruent, and GVN
+// forwards the value of a store to the loads which depend on it.
 bool
 AliasAnalysis::analyze()
 {
-    Vector<MDefinition *, 16, SystemAllocPolicy> stores;
+    MDefinitionVector stores[NUM_ALIAS_SETS];
+    bool refine = js_IonOptions.aliasRefinement;
 
     // Initialize to the first instruction.
     MDefinition *firstIns = *graph_.begin()->begin();
     for (unsigned i=0; i < NUM_ALIAS_SETS; i++) {
-        if (!stores.append(firstIns))
+        if (!stores[i].append(firstIns))
             return false;
     }
 
@@ -98,8 +315,10 @@ AliasAnalysis::analyze()
                 continue;
 
             if (set.isStore()) {
-                for (AliasSetIterator iter(set); iter; iter++)
-                    stores[*iter] = *def;
+                for (AliasSetIterator iter(set); iter; iter++) {
+                    if (!stores[*iter].append(*def))
+                        return false;
+                }
 
                 IonSpew(IonSpew_Alias, "Processing store %d (flags %x)", def->id(), set.flags());
 
@@ -110,9 +329,18 @@ AliasAnalysis::analyze()
                 MDefinition *lastStore = NULL;
 
                 for (AliasSetIterator iter(set); iter; iter++) {
-                    MDefinition *store = stores[*iter];
-                    if (!lastStore || lastStore->id() < store->id())
-                        lastStore = store;
+                    MDefinitionVector &aliasedStores = stores[*iter];
+                    for (size_t i = aliasedStores.length(); i > 0; i--) {
+                        MDefinition *store = aliasedStores[i - 1];
+                        if (refine && i > 1 &&
+                            !(MightAlias(*def, store) && BlockMightReach(store->block(), *block)))
+                        {
+                            continue;
+                        }
+                        if (!lastStore || lastStore->id() < store->id())
+                            lastStore = store;
+                        break;
+                    }
                 }
 
                 def->setDependency(lastStore);
@@ -139,13 +367,31 @@ AliasAnalysis::analyze()
                 outerLoop->addStore(loop_->loopStores());
 
             const InstructionVector &invariant = loop_->invariantLoads();
+            uint32 firstLoopId = loop_->firstInstruction()->id();
 
             for (unsigned i = 0; i < invariant.length(); i++) {
                 MDefinition *ins = invariant[i];
                 AliasSet set = ins->getAliasSet();
                 JS_ASSERT(set.isLoad());
 
-                if ((loop_->loopStores() & set).isNone()) {
+                bool hasAlias = !(loop_->loopStores() & set).isNone();
+                if (hasAlias && refine) {
+                    hasAlias = false;
+                    for (AliasSetIterator iter(set); iter && !hasAlias; iter++) {
+                        MDefinitionVector &aliasedStores = stores[*iter];
+                        for (size_t j = aliasedStores.length(); j > 0; j--) {
+                            MDefinition *store = aliasedStores[j - 1];
+                            if (store->id() < firstLoopId)
+                                break;
+                            if (MightAlias(ins, store)) {
+                                hasAlias = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                if (!hasAlias) {
                     IonSpew(IonSpew_Alias, "Load %d does not depend on any stores in this loop",
                             ins->id());
 
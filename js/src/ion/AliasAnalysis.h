@@ -63,6 +63,10 @@ class AliasAnalysis
     bool analyze();
 };
 
+// Whether a store may write the location read by a load whose alias set
+// shares a category with its own.
+bool MightAlias(MDefinition *load, MDefinition *store);
+
 } // namespace js
 } // namespace ion
 
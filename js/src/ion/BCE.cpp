@@ -13,7 +13,9 @@ using namespace js;
 using namespace js::ion;
 
 BCE::BCE(MIRGraph &graph)
-  : graph(graph)
+  : graph(graph),
+    indVars(graph),
+    unneededIds(NULL)
 {
 }
 
@@ -22,54 +24,18 @@ BCE::analyze()
 {
     IonSpew(IonSpew_BCE, "Beginning BCE pass.");
 
-    // Looks for all the unneed bounds checks in the graph.
-    for (MBasicBlockIterator blockIt(graph.begin()); blockIt != graph.end(); blockIt++) {
-        MBasicBlock *block = *blockIt;
-
-        InductionVariable indVar(block);
-
-        if (!indVar.extractPattern())
-            continue;
-
-        IonSpew(IonSpew_BCE, "Induction variable found! id = %d.", indVar.variable()->id());
-
-        // Looks for unneeded bounds checks among the uses of induction
-        // variable.
-        for (MUseIterator useIt = indVar.variable()->usesBegin(); useIt != indVar.variable()->usesEnd(); useIt++) {
-            MUse *use = *useIt;
-
-            if (!use->node()->isDefinition())
-                continue;
-
-            MDefinition *useNode = use->node()->toDefinition();
-
-            // Tries to eliminate the use.
-            if (tryElimination(&indVar, useNode))
-                continue;
-
-            // The use may be an integer specialization of a bounds check index.
-            if (useNode->isToInt32()) {
-                for (MUseIterator toInt32UseIt = useNode->usesBegin(); toInt32UseIt != useNode->usesEnd(); toInt32UseIt++) {
-                    MUse *toInt32Use = *toInt32UseIt;
-
-                    if (!(toInt32Use->node()->isDefinition()))
-                        continue;
-
-                    tryElimination(&indVar, toInt32Use->node()->toDefinition());
-                }
-            }
-
-            // The use may be an unbox of a bounds check index.
-            else if (useNode->isUnbox()) {
-                for (MUseIterator unboxUseIt = useNode->usesBegin(); unboxUseIt != useNode->usesEnd(); unboxUseIt++) {
-                    MUse *unboxUse = *unboxUseIt;
+    unneededIds = BitSet::New(graph.getMaxInstructionId());
+    if (!unneededIds)
+        return false;
 
-                    if (!unboxUse->node()->isDefinition())
-                        continue;
+    if (!indVars.analyze())
+        return false;
 
-                    tryElimination(&indVar, unboxUse->node()->toDefinition());
-                }
-            }
+    // Looks for all the unneeded bounds checks in the graph.
+    for (MBasicBlockIterator block(graph.begin()); block != graph.end(); block++) {
+        for (MInstructionIterator ins(block->begin()); ins != block->end(); ins++) {
+            if (!tryElimination(*ins))
+                return false;
         }
     }
 
@@ -79,144 +45,222 @@ BCE::analyze()
 }
 
 bool
-BCE::tryElimination(InductionVariable *indVar, MDefinition *def)
+BCE::tryElimination(MInstruction *ins)
 {
-    // The induction variable range must be valid in the definition block.
-    if (!indVar->rangeIsValid(def->block()))
-        return false;
+    bool unneeded;
+    if (ins->isBoundsCheck()) {
+        unneeded = eliminateBoundsCheck(ins->toBoundsCheck());
+        if (!unneeded && !hoistBoundsCheck(ins->toBoundsCheck(), &unneeded))
+            return false;
+    } else if (ins->isBoundsCheckLower()) {
+        unneeded = eliminateBoundsCheckLower(ins->toBoundsCheckLower());
+    } else {
+        return true;
+    }
 
-    if (def->isBoundsCheck()) {
-        MBoundsCheck *bCheck = def->toBoundsCheck();
+    if (!unneeded)
+        return true;
 
-        if ((bCheck->minimum() == 0) && (bCheck->maximum() == 0)) {
-            if (eliminateBoundsCheck(indVar, bCheck))
-                return true;
-        } else if (eliminateBoundsCheckRange(indVar, bCheck))
-            return true;
+    return markUnneeded(ins);
+}
 
-    } else if (def->isBoundsCheckLower()) {
-        if (eliminateBoundsCheckLower(indVar, def->toBoundsCheckLower()))
-            return true;
-    }
+bool
+BCE::markUnneeded(MInstruction *bCheck)
+{
+    if (unneededIds->contains(bCheck->id()))
+        return true;
 
-    return false;
+    unneededIds->insert(bCheck->id());
+    return unneededChecks.append(bCheck);
 }
 
 bool
-BCE::eliminateBoundsCheck(InductionVariable *indVar, MBoundsCheck *bCheck)
+BCE::eliminateBoundsCheck(MBoundsCheck *bCheck)
 {
-    JS_ASSERT((bCheck->minimum() == 0) && (bCheck->maximum() == 0));
-
-    if (!bCheck->length()->isInitializedLength())
+    MDefinition *index = bCheck->index();
+    if (!indVars.recurrence(index))
         return false;
 
-    if (!indVar->hasUpperBound())
+    // Negative indexes are caught by the bounds check as well, so the
+    // index must be known to stay non-negative.
+    Range range = indVars.rangeAt(index, bCheck->block());
+    if (range.isLowerInfinite() || int64_t(range.lower()) + bCheck->minimum() < 0)
         return false;
 
-    // If the length is known to be a constant, we can try to eliminate
-    // the bounds check in a easier way.
-    if (evaluateConstantLength(indVar->upperBound(), bCheck)) {
-        unneededChecks.insert(bCheck);
+    // The index may be compared to the same length in the loop.
+    if (bCheck->maximum() <= 0 && indVars.isLessThan(index, bCheck->block(), bCheck->length())) {
+        IonSpew(IonSpew_BCE, "Index %d is below the length of bounds check %d",
+                index->id(), bCheck->id());
         return true;
     }
 
-    // If the bounds check target is not a constant, we cannot retrieve the
-    // array initialized length.
-    if (!bCheck->length()->toInitializedLength()->elements()->toElements()->object()->isConstant())
+    if (range.isUpperInfinite())
         return false;
 
-    MConstant *object = bCheck->length()->toInitializedLength()->elements()->toElements()->object()->toConstant();
-
-    if (!object->value().isObject())
-        return false;
-
-    if (!object->value().toObject().isDenseArray())
+    // If index + maximum < length, the bounds check can be eliminated.
+    int32 length;
+    if (!constantLength(bCheck, &length))
         return false;
+    return int64_t(range.upper()) + bCheck->maximum() < length;
+}
 
-    // We need to guarantee that the array initialized length will not
-    // change during the scrip execution.
-    if (!bCheck->length()->isInitializedLength() || !hasUnchangeableLength(object))
+bool
+BCE::eliminateBoundsCheckLower(MBoundsCheckLower *bCheckLower)
+{
+    MDefinition *index = bCheckLower->index();
+    if (!indVars.recurrence(index))
         return false;
 
-    uint32_t initializedLength = object->value().toObject().getDenseArrayInitializedLength();
-
-    // If index < initialized_length, the bounds check can be eliminated.
-    if (indVar->upperBound() <= initializedLength) {
-        unneededChecks.insert(bCheck);
-        return true;
-    }
+    // If index >= minimum, the bounds check can be eliminated.
+    Range range = indVars.rangeAt(index, bCheckLower->block());
+    return !range.isLowerInfinite() && range.lower() >= bCheckLower->minimum();
+}
 
-    return false;
+static MBasicBlock *
+Preheader(MBasicBlock *header)
+{
+    if (header->getPredecessor(0) == header->backedge())
+        return header->getPredecessor(1);
+    return header->getPredecessor(0);
 }
 
 bool
-BCE::eliminateBoundsCheckRange(InductionVariable *indVar, MBoundsCheck *bCheck)
+BCE::hoistBoundsCheck(MBoundsCheck *bCheck, bool *hoisted)
 {
-    JS_ASSERT((bCheck->minimum() != 0) || (bCheck->maximum() != 0));
+    *hoisted = false;
 
-    // The induction variable must have a fixed range.
-    if (!indVar->hasLowerBound() || !indVar->hasUpperBound())
-        return false;
+    // Checks are not movable once a hoisted check failed in the script.
+    if (!bCheck->isMovable())
+        return true;
 
-    // If the bounds check target is not a constant, we cannot retrieve the
-    // array initialized length.
-    if (!bCheck->length()->toInitializedLength()->elements()->toElements()->object()->isConstant())
-        return false;
+    MDefinition *index = bCheck->index();
+    MBasicBlock *header = indVars.loopHeader(index);
+    if (!header)
+        return true;
+
+    // The check and the index must be in the loop, the length out of it.
+    MBasicBlock *backedge = header->backedge();
+    MBasicBlock *block = bCheck->block();
+    if (!header->dominates(block) || block->id() > backedge->id())
+        return true;
+    MBasicBlock *lengthBlock = bCheck->length()->block();
+    if (header->dominates(lengthBlock) && lengthBlock->id() <= backedge->id())
+        return true;
 
-    MConstant *object = bCheck->length()->toInitializedLength()->elements()->toElements()->object()->toConstant();
+    // The index is known to be within [first + firstOffset, last + lastOffset]
+    // wherever the check is made, where first and last are computed before
+    // the loop.
+    MDefinition *first, *last;
+    int32 firstOffset, lastOffset;
+    if (!indVars.symbolicBound(index, block, false, &first, &firstOffset) ||
+        !indVars.symbolicBound(index, block, true, &last, &lastOffset))
+    {
+        return true;
+    }
 
-    if (!object->value().isObject())
-        return false;
+    // first + firstOffset + minimum >= 0, and last + lastOffset + maximum
+    // < length.
+    int32 lowerBound, upperOffset;
+    if (!SafeAdd(firstOffset, bCheck->minimum(), &lowerBound) ||
+        !SafeSub(0, lowerBound, &lowerBound) ||
+        !SafeAdd(lastOffset, bCheck->maximum(), &upperOffset))
+    {
+        return true;
+    }
 
-    if (!object->value().toObject().isDenseArray())
-        return false;
+    // Sides which are already proven are not checked again.
+    Range range = indVars.rangeAt(index, block);
+    bool lowerProven = !range.isLowerInfinite() &&
+                       int64_t(range.lower()) + bCheck->minimum() >= 0;
 
-    // We need to guarantee that the array initialized length will not
-    // change during the scrip execution.
-    if (!hasUnchangeableLength(object))
+    MBasicBlock *preheader = Preheader(header);
+    if (!lowerProven && !addHoistedCheckLower(preheader, first, lowerBound))
+        return false;
+    if (!addHoistedCheck(preheader, last, bCheck->length(), upperOffset, upperOffset))
         return false;
 
-    uint32_t initializedLength = object->value().toObject().getDenseArrayInitializedLength();
+    IonSpew(IonSpew_BCE, "Bounds check %d hoisted to block %d", bCheck->id(), preheader->id());
+    *hoisted = true;
+    return true;
+}
 
-    // If index + minimum >= 0 and index + maximum < initialized_length, the bounds check can be eliminated.
-    if (((indVar->lowerBound() + bCheck->minimum()) >= 0) && ((indVar->upperBound() + bCheck->maximum()) <= initializedLength)) {
-        unneededChecks.insert(bCheck);
-        return true;
+bool
+BCE::addHoistedCheck(MBasicBlock *preheader, MDefinition *bound, MDefinition *length,
+                     int32 minimum, int32 maximum)
+{
+    // Checks of the same bound against the same length are merged.
+    for (size_t i = 0; i < hoistedChecks.length(); i++) {
+        if (!hoistedChecks[i]->isBoundsCheck())
+            continue;
+        MBoundsCheck *check = hoistedChecks[i]->toBoundsCheck();
+        if (check->block() == preheader && check->index() == bound && check->length() == length) {
+            check->setMinimum(Min(check->minimum(), minimum));
+            check->setMaximum(Max(check->maximum(), maximum));
+            return true;
+        }
     }
 
-    return false;
+    MBoundsCheck *check = MBoundsCheck::New(bound, length);
+    check->setMinimum(minimum);
+    check->setMaximum(maximum);
+    preheader->insertBefore(preheader->lastIns(), check);
+    return hoistedChecks.append(check);
 }
 
 bool
-BCE::eliminateBoundsCheckLower(InductionVariable *indVar, MBoundsCheckLower *bCheckLower)
+BCE::addHoistedCheckLower(MBasicBlock *preheader, MDefinition *bound, int32 minimum)
 {
-    if (!indVar->hasLowerBound())
-        return false;
-
-    // If index >= minimum, the bounds check can be eliminated.
-    if (indVar->lowerBound() >= bCheckLower->minimum()) {
-        unneededChecks.insert(bCheckLower);
-        return true;
+    for (size_t i = 0; i < hoistedChecks.length(); i++) {
+        if (!hoistedChecks[i]->isBoundsCheckLower())
+            continue;
+        MBoundsCheckLower *check = hoistedChecks[i]->toBoundsCheckLower();
+        if (check->block() == preheader && check->index() == bound) {
+            check->setMinimum(Max(check->minimum(), minimum));
+            return true;
+        }
     }
 
-    return false;
+    MBoundsCheckLower *check = MBoundsCheckLower::New(bound);
+    check->setMinimum(minimum);
+    preheader->insertBefore(preheader->lastIns(), check);
+    return hoistedChecks.append(check);
 }
 
-bool 
-BCE::evaluateConstantLength(int32 upperBound, MBoundsCheck *bCheck)
+bool
+BCE::constantLength(MBoundsCheck *bCheck, int32 *length)
 {
-    if (!bCheck->length()->isConstant())
+    MDefinition *def = bCheck->length();
+    if (def->isConstant()) {
+        if (!def->toConstant()->value().isInt32())
+            return false;
+        *length = def->toConstant()->value().toInt32();
+        return true;
+    }
+
+    // If the bounds check target is not a constant, we cannot retrieve the
+    // array initialized length.
+    if (!def->isInitializedLength())
+        return false;
+
+    MDefinition *elements = def->toInitializedLength()->elements();
+    if (!elements->isElements() || !elements->toElements()->object()->isConstant())
         return false;
 
-    MConstant *length = bCheck->length()->toConstant();
+    MConstant *object = elements->toElements()->object()->toConstant();
 
-    if (!length->value().isInt32())
+    if (!object->value().isObject())
         return false;
 
-    if (upperBound <= length->value().toInt32())
-        return true;
+    if (!object->value().toObject().isDenseArray())
+        return false;
 
-    return false;
+    // We need to guarantee that the array initialized length will not
+    // change during the scrip execution.
+    if (!hasUnchangeableLength(object))
+        return false;
+
+    *length = object->value().toObject().getDenseArrayInitializedLength();
+    return true;
 }
 
 bool
@@ -246,28 +290,15 @@ BCE::hasUnchangeableLength(MConstant *array)
 void
 BCE::eliminateUnneededChecks()
 {
-    while (!unneededChecks.empty()) {
-        // Gets a new element from the  list.
-        MInstruction *bCheck = *(unneededChecks.begin());
-
-        bool canDelete = true;
-        for (MUseIterator itUse = bCheck->usesBegin(); itUse != bCheck->usesEnd(); ) { // itUse++) {
-            MDefinition *useDef = itUse->node()->toDefinition();
-            if (useDef->isLoadElement()) {
-                itUse = itUse->node()->replaceOperand(itUse, bCheck->getOperand(0));
-            } else {
-                canDelete = false;
-                itUse++;
-            }
-        }
-
-        unneededChecks.erase(unneededChecks.begin());
-
-        if (!canDelete) 
-            continue;
+    for (size_t i = 0; i < unneededChecks.length(); i++) {
+        MInstruction *bCheck = unneededChecks[i];
 
-        bCheck->block()->discard(bCheck);
+        // A bounds check returns the index it checks, so its uses, whether
+        // they load or store elements of arrays or typed arrays, may use the
+        // index directly.
+        bCheck->replaceAllUsesWith(bCheck->getOperand(0));
 
         IonSpew(IonSpew_BCE, "Bounds check %d eliminated.", bCheck->id());
+        bCheck->block()->discard(bCheck);
     }
 }
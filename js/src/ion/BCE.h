@@ -6,8 +6,9 @@
 #ifndef jsion_bce_h__
 #define jsion_bce_h__
 
+#include "BitSet.h"
 #include "InductionVariable.h"
-#include <set>
+#include "IonAllocPolicy.h"
 
 // This file represents the Array Bounds Check Elimination optimization pass
 
@@ -29,31 +30,49 @@ class BCE
 
   private:
     MIRGraph &graph;
-    std::set<MInstruction*> unneededChecks; // List of bounds checks that can be eliminated.
+    InductionVariableAnalysis indVars;
 
-    // Verifies if the given definition is a known kind of bounds check. If so, tries
-    // to eliminate it based on the range of the given induction variable.
-    bool tryElimination(InductionVariable *indVar,  MDefinition *def);
+    // List of bounds checks that can be eliminated, and the set of their
+    // ids.
+    Vector<MInstruction *, 8, IonAllocPolicy> unneededChecks;
+    BitSet *unneededIds;
+
+    // Checks added to loop preheaders, in place of checks made in the loops.
+    Vector<MInstruction *, 8, IonAllocPolicy> hoistedChecks;
+
+    // Verifies if the given instruction is a known kind of bounds check
+    // whose index is an induction variable. If so, tries to eliminate it
+    // based on the range of the index. Returns false on OOM.
+    bool tryElimination(MInstruction *ins);
+
+    bool markUnneeded(MInstruction *bCheck);
 
     /**
-      * Given a specific kind of array bounds check and the induction variable
-      * used as its index, this set of functions try to eliminate the bounds
-      * check by proving that the index is always within the array limits and
-      * the array length is never changed inside the function.
+      * Given a specific kind of array bounds check, this set of functions try
+      * to eliminate the bounds check by proving that the index is always
+      * within the array limits.
       */
 
-    // Attempts to eliminate the basic kind of bounds check: index < length.
-    bool eliminateBoundsCheck(InductionVariable *indVar, MBoundsCheck *bCheck);
-
     // Attempts to eliminate a bounds check in a specifc range: index +
-    // minimum >= 0 and index + maximum < length.
-    bool eliminateBoundsCheckRange(InductionVariable *indVar, MBoundsCheck *bCheck);
+    // minimum >= 0 and index + maximum < length. The basic kind of bounds
+    // check has a minimum and a maximum of 0.
+    bool eliminateBoundsCheck(MBoundsCheck *bCheck);
 
     // Attempts to eliminate an lower bounds check: index >= minimum.
-    bool eliminateBoundsCheckLower(InductionVariable *indVar, MBoundsCheckLower *bCheckLower);
-
-
-    bool evaluateConstantLength(int32 upperBound, MBoundsCheck *bCheck);
+    bool eliminateBoundsCheckLower(MBoundsCheckLower *bCheckLower);
+
+    // Replaces a bounds check made in a loop by checks made once in the
+    // preheader of the loop, on the first and the last values the index
+    // may have. If they fail, the script bails out and is recompiled without
+    // hoisting bounds checks. Returns false on OOM.
+    bool hoistBoundsCheck(MBoundsCheck *bCheck, bool *hoisted);
+    bool addHoistedCheck(MBasicBlock *preheader, MDefinition *bound, MDefinition *length,
+                         int32 minimum, int32 maximum);
+    bool addHoistedCheckLower(MBasicBlock *preheader, MDefinition *bound, int32 minimum);
+
+    // Retrieves the length of the bounds check if it is a constant, or the
+    // initialized length of a constant dense array which does not change.
+    bool constantLength(MBoundsCheck *bCheck, int32 *length);
 
     // Verifies if the length of a dense array does not change during the
     // script execution.
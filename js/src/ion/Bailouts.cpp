@@ -13,9 +13,13 @@
 #include "Ion.h"
 #include "IonCompartment.h"
 #include "IonSpewer.h"
+#include "PSVersionCache.h"
+#include "VMFunctions.h"
+#include "gc/Marking.h"
 #include "jsinfer.h"
 #include "jsanalyze.h"
 #include "jsinferinlines.h"
+#include "jsobjinlines.h"
 #include "IonFrames-inl.h"
 
 using namespace js;
@@ -42,7 +46,8 @@ SnapshotIterator::SnapshotIterator(const IonBailoutIterator &iter)
                    iter.ionScript()->snapshots() + iter.ionScript()->snapshotsSize()),
     fp_(iter.jsFrame()),
     machine_(iter.machineState()),
-    ionScript_(iter.ionScript())
+    ionScript_(iter.ionScript()),
+    materialized_(NULL)
 {
 }
 
@@ -93,6 +98,120 @@ GetBailedJSScript(JSContext *cx)
     }
 }
 
+void
+MaterializedObjects::startObject(uint32 number, JSObject *templateObject)
+{
+    JS_ASSERT(!has(number));
+    if (number >= objects_.length() && !objects_.resize(number + 1)) {
+        oom_ = true;
+        return;
+    }
+
+    filling_ = number;
+    Object &object = objects_[number];
+    object.templateObject = templateObject;
+    object.firstField = fields_.length();
+    object.numFields = 0;
+}
+
+void
+MaterializedObjects::addField(const Value &v)
+{
+    if (oom_)
+        return;
+    if (!fields_.append(v)) {
+        oom_ = true;
+        return;
+    }
+    objects_[filling_].numFields++;
+}
+
+void
+MaterializedObjects::noteTarget(Value *vp)
+{
+    JS_ASSERT(vp->isMagic() && vp->whyMagic() == JS_ION_MATERIALIZE);
+
+    Target target = { lastRead_, vp };
+    if (!targets_.append(target))
+        oom_ = true;
+}
+
+JSObject *
+MaterializedObjects::create(JSContext *cx, const Object &object)
+{
+    RootedObject templateObject(cx, object.templateObject);
+    const Value *fields = fields_.begin() + object.firstField;
+
+    if (templateObject->isDenseArray()) {
+        types::TypeObject *type = templateObject->hasSingletonType() ? NULL : templateObject->type();
+        JSObject *obj = NewInitArray(cx, templateObject->getArrayLength(), type);
+        if (!obj)
+            return NULL;
+
+        obj->setDenseArrayInitializedLength(object.numFields);
+        for (uint32 i = 0; i < object.numFields; i++)
+            obj->initDenseArrayElement(i, fields[i]);
+        return obj;
+    }
+
+    JSObject *obj = NewInitObject(cx, templateObject);
+    if (!obj)
+        return NULL;
+
+    for (uint32 i = 0; i < object.numFields; i++)
+        obj->setSlot(i, fields[i]);
+    return obj;
+}
+
+bool
+MaterializedObjects::materialize(JSContext *cx)
+{
+    JS_ASSERT(!oom_);
+
+    for (uint32 number = 0; number < objects_.length(); number++) {
+        if (!has(number))
+            continue;
+
+        IonSpew(IonSpew_Bailouts, " materializing object %u", number);
+
+        // The fields stay traced until all the objects have been created,
+        // and each object is rooted by the frame slots it is stored in.
+        JSObject *obj = create(cx, objects_[number]);
+        if (!obj)
+            return false;
+
+        for (size_t i = 0; i < targets_.length(); i++) {
+            if (targets_[i].number == number)
+                targets_[i].vp->setObject(*obj);
+        }
+    }
+
+    objects_.clear();
+    fields_.clear();
+    targets_.clear();
+    return true;
+}
+
+void
+MaterializedObjects::trace(JSTracer *trc)
+{
+    for (size_t i = 0; i < objects_.length(); i++) {
+        if (objects_[i].templateObject)
+            gc::MarkObjectRoot(trc, &objects_[i].templateObject, "materialized-template");
+    }
+    gc::MarkValueRootRange(trc, fields_.length(), fields_.begin(), "materialized-fields");
+}
+
+// Reads the next value of the snapshot into |vp|, which is patched later if
+// it is an object to materialize.
+static inline void
+RestoreValue(SnapshotIterator &iter, Value *vp)
+{
+    *vp = iter.read();
+    if (vp->isMagic() && vp->whyMagic() == JS_ION_MATERIALIZE)
+        iter.materializedObjects()->noteTarget(vp);
+}
+
 void
 StackFrame::initFromBailout(JSContext *cx, SnapshotIterator &iter)
 {
@@ -104,7 +223,9 @@ StackFrame::initFromBailout(JSContext *cx, SnapshotIterator &iter)
     IonSpew(IonSpew_Bailouts, " expr stack slots %u, is function frame %u",
             exprStackSlots, isFunctionFrame());
 
-    if (iter.bailoutKind() == Bailout_ArgumentCheck) {
+    if (iter.bailoutKind() == Bailout_ArgumentCheck ||
+        iter.bailoutKind() == Bailout_ParameterCheck)
+    {
         // Temporary hack -- skip the (unused) scopeChain, because it could be
         // bogus (we can fail before the scope chain slot is set). Strip the
         // hasScopeChain flag and we'll check this later to run prologue().
@@ -129,8 +250,8 @@ StackFrame::initFromBailout(JSContext *cx, SnapshotIterator &iter)
         setPushedSPSFrame();
 
     if (isFunctionFrame()) {
-        Value thisv = iter.read();
-        formals()[-1] = thisv;
+        RestoreValue(iter, &formals()[-1]);
+        Value thisv = formals()[-1];
 
         // The new |this| must have already been constructed prior to an Ion
         // constructor running.
@@ -141,32 +262,25 @@ StackFrame::initFromBailout(JSContext *cx, SnapshotIterator &iter)
         IonSpew(IonSpew_Bailouts, " frame slots %u, nargs %u, nfixed %u",
                 iter.slots(), fun()->nargs, script()->nfixed);
 
-        for (uint32 i = 0; i < fun()->nargs; i++) {
-            Value arg = iter.read();
-            formals()[i] = arg;
-        }
+        for (uint32 i = 0; i < fun()->nargs; i++)
+            RestoreValue(iter, &formals()[i]);
     }
     exprStackSlots -= CountArgSlots(maybeFun());
 
-    for (uint32 i = 0; i < script()->nfixed; i++) {
-        Value slot = iter.read();
-        slots()[i] = slot;
-    }
+    for (uint32 i = 0; i < script()->nfixed; i++)
+        RestoreValue(iter, &slots()[i]);
 
     IonSpew(IonSpew_Bailouts, " pushing %u expression stack slots", exprStackSlots);
     FrameRegs &regs = cx->regs();
     for (uint32 i = 0; i < exprStackSlots; i++) {
-        Value v;
-
         // If coming from an invalidation bailout, and this is the topmost
         // value, and a value override has been specified, don't read from the
         // iterator. Otherwise, we risk using a garbage value.
         if (!iter.moreFrames() && i == exprStackSlots - 1 && cx->runtime->hasIonReturnOverride())
-            v = iter.skip();
+            *regs.sp = iter.skip();
         else
-            v = iter.read();
-
-        *regs.sp++ = v;
+            RestoreValue(iter, regs.sp);
+        regs.sp++;
     }
     unsigned pcOff = iter.pcOffset();
     regs.pc = script()->code + pcOff;
@@ -245,6 +359,7 @@ ConvertFrames(JSContext *cx, IonActivation *activation, IonBailoutIterator &it)
     if (!br)
         return BAILOUT_RETURN_FATAL_ERROR;
     activation->setBailout(br);
+    iter.setMaterializedObjects(br->materializedObjects());
 
     StackFrame *fp;
     if (it.isEntryJSFrame() && cx->fp()->runningInIon()) {
@@ -292,6 +407,9 @@ ConvertFrames(JSContext *cx, IonActivation *activation, IonBailoutIterator &it)
             return BAILOUT_RETURN_FATAL_ERROR;
     }
 
+    if (br->materializedObjects()->oom())
+        return BAILOUT_RETURN_FATAL_ERROR;
+
     jsbytecode *bailoutPc = fp->script()->code + iter.pcOffset();
     br->setBailoutPc(bailoutPc);
 
@@ -317,6 +435,13 @@ ConvertFrames(JSContext *cx, IonActivation *activation, IonBailoutIterator &it)
         fp->unsetPushedSPSFrame();
         Probes::enterScript(cx, fp->script(), fp->script()->function(), fp);
         return BAILOUT_RETURN_ARGUMENT_CHECK;
+
+      // Parameter checks are emitted right after the argument checks, so
+      // the same applies.
+      case Bailout_ParameterCheck:
+        fp->unsetPushedSPSFrame();
+        Probes::enterScript(cx, fp->script(), fp->script()->function(), fp);
+        return BAILOUT_RETURN_PARAMETER_CHECK;
     }
 
     JS_NOT_REACHED("bad bailout kind");
@@ -345,6 +470,21 @@ EnsureExitFrame(IonCommonFrameLayout *frame)
     frame->changePrevType(IonFrame_Bailed_JS);
 }
 
+// Count a bailout from the IonScript |it| comes from, and let the PS policy
+// of its script weigh it if it is the active specialized version.
+static void
+NoteBailout(IonBailoutIterator &it)
+{
+    SnapshotIterator iter(it);
+    IonScript *ion = it.ionScript();
+    ion->noteBailout(it.snapshotOffset(), iter.bailoutKind());
+
+    JSScript *script = it.script();
+    if (script->ion != ion || !script->isParameterSpecialized || !script->psVersions)
+        return;
+    script->psVersions->policy().noteBailout(script, ion, it.snapshotOffset(), iter.bailoutKind());
+}
+
 uint32
 ion::Bailout(BailoutStack *sp)
 {
@@ -361,6 +501,8 @@ ion::Bailout(BailoutStack *sp)
 
     IonSpew(IonSpew_Bailouts, "Took bailout! Snapshot offset: %d", iter.snapshotOffset());
 
+    NoteBailout(iter);
+
     uint32 retval = ConvertFrames(cx, activation, iter);
 
     EnsureExitFrame(iter.jsFrame());
@@ -460,6 +602,10 @@ ion::ReflowTypeInfo(uint32 bailoutResult)
 
     IonSpew(IonSpew_Bailouts, "reflowing type info");
 
+    // The values reflowed may be objects which still have to be allocated.
+    if (!activation->bailout()->materializedObjects()->materialize(cx))
+        return false;
+
     if (bailoutResult == BAILOUT_RETURN_ARGUMENT_CHECK) {
         IonSpew(IonSpew_Bailouts, "reflowing type info at argument-checked entry");
         ReflowArgTypes(cx);
@@ -553,12 +699,46 @@ ion::ForceInvalidation()
     return Invalidate(cx, script);
 }
 
+uint32
+ion::ParameterCheckFailure()
+{
+    JSContext *cx = GetIonContext()->cx;
+    JSScript *script = GetBailedJSScript(cx);
+    StackFrame *fp = cx->fp();
+
+    IonSpew(IonSpew_Bailouts, "Parameter check failure %s:%d", script->filename,
+            script->lineno);
+
+    // The version has been entered with other arguments than the ones it was
+    // specialized to, most likely from a direct call in Ion code, which the
+    // argument profile has not seen. Throw it away so that callers go through
+    // the version dispatch again.
+    script->profileArguments(fp);
+    if (script->psVersions)
+        script->psVersions->clearActive();
+
+    if (!script->hasIonScript())
+        return true;
+
+    IonSpew(IonSpew_Invalidate, "Invalidating due to parameter check failure");
+
+    return Invalidate(cx, script, /* resetUses */ false);
+}
+
 uint32
 ion::ThunkToInterpreter(Value *vp)
 {
     JSContext *cx = GetIonContext()->cx;
     IonActivation *activation = cx->runtime->ionActivation;
-    BailoutClosure *br = activation->takeBailout();
+    BailoutClosure *br = activation->bailout();
+
+    // Allocate the objects removed by escape analysis while the closure is
+    // still traced by the activation.
+    if (!br->materializedObjects()->materialize(cx)) {
+        cx->delete_(activation->takeBailout());
+        return Interpret_Error;
+    }
+    activation->takeBailout();
 
     if (!EnsureHasCallObject(cx, cx->fp()))
         return Interpret_Error;
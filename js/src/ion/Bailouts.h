@@ -107,6 +107,71 @@ static const uint32 BAILOUT_RETURN_MONITOR = 4;
 static const uint32 BAILOUT_RETURN_RECOMPILE_CHECK = 5;
 static const uint32 BAILOUT_RETURN_BOUNDS_CHECK = 6;
 static const uint32 BAILOUT_RETURN_INVALIDATE = 7;
+static const uint32 BAILOUT_RETURN_PARAMETER_CHECK = 8;
+
+// Objects which escape analysis removed from the code, and which have to exist
+// again in the interpreter frames. Nothing can be allocated while the frames
+// are converted, so they are gathered from the snapshot then, and the slots
+// holding them are given a placeholder. materialize() allocates them and
+// patches the slots before the interpreter runs.
+class MaterializedObjects
+{
+    struct Object {
+        JSObject *templateObject;
+        uint32 firstField;
+        uint32 numFields;
+    };
+    struct Target {
+        uint32 number;
+        Value *vp;
+    };
+
+    js::Vector<Object, 2, SystemAllocPolicy> objects_;
+    js::Vector<Value, 8, SystemAllocPolicy> fields_;
+    js::Vector<Target, 4, SystemAllocPolicy> targets_;
+
+    // Number of the object whose fields are being added, and of the object
+    // given by the last call to placeholder().
+    uint32 filling_;
+    uint32 lastRead_;
+    bool oom_;
+
+    JSObject *create(JSContext *cx, const Object &object);
+
+  public:
+    MaterializedObjects()
+      : filling_(0),
+        lastRead_(0),
+        oom_(false)
+    { }
+
+    bool has(uint32 number) const {
+        return number < objects_.length() && objects_[number].templateObject;
+    }
+
+    // Fields are added in order after their object has been started.
+    void startObject(uint32 number, JSObject *templateObject);
+    void addField(const Value &v);
+
+    Value placeholder(uint32 number) {
+        JS_ASSERT(has(number));
+        lastRead_ = number;
+        return MagicValue(JS_ION_MATERIALIZE);
+    }
+
+    // Records that |vp| holds the placeholder which has been read last.
+    void noteTarget(Value *vp);
+
+    bool oom() const {
+        return oom_;
+    }
+    bool empty() const {
+        return targets_.empty();
+    }
+
+    bool materialize(JSContext *cx);
+    void trace(JSTracer *trc);
+};
 
 // Attached to the compartment for easy passing through from ::Bailout to
 // ::ThunkToInterpreter.
@@ -125,6 +190,7 @@ class BailoutClosure
 
     StackFrame *entryfp_;
     jsbytecode *bailoutPc_;
+    MaterializedObjects materializedObjects_;
 
   public:
     BailoutClosure()
@@ -157,6 +223,14 @@ class BailoutClosure
     jsbytecode *bailoutPc() const {
         return bailoutPc_;
     }
+
+    MaterializedObjects *materializedObjects() {
+        return &materializedObjects_;
+    }
+
+    void trace(JSTracer *trc) {
+        materializedObjects_.trace(trc);
+    }
 };
 
 class IonCompartment;
@@ -222,6 +296,8 @@ uint32 BoundsCheckFailure();
 
 uint32 ForceInvalidation();
 
+uint32 ParameterCheckFailure();
+
 } // namespace ion
 } // namespace js
 
@@ -455,6 +455,16 @@ CodeGenerator::visitTypeBarrier(LTypeBarrier *lir)
     return true;
 }
 
+bool
+CodeGenerator::visitGuardValue(LGuardValue *lir)
+{
+    ValueOperand operand = ToValue(lir, LGuardValue::Input);
+
+    Label mismatched;
+    masm.branchTestValue(Assembler::NotEqual, operand, lir->mir()->value(), &mismatched);
+    return bailoutFrom(&mismatched, lir->snapshot());
+}
+
 bool
 CodeGenerator::visitMonitorTypes(LMonitorTypes *lir)
 {
@@ -551,6 +561,60 @@ CodeGenerator::visitCallNative(LCallNative *call)
     return true;
 }
 
+// Stub miss path of a call cache. Once a stub is attached for the callee, it is
+// called by the generic path, so the call itself never goes through the VM.
+class OutOfLineCallCache : public OutOfLineCodeBase<CodeGenerator>
+{
+    LCallGeneric *call_;
+    RepatchLabel repatchEntry_;
+    CodeOffsetJump inlineJump;
+    CodeOffsetLabel inlineLabel;
+    CodeOffsetLabel fallbackLabel;
+    Label generic_;
+
+  public:
+    OutOfLineCallCache(LCallGeneric *call)
+      : call_(call)
+    {}
+
+    void setInlineJump(CodeOffsetJump jump, CodeOffsetLabel label) {
+        inlineJump = jump;
+        inlineLabel = label;
+    }
+    CodeOffsetJump getInlineJump() const {
+        return inlineJump;
+    }
+    CodeOffsetLabel getInlineLabel() const {
+        return inlineLabel;
+    }
+
+    // Start of the generic path, where stubs send the callees they cannot
+    // call directly.
+    void setFallbackLabel(CodeOffsetLabel label) {
+        fallbackLabel = label;
+    }
+    CodeOffsetLabel getFallbackLabel() const {
+        return fallbackLabel;
+    }
+    Label *generic() {
+        return &generic_;
+    }
+
+    bool accept(CodeGenerator *codegen) {
+        return codegen->visitOutOfLineCallCache(this);
+    }
+
+    LCallGeneric *call() const {
+        return call_;
+    }
+    void bind(MacroAssembler *masm) {
+        masm->bind(&repatchEntry_);
+    }
+    RepatchLabel *repatchEntry() {
+        return &repatchEntry_;
+    }
+};
+
 bool
 CodeGenerator::emitCallInvokeFunction(LCallGeneric *call, uint32 unusedStack)
 {
@@ -621,26 +685,41 @@ CodeGenerator::visitCallGeneric(LCallGeneric *call)
     }
 
     Label end, invoke;
+    OutOfLineCallCache *ool = NULL;
+    uint32 framePushed = masm.framePushed();
 
-    // Guard that calleereg is a non-native function:
-    // Non-native iff (callee->flags & JSFUN_KINDMASK >= JSFUN_INTERPRETED).
-    // This is equivalent to testing if any of the bits in JSFUN_KINDMASK are set.
-    if (!call->hasSingleTarget()) {
-        Address flags(calleereg, offsetof(JSFunction, flags));
-        masm.load16ZeroExtend_mask(flags, Imm32(JSFUN_INTERPRETED), nargsreg);
-        masm.branch32(Assembler::NotEqual, nargsreg, Imm32(JSFUN_INTERPRETED), &invoke);
-    } else {
+    if (call->hasSingleTarget()) {
         // Native single targets are handled by LCallNative.
         JS_ASSERT(!call->getSingleTarget()->isNative());
-    }
 
+        // Missing arguments must have been explicitly appended by the IonBuilder.
+        JS_ASSERT(call->getSingleTarget()->nargs <= call->numStackArgs());
 
-    // Knowing that calleereg is a non-native function, load the JSScript.
-    masm.movePtr(Address(calleereg, offsetof(JSFunction, u.i.script_)), objreg);
-    masm.movePtr(Address(objreg, offsetof(JSScript, ion)), objreg);
+        // Knowing that calleereg is a non-native function, load the JSScript.
+        masm.movePtr(Address(calleereg, offsetof(JSFunction, u.i.script_)), objreg);
+        masm.movePtr(Address(objreg, offsetof(JSScript, ion)), objreg);
 
-    // Guard that the IonScript has been compiled.
-    masm.branchPtr(Assembler::BelowOrEqual, objreg, ImmWord(ION_COMPILING_SCRIPT), &invoke);
+        // Guard that the IonScript has been compiled.
+        masm.branchPtr(Assembler::BelowOrEqual, objreg, ImmWord(ION_COMPILING_SCRIPT), &invoke);
+
+        // Load the start of the target IonCode.
+        masm.movePtr(Address(objreg, offsetof(IonScript, method_)), objreg);
+        masm.movePtr(Address(objreg, IonCode::OffsetOfCode()), objreg);
+    } else {
+        // Polymorphic call sites go through a cache whose stubs load the Ion
+        // code of the callees seen so far into objreg. Other callees are
+        // handled by the generic path below.
+        ool = new OutOfLineCallCache(call);
+        if (!addOutOfLineCode(ool))
+            return false;
+
+        CodeOffsetJump jump = masm.jumpWithPatch(ool->repatchEntry());
+        CodeOffsetLabel label = masm.labelForPatch();
+        ool->setInlineJump(jump, label);
+    }
+
+    Label ionCall, afterCall;
+    masm.bind(&ionCall);
 
     // Nestle %esp up to the argument vector.
     masm.freeStack(unusedStack);
@@ -651,31 +730,57 @@ CodeGenerator::visitCallGeneric(LCallGeneric *call)
     masm.Push(calleereg);
     masm.Push(Imm32(descriptor));
 
-    Label thunk, rejoin;
+    // Finally call the function in objreg.
+    masm.callIon(objreg);
+    if (!markSafepoint(call))
+        return false;
+
+    masm.bind(&afterCall);
+
+    // Increment to remove IonFramePrefix; decrement to fill FrameSizeClass.
+    // The return address has already been removed from the Ion frame.
+    int prefixGarbage = sizeof(IonJSFrameLayout) - sizeof(void *);
+    masm.adjustStack(prefixGarbage - unusedStack);
+
+    masm.jump(&end);
+
+    if (ool) {
+        // Generic path, for callees without a stub.
+        masm.setFramePushed(framePushed);
+        ool->setFallbackLabel(masm.labelForPatch());
+        masm.bind(ool->generic());
+
+        // Guard that calleereg is a non-native function:
+        // Non-native iff (callee->flags & JSFUN_KINDMASK >= JSFUN_INTERPRETED).
+        // This is equivalent to testing if any of the bits in JSFUN_KINDMASK are set.
+        Address flags(calleereg, offsetof(JSFunction, flags));
+        masm.load16ZeroExtend_mask(flags, Imm32(JSFUN_INTERPRETED), nargsreg);
+        masm.branch32(Assembler::NotEqual, nargsreg, Imm32(JSFUN_INTERPRETED), &invoke);
+
+        // Knowing that calleereg is a non-native function, load the JSScript.
+        masm.movePtr(Address(calleereg, offsetof(JSFunction, u.i.script_)), objreg);
+        masm.movePtr(Address(objreg, offsetof(JSScript, ion)), objreg);
+
+        // Guard that the IonScript has been compiled.
+        masm.branchPtr(Assembler::BelowOrEqual, objreg, ImmWord(ION_COMPILING_SCRIPT), &invoke);
 
-    if (call->hasSingleTarget()) {
-        // Missing arguments must have been explicitly appended by the IonBuilder.
-        JS_ASSERT(call->getSingleTarget()->nargs <= call->numStackArgs());
-    } else {
         // Check whether the provided arguments satisfy target argc.
+        Label thunk;
         masm.load16ZeroExtend(Address(calleereg, offsetof(JSFunction, nargs)), nargsreg);
         masm.cmp32(nargsreg, Imm32(call->numStackArgs()));
         masm.j(Assembler::Above, &thunk);
-    }
 
-    // No argument fixup needed. Load the start of the target IonCode.
-    {
+        // No argument fixup needed. Load the start of the target IonCode.
         masm.movePtr(Address(objreg, offsetof(IonScript, method_)), objreg);
         masm.movePtr(Address(objreg, IonCode::OffsetOfCode()), objreg);
-    }
-
-    Label afterCall;
+        masm.jump(&ionCall);
 
-    // Argument fixup needed. Get ready to call the argumentsRectifier.
-    if (!call->hasSingleTarget()) {
-        // Skip this thunk unless an explicit jump target.
-        masm.jump(&rejoin);
+        // Argument fixup needed. Call the argumentsRectifier.
         masm.bind(&thunk);
+        masm.freeStack(unusedStack);
+        masm.Push(Imm32(call->numActualArgs()));
+        masm.Push(calleereg);
+        masm.Push(Imm32(descriptor));
 
         // Hardcode the address of the argumentsRectifier code.
         IonCompartment *ion = gen->ionCompartment();
@@ -688,27 +793,14 @@ CodeGenerator::visitCallGeneric(LCallGeneric *call)
         masm.call(argumentsRectifier);
         if (!markSafepoint(call))
             return false;
-        masm.jump(&afterCall);
-    }
-
-    masm.bind(&rejoin);
-
-    // Finally call the function in objreg.
-    masm.callIon(objreg);
-    if (!markSafepoint(call))
-        return false;
-
-    masm.bind(&afterCall);
-
-    // Increment to remove IonFramePrefix; decrement to fill FrameSizeClass.
-    // The return address has already been removed from the Ion frame.
-    int prefixGarbage = sizeof(IonJSFrameLayout) - sizeof(void *);
-    masm.adjustStack(prefixGarbage - unusedStack);
 
-    masm.jump(&end);
+        masm.adjustStack(prefixGarbage - unusedStack);
+        masm.jump(&end);
+    }
 
     // Handle uncompiled or native functions.
     masm.bind(&invoke);
+    masm.setFramePushed(framePushed);
     if (!emitCallInvokeFunction(call, unusedStack))
         return false;
 
@@ -2624,9 +2716,8 @@ CodeGenerator::generate()
     // Before generating any code, we generate type checks for all parameters.
     // This comes before deoptTable_, because we can't use deopt tables without
     // creating the actual frame.
-    if(!js_IonOptions.ps)
-        if (!generateArgumentsChecks())
-            return false;
+    if (!generateArgumentsChecks())
+        return false;
 
     if (frameClass_ != FrameSizeClass::None()) {
         deoptTable_ = cx->compartment->ionCompartment()->getBailoutTable(cx, frameClass_);
@@ -2909,6 +3000,8 @@ class OutOfLineCache : public OutOfLineCodeBase<CodeGenerator>
             return codegen->visitOutOfLineCacheGetProperty(this);
           case LInstruction::LOp_GetElementCacheV:
             return codegen->visitOutOfLineGetElementCache(this);
+          case LInstruction::LOp_SetElementCacheV:
+            return codegen->visitOutOfLineSetElementCache(this);
           case LInstruction::LOp_SetPropertyCacheT:
           case LInstruction::LOp_SetPropertyCacheV:
             return codegen->visitOutOfLineSetPropertyCache(this);
@@ -3089,6 +3182,75 @@ CodeGenerator::visitOutOfLineGetElementCache(OutOfLineCache *ool)
     return true;
 }
 
+bool
+CodeGenerator::visitOutOfLineSetElementCache(OutOfLineCache *ool)
+{
+    LSetElementCacheV *ins = ool->cache()->toSetElementCacheV();
+    const MSetElementCache *mir = ins->mir();
+
+    Register obj = ToRegister(ins->object());
+    ValueOperand index = ToValue(ins, LSetElementCacheV::Index);
+    ValueOperand value = ToValue(ins, LSetElementCacheV::Value);
+
+    RegisterSet liveRegs = ins->safepoint()->liveRegs();
+
+    IonCacheSetElement cache(ool->getInlineJump(), ool->getInlineLabel(),
+                             masm.labelForPatch(), liveRegs,
+                             obj, index, value,
+                             ToRegister(ins->temp()), ToFloatRegister(ins->tempFloat()),
+                             mir->strict());
+
+    cache.setScriptedLocation(mir->block()->info().script(), mir->resumePoint()->pc());
+    size_t cacheIndex = allocateCache(cache);
+
+    saveLive(ins);
+
+    typedef bool (*pf)(JSContext *, size_t, HandleObject, HandleValue, HandleValue);
+    static const VMFunction Info = FunctionInfo<pf>(SetElementCache);
+
+    pushArg(value);
+    pushArg(index);
+    pushArg(obj);
+    pushArg(Imm32(cacheIndex));
+    if (!callVM(Info, ins))
+        return false;
+
+    restoreLive(ins);
+
+    masm.jump(ool->rejoin());
+    return true;
+}
+
+bool
+CodeGenerator::visitOutOfLineCallCache(OutOfLineCallCache *ool)
+{
+    LCallGeneric *call = ool->call();
+    Register calleereg = ToRegister(call->getFunction());
+
+    IonCacheCall cache(ool->getInlineJump(), ool->getInlineLabel(),
+                       masm.labelForPatch(), ool->getFallbackLabel(),
+                       calleereg, ToRegister(call->getTempObject()),
+                       call->numStackArgs());
+
+    size_t cacheIndex = allocateCache(cache);
+
+    typedef bool (*pf)(JSContext *, size_t, HandleFunction);
+    static const VMFunction Info = FunctionInfo<pf>(CallCache);
+
+    // The cache function only attaches a stub, the callee is needed after it.
+    masm.Push(calleereg);
+
+    pushArg(calleereg);
+    pushArg(Imm32(cacheIndex));
+    if (!callVM(Info, call))
+        return false;
+
+    masm.Pop(calleereg);
+
+    masm.jump(ool->generic());
+    return true;
+}
+
 bool
 CodeGenerator::visitOutOfLineBindNameCache(OutOfLineCache *ool)
 {
@@ -26,6 +26,7 @@ class OutOfLineNewObject;
 class CheckOverRecursedFailure;
 class OutOfLineUnboxDouble;
 class OutOfLineCache;
+class OutOfLineCallCache;
 class OutOfLineStoreElementHole;
 class OutOfLineTypeOfV;
 class OutOfLineLoadTypedArray;
@@ -68,6 +69,7 @@ class CodeGenerator : public CodeGeneratorSpecific
     bool visitStoreSlotV(LStoreSlotV *store);
     bool visitElements(LElements *lir);
     bool visitTypeBarrier(LTypeBarrier *lir);
+    bool visitGuardValue(LGuardValue *lir);
     bool visitMonitorTypes(LMonitorTypes *lir);
     bool visitCallNative(LCallNative *call);
     bool emitCallInvokeFunction(LCallGeneric *call, uint32 unusedStack);
@@ -172,9 +174,11 @@ class CodeGenerator : public CodeGeneratorSpecific
 
     bool visitOutOfLineCacheGetProperty(OutOfLineCache *ool);
     bool visitOutOfLineGetElementCache(OutOfLineCache *ool);
+    bool visitOutOfLineSetElementCache(OutOfLineCache *ool);
     bool visitOutOfLineSetPropertyCache(OutOfLineCache *ool);
     bool visitOutOfLineBindNameCache(OutOfLineCache *ool);
     bool visitOutOfLineGetNameCache(OutOfLineCache *ool);
+    bool visitOutOfLineCallCache(OutOfLineCallCache *ool);
 
     bool visitGetPropertyCacheV(LGetPropertyCacheV *ins) {
         return visitCache(ins);
@@ -185,6 +189,9 @@ class CodeGenerator : public CodeGeneratorSpecific
     bool visitGetElementCacheV(LGetElementCacheV *ins) {
         return visitCache(ins);
     }
+    bool visitSetElementCacheV(LSetElementCacheV *ins) {
+        return visitCache(ins);
+    }
     bool visitBindNameCache(LBindNameCache *ins) {
         return visitCache(ins);
     }
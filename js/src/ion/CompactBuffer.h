@@ -88,6 +88,13 @@ class CompactBufferReader
         JS_ASSERT(buffer_ <= end_);
         return buffer_ < end_;
     }
+
+    const uint8 *currentPosition() const {
+        return buffer_;
+    }
+    const uint8 *end() const {
+        return end_;
+    }
 };
 
 class CompactBufferWriter
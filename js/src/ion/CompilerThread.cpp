@@ -0,0 +1,178 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifdef JS_THREADSAFE
+
+#include "CompilerThread.h"
+#include "IonBuilder.h"
+#include "IonSpewer.h"
+
+#include "jsinferinlines.h"
+
+using namespace js;
+using namespace js::ion;
+
+OffThreadCompilation::OffThreadCompilation(JSScript *script)
+  : script(script),
+    roots(NULL),
+    alloc(JSRuntime::TEMP_LIFO_ALLOC_PRIMARY_CHUNK_SIZE),
+    temp(&alloc),
+    graph(&temp),
+    builder(NULL),
+    lir(graph),
+    specialized(false),
+    succeeded(false)
+{
+    recompileInfo.outputIndex = types::RecompileInfo::NoCompilerRunning;
+    versionKey.clear();
+}
+
+OffThreadCompilation::~OffThreadCompilation()
+{
+    Foreground::delete_(builder);
+    versionKey.release();
+
+    types::TypeCompartment &types = script->compartment()->types;
+    if (recompileInfo.outputIndex != types::RecompileInfo::NoCompilerRunning &&
+        types.constrainedOutputs)
+    {
+        (*types.constrainedOutputs)[recompileInfo.outputIndex].pendingCompile = false;
+    }
+    script->ionCompilingOffThread = false;
+}
+
+void
+CompilerThread::compilerThread(void *arg)
+{
+    PR_SetCurrentThreadName("JS Ion Compiler Thread");
+    static_cast<CompilerThread *>(arg)->threadLoop();
+}
+
+bool
+CompilerThread::init()
+{
+    JS_ASSERT(!thread);
+    lock = PR_NewLock();
+    if (!lock)
+        return false;
+    wakeup = PR_NewCondVar(lock);
+    if (!wakeup)
+        return false;
+    done = PR_NewCondVar(lock);
+    if (!done)
+        return false;
+    thread = PR_CreateThread(PR_USER_THREAD, compilerThread, this, PR_PRIORITY_NORMAL,
+                             PR_GLOBAL_THREAD, PR_JOINABLE_THREAD, 0);
+    if (!thread)
+        return false;
+    return true;
+}
+
+void
+CompilerThread::finish()
+{
+    if (thread) {
+        cancelAll();
+        PR_Lock(lock);
+        shutdown = true;
+        PR_NotifyCondVar(wakeup);
+        PR_Unlock(lock);
+        PR_JoinThread(thread);
+    }
+    if (wakeup)
+        PR_DestroyCondVar(wakeup);
+    if (done)
+        PR_DestroyCondVar(done);
+    if (lock)
+        PR_DestroyLock(lock);
+}
+
+void
+CompilerThread::threadLoop()
+{
+    PR_Lock(lock);
+    while (true) {
+        if (shutdown) {
+            PR_Unlock(lock);
+            return;
+        }
+        if (worklist.empty()) {
+            PR_WaitCondVar(wakeup, PR_INTERVAL_NO_TIMEOUT);
+            continue;
+        }
+
+        current = worklist[0];
+        worklist.erase(worklist.begin());
+        PR_Unlock(lock);
+
+        current->succeeded = CompileOffThread(current);
+
+        // The compilation is linked or thrown away on the main thread, and
+        // room has been made for it by submit().
+        PR_Lock(lock);
+        finished.infallibleAppend(current);
+        current = NULL;
+        PR_NotifyCondVar(done);
+        rt->triggerOperationCallback();
+    }
+}
+
+bool
+CompilerThread::submit(OffThreadCompilation *compilation)
+{
+    PR_Lock(lock);
+    size_t pending = worklist.length() + finished.length() + (current ? 1 : 0);
+    bool ok = finished.reserve(pending + 1) && worklist.append(compilation);
+    if (ok)
+        PR_NotifyCondVar(wakeup);
+    PR_Unlock(lock);
+    return ok;
+}
+
+OffThreadCompilation *
+CompilerThread::takeFinished()
+{
+    PR_Lock(lock);
+    OffThreadCompilation *compilation = NULL;
+    if (!finished.empty()) {
+        compilation = finished.back();
+        finished.popBack();
+    }
+    PR_Unlock(lock);
+    return compilation;
+}
+
+static void
+Cancel(OffThreadCompilation *compilation)
+{
+    IonSpew(IonSpew_OffThread, "Cancelled compilation of %s:%d",
+            compilation->script->filename, compilation->script->lineno);
+    Foreground::delete_(compilation);
+}
+
+void
+CompilerThread::cancelAll()
+{
+    // Compilations are destroyed with the lock held: once the worklist is
+    // empty and no compilation is running, the compiler thread waits for the
+    // main thread to give it more work. The compilation running stops at the
+    // end of its current pass.
+    PR_Lock(lock);
+    if (current)
+        current->builder->cancel();
+    while (current)
+        PR_WaitCondVar(done, PR_INTERVAL_NO_TIMEOUT);
+    for (size_t i = 0; i < worklist.length(); i++)
+        Cancel(worklist[i]);
+    worklist.clear();
+    for (size_t i = 0; i < finished.length(); i++)
+        Cancel(finished[i]);
+    finished.clear();
+    PR_Unlock(lock);
+}
+
+#endif // JS_THREADSAFE
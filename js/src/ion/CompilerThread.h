@@ -0,0 +1,141 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef jsion_compiler_thread_h__
+#define jsion_compiler_thread_h__
+
+#ifdef JS_THREADSAFE
+
+#include "jsinfer.h"
+#include "prlock.h"
+#include "prcvar.h"
+#include "prthread.h"
+
+#include "ds/LifoAlloc.h"
+#include "IonAllocPolicy.h"
+#include "LIR.h"
+#include "MIRGraph.h"
+#include "PSVersionCache.h"
+#include "TypeOracle.h"
+
+namespace js {
+namespace ion {
+
+class IonBuilder;
+
+// A compilation whose MIR has been built on the main thread. The compiler
+// thread optimizes it, lowers it and allocates its registers, and the main
+// thread then generates its code and links it at the next operation callback.
+//
+// Everything the compilation allocates lives in its own LifoAlloc, as the
+// temporary allocator of the context may be used by the main thread while it
+// runs.
+struct OffThreadCompilation
+{
+    JSScript *script;
+
+    // Output of the compilation in the type constraints of its compartment.
+    // Its pendingCompile flag is cleared by the constraints the compilation
+    // depends on, which then has to be thrown away.
+    types::RecompileInfo recompileInfo;
+
+    // The GC things rooted while building the MIR, rooted again while the
+    // code is generated. No GC happens in between: every GC throws pending
+    // compilations away.
+    JS::CompilerRootNode *roots;
+
+    LifoAlloc alloc;
+    TempAllocator temp;
+    MIRGraph graph;
+    TypeInferenceOracle oracle;
+    IonBuilder *builder;
+    LIRGraph lir;
+
+    // Whether the MIR has been specialized to the arguments of the frame it
+    // was built for, and the key of the version, made while the frame was
+    // still around. The values of the key are not traced, as for |roots|.
+    bool specialized;
+    PSVersionCache::Key versionKey;
+
+    // Set by the compiler thread if the passes it ran succeeded.
+    bool succeeded;
+
+    OffThreadCompilation(JSScript *script);
+
+    // Lets the script be compiled again.
+    ~OffThreadCompilation();
+};
+
+// Thread running the optimization passes, lowering and register allocation of
+// the compilations handed over by the main thread, one at a time. It follows
+// SourceCompressorThread: the main thread notifies it when it queues a
+// compilation, and it triggers the operation callback of the runtime when one
+// is finished.
+class CompilerThread
+{
+  private:
+    typedef Vector<OffThreadCompilation *, 0, SystemAllocPolicy> CompilationVector;
+
+    JSRuntime *rt;
+    PRThread *thread;
+    // Protects the fields below.
+    PRLock *lock;
+    // When it has nothing to compile, the compiler thread blocks on this. The
+    // main thread uses it to notify the compiler thread of a new compilation.
+    PRCondVar *wakeup;
+    // The main thread blocks on this to wait for the compilation running to
+    // finish.
+    PRCondVar *done;
+
+    // Compilations waiting for the compiler thread, in order.
+    CompilationVector worklist;
+    // Compilation the compiler thread is running.
+    OffThreadCompilation *current;
+    // Compilations waiting to be linked on the main thread.
+    CompilationVector finished;
+    // Set by finish() to tell the compiler thread to exit.
+    bool shutdown;
+
+    void threadLoop();
+    static void compilerThread(void *arg);
+
+  public:
+    explicit CompilerThread(JSRuntime *rt)
+      : rt(rt),
+        thread(NULL),
+        lock(NULL),
+        wakeup(NULL),
+        done(NULL),
+        current(NULL),
+        shutdown(false)
+    { }
+
+    bool init();
+    void finish();
+
+    // Queues a compilation. Returns false if the queue cannot grow.
+    bool submit(OffThreadCompilation *compilation);
+
+    // Removes a finished compilation from the queue, or returns NULL.
+    OffThreadCompilation *takeFinished();
+
+    // Stops the compilation running at the end of its current pass, and
+    // destroys all compilations. Finished ones are linked beforehand where
+    // possible, see AttachFinishedCompilations.
+    void cancelAll();
+};
+
+// Runs the passes of an off thread compilation on the compiler thread.
+// Defined in Ion.cpp, along the passes of synchronous compilations.
+bool CompileOffThread(OffThreadCompilation *compilation);
+
+} // namespace ion
+} // namespace js
+
+#endif // JS_THREADSAFE
+
+#endif // jsion_compiler_thread_h__
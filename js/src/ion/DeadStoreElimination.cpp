@@ -0,0 +1,247 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Ion.h"
+#include "IonSpewer.h"
+#include "AliasAnalysis.h"
+#include "DeadStoreElimination.h"
+
+using namespace js;
+using namespace js::ion;
+
+DeadStoreElimination::DeadStoreElimination(MIRGraph &graph)
+  : graph(graph)
+{
+}
+
+// The resume point of a removed instruction is dropped with it.
+static void
+Discard(MInstruction *ins)
+{
+    if (MResumePoint *resumePoint = ins->resumePoint()) {
+        for (size_t i = 0; i < resumePoint->numOperands(); i++) {
+            if (resumePoint->getOperand(i))
+                resumePoint->replaceOperand(i, NULL);
+        }
+    }
+    ins->block()->discard(ins);
+}
+
+static bool
+IsPlainStore(MInstruction *ins)
+{
+    return ins->isStoreFixedSlot() || ins->isStoreSlot() || ins->isStoreElement();
+}
+
+static bool
+SameIndex(MDefinition *lhs, MDefinition *rhs)
+{
+    if (lhs == rhs)
+        return true;
+    return lhs->isConstant() && rhs->isConstant() &&
+           lhs->toConstant()->value() == rhs->toConstant()->value();
+}
+
+// Whether two plain stores write the same slot or element of the same object.
+static bool
+SameLocation(MInstruction *store, MInstruction *other)
+{
+    if (store->op() != other->op())
+        return false;
+
+    switch (store->op()) {
+      case MDefinition::Op_StoreFixedSlot:
+        return store->toStoreFixedSlot()->object() == other->toStoreFixedSlot()->object() &&
+               store->toStoreFixedSlot()->slot() == other->toStoreFixedSlot()->slot();
+      case MDefinition::Op_StoreSlot:
+        return store->toStoreSlot()->slots() == other->toStoreSlot()->slots() &&
+               store->toStoreSlot()->slot() == other->toStoreSlot()->slot();
+      case MDefinition::Op_StoreElement:
+        return store->toStoreElement()->elements() == other->toStoreElement()->elements() &&
+               SameIndex(store->toStoreElement()->index(), other->toStoreElement()->index());
+      default:
+        JS_NOT_REACHED("Not a plain store");
+        return false;
+    }
+}
+
+// Instructions which are never given a snapshot when lowered.
+static bool
+CannotBailOut(MInstruction *ins)
+{
+    switch (ins->op()) {
+      case MDefinition::Op_Constant:
+      case MDefinition::Op_Box:
+      case MDefinition::Op_Slots:
+      case MDefinition::Op_Elements:
+      case MDefinition::Op_InitializedLength:
+      case MDefinition::Op_LoadFixedSlot:
+      case MDefinition::Op_LoadSlot:
+        return true;
+      case MDefinition::Op_ToDouble:
+        return ins->toToDouble()->input()->type() == MIRType_Int32;
+      case MDefinition::Op_Unbox:
+        return !ins->toUnbox()->fallible();
+      case MDefinition::Op_Add:
+        return ins->toAdd()->specialization() == MIRType_Double;
+      case MDefinition::Op_Sub:
+        return ins->toSub()->specialization() == MIRType_Double;
+      case MDefinition::Op_Mul:
+        return ins->toMul()->specialization() == MIRType_Double;
+      default:
+        return false;
+    }
+}
+
+// A store is overwritten if a later store of its block writes the same
+// location, and the value stored is neither read nor observed by a bailout in
+// between.
+//
+// Until another resume point is reached, bailing out resumes before the
+// removed store and the interpreter makes it again, so any instruction may
+// bail. Past that resume point, only instructions which cannot bail are
+// allowed.
+bool
+DeadStoreElimination::isOverwritten(MInstruction *store)
+{
+    AliasSet storeSet = store->getAliasSet();
+    bool passedResumePoint = false;
+
+    for (MInstructionIterator iter(store->block()->begin(store)); ; ) {
+        iter++;
+        MInstruction *ins = *iter;
+        if (ins->isControlInstruction())
+            return false;
+
+        AliasSet set = ins->getAliasSet();
+        if (set.isStore()) {
+            if (!IsPlainStore(ins))
+                return false;
+            if (SameLocation(store, ins)) {
+                IonSpew(IonSpew_DSE, "Store %d is overwritten by store %d",
+                        store->id(), ins->id());
+                return true;
+            }
+        } else if (!(set & storeSet).isNone() && MightAlias(ins, store)) {
+            return false;
+        }
+
+        if (passedResumePoint && !IsPlainStore(ins) && !CannotBailOut(ins))
+            return false;
+        if (ins->resumePoint())
+            passedResumePoint = true;
+    }
+}
+
+// Whether the only uses of the slots or elements of a literal are stores into
+// them, which are then added to the list of stores to remove.
+bool
+DeadStoreElimination::isOnlyStored(MDefinition *vector)
+{
+    for (MUseIterator use(vector->usesBegin()); use != vector->usesEnd(); use++) {
+        if (use->node()->isResumePoint())
+            return false;
+
+        MDefinition *consumer = use->node()->toDefinition();
+        if (use->index() != 0)
+            return false;
+        if (!consumer->isStoreFixedSlot() && !consumer->isStoreSlot() &&
+            !consumer->isStoreElement() && !consumer->isSetInitializedLength())
+        {
+            return false;
+        }
+        if (!stores.append(consumer->toInstruction()))
+            return false;
+    }
+    return true;
+}
+
+// An object or array literal is unused if it is only stored to, directly or
+// through its slots and elements, and only captured by the resume points of
+// these stores and of its allocation.
+bool
+DeadStoreElimination::isUnusedLiteral(MInstruction *alloc)
+{
+    stores.clear();
+
+    Vector<MDefinition *, 2, IonAllocPolicy> vectors;
+    for (MUseIterator use(alloc->usesBegin()); use != alloc->usesEnd(); use++) {
+        if (use->node()->isResumePoint())
+            continue;
+
+        MDefinition *def = use->node()->toDefinition();
+        if (def->isSlots() || def->isElements()) {
+            if (!vectors.append(def))
+                return false;
+        } else if (!def->isStoreFixedSlot() || use->index() != 0) {
+            return false;
+        } else if (!stores.append(def->toInstruction())) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < vectors.length(); i++) {
+        if (!isOnlyStored(vectors[i]))
+            return false;
+    }
+
+    for (MUseIterator use(alloc->usesBegin()); use != alloc->usesEnd(); use++) {
+        if (!use->node()->isResumePoint())
+            continue;
+
+        MResumePoint *resumePoint = use->node()->toResumePoint();
+        bool removed = resumePoint == alloc->resumePoint();
+        for (size_t i = 0; i < stores.length() && !removed; i++)
+            removed = resumePoint == stores[i]->resumePoint();
+        if (!removed)
+            return false;
+    }
+
+    // Slots and elements are removed after the stores using them.
+    for (size_t i = 0; i < vectors.length(); i++) {
+        if (!stores.append(vectors[i]->toInstruction()))
+            return false;
+    }
+    return true;
+}
+
+bool
+DeadStoreElimination::analyze()
+{
+    IonSpew(IonSpew_DSE, "Beginning DSE pass.");
+
+    Vector<MInstruction *, 4, IonAllocPolicy> literals;
+    for (ReversePostorderIterator block(graph.rpoBegin()); block != graph.rpoEnd(); block++) {
+        for (MInstructionIterator ins(block->begin()); ins != block->end(); ins++) {
+            if ((ins->isNewObject() || ins->isNewArray()) && !literals.append(*ins))
+                return false;
+        }
+    }
+
+    for (size_t i = 0; i < literals.length(); i++) {
+        MInstruction *alloc = literals[i];
+        if (!isUnusedLiteral(alloc))
+            continue;
+
+        IonSpew(IonSpew_DSE, "Removing literal %d and its %d stores",
+                alloc->id(), int(stores.length()));
+        for (size_t j = 0; j < stores.length(); j++)
+            Discard(stores[j]);
+        Discard(alloc);
+    }
+
+    for (ReversePostorderIterator block(graph.rpoBegin()); block != graph.rpoEnd(); block++) {
+        for (MInstructionIterator ins(block->begin()); ins != block->end(); ) {
+            MInstruction *store = *ins;
+            ins++;
+            if (IsPlainStore(store) && isOverwritten(store))
+                Discard(store);
+        }
+    }
+
+    return true;
+}
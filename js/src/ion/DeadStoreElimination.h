@@ -0,0 +1,46 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef jsion_dead_store_elimination_h__
+#define jsion_dead_store_elimination_h__
+
+#include "IonAllocPolicy.h"
+#include "MIR.h"
+#include "MIRGraph.h"
+
+namespace js {
+namespace ion {
+
+// Removes the stores to slots and elements which are never read.
+//
+// A store is dead when a later store of its block writes the same location,
+// and no instruction in between may read it or bail out. Bailing out resumes
+// the interpreter after the first store, which must then have been made.
+//
+// Stores to an object or array literal are also dead when the literal is only
+// used by these stores: it is then removed with them.
+class DeadStoreElimination
+{
+    MIRGraph &graph;
+
+    // Stores of the literal being removed, followed by its slots and
+    // elements.
+    Vector<MInstruction *, 8, IonAllocPolicy> stores;
+
+    bool isOverwritten(MInstruction *store);
+    bool isUnusedLiteral(MInstruction *alloc);
+    bool isOnlyStored(MDefinition *vector);
+
+  public:
+    DeadStoreElimination(MIRGraph &graph);
+    bool analyze();
+};
+
+} // namespace ion
+} // namespace js
+
+#endif // jsion_dead_store_elimination_h__
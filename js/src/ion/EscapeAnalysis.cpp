@@ -0,0 +1,547 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Ion.h"
+#include "IonSpewer.h"
+#include "EscapeAnalysis.h"
+
+#include "jsobjinlines.h"
+
+using namespace js;
+using namespace js::ion;
+
+EscapeAnalysis::EscapeAnalysis(MIRGraph &graph)
+  : graph(graph),
+    numReplaced(0),
+    alloc(NULL),
+    templateObject(NULL),
+    numFields(0),
+    initLength(0),
+    state(NULL)
+{
+}
+
+// Index given by an int32 constant, possibly converted and checked against
+// a length first.
+static bool
+ConstantIndex(MDefinition *def, uint32 *index)
+{
+    if (def->isBoundsCheck())
+        def = def->toBoundsCheck()->index();
+    if (def->isToInt32())
+        def = def->toToInt32()->input();
+    if (!def->isConstant() || !def->toConstant()->value().isInt32())
+        return false;
+
+    int32 value = def->toConstant()->value().toInt32();
+    if (value < 0)
+        return false;
+    *index = uint32(value);
+    return true;
+}
+
+// Whether a field of type |from| can be given to the uses of a load of type
+// |to|.
+static bool
+CanConvert(MIRType from, MIRType to)
+{
+    if (from == to || to == MIRType_Value)
+        return true;
+    if (to == MIRType_Double)
+        return from == MIRType_Int32;
+    if (from == MIRType_Value) {
+        return to == MIRType_Boolean || to == MIRType_Int32 ||
+               to == MIRType_String || to == MIRType_Object;
+    }
+    return false;
+}
+
+static MDefinition *
+Convert(MDefinition *value, MIRType type, MInstruction *at)
+{
+    JS_ASSERT(CanConvert(value->type(), type));
+
+    MInstruction *ins;
+    if (value->type() == type)
+        return value;
+    if (type == MIRType_Value)
+        ins = MBox::New(value);
+    else if (type == MIRType_Double)
+        ins = MToDouble::New(value);
+    else
+        ins = MUnbox::New(value, type, MUnbox::Fallible);
+
+    at->block()->insertBefore(at, ins);
+    return ins;
+}
+
+// The resume point of a removed instruction is dropped with it.
+static void
+Discard(MInstruction *ins)
+{
+    if (MResumePoint *resumePoint = ins->resumePoint()) {
+        for (size_t i = 0; i < resumePoint->numOperands(); i++) {
+            if (resumePoint->getOperand(i))
+                resumePoint->replaceOperand(i, NULL);
+        }
+    }
+    ins->block()->discard(ins);
+}
+
+static MConstant *
+InsertConstant(const Value &v, MInstruction *at)
+{
+    MConstant *constant = MConstant::New(v);
+    at->block()->insertBefore(at, constant);
+    return constant;
+}
+
+bool
+EscapeAnalysis::isCandidate(MInstruction *ins)
+{
+    if (ins->isNewObject()) {
+        templateObject = ins->toNewObject()->templateObject();
+
+        // Properties added to the template after the literal need dynamic
+        // slots, which are not followed.
+        if (templateObject->hasSingletonType() || templateObject->hasDynamicSlots())
+            return false;
+        numFields = templateObject->slotSpan();
+        return numFields <= MaxFields && numFields <= templateObject->numFixedSlots();
+    }
+
+    if (ins->isNewArray()) {
+        MNewArray *array = ins->toNewArray();
+        templateObject = array->templateObject();
+        if (!array->isAllocating() || templateObject->hasSingletonType())
+            return false;
+        numFields = array->count();
+        return numFields <= MaxFields;
+    }
+
+    return false;
+}
+
+bool
+EscapeAnalysis::ownsElements(MDefinition *def)
+{
+    return def->isElements() && def->toElements()->object() == alloc;
+}
+
+bool
+EscapeAnalysis::isStore(MInstruction *ins, uint32 *index, MDefinition **value)
+{
+    if (ins->isStoreFixedSlot()) {
+        MStoreFixedSlot *store = ins->toStoreFixedSlot();
+        if (store->object() != alloc)
+            return false;
+        *index = store->slot();
+        *value = store->value();
+        return true;
+    }
+
+    if (ins->isStoreElement()) {
+        MStoreElement *store = ins->toStoreElement();
+        if (!ownsElements(store->elements()))
+            return false;
+        JS_ALWAYS_TRUE(ConstantIndex(store->index(), index));
+        *value = store->value();
+        return true;
+    }
+
+    return false;
+}
+
+bool
+EscapeAnalysis::isLoad(MInstruction *ins, uint32 *index)
+{
+    if (ins->isLoadFixedSlot()) {
+        MLoadFixedSlot *load = ins->toLoadFixedSlot();
+        if (load->object() != alloc)
+            return false;
+        *index = load->slot();
+        return true;
+    }
+
+    if (ins->isLoadElement()) {
+        MLoadElement *load = ins->toLoadElement();
+        if (!ownsElements(load->elements()))
+            return false;
+        JS_ALWAYS_TRUE(ConstantIndex(load->index(), index));
+        return true;
+    }
+
+    return false;
+}
+
+bool
+EscapeAnalysis::isInitializedLength(MInstruction *ins)
+{
+    return ins->isInitializedLength() && ownsElements(ins->toInitializedLength()->elements());
+}
+
+bool
+EscapeAnalysis::checkElementsUses(MElements *elems)
+{
+    for (MUseIterator use(elems->usesBegin()); use != elems->usesEnd(); use++) {
+        if (!use->node()->isDefinition())
+            return false;
+
+        MDefinition *def = use->node()->toDefinition();
+        uint32 index;
+        switch (def->op()) {
+          case MDefinition::Op_StoreElement:
+            if (use->index() != 0 || def->block() != alloc->block())
+                return false;
+            if (!ConstantIndex(def->toStoreElement()->index(), &index) || index >= numFields)
+                return false;
+            break;
+
+          case MDefinition::Op_SetInitializedLength:
+            if (def->block() != alloc->block())
+                return false;
+            if (!ConstantIndex(def->toSetInitializedLength()->index(), &index) ||
+                index >= numFields)
+            {
+                return false;
+            }
+            break;
+
+          case MDefinition::Op_LoadElement:
+            if (!ConstantIndex(def->toLoadElement()->index(), &index) || index >= numFields)
+                return false;
+            if (!loads.append(def->toInstruction()))
+                return false;
+            break;
+
+          case MDefinition::Op_InitializedLength:
+          case MDefinition::Op_ArrayLength:
+            break;
+
+          default:
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+EscapeAnalysis::checkUses()
+{
+    for (MUseIterator use(alloc->usesBegin()); use != alloc->usesEnd(); use++) {
+        if (use->node()->isResumePoint())
+            continue;
+
+        MDefinition *def = use->node()->toDefinition();
+        if (!isArray() && def->isStoreFixedSlot()) {
+            // The object must not be stored itself.
+            if (use->index() != 0 || def->block() != alloc->block())
+                return false;
+            if (def->toStoreFixedSlot()->slot() >= numFields)
+                return false;
+            continue;
+        }
+        if (!isArray() && def->isLoadFixedSlot()) {
+            if (def->toLoadFixedSlot()->slot() >= numFields)
+                return false;
+            if (!loads.append(def->toInstruction()))
+                return false;
+            continue;
+        }
+        if (isArray() && def->isElements()) {
+            if (!checkElementsUses(def->toElements()))
+                return false;
+            if (!elements.append(def->toElements()))
+                return false;
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool
+EscapeAnalysis::canLoad(uint32 index, MIRType type)
+{
+    if (index >= numFields)
+        return false;
+
+    // Fields of objects are undefined until stored, but arrays are only read
+    // below their initialized length.
+    if (isArray() && (index >= initLength || !fields[index]))
+        return false;
+
+    MIRType fieldType = fields[index] ? fields[index]->type() : MIRType_Undefined;
+    return CanConvert(fieldType, type);
+}
+
+MObjectState *
+EscapeAnalysis::currentState(MInstruction *at)
+{
+    if (state)
+        return state;
+
+    size_t length = isArray() ? initLength : numFields;
+    state = MObjectState::New(templateObject, numReplaced, fields.begin(), length);
+    if (!state)
+        return NULL;
+    at->block()->insertBefore(at, state);
+    return state;
+}
+
+// Walks the block of the allocation, in which all the stores are made. With
+// |replace| unset, only checks that the loads can be given the value of the
+// field they read, and that arrays have no holes. Otherwise, removes the
+// stores and the loads of the block, and gives the resume points of the block
+// the state of the allocation at their point.
+//
+// Fields are left with their values at the end of the block.
+bool
+EscapeAnalysis::followStores(bool replace)
+{
+    MBasicBlock *block = alloc->block();
+    MConstant *initial = NULL;
+    if (replace && !isArray()) {
+        initial = MConstant::New(UndefinedValue());
+        block->insertAfter(alloc, initial);
+    }
+
+    fields.clear();
+    if (!fields.appendN(initial, numFields))
+        return false;
+    initLength = 0;
+    state = NULL;
+
+    MInstructionIterator iter(block->begin(alloc));
+    for (iter++; iter != block->end(); ) {
+        MInstruction *ins = *iter;
+        uint32 index;
+        MDefinition *value;
+
+        if (isStore(ins, &index, &value)) {
+            fields[index] = value;
+            state = NULL;
+            if (replace && ins->isStoreElement() &&
+                ins->toStoreElement()->index()->isBoundsCheck() &&
+                !boundsChecks.append(ins->toStoreElement()->index()->toBoundsCheck()))
+            {
+                return false;
+            }
+        } else if (ins->isSetInitializedLength() &&
+                   ownsElements(ins->toSetInitializedLength()->elements()))
+        {
+            JS_ALWAYS_TRUE(ConstantIndex(ins->toSetInitializedLength()->index(), &index));
+            for (uint32 i = 0; i <= index; i++) {
+                if (!fields[i])
+                    return false;
+            }
+            initLength = index + 1;
+            state = NULL;
+        } else if (isLoad(ins, &index)) {
+            if (!canLoad(index, ins->type()))
+                return false;
+            if (replace && !replaceLoad(ins, index))
+                return false;
+        } else if (replace && isInitializedLength(ins)) {
+            ins->replaceAllUsesWith(InsertConstant(Int32Value(initLength), ins));
+        } else if (replace && ins->isArrayLength() &&
+                   ownsElements(ins->toArrayLength()->elements()))
+        {
+            ins->replaceAllUsesWith(InsertConstant(Int32Value(numFields), ins));
+        } else {
+            if (replace && ins->resumePoint()) {
+                MResumePoint *resumePoint = ins->resumePoint();
+                for (size_t i = 0; i < resumePoint->numOperands(); i++) {
+                    if (resumePoint->getOperand(i) != alloc)
+                        continue;
+                    MObjectState *objectState = currentState(ins);
+                    if (!objectState)
+                        return false;
+                    resumePoint->replaceOperand(i, objectState);
+                }
+            }
+            iter++;
+            continue;
+        }
+
+        iter++;
+        if (replace)
+            Discard(ins);
+    }
+
+    // Loads in other blocks read the fields as they are left.
+    if (!replace) {
+        for (size_t i = 0; i < loads.length(); i++) {
+            MInstruction *load = loads[i];
+            if (load->block() == block)
+                continue;
+            uint32 index;
+            JS_ALWAYS_TRUE(isLoad(load, &index));
+            if (!canLoad(index, load->type()))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+EscapeAnalysis::replaceLoad(MInstruction *load, uint32 index)
+{
+    JS_ASSERT(canLoad(index, load->type()));
+    load->replaceAllUsesWith(Convert(fields[index], load->type(), load));
+
+    if (load->isLoadElement() && load->toLoadElement()->index()->isBoundsCheck())
+        return boundsChecks.append(load->toLoadElement()->index()->toBoundsCheck());
+    return true;
+}
+
+// Replaces the uses of the allocation left after its block with the values
+// of the fields at the end of the block.
+bool
+EscapeAnalysis::replaceRemainingUses()
+{
+    Vector<MNode *, 8, IonAllocPolicy> nodes;
+
+    for (size_t i = 0; i < elements.length(); i++) {
+        MElements *elems = elements[i];
+
+        nodes.clear();
+        for (MUseIterator use(elems->usesBegin()); use != elems->usesEnd(); use++) {
+            if (!nodes.append(use->node()))
+                return false;
+        }
+
+        for (size_t j = 0; j < nodes.length(); j++) {
+            MInstruction *ins = nodes[j]->toDefinition()->toInstruction();
+            uint32 index;
+            if (isLoad(ins, &index)) {
+                if (!replaceLoad(ins, index))
+                    return false;
+            } else if (ins->isInitializedLength()) {
+                ins->replaceAllUsesWith(InsertConstant(Int32Value(initLength), ins));
+            } else {
+                JS_ASSERT(ins->isArrayLength());
+                ins->replaceAllUsesWith(InsertConstant(Int32Value(numFields), ins));
+            }
+            Discard(ins);
+        }
+
+        Discard(elems);
+    }
+
+    nodes.clear();
+    for (MUseIterator use(alloc->usesBegin()); use != alloc->usesEnd(); use++) {
+        if (!nodes.append(use->node()))
+            return false;
+    }
+
+    for (size_t i = 0; i < nodes.length(); i++) {
+        MNode *node = nodes[i];
+        if (node->isDefinition()) {
+            MInstruction *load = node->toDefinition()->toInstruction();
+            uint32 index;
+            JS_ALWAYS_TRUE(isLoad(load, &index));
+            if (!replaceLoad(load, index))
+                return false;
+            Discard(load);
+            continue;
+        }
+
+        MResumePoint *resumePoint = node->toResumePoint();
+        MObjectState *objectState = currentState(alloc->block()->lastIns());
+        if (!objectState)
+            return false;
+        for (size_t j = 0; j < resumePoint->numOperands(); j++) {
+            if (resumePoint->getOperand(j) == alloc)
+                resumePoint->replaceOperand(j, objectState);
+        }
+    }
+
+    return true;
+}
+
+// Bounds checks on the elements have been given constant operands. Those
+// which cannot fail are removed.
+void
+EscapeAnalysis::removeBoundsChecks()
+{
+    for (size_t i = 0; i < boundsChecks.length(); i++) {
+        MBoundsCheck *check = boundsChecks[i];
+        if (!check || check->hasUses() || check->minimum() != 0 || check->maximum() != 0)
+            continue;
+
+        uint32 index;
+        if (!ConstantIndex(check->index(), &index) || !check->length()->isConstant())
+            continue;
+        if (int32(index) >= check->length()->toConstant()->value().toInt32())
+            continue;
+
+        for (size_t j = i + 1; j < boundsChecks.length(); j++) {
+            if (boundsChecks[j] == check)
+                boundsChecks[j] = NULL;
+        }
+        Discard(check);
+    }
+}
+
+bool
+EscapeAnalysis::replace(MInstruction *ins)
+{
+    alloc = ins;
+    if (!isCandidate(ins))
+        return true;
+
+    elements.clear();
+    loads.clear();
+    boundsChecks.clear();
+
+    if (!checkUses() || !followStores(false)) {
+        IonSpew(IonSpew_Escape, "Allocation %u escapes", alloc->id());
+        return true;
+    }
+
+    IonSpew(IonSpew_Escape, "Replacing allocation %u by its %u fields", alloc->id(), numFields);
+
+    // The resume point taken after the allocation holds it, and goes away
+    // with it.
+    if (MResumePoint *resumePoint = alloc->resumePoint()) {
+        for (size_t i = 0; i < resumePoint->numOperands(); i++)
+            resumePoint->replaceOperand(i, NULL);
+    }
+
+    if (!followStores(true) || !replaceRemainingUses())
+        return false;
+    removeBoundsChecks();
+
+    JS_ASSERT(!alloc->hasUses());
+    alloc->block()->discard(alloc);
+
+    numReplaced++;
+    return true;
+}
+
+bool
+EscapeAnalysis::analyze()
+{
+    Vector<MInstruction *, 8, IonAllocPolicy> allocations;
+    for (ReversePostorderIterator block(graph.rpoBegin()); block != graph.rpoEnd(); block++) {
+        for (MInstructionIterator ins(block->begin()); ins != block->end(); ins++) {
+            if ((ins->isNewObject() || ins->isNewArray()) && !allocations.append(*ins))
+                return false;
+        }
+    }
+
+    for (size_t i = 0; i < allocations.length(); i++) {
+        if (!replace(allocations[i]))
+            return false;
+    }
+
+    IonSpew(IonSpew_Escape, "Replaced %u of %u allocations", numReplaced,
+            unsigned(allocations.length()));
+    return true;
+}
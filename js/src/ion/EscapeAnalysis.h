@@ -0,0 +1,88 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef jsion_escape_analysis_h__
+#define jsion_escape_analysis_h__
+
+#include "IonAllocPolicy.h"
+#include "MIR.h"
+#include "MIRGraph.h"
+
+namespace js {
+namespace ion {
+
+// Removes the object and array literals which do not escape the function, and
+// uses the values stored into their slots and elements directly in their
+// place.
+//
+// An allocation does not escape when it is only used to store values in the
+// block which allocates it, to load values anywhere, and by resume points.
+// The stores are followed in the allocating block, so that each load is given
+// the value of the field at that point, and each resume point an
+// MObjectState holding the values of all the fields. When bailing out, the
+// object is allocated again from its template and these values.
+class EscapeAnalysis
+{
+    // Allocations with more fields are left alone, to keep snapshots small.
+    static const uint32 MaxFields = 32;
+
+    MIRGraph &graph;
+
+    // Number of allocations replaced so far, which numbers their states.
+    uint32 numReplaced;
+
+    // Allocation being replaced, and its state at the point reached in its
+    // block: the value of each field, the initialized length of arrays, and
+    // the last MObjectState built from them, if any fields have not been
+    // stored since.
+    MInstruction *alloc;
+    JSObject *templateObject;
+    uint32 numFields;
+    MDefinitionVector fields;
+    uint32 initLength;
+    MObjectState *state;
+
+    // Elements of the array being replaced.
+    Vector<MElements *, 4, IonAllocPolicy> elements;
+
+    // Loads of the allocation, and the bounds checks made before loading
+    // elements.
+    Vector<MInstruction *, 4, IonAllocPolicy> loads;
+    Vector<MBoundsCheck *, 4, IonAllocPolicy> boundsChecks;
+
+    bool isArray() const {
+        return alloc->isNewArray();
+    }
+
+    bool isCandidate(MInstruction *ins);
+    bool checkUses();
+    bool checkElementsUses(MElements *elems);
+
+    bool isStore(MInstruction *ins, uint32 *index, MDefinition **value);
+    bool isLoad(MInstruction *ins, uint32 *index);
+    bool isInitializedLength(MInstruction *ins);
+    bool ownsElements(MDefinition *def);
+
+    bool canLoad(uint32 index, MIRType type);
+    MObjectState *currentState(MInstruction *at);
+
+    bool followStores(bool replace);
+    bool replaceLoad(MInstruction *load, uint32 index);
+    bool replaceRemainingUses();
+    void removeBoundsChecks();
+
+    bool replace(MInstruction *ins);
+
+  public:
+    EscapeAnalysis(MIRGraph &graph);
+    bool analyze();
+};
+
+} // namespace ion
+} // namespace js
+
+#endif // jsion_escape_analysis_h__
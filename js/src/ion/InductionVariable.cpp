@@ -1,440 +1,660 @@
 /* Authors:
  * Igor Rafael [igor@dcc.ufmg.br]
  * Pericles Alves [periclesrafael@dcc.ufmg.br]
- */ 
+ */
 
 #include "InductionVariable.h"
+#include "IonSpewer.h"
+#include "jsanalyze.h"
 
 using namespace js;
 using namespace js::ion;
 
-InductionVariable::InductionVariable(MBasicBlock *block)
+InductionVariableAnalysis::InductionVariableAnalysis(MIRGraph &graph)
+  : graph_(graph)
 {
-    this->block = block;
-    variable_ = NULL;
-
-    hasLowerBound_ = false;
-    hasUpperBound_ = false;
 }
 
-bool
-InductionVariable::extractPattern()
+static bool
+IsInt32Constant(MDefinition *def, int32 *value)
 {
-    bool match = false;
-
-    // The patterns are arranged from the most common to the less common.
-
-    if (extractUBCSPattern() || extractUBCSPatternDoWhile())
-        match = true;
-    
-    if (!match)
-        return false;
-
-    if (!variable_)
+    if (!def->isConstant() || !def->toConstant()->value().isInt32())
         return false;
-
+    *value = def->toConstant()->value().toInt32();
     return true;
 }
 
-bool
-InductionVariable::extractUBCSPattern()
+// Conversions of int32 values to int32, which are only removed by GVN.
+static MDefinition *
+SkipInt32Conversion(MDefinition *def)
 {
-    // Upper Bounded Continuous Sum pattern.
-    // e.g.: "for (i = <lower_bound>; i </<= <upper_bound>; i += <something>)".
-    // e.g.: "i = <lower_bound>; while (i </<= <upper_bound>) { ... i += <something>; }"
-
-    if (!(block->isLoopHeader()))
-        return false;
- 
-    // The last instruction of the block must be a boolean test (MTest).
-    if (!block->lastIns()->isTest())
-        return false;
-        
-    MTest *test = block->lastIns()->toTest();
-    
-    if (!test->getOperand(0)->isCompare())
-        return false;
-        
-    MCompare *compare = test->getOperand(0)->toCompare();
-
-    // The boolean test must be a "lt" or "le" comparision. 
-    if ((compare->jsop() != JSOP_LT) && (compare->jsop() != JSOP_LE))
-        return false;
-        
-    // The left comparision operand must be one of the following kinds of
-    // instructions:
-    // - a phi.
-    // - an integer specialization (toInt32) of a phi.
-    // - an unbox of a phi.
-    // - a box of a phi.
-    MDefinition *compareLhs = compare->lhs();
-    MPhi *phi = NULL;
-
-    // In case it is a phi.
-    if (compareLhs->isPhi())
-        phi = compareLhs->toPhi();
-
-    // In case it is an integer specialization of a phi.
-    else if (compareLhs->isToInt32()) {
-        if (compareLhs->toToInt32()->input()->isPhi())
-            phi = compareLhs->toToInt32()->input()->toPhi();
-
-    // in case it is an unbox of a phi.
-    } else if (compareLhs->isUnbox()) {
-        if (compareLhs->toUnbox()->input()->isPhi())
-            phi = compareLhs->toUnbox()->input()->toPhi();
-
-    // In case it is an box of a phi.
-    } else if (compareLhs->isBox()) {
-        if (compareLhs->toBox()->getOperand(0)->isPhi())
-            phi = compareLhs->toBox()->getOperand(0)->toPhi();
-    }
-
-    if (!phi)
-        return false;
+    if (def->isToInt32() && def->getOperand(0)->type() == MIRType_Int32)
+        return def->getOperand(0);
+    return def;
+}
 
-    if (phi->numOperands() != 2)
-        return false;   
-        
-    // One of the phi operands must be one of the following kinds of
-    // instructions:
-    // - an add.
-    // - an integer specialization (toInt32) of an add.
-    // - an unbox of an add.
-    // - a box of an add.
-    // and its block must be a loop back edge.
-    MDefinition *phiOperand0 = phi->getOperand(0);
-    MDefinition *phiOperand1 = phi->getOperand(1);
-    MAdd *add = NULL; // The add instruction used to increase the induction variable value.
-    MDefinition *mayBeLowerBound = NULL; // Possible lower bound for the induction variable.
-
-    // In case it is an add.
-    if (phiOperand0->isAdd() && phiOperand0->block()->isLoopBackedge()) {
-        add = phiOperand0->toAdd();
-        mayBeLowerBound = phiOperand1;
-    } else if (phiOperand1->isAdd() && phiOperand1->block()->isLoopBackedge()) {
-        add = phiOperand1->toAdd();
-        mayBeLowerBound = phiOperand0;
-
-    // In case it is an integer specialization of an add.
-    } else if(phiOperand0->isToInt32()) {
-        if ((phiOperand0->toToInt32()->input()->isAdd()) && (phiOperand0->block()->isLoopBackedge())) {
-            add = phiOperand0->toToInt32()->input()->toAdd();
-            mayBeLowerBound = phiOperand1;
-        }
-    } else if(phiOperand1->isToInt32()) {
-        if ((phiOperand1->toToInt32()->input()->isAdd()) && (phiOperand1->block()->isLoopBackedge())) {
-            add = phiOperand1->toToInt32()->input()->toAdd();
-            mayBeLowerBound = phiOperand0;
-        }
+static bool
+IsInLoop(MBasicBlock *header, MBasicBlock *block)
+{
+    // Loop blocks are numbered contiguously, from the header to the backedge.
+    return header->dominates(block) && block->id() <= header->backedge()->id();
+}
 
-    // In case it is an unbox of an add.
-    } else if(phiOperand0->isUnbox()) {
-        if ((phiOperand0->toUnbox()->input()->isAdd()) && (phiOperand0->block()->isLoopBackedge())) {
-            add = phiOperand0->toUnbox()->input()->toAdd();
-            mayBeLowerBound = phiOperand1;
-        }
-    } else if(phiOperand1->isUnbox()) {
-        if ((phiOperand1->toUnbox()->input()->isAdd()) && (phiOperand1->block()->isLoopBackedge())) {
-            add = phiOperand1->toUnbox()->input()->toAdd();
-            mayBeLowerBound = phiOperand0;
-        }
+static inline bool
+IsIncrementTruncated(MInstruction *increment)
+{
+    if (increment->isAdd())
+        return increment->toAdd()->isTruncated();
+    return increment->toSub()->isTruncated();
+}
 
-    // In case it is a box of an add.
-    } else if(phiOperand0->isBox()) {
-        if ((phiOperand0->toBox()->getOperand(0)->isAdd()) && (phiOperand0->block()->isLoopBackedge())) {
-            add = phiOperand0->toBox()->getOperand(0)->toAdd();
-            mayBeLowerBound = phiOperand1;
-        }
-    } else if(phiOperand1->isBox()) {
-        if ((phiOperand1->toBox()->getOperand(0)->isAdd()) && (phiOperand1->block()->isLoopBackedge())) {
-            add = phiOperand1->toBox()->getOperand(0)->toAdd();
-            mayBeLowerBound = phiOperand0;
+// Range of a definition which is not an induction variable.
+static Range
+DefinitionRange(MDefinition *def)
+{
+    int32 value;
+    if (IsInt32Constant(def, &value))
+        return Range(value, value);
+
+    if (def->type() != MIRType_Int32)
+        return Range();
+
+    // Phis merging constants, e.g. initial values set in both branches of a
+    // condition.
+    if (def->isPhi() && def->numOperands()) {
+        int32 lower = JSVAL_INT_MAX;
+        int32 upper = JSVAL_INT_MIN;
+        size_t i = 0;
+        for (; i < def->numOperands(); i++) {
+            if (!IsInt32Constant(def->getOperand(i), &value))
+                break;
+            lower = Min(lower, value);
+            upper = Max(upper, value);
         }
+        if (i == def->numOperands())
+            return Range(lower, upper);
     }
 
-    if (!add)
-        return false;
+    return *def->range();
+}
 
-    // The add must ba a sum of the induction variable with a positive
-    // integer constant.
-    MConstant *increment = NULL;
+bool
+InductionVariableAnalysis::findBasicInductionVariable(MPhi *phi)
+{
+    MBasicBlock *header = phi->block();
+    if (phi->type() != MIRType_Int32 || phi->numOperands() != 2)
+        return true;
 
-    if (add->lhs()->isConstant())
-        increment = add->lhs()->toConstant();
-    else if (add->rhs()->isConstant())
-        increment = add->rhs()->toConstant();
+    size_t backedgeIndex = (header->getPredecessor(0) == header->backedge()) ? 0 : 1;
+    if (header->getPredecessor(backedgeIndex) != header->backedge())
+        return true;
 
-    if (!increment)
-        return false;
+    // The value coming from the backedge must be "phi + c" or "phi - c".
+    MDefinition *next = phi->getOperand(backedgeIndex);
+    int32 step;
+    if (next->isAdd() && next->toAdd()->specialization() == MIRType_Int32) {
+        MAdd *add = next->toAdd();
+        MDefinition *lhs = SkipInt32Conversion(add->lhs());
+        MDefinition *rhs = SkipInt32Conversion(add->rhs());
+        MDefinition *other = (lhs == phi) ? add->rhs() : add->lhs();
+        if ((lhs != phi && rhs != phi) || !IsInt32Constant(other, &step))
+            return true;
+    } else if (next->isSub() && next->toSub()->specialization() == MIRType_Int32) {
+        MSub *sub = next->toSub();
+        if (SkipInt32Conversion(sub->lhs()) != phi || !IsInt32Constant(sub->rhs(), &step) || step == JSVAL_INT_MIN)
+            return true;
+        step = -step;
+    } else {
+        return true;
+    }
 
-    if (!increment->value().isInt32())
-        return false;
+    if (step == 0)
+        return true;
 
-    if (increment->value().toInt32() < 0)
+    InductionVariable iv;
+    iv.phi = phi;
+    iv.start = phi->getOperand(1 - backedgeIndex);
+    iv.increment = next->toInstruction();
+    iv.step = step;
+    if (!ivs_.append(iv))
         return false;
 
-    // If all conditions are satisfied, the phi is the induction variable.
-    variable_ = phi;
-
-    // Extracts the lower bound.
-    if (mayBeLowerBound) {
-        Value value = UndefinedValue(); // The actual lower bound.
+    Recurrence &rec = recurrences_[phi->id()];
+    rec.iv = ivs_.length() - 1;
+    rec.scale = 1;
+    rec.offset = 0;
 
-        if (mayBeLowerBound->isConstant())
-            value = mayBeLowerBound->toConstant()->value();
-
-        // The lower bound can be extracted even if we have a phi of two
-        // constants.
-        else if (mayBeLowerBound->isPhi() && (mayBeLowerBound->numOperands() == 2)) {
-            MPhi *lowerPhi = mayBeLowerBound->toPhi();
+    IonSpew(IonSpew_BCE, "Induction variable %d starts at %d with step %d",
+            phi->id(), iv.start->id(), step);
+    return true;
+}
 
-            if (lowerPhi->getOperand(0)->isConstant() && lowerPhi->getOperand(1)->isConstant()) {
-                Value lPhiLhs = lowerPhi->getOperand(0)->toConstant()->value();
-                Value lPhiRhs = lowerPhi->getOperand(1)->toConstant()->value();
+void
+InductionVariableAnalysis::findDerivedInductionVariable(MDefinition *def)
+{
+    if (def->type() != MIRType_Int32 || recurrence(def))
+        return;
 
-                if (lPhiLhs.isInt32() && lPhiRhs.isInt32()) {
-                    if (lPhiLhs.toInt32() <= lPhiRhs.toInt32())
-                        value = lPhiLhs;
-                    else
-                        value = lPhiRhs;
-                }
-            }
+    if (SkipInt32Conversion(def) != def) {
+        if (const Recurrence *rec = recurrence(def->getOperand(0)))
+            recurrences_[def->id()] = *rec;
+        return;
+    }
 
+    if (!def->isAdd() && !def->isSub() && !def->isMul())
+        return;
+    if (static_cast<MBinaryArithInstruction *>(def)->specialization() != MIRType_Int32)
+        return;
+
+    MDefinition *lhs = def->getOperand(0);
+    MDefinition *rhs = def->getOperand(1);
+    const Recurrence *rec;
+    int32 c;
+    bool constantOnRight;
+    if ((rec = recurrence(lhs)) && IsInt32Constant(rhs, &c))
+        constantOnRight = true;
+    else if ((rec = recurrence(rhs)) && IsInt32Constant(lhs, &c))
+        constantOnRight = false;
+    else
+        return;
+
+    int64_t scale = rec->scale;
+    int64_t offset = rec->offset;
+    if (def->isAdd()) {
+        offset += c;
+    } else if (def->isSub()) {
+        if (constantOnRight) {
+            offset -= c;
+        } else {
+            scale = -scale;
+            offset = c - offset;
         }
+    } else {
+        scale *= c;
+        offset *= c;
+    }
 
-        if (value.isInt32()) {
-            int32 lowerBound = value.toInt32();
-            
-            if (lowerBound >= 0) {
-                hasLowerBound_ = true;
-                range.lowerBound = lowerBound;
-            }
-        }
+    if (scale == 0 ||
+        scale < JSVAL_INT_MIN || scale > JSVAL_INT_MAX ||
+        offset < JSVAL_INT_MIN || offset > JSVAL_INT_MAX)
+    {
+        return;
     }
 
-    // Extracts the upper bound.
-    if (compare->rhs()->isConstant()) {
-        Value value = compare->rhs()->toConstant()->value();
+    Recurrence &derived = recurrences_[def->id()];
+    derived.iv = rec->iv;
+    derived.scale = int32(scale);
+    derived.offset = int32(offset);
+}
 
-        if (value.isInt32()) {
-            int32 upperBound = value.toInt32();
+bool
+InductionVariableAnalysis::addLoopTest(MTest *test, MBasicBlock *successor, JSOp op,
+                                       MDefinition *def, MDefinition *bound)
+{
+    if (op == JSOP_EQ || op == JSOP_STRICTEQ)
+        return true;
+    if (op == JSOP_STRICTNE)
+        op = JSOP_NE;
 
-            if (upperBound >= 0) {
-                hasUpperBound_ = true;
+    const Recurrence *rec = recurrence(def);
+    if (!rec || rec->scale != 1)
+        return true;
 
-                // The upper bound must guarantee the LT relation.
-                if (compare->jsop() == JSOP_LE)
-                    range.upperBound = (upperBound - 1);
-                else
-                    range.upperBound = upperBound;
-            }
-        }
-    }
+    MBasicBlock *header = ivs_[rec->iv].phi->block();
+    if (!IsInLoop(header, test->block()))
+        return true;
 
-    return true;
+    // The successor must only be reached when the comparison holds.
+    if (successor->numPredecessors() != 1)
+        return true;
+
+    LoopTest loopTest;
+    loopTest.iv = rec->iv;
+    loopTest.successor = successor;
+    loopTest.op = op;
+    loopTest.bound = bound;
+    loopTest.offset = rec->offset;
+    loopTest.exits = successor->dominates(header->backedge());
+
+    IonSpew(IonSpew_BCE, "Test %d bounds induction variable %d in block %d%s",
+            test->id(), ivs_[rec->iv].phi->id(), successor->id(),
+            loopTest.exits ? ", exiting the loop otherwise" : "");
+    return tests_.append(loopTest);
 }
 
 bool
-InductionVariable::extractUBCSPatternDoWhile() {
-    // Upper Bounded Continuous Sum pattern.
-    // e.g: "i = <lower_bound>; do { ... i += <something> } while (i </<= <upper_bound);
-
-    if (!(block->isLoopHeader()))
-        return false;
-
-    // Save the header an work on the its backedge.
-    MBasicBlock *header = block;
-    block = block->backedge()->getPredecessor(0);
- 
-    // The last instruction if the block must be a boolean test (MTest).
+InductionVariableAnalysis::findLoopTests(MBasicBlock *block)
+{
     if (!block->lastIns()->isTest())
-        return false;
-        
+        return true;
+
     MTest *test = block->lastIns()->toTest();
-    
     if (!test->getOperand(0)->isCompare())
-        return false;
-        
+        return true;
+
     MCompare *compare = test->getOperand(0)->toCompare();
+    if (compare->specialization() != MIRType_Int32)
+        return true;
 
-    // The boolean test must be a "lt" or "le" comparision. 
-    if ((compare->jsop() != JSOP_LT) && (compare->jsop() != JSOP_LE))
-        return false;
+    JSOp op = compare->jsop();
+    switch (op) {
+      case JSOP_LT:
+      case JSOP_LE:
+      case JSOP_GT:
+      case JSOP_GE:
+      case JSOP_EQ:
+      case JSOP_NE:
+      case JSOP_STRICTEQ:
+      case JSOP_STRICTNE:
+        break;
+      default:
+        return true;
+    }
 
-    // The left comparision operand must be an add. 
+    // Both sides of the comparison may be induction variables, and both
+    // branches tell something about them.
+    for (size_t i = 0; i < test->numSuccessors(); i++) {
+        JSOp branchOp = (i == 0) ? op : analyze::NegateCompareOp(op);
+        MBasicBlock *successor = test->getSuccessor(i);
+        if (!addLoopTest(test, successor, branchOp, compare->lhs(), compare->rhs()))
+            return false;
+        if (!addLoopTest(test, successor, analyze::ReverseCompareOp(branchOp),
+                         compare->rhs(), compare->lhs()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
-    MDefinition *compareLhs = compare->lhs();
+MBasicBlock *
+InductionVariableAnalysis::preheader(const InductionVariable &iv) const
+{
+    MBasicBlock *header = iv.phi->block();
+    if (header->getPredecessor(0) == header->backedge())
+        return header->getPredecessor(1);
+    return header->getPredecessor(0);
+}
 
-    if (!compare->rhs()->isConstant())
-       return false;
+void
+InductionVariableAnalysis::computeRange(InductionVariable &iv)
+{
+    uint32 index = &iv - ivs_.begin();
+    Range start = rangeAt(iv.start, preheader(iv));
+    bool truncated = IsIncrementTruncated(iv.increment);
+
+    // Each value of the phi, but the first one, is the previous value plus
+    // the step, which passed all the tests leaving the loop. Without such a
+    // test, the phi is still bounded by its start value, as long as it
+    // cannot wrap around.
+    bool increasing = iv.step > 0;
+    if (increasing ? start.isLowerInfinite() : start.isUpperInfinite())
+        return;
+
+    bool bounded = false;
+    int64_t last = increasing ? JSVAL_INT_MAX : JSVAL_INT_MIN;
+    for (LoopTest *test = tests_.begin(); test != tests_.end(); test++) {
+        if (test->iv != index || !test->exits)
+            continue;
+
+        Range bound = DefinitionRange(test->bound);
+        int64_t value;
+        if (increasing) {
+            if (bound.isUpperInfinite())
+                continue;
+            if (test->op == JSOP_LT)
+                value = int64_t(bound.upper()) - 1 - test->offset;
+            else if (test->op == JSOP_LE)
+                value = int64_t(bound.upper()) - test->offset;
+            else if (test->op == JSOP_NE && iv.step == 1 && bound.isFinite() &&
+                     bound.lower() == bound.upper() && !start.isUpperInfinite() &&
+                     int64_t(start.upper()) <= int64_t(bound.lower()) - test->offset)
+                value = int64_t(bound.lower()) - 1 - test->offset;
+            else
+                continue;
+
+            value += iv.step;
+            if (value > JSVAL_INT_MAX) {
+                // A truncated increment wraps around, otherwise it bails out.
+                if (truncated)
+                    continue;
+                value = JSVAL_INT_MAX;
+            }
+            last = bounded ? Min(last, value) : value;
+        } else {
+            if (bound.isLowerInfinite())
+                continue;
+            if (test->op == JSOP_GT)
+                value = int64_t(bound.lower()) + 1 - test->offset;
+            else if (test->op == JSOP_GE)
+                value = int64_t(bound.lower()) - test->offset;
+            else if (test->op == JSOP_NE && iv.step == -1 && bound.isFinite() &&
+                     bound.lower() == bound.upper() && !start.isLowerInfinite() &&
+                     int64_t(start.lower()) >= int64_t(bound.upper()) - test->offset)
+                value = int64_t(bound.upper()) + 1 - test->offset;
+            else
+                continue;
+
+            value += iv.step;
+            if (value < JSVAL_INT_MIN) {
+                if (truncated)
+                    continue;
+                value = JSVAL_INT_MIN;
+            }
+            last = bounded ? Max(last, value) : value;
+        }
+        bounded = true;
+    }
 
-    if (!compareLhs->isAdd())
-        return false;
+    if (!bounded && truncated)
+        return;
+
+    if (increasing) {
+        iv.range.setLower(start.lower());
+        if (bounded && !start.isUpperInfinite())
+            iv.range.setUpper(Max(int64_t(start.upper()), last));
+    } else {
+        iv.range.setUpper(start.upper());
+        if (bounded && !start.isLowerInfinite())
+            iv.range.setLower(Min(int64_t(start.lower()), last));
+    }
 
-    MAdd *add = compareLhs->toAdd();
-
-    // The left operand of the add must be:
-    // - a phi.
-    // - an integer specialization (toInt32) of a phi.
-    // - an unbox of a phi.
-    // - a box of a phi.
-    MDefinition *addLhs = add->getOperand(0); 
-    MPhi *phi = NULL;
-
-    if (addLhs->isPhi()) {
-        phi = addLhs->toPhi();
-    } else if (addLhs->isToInt32()) {
-        if (addLhs->toToInt32()->input()->isPhi())
-            phi = addLhs->toToInt32()->input()->toPhi();
-    } else if (addLhs->isUnbox()) {
-        if (addLhs->toUnbox()->input()->isPhi())
-            phi = addLhs->toUnbox()->input()->toPhi();
-    } else if (addLhs->isBox()) {
-        if (addLhs->toBox()->getOperand(0)->isPhi())
-            phi = addLhs->toBox()->getOperand(0)->toPhi();
+#ifdef DEBUG
+    if (IonSpewEnabled(IonSpew_BCE)) {
+        IonSpewHeader(IonSpew_BCE);
+        fprintf(IonSpewFile, "Induction variable %d has range ", iv.phi->id());
+        iv.range.printRange(IonSpewFile);
+        fprintf(IonSpewFile, "\n");
     }
+#endif
+}
 
-    if (!phi)
+bool
+InductionVariableAnalysis::analyze()
+{
+    if (!recurrences_.growBy(graph_.getMaxInstructionId() + 1))
         return false;
 
-    if (phi->numOperands() != 2)
-        return false;   
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        if (!block->isLoopHeader())
+            continue;
+        for (MPhiIterator phi(block->phisBegin()); phi != block->phisEnd(); phi++) {
+            if (!findBasicInductionVariable(*phi))
+                return false;
+        }
+    }
 
-    // The phi's first operand can be:
-    // - a phi with the same conditions except for this one. 
-    // - a box of a constant.
-    // - an unbox of a constant.
-    // - a constant.
+    if (ivs_.empty())
+        return true;
 
-    MPhi *otherPhi;
-    if (phi->getOperand(0)->isPhi())
-        otherPhi = phi->getOperand(0)->toPhi();
-    else
-        otherPhi = phi;
+    // Operands are visited before their uses, but for loop phis.
+    for (ReversePostorderIterator block(graph_.rpoBegin()); block != graph_.rpoEnd(); block++) {
+        for (MInstructionIterator ins(block->begin()); ins != block->end(); ins++)
+            findDerivedInductionVariable(*ins);
+    }
 
-    MDefinition *phiOper0 = otherPhi->getOperand(0);
-    MConstant *lowerBound = NULL;
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        if (!findLoopTests(*block))
+            return false;
+    }
 
-    if (phiOper0->isBox() && phiOper0->getOperand(0)->isConstant())
-        lowerBound = phiOper0->getOperand(0)->toConstant();
-    else if (phiOper0->isConstant())
-        lowerBound = phiOper0->toConstant();
+    // Outer loops come first, the ranges of inner loops may start from the
+    // range of their induction variables.
+    for (InductionVariable *iv = ivs_.begin(); iv != ivs_.end(); iv++)
+        computeRange(*iv);
 
-    if (!lowerBound)
-        return false;
+    return true;
+}
 
-    // The add must ba a sum of the induction variable with a positive
-    // integer constant.
-    MConstant *increment = NULL;
+const InductionVariableAnalysis::Recurrence *
+InductionVariableAnalysis::recurrence(MDefinition *def) const
+{
+    if (def->id() >= recurrences_.length())
+        return NULL;
+    const Recurrence &rec = recurrences_[def->id()];
+    if (rec.iv == NoInductionVariable)
+        return NULL;
+    return &rec;
+}
 
-    if (add->lhs()->isConstant())
-        increment = add->lhs()->toConstant();
-    else if (add->rhs()->isConstant())
-        increment = add->rhs()->toConstant();
+const InductionVariableAnalysis::InductionVariable *
+InductionVariableAnalysis::inductionVariable(MDefinition *def) const
+{
+    const Recurrence *rec = recurrence(def);
+    if (!rec || ivs_[rec->iv].phi != def)
+        return NULL;
+    return &ivs_[rec->iv];
+}
 
-    if (!increment)
-        return false;
+const Range *
+InductionVariableAnalysis::recomputeRange(MDefinition *phi)
+{
+    const Recurrence *rec = recurrence(phi);
+    if (!rec || ivs_[rec->iv].phi != phi)
+        return NULL;
+
+    InductionVariable &iv = ivs_[rec->iv];
+    iv.range = Range();
+    computeRange(iv);
+    return &iv.range;
+}
 
-    if (!increment->value().isInt32())
-        return false;
+Range
+InductionVariableAnalysis::rangeOfPhi(uint32 index, MBasicBlock *block)
+{
+    Range range = ivs_[index].range;
+
+    for (LoopTest *test = tests_.begin(); test != tests_.end(); test++) {
+        if (test->iv != index || !test->successor->dominates(block))
+            continue;
+
+        Range bound = DefinitionRange(test->bound);
+        Range holds;
+        switch (test->op) {
+          case JSOP_LT:
+            if (bound.isUpperInfinite())
+                continue;
+            holds.setUpper(int64_t(bound.upper()) - 1 - test->offset);
+            break;
+          case JSOP_LE:
+            if (bound.isUpperInfinite())
+                continue;
+            holds.setUpper(int64_t(bound.upper()) - test->offset);
+            break;
+          case JSOP_GT:
+            if (bound.isLowerInfinite())
+                continue;
+            holds.setLower(int64_t(bound.lower()) + 1 - test->offset);
+            break;
+          case JSOP_GE:
+            if (bound.isLowerInfinite())
+                continue;
+            holds.setLower(int64_t(bound.lower()) - test->offset);
+            break;
+          case JSOP_NE: {
+            // Only useful when the bound is at one end of the range.
+            if (!bound.isFinite() || bound.lower() != bound.upper())
+                continue;
+            int64_t excluded = int64_t(bound.lower()) - test->offset;
+            if (!range.isUpperInfinite() && range.upper() == excluded)
+                holds.setUpper(excluded - 1);
+            else if (!range.isLowerInfinite() && range.lower() == excluded)
+                holds.setLower(excluded + 1);
+            else
+                continue;
+            break;
+          }
+          default:
+            continue;
+        }
 
-    if (increment->value().toInt32() < 0)
-        return false;
+        range = Range::intersect(&range, &holds);
+    }
 
-    // If all conditions are satisfied, the phi is the induction variable.
-    variable_ = phi;
- 
-    Value value = lowerBound->toConstant()->value();
-    if (value.isInt32()) {
-        int32 lowerBound = value.toInt32();
-        if (lowerBound >= 0) {
-            hasLowerBound_ = true;
-            range.lowerBound = lowerBound;
-        }
+    return range;
+}
+
+Range
+InductionVariableAnalysis::rangeAt(MDefinition *def, MBasicBlock *block)
+{
+    const Recurrence *rec = recurrence(def);
+    if (!rec)
+        return DefinitionRange(def);
+
+    // Derived induction variables are computed from the value of the phi
+    // where they are defined.
+    const InductionVariable &iv = ivs_[rec->iv];
+    Range range = rangeOfPhi(rec->iv, def == iv.phi ? block : def->block());
+    if (rec->scale == 1 && rec->offset == 0)
+        return Range::intersect(&range, def->range());
+
+    if (!range.isFinite())
+        return *def->range();
+
+    int64_t lower = int64_t(rec->scale) * range.lower() + rec->offset;
+    int64_t upper = int64_t(rec->scale) * range.upper() + rec->offset;
+    if (rec->scale < 0) {
+        int64_t tmp = lower;
+        lower = upper;
+        upper = tmp;
     }
 
-    if (compare->rhs()->isConstant()) {
-        Value value = compare->rhs()->toConstant()->value();
+    // Truncated operations may have wrapped around.
+    if (lower < JSVAL_INT_MIN || upper > JSVAL_INT_MAX)
+        return *def->range();
 
-        if (value.isInt32()) {
-            int32 upperBound = value.toInt32();
+    // Ranges found by RangeAnalysis, if it ran, hold as well.
+    Range derived(lower, upper);
+    return Range::intersect(&derived, def->range());
+}
 
-            if (upperBound >= 0) {
-                hasUpperBound_ = true;
+bool
+InductionVariableAnalysis::isLessThan(MDefinition *def, MBasicBlock *block, MDefinition *bound)
+{
+    const Recurrence *rec = recurrence(def);
+    if (!rec || rec->scale != 1)
+        return false;
 
-                // The upper bound must guarantee the LT relation.
-                if (compare->jsop() == JSOP_LE)
-                    range.upperBound = (upperBound - 1);
-                else
-                    range.upperBound = upperBound;
-            }
-        }
+    // def is "phi + offset", and a test "phi + testOffset < bound" holds.
+    MBasicBlock *at = def == ivs_[rec->iv].phi ? block : def->block();
+    for (LoopTest *test = tests_.begin(); test != tests_.end(); test++) {
+        if (test->iv != rec->iv || test->bound != bound || !test->successor->dominates(at))
+            continue;
+        if (test->op == JSOP_LT && rec->offset <= test->offset)
+            return true;
+        if (test->op == JSOP_LE && rec->offset < test->offset)
+            return true;
     }
-    isDoWhile_ = true;
-        
-    return true;
+    return false;
 }
 
-MDefinition*
-InductionVariable::variable()
+MBasicBlock *
+InductionVariableAnalysis::loopHeader(MDefinition *def) const
 {
-    return variable_;
+    const Recurrence *rec = recurrence(def);
+    if (!rec)
+        return NULL;
+    return ivs_[rec->iv].phi->block();
 }
 
 bool
-InductionVariable::rangeIsValid(MBasicBlock *block)
+InductionVariableAnalysis::symbolicBound(MDefinition *def, MBasicBlock *block, bool upper,
+                                         MDefinition **bound, int32 *offset)
 {
-    if (!variable_)
-        return false;
-
-    // The induction variable range is valid only within the loop body,
-    // therefore, we must have: headerId < blockId <= backEdgeId.
-
-    if (!variable_->block()->isLoopHeader())
+    const Recurrence *rec = recurrence(def);
+    if (!rec || rec->scale != 1)
         return false;
 
-    uint32 blockId = block->id();
-    uint32 headerId = variable_->block()->id();
-    uint32 backEdgeId = variable_->block()->backedge()->id();
+    const InductionVariable &iv = ivs_[rec->iv];
+    MBasicBlock *header = iv.phi->block();
+    MBasicBlock *at = def == iv.phi ? block : def->block();
 
-    if ((headerId < blockId) && (blockId <= backEdgeId))
+    // The phi never goes back past its start value, unless its increment
+    // wraps around.
+    if ((iv.step > 0) != upper && !IsIncrementTruncated(iv.increment)) {
+        *bound = iv.start;
+        *offset = rec->offset;
         return true;
-    if (isDoWhile() && (headerId <= blockId) && (blockId <= backEdgeId))
+    }
+
+    // Otherwise, a test comparing "phi + testOffset" to a definition
+    // computed before the loop must hold where |def| is used.
+    for (LoopTest *test = tests_.begin(); test != tests_.end(); test++) {
+        if (test->iv != rec->iv || !test->successor->dominates(at))
+            continue;
+        if (IsInLoop(header, test->bound->block()))
+            continue;
+
+        int64_t value = int64_t(rec->offset) - test->offset;
+        if (upper && test->op == JSOP_LT)
+            value -= 1;
+        else if (!upper && test->op == JSOP_GT)
+            value += 1;
+        else if (test->op != (upper ? JSOP_LE : JSOP_GE))
+            continue;
+
+        if (value < JSVAL_INT_MIN || value > JSVAL_INT_MAX)
+            continue;
+
+        *bound = test->bound;
+        *offset = int32(value);
         return true;
+    }
 
     return false;
 }
 
 bool
-InductionVariable::hasLowerBound()
+InductionVariableAnalysis::maxTripCount(MBasicBlock *header, uint32 *count)
 {
-    return hasLowerBound_;
-}
-
-bool
-InductionVariable::hasUpperBound()
-{
-    return hasUpperBound_;
-}
-
-int32
-InductionVariable::lowerBound()
-{
-    JS_ASSERT(hasLowerBound_);
-
-    return range.lowerBound;
-}
+    bool bounded = false;
+    int64_t best = 0;
+
+    for (InductionVariable *iv = ivs_.begin(); iv != ivs_.end(); iv++) {
+        if (iv->phi->block() != header)
+            continue;
+
+        uint32 index = iv - ivs_.begin();
+        Range start = rangeAt(iv->start, preheader(*iv));
+
+        // The backedge is only taken by values of the phi passing every test
+        // leaving the loop.
+        for (LoopTest *test = tests_.begin(); test != tests_.end(); test++) {
+            if (test->iv != index || !test->exits)
+                continue;
+
+            Range bound = DefinitionRange(test->bound);
+            int64_t span;
+            if (iv->step > 0) {
+                if (start.isLowerInfinite() || bound.isUpperInfinite())
+                    continue;
+                if (test->op == JSOP_LT)
+                    span = int64_t(bound.upper()) - 1 - test->offset - start.lower();
+                else if (test->op == JSOP_LE)
+                    span = int64_t(bound.upper()) - test->offset - start.lower();
+                else
+                    continue;
+            } else {
+                if (start.isUpperInfinite() || bound.isLowerInfinite())
+                    continue;
+                if (test->op == JSOP_GT)
+                    span = int64_t(start.upper()) - (int64_t(bound.lower()) + 1 - test->offset);
+                else if (test->op == JSOP_GE)
+                    span = int64_t(start.upper()) - (int64_t(bound.lower()) - test->offset);
+                else
+                    continue;
+            }
 
-int32
-InductionVariable::upperBound()
-{
-    JS_ASSERT(hasUpperBound_);
+            int64_t step = (iv->step > 0) ? iv->step : -int64_t(iv->step);
+            int64_t trips = (span < 0) ? 0 : span / step + 1;
+            best = bounded ? Min(best, trips) : trips;
+            bounded = true;
+        }
+    }
 
-    return range.upperBound;
-}
+    if (!bounded || best > int64_t(uint32(-1)))
+        return false;
 
-bool
-InductionVariable::isDoWhile() {
-    return isDoWhile_;
+    *count = uint32(best);
+    return true;
 }
@@ -1,68 +1,144 @@
 /* Authors:
  * Igor Rafael [igor@dcc.ufmg.br]
  * Pericles Alves [periclesrafael@dcc.ufmg.br]
- */ 
+ */
 
 #ifndef jsion_include_indvar_h__
 #define jsion_include_indvar_h__
 
+#include "IonAllocPolicy.h"
 #include "MIR.h"
 #include "MIRGraph.h"
+#include "RangeAnalysis.h"
 
 namespace js {
 namespace ion {
 
-class InductionVariable
+/**
+  * Induction variable analysis, in the spirit of scalar evolution.
+  *
+  * Basic induction variables are integer loop phis whose value coming from
+  * the backedge is the phi plus a constant step: {start, +, step}. Integer
+  * additions, subtractions and multiplications of an induction variable by
+  * constants are derived induction variables, affine functions of a basic
+  * one. Any number of them may live in the same loop.
+  *
+  * Comparisons of induction variables made in a loop give bounds to the
+  * blocks dominated by the branch where they hold. Comparisons which leave
+  * the loop when they fail, wherever they are in the loop, bound every value
+  * the phi takes, and the number of iterations of the loop.
+  *
+  * Since it relies on block ids to find the blocks of a loop, and on the
+  * dominator tree, this analysis must run after RenumberBlocks and
+  * BuildDominatorTree.
+  */
+class InductionVariableAnalysis
 {
-    // Basic integer range such that "variable >= lowerBound" and "variable <
-    // upperBound".
-    // The range is valid only outside the induction variable block.
-    struct Range {
-        int32 lowerBound;
-        int32 upperBound;
-   };
+  public:
+    static const uint32 NoInductionVariable = uint32(-1);
+
+    // A basic induction variable.
+    struct InductionVariable
+    {
+        MPhi *phi;
+
+        // The value of the phi when the loop is entered.
+        MDefinition *start;
+
+        // The addition or subtraction computing the next value of the phi.
+        MInstruction *increment;
+        int32 step;
+
+        // Values the phi may have, wherever it is used.
+        Range range;
+    };
+
+    // A comparison "iv + offset <op> bound" of the basic induction variable
+    // |iv|, which holds in the blocks dominated by |successor|.
+    struct LoopTest
+    {
+        uint32 iv;
+        MBasicBlock *successor;
+        JSOp op;
+        MDefinition *bound;
+        int32 offset;
+
+        // Whether the loop is left when the comparison does not hold.
+        bool exits;
+    };
+
+    // An affine function "scale * iv + offset" of a basic induction variable.
+    struct Recurrence
+    {
+        uint32 iv;
+        int32 scale;
+        int32 offset;
+
+        Recurrence()
+          : iv(NoInductionVariable),
+            scale(0),
+            offset(0)
+        { }
+    };
+
   private:
-    MBasicBlock *block;
-    
-    MDefinition *variable_; // The actual induction variable.
-
-    /**
-      * Indicates if the variable is known to have fixed bounds. These
-      * bounds are not valid either in the variable block or outside the
-      * loop body.
-      */
-    bool hasLowerBound_;
-    bool hasUpperBound_;
-    bool isDoWhile_;
-
-    Range range;
-
-    /**
-      * Look for induction variable patterns in the given block. All
-      * patterns are integer ones, since it would not be worth it to handle
-      * other types.
-      * These functions also extract the induction variable range.
-      */
-    bool extractUBCSPattern(); // Upper Bounded Continuous Sum pattern.
-    bool extractUBCSPatternDoWhile();
-    
+    MIRGraph &graph_;
+
+    Vector<InductionVariable, 4, IonAllocPolicy> ivs_;
+    Vector<LoopTest, 4, IonAllocPolicy> tests_;
+
+    // Recurrences of definitions, indexed by definition id.
+    Vector<Recurrence, 0, IonAllocPolicy> recurrences_;
+
+    bool findBasicInductionVariable(MPhi *phi);
+    void findDerivedInductionVariable(MDefinition *def);
+    bool findLoopTests(MBasicBlock *block);
+    bool addLoopTest(MTest *test, MBasicBlock *successor, JSOp op,
+                     MDefinition *iv, MDefinition *bound);
+    void computeRange(InductionVariable &iv);
+
+    MBasicBlock *preheader(const InductionVariable &iv) const;
+    Range rangeOfPhi(uint32 index, MBasicBlock *block);
+
   public:
-    InductionVariable(MBasicBlock *block);
+    InductionVariableAnalysis(MIRGraph &graph);
+    bool analyze();
+
+    // Returns the recurrence of the given definition, or NULL if it is not
+    // an induction variable.
+    const Recurrence *recurrence(MDefinition *def) const;
+
+    // Returns the basic induction variable of the given loop phi, if any.
+    const InductionVariable *inductionVariable(MDefinition *def) const;
+
+    // Returns the basic induction variable of which |rec| is a recurrence.
+    const InductionVariable &basicInductionVariable(const Recurrence &rec) const {
+        return ivs_[rec.iv];
+    }
+
+    // Computes again the range of the given basic induction variable, after
+    // the ranges of its start value or of its bounds have changed.
+    const Range *recomputeRange(MDefinition *phi);
+
+    // Computes the values |def| may have when it is used in |block|.
+    Range rangeAt(MDefinition *def, MBasicBlock *block);
 
-    bool extractPattern();
+    // Whether |def| is known to be less than |bound| when used in |block|.
+    bool isLessThan(MDefinition *def, MBasicBlock *block, MDefinition *bound);
 
-    MDefinition *variable();
+    // Returns the header of the loop in which the basic induction variable of
+    // |def| is defined, or NULL if |def| is not an induction variable.
+    MBasicBlock *loopHeader(MDefinition *def) const;
 
-    // Verifies if the induction variable range is valid in the given block.
-    // Since it relies on block IDs, this pass must run after Renumber
-    // Blocks.
-    bool rangeIsValid(MBasicBlock *block);
+    // Finds a definition |bound|, computed before the loop of |def|, and a
+    // constant |offset| such that |def| <= bound + offset, if |upper| is true,
+    // or |def| >= bound + offset otherwise, whenever |def| is used in |block|.
+    bool symbolicBound(MDefinition *def, MBasicBlock *block, bool upper,
+                       MDefinition **bound, int32 *offset);
 
-    bool hasLowerBound();
-    bool hasUpperBound();
-    int32 lowerBound();
-    int32 upperBound();
-    bool isDoWhile();
+    // Computes the maximum number of times the backedge of the loop starting
+    // at |header| is taken. Returns false if it cannot be bounded.
+    bool maxTripCount(MBasicBlock *header, uint32 *count);
 };
 
 } // namespace ion
@@ -8,6 +8,7 @@
 #include "Ion.h"
 #include "IonAnalysis.h"
 #include "IonBuilder.h"
+#include "IonCaches.h"
 #include "IonLinker.h"
 #include "IonSpewer.h"
 #include "IonProfiler.h"
@@ -17,13 +18,21 @@
 #include "ValueNumbering.h"
 #include "EdgeCaseAnalysis.h"
 #include "RangeAnalysis.h"
+#include "SCCP.h"
 #include "OverflowTestElimination.h"
-#include "CP.h"
 #include "BCE.h"
+#include "LoopUnrolling.h"
+#include "LoopVectorization.h"
+#include "LInversion.h"
+#include "EscapeAnalysis.h"
+#include "DeadStoreElimination.h"
+#include "ParameterSpecialization.h"
+#include "PSVersionCache.h"
 #include "LinearScan.h"
 #include "jscompartment.h"
 #include "IonCompartment.h"
 #include "CodeGenerator.h"
+#include "CompilerThread.h"
 
 #if defined(JS_CPU_X86)
 # include "x86/Lowering-x86.h"
@@ -127,7 +136,10 @@ IonCompartment::IonCompartment()
     bailoutHandler_(NULL),
     argumentsRectifier_(NULL),
     invalidator_(NULL),
-    functionWrappers_(NULL)
+    functionWrappers_(NULL),
+    getPropertyTable_(NULL),
+    setPropertyTable_(NULL),
+    nextScriptId_(0)
 {
 }
 
@@ -194,6 +206,28 @@ IonCompartment::sweep(FreeOp *fop)
 
     // Sweep cache of VM function implementations.
     functionWrappers_->sweep(fop);
+
+    // Entries of the megamorphic tables may refer to dead shapes and types.
+    if (getPropertyTable_)
+        getPropertyTable_->purge();
+    if (setPropertyTable_)
+        setPropertyTable_->purge();
+}
+
+MegamorphicCache *
+IonCompartment::getPropertyTable(JSContext *cx)
+{
+    if (!getPropertyTable_)
+        getPropertyTable_ = cx->new_<MegamorphicCache>();
+    return getPropertyTable_;
+}
+
+MegamorphicCache *
+IonCompartment::setPropertyTable(JSContext *cx)
+{
+    if (!setPropertyTable_)
+        setPropertyTable_ = cx->new_<MegamorphicCache>();
+    return setPropertyTable_;
 }
 
 IonCode *
@@ -225,6 +259,8 @@ IonCompartment::getBailoutTable(JSContext *cx, const FrameSizeClass &frameClass)
 IonCompartment::~IonCompartment()
 {
     Foreground::delete_(functionWrappers_);
+    Foreground::delete_(getPropertyTable_);
+    Foreground::delete_(setPropertyTable_);
 }
 
 IonActivation::IonActivation(JSContext *cx, StackFrame *fp)
@@ -390,8 +426,14 @@ IonScript::IonScript()
     safepointsStart_(0),
     safepointsSize_(0),
     refcount_(0),
-    slowCallCount(0)
+    id_(0),
+    slowCallCount(0),
+    numEntries_(0),
+    numBailouts_(0),
+    snapshotBailouts_(NULL)
 {
+    for (uint32 i = 0; i < NUM_BAILOUT_KINDS; i++)
+        bailoutKindCounts_[i] = 0;
 }
 static const int DataAlignment = 4;
 IonScript *
@@ -433,6 +475,7 @@ IonScript::New(JSContext *cx, uint32 frameSlots, uint32 frameSize, size_t snapsh
 
     IonScript *script = reinterpret_cast<IonScript *>(buffer);
     new (script) IonScript();
+    script->id_ = cx->compartment->ionCompartment()->nextScriptId();
 
     uint32 offsetCursor = sizeof(IonScript);
 
@@ -653,9 +696,56 @@ IonScript::Trace(JSTracer *trc, IonScript *script)
 void
 IonScript::Destroy(FreeOp *fop, IonScript *script)
 {
+    if (script->snapshotBailouts_)
+        fop->delete_(script->snapshotBailouts_);
     fop->free_(script);
 }
 
+namespace js {
+namespace ion {
+
+class SnapshotBailoutCounts
+  : public HashMap<SnapshotOffset, uint32, DefaultHasher<SnapshotOffset>, SystemAllocPolicy>
+{ };
+
+} // namespace ion
+} // namespace js
+
+void
+IonScript::noteBailout(SnapshotOffset snapshot, BailoutKind kind)
+{
+    JS_ASSERT(uint32(kind) < NUM_BAILOUT_KINDS);
+    numBailouts_++;
+    bailoutKindCounts_[kind]++;
+
+    // Bailouts are rare enough that failing to count one does not matter.
+    if (!snapshotBailouts_) {
+        snapshotBailouts_ = OffTheBooks::new_<SnapshotBailoutCounts>();
+        if (!snapshotBailouts_)
+            return;
+        if (!snapshotBailouts_->init()) {
+            Foreground::delete_(snapshotBailouts_);
+            snapshotBailouts_ = NULL;
+            return;
+        }
+    }
+
+    SnapshotBailoutCounts::AddPtr p = snapshotBailouts_->lookupForAdd(snapshot);
+    if (p)
+        p->value++;
+    else
+        snapshotBailouts_->add(p, snapshot, 1);
+}
+
+uint32
+IonScript::numBailoutsAt(SnapshotOffset snapshot) const
+{
+    if (!snapshotBailouts_)
+        return 0;
+    SnapshotBailoutCounts::Ptr p = snapshotBailouts_->lookup(snapshot);
+    return p ? p->value : 0;
+}
+
 void
 IonScript::toggleBarriers(bool enabled)
 {
@@ -683,6 +773,8 @@ ion::ToggleBarriers(JSCompartment *comp, bool needs)
         JSScript *script = i.get<JSScript>();
         if (script->hasIonScript())
             script->ion->toggleBarriers(needs);
+        if (script->psVersions)
+            script->psVersions->toggleBarriers(needs);
     }
 }
 
@@ -699,7 +791,12 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
 
     IonSpewPass("BuildSSA");
     IonProfileSpewTimer("BuildSSA");
+    return true;
+}
 
+static bool
+OptimizeMIR(IonBuilder &builder, MIRGraph &graph)
+{
     // Note: don't call AssertGraphCoherency before SplitCriticalEdges,
     // the graph is not in RPO at this point.
     if (js_IonOptions.cp) {
@@ -707,63 +804,29 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         CheckInstructionsWithConstantOperands(graph);
         IonSpew(IonSpew_CP, " [End of analysis]");
     }
-    bool updated;
-//    int iteration = 0;
-//    do{
-//        updated = false;
-
-//        IonSpew(IonSpew_Scripts, "Starting iteration %d", iteration);
-        if (js_IonOptions.cp) {
-            IonProfileStartTimer();
-            if (!EliminatePhis(graph))
-                return false;
-            IonProfileStopTimer();
-            IonProfileSpewTimer("Eliminate Phis First");
-
-            CP cp(graph);
-            IonProfileStartTimer();
-            SAVE_ACTUAL_SCRIPT(cp,builder.script);
-            updated |= cp.analyze();
-            IonProfileStopTimer();
-
-            IonSpewPass("CP");
-            IonProfileSpewTimer("CP");
-        }
-
-        if (js_IonOptions.dcec) {
-            IonProfileStartTimer();
-            if (!DCEConditionals(graph))
-                return false;
-            if (!EliminateDeadCode(graph))
-                return false;
+    if (js_IonOptions.cp || js_IonOptions.dcec) {
+        IonProfileStartTimer();
+        if (!EliminatePhis(graph))
+            return false;
+        IonProfileStopTimer();
+        IonProfileSpewTimer("Eliminate Phis First");
 
-            IonProfileStopTimer();
+        // Folding constants and removing the branches which are never taken
+        // are done together, so that each of them benefits from the other.
+        SCCP sccp(graph, js_IonOptions.cp, js_IonOptions.dcec);
+        IonProfileStartTimer();
+        if (!sccp.analyze())
+            return false;
+        if (!EliminateDeadCode(graph))
+            return false;
+        IonProfileStopTimer();
 
-            IonSpewPass("DCEConditionals");
-            IonProfileSpewTimer("DCEConditionals");
-        }
+        IonSpewPass("SCCP");
+        IonProfileSpewTimer("SCCP");
 
-//        if (updated && js_IonOptions.cp && js_IonOptions.dcec) {
-//            // This pass also removes copies.
-//            IonProfileStartTimer();
-//            if (!ApplyTypeInformation(graph))
-//                return false;
-//            IonProfileStopTimer();
-//            IonSpewPass("Apply types");
-//            IonProfileSpewTimer("Apply types");
-//        }
-//        if (js_IonOptions.bcoal) {
-//            IonProfileStartTimer();
-//            if (!CoalesceBlocks(graph))
-//                return false;
-//            IonProfileStopTimer();
-//
-//            IonSpewPass("BlockCoalescing");
-//            IonProfileSpewTimer("BlockCoalescing");
-//        }
-//        iteration++;
-//    }while(updated);
-//    IonSpew(IonSpew_Scripts, "Iterations: %d", iteration);
+        if (builder.shouldCancel("SCCP"))
+            return false;
+    }
 
     IonProfileStartTimer();
     if (!SplitCriticalEdges(&builder, graph))
@@ -774,6 +837,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
     IonProfileSpewTimer("Split Critical Edges");
     AssertGraphCoherency(graph);
 
+    if (builder.shouldCancel("Split Critical Edges"))
+        return false;
+
     IonProfileStartTimer();
     if (!RenumberBlocks(graph))
         return false;
@@ -783,6 +849,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
     IonProfileSpewTimer("Renumber Blocks");
     AssertGraphCoherency(graph);
 
+    if (builder.shouldCancel("Renumber Blocks"))
+        return false;
+
     if (!BuildDominatorTree(graph))
         return false;
     // No spew: graph not changed.
@@ -796,6 +865,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
     IonProfileSpewTimer("Eliminate phis");
     AssertGraphCoherency(graph);
 
+    if (builder.shouldCancel("Eliminate phis"))
+        return false;
+
     if (!BuildPhiReverseMapping(graph))
         return false;
     // No spew: graph not changed.
@@ -810,11 +882,71 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
     IonProfileSpewTimer("Apply types");
     AssertGraphCoherency(graph);
 
+    if (builder.shouldCancel("Apply types"))
+        return false;
+
     if (js_IonOptions.cp) {
         IonSpew(IonSpew_CP, " [Analyzing instructions after ApplyTypes]");
         CheckInstructionsWithConstantOperands(graph);
         IonSpew(IonSpew_CP, " [End of analysis]");
     }
+
+    // Unrolled loops are left as straight-line code, in which GVN folds the
+    // induction variables to constants.
+    if (js_IonOptions.unroll) {
+        LoopUnrolling unrolling(graph);
+        IonProfileStartTimer();
+        if (!unrolling.analyze())
+            return false;
+        IonProfileStopTimer();
+
+        IonSpewPass("Loop Unrolling");
+        IonProfileSpewTimer("Loop Unrolling");
+        AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Loop Unrolling"))
+            return false;
+    }
+
+    // Inverted loops test their condition on the back edge, so that each
+    // iteration takes a single branch.
+    if (js_IonOptions.linv) {
+        LInversion inversion(graph);
+        IonProfileStartTimer();
+        if (!inversion.analyze())
+            return false;
+        IonProfileStopTimer();
+
+        IonSpewPass("Loop Inversion");
+        IonProfileSpewTimer("Loop Inversion");
+        AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Loop Inversion"))
+            return false;
+    }
+
+    if (js_IonOptions.linvA) {
+        LInversion inversion(graph);
+        inversion.analyzeEmptyBlocks();
+    }
+
+    // Loads of the literals removed are replaced by the values stored, which
+    // GVN and range analysis see through.
+    if (js_IonOptions.escapeAnalysis) {
+        EscapeAnalysis escape(graph);
+        IonProfileStartTimer();
+        if (!escape.analyze())
+            return false;
+        IonProfileStopTimer();
+
+        IonSpewPass("Escape Analysis");
+        IonProfileSpewTimer("Escape Analysis");
+        AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Escape Analysis"))
+            return false;
+    }
+
     // Alias analysis is required for LICM and GVN so that we don't move
     // loads across stores.
     if (js_IonOptions.licm || js_IonOptions.gvn) {
@@ -827,6 +959,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonSpewPass("Alias analysis");
         IonProfileSpewTimer("Alias analysis");
         AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Alias analysis"))
+            return false;
     }
 
     if (js_IonOptions.edgeCaseAnalysis) {
@@ -839,6 +974,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonSpewPass("Edge Case Analysis (Early)");
         IonProfileSpewTimer("Edge Case Analysis (Early)");
         AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Edge Case Analysis (Early)"))
+            return false;
     }
 
     if (js_IonOptions.gvn) {
@@ -851,6 +989,25 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonSpewPass("GVN");
         IonProfileSpewTimer("GVN");
         AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("GVN"))
+            return false;
+    }
+
+    // GVN merges the objects, slots and elements which stores write.
+    if (js_IonOptions.dse) {
+        DeadStoreElimination dse(graph);
+        IonProfileStartTimer();
+        if (!dse.analyze())
+            return false;
+        IonProfileStopTimer();
+
+        IonSpewPass("Dead Store Elimination");
+        IonProfileSpewTimer("Dead Store Elimination");
+        AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Dead Store Elimination"))
+            return false;
     }
 
     if (js_IonOptions.rangeAnalysis) {
@@ -864,6 +1021,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonProfileSpewTimer("Beta");
         AssertGraphCoherency(graph);
 
+        if (builder.shouldCancel("Beta"))
+            return false;
+
         IonProfileStartTimer();
         if (!r.analyze())
             return false;
@@ -873,6 +1033,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonProfileSpewTimer("Range Analysis");
         AssertGraphCoherency(graph);
 
+        if (builder.shouldCancel("Range Analysis"))
+            return false;
+
         IonProfileStartTimer();
         if (!r.removeBetaNobes())
             return false;
@@ -881,6 +1044,21 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonSpewPass("De-Beta");
         IonProfileSpewTimer("De-Beta");
         AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("De-Beta"))
+            return false;
+
+        IonProfileStartTimer();
+        if (!r.eliminateConversions())
+            return false;
+        IonProfileStopTimer();
+
+        IonSpewPass("Conversion Elimination");
+        IonProfileSpewTimer("Conversion Elimination");
+        AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Conversion Elimination"))
+            return false;
     }
 
     IonProfileStartTimer();
@@ -892,6 +1070,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
     IonProfileSpewTimer("DCE");
     AssertGraphCoherency(graph);
 
+    if (builder.shouldCancel("DCE"))
+        return false;
+
     if (js_IonOptions.licm) {
         LICM licm(graph);
         IonProfileStartTimer();
@@ -902,6 +1083,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonSpewPass("LICM");
         IonProfileSpewTimer("LICM");
         AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("LICM"))
+            return false;
     }
 
     if (js_IonOptions.bce) {
@@ -914,6 +1098,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonSpewPass("BCE");
         IonProfileSpewTimer("BCE");
         AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("BCE"))
+            return false;
     }
 
     if (js_IonOptions.edgeCaseAnalysis) {
@@ -926,6 +1113,9 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
         IonSpewPass("Edge Case Analysis (Late)");
         IonProfileSpewTimer("Edge Case Analysis (Late)");
         AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Edge Case Analysis (Late)"))
+            return false;
     }
 
     // Note: bounds check elimination has to run after all other passes that
@@ -940,21 +1130,52 @@ BuildMIR(IonBuilder &builder, MIRGraph &graph)
     IonSpewPass("Bounds Check Elimination");
     IonProfileSpewTimer("Bounds Check Elimination");
     AssertGraphCoherency(graph);
-    
-//    if (js_IonOptions.ota) {
-//        OverflowTestElimination ote(graph);
-//        ote.eliminateOverflowTests();
-//        IonSpewPass("Overflow tests elimination");
-//        AssertGraphCoherency(graph);
-//    }
+
+    if (builder.shouldCancel("Bounds Check Elimination"))
+        return false;
+
+#ifdef JS_CPU_X64
+    // Loads and stores only use the index of the loop directly once the
+    // uses of their bounds checks have been replaced.
+    if (js_IonOptions.vectorize) {
+        LoopVectorization vectorization(graph);
+        IonProfileStartTimer();
+        if (!vectorization.analyze())
+            return false;
+        IonProfileStopTimer();
+
+        IonSpewPass("Loop Vectorization");
+        IonProfileSpewTimer("Loop Vectorization");
+        AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Loop Vectorization"))
+            return false;
+    }
+#endif
+
+    // Overflow tests are removed last, as moving an instruction may place it
+    // out of the blocks where the ranges of its operands are known.
+    if (js_IonOptions.ota) {
+        OverflowTestElimination ote(graph);
+        IonProfileStartTimer();
+        if (!ote.analyze())
+            return false;
+        IonProfileStopTimer();
+
+        IonSpewPass("Overflow Test Elimination");
+        IonProfileSpewTimer("Overflow Test Elimination");
+        AssertGraphCoherency(graph);
+
+        if (builder.shouldCancel("Overflow Test Elimination"))
+            return false;
+    }
 
     return true;
 }
 
 static bool
-GenerateCode(IonBuilder &builder, MIRGraph &graph)
+GenerateLIR(IonBuilder &builder, MIRGraph &graph, LIRGraph &lir)
 {
-    LIRGraph lir(graph);
     LIRGenerator lirgen(&builder, graph, lir);
     IonProfileStartTimer();
     if (!lirgen.generate())
@@ -964,6 +1185,9 @@ GenerateCode(IonBuilder &builder, MIRGraph &graph)
     IonSpewPass("Generate LIR");
     IonProfileSpewTimer("Generate LIR");
 
+    if (builder.shouldCancel("Generate LIR"))
+        return false;
+
     if (js_IonOptions.lsra) {
         LinearScanAllocator regalloc(&lirgen, lir);
         IonProfileStartTimer();
@@ -975,6 +1199,12 @@ GenerateCode(IonBuilder &builder, MIRGraph &graph)
         IonProfileSpewTimer("Allocate Registers");
     }
 
+    return true;
+}
+
+static bool
+GenerateCode(IonBuilder &builder, LIRGraph &lir)
+{
     CodeGenerator codegen(&builder, lir);
     if (!codegen.generate())
         return false;
@@ -995,10 +1225,10 @@ GenerateCode(IonBuilder &builder, MIRGraph &graph)
         char dumpcmd[] = "objdump -D -b binary -m i386:x86-64 -Maddr64 /tmp/asm.bin | cut -f 1,3 |"
                          "sed '/^$/d' | sed 's/^[ ]*//g'";
 #endif
-        StackFrame *fp = GetIonContext()->cx->fp();
+        IonCode *method = builder.script->ion->method();
         FILE *fptr = fopen("/tmp/asm.bin", "w+b");
-        uint8 *raw = fp->script()->ion->method()->raw();
-        fwrite(raw, 1, fp->script()->ion->method()->instructionsSize(), fptr);
+        uint8 *raw = method->raw();
+        fwrite(raw, 1, method->instructionsSize(), fptr);
         fclose(fptr);
         FILE *disasm = popen(dumpcmd, "r");
 
@@ -1035,7 +1265,14 @@ TestCompiler(IonBuilder &builder, MIRGraph &graph)
     if (!BuildMIR(builder, graph))
         return false;
 
-    if (!GenerateCode(builder, graph))
+    if (!OptimizeMIR(builder, graph))
+        return false;
+
+    LIRGraph lir(graph);
+    if (!GenerateLIR(builder, graph, lir))
+        return false;
+
+    if (!GenerateCode(builder, lir))
         return false;
 
     IonSpewEndFunction();
@@ -1077,6 +1314,206 @@ IonCompile(JSContext *cx, JSScript *script, JSFunction *fun, jsbytecode *osrPc,
     return true;
 }
 
+#ifdef JS_THREADSAFE
+
+static bool InitVersionKey(JSContext *cx, JSScript *script, jsbytecode *osrPc,
+                           PSVersionCache::Key *key);
+static bool NoteCompiledVersion(JSContext *cx, JSScript *script, PSVersionCache::Key *key);
+
+// Whether compilations may be finished off the main thread.
+static bool
+OffThreadCompilationEnabled(JSContext *cx)
+{
+    // GCs throw the pending compilations away, so none is started during an
+    // incremental one.
+    return js_IonOptions.parallelCompilation &&
+           cx->runtime->gcIncrementalState == gc::NO_INCREMENTAL;
+}
+
+static CompilerThread *
+EnsureCompilerThread(JSContext *cx)
+{
+    JSRuntime *rt = cx->runtime;
+    if (rt->ionCompilerThread)
+        return rt->ionCompilerThread;
+
+    CompilerThread *thread = cx->new_<CompilerThread>(rt);
+    if (!thread)
+        return NULL;
+    if (!thread->init()) {
+        thread->finish();
+        Foreground::delete_(thread);
+        return NULL;
+    }
+
+    rt->ionCompilerThread = thread;
+    return thread;
+}
+
+// Builds the MIR of |script| on the main thread, and queues the rest of the
+// compilation on the compiler thread. The script keeps running in the other
+// engines until its code is linked.
+static bool
+IonCompileOffThread(JSContext *cx, JSScript *script, JSFunction *fun, jsbytecode *osrPc,
+                    bool constructing)
+{
+    CompilerThread *thread = EnsureCompilerThread(cx);
+    if (!thread)
+        return false;
+
+    if (!cx->compartment->ensureIonCompartmentExists(cx))
+        return false;
+
+    ScopedDeletePtr<OffThreadCompilation> compilation(cx->new_<OffThreadCompilation>(script));
+    if (!compilation)
+        return false;
+
+    IonContext ictx(cx, cx->compartment, &compilation->temp);
+    CompileInfo *info = compilation->alloc.new_<CompileInfo>(script, fun, osrPc, constructing);
+    if (!info)
+        return false;
+
+    {
+        types::AutoEnterTypeInference enter(cx, true);
+        if (!compilation->oracle.init(cx, script))
+            return false;
+
+        types::AutoEnterCompilation enterCompiler(cx, types::AutoEnterCompilation::Ion);
+        if (!enterCompiler.init(script, false, 0))
+            return false;
+        compilation->recompileInfo = enterCompiler.info;
+        AutoCompilerRoots roots(script->compartment()->rt);
+
+        compilation->builder = cx->new_<IonBuilder>(cx, &compilation->temp, &compilation->graph,
+                                                    &compilation->oracle, info);
+        if (!compilation->builder)
+            return false;
+        if (!compilation->builder->build()) {
+            IonSpew(IonSpew_Abort, "IM Compilation failed.");
+            return false;
+        }
+        compilation->roots = cx->runtime->ionCompilerRootList;
+    }
+
+    // The frame the MIR has been specialized to is gone by the time the code
+    // is linked, so the key of the version is made now.
+    if (js_IonOptions.ps) {
+        compilation->specialized = script->isParameterSpecialized;
+        script->isParameterSpecialized = false;
+        if (compilation->specialized &&
+            !InitVersionKey(cx, script, osrPc, &compilation->versionKey))
+        {
+            return false;
+        }
+    }
+
+    // The output of the compilation has no code yet: the type changes it is
+    // notified of from now on throw the compilation away when it finishes.
+    compilation->recompileInfo.compilerOutput(cx)->pendingCompile = true;
+    script->ionCompilingOffThread = true;
+
+    if (!thread->submit(compilation))
+        return false;
+
+    IonSpew(IonSpew_OffThread, "Queued compilation of %s:%d", script->filename, script->lineno);
+    compilation.forget();
+    return true;
+}
+
+bool
+CompileOffThread(OffThreadCompilation *compilation)
+{
+    IonContext ictx(NULL, compilation->script->compartment(), &compilation->temp);
+    IonBuilder &builder = *compilation->builder;
+    MIRGraph &graph = compilation->graph;
+
+    // Graphs are not spewed off the main thread, see IonSpewPass.
+    if (!OptimizeMIR(builder, graph))
+        return false;
+
+    return GenerateLIR(builder, graph, compilation->lir);
+}
+
+// Generates the code of a compilation finished off the main thread, unless
+// the types it depends on have changed, or the script cannot be compiled
+// anymore.
+static void
+LinkOffThreadCompilation(JSContext *cx, OffThreadCompilation *compilation)
+{
+    JSScript *script = compilation->script;
+    types::CompilerOutput *co = compilation->recompileInfo.compilerOutput(cx);
+
+    if (!compilation->succeeded) {
+        IonSpew(IonSpew_Abort, "IM Compilation failed.");
+        ForbidCompilation(script);
+        return;
+    }
+    if (!co->pendingCompile || script->ion || !IsEnabled(cx)) {
+        IonSpew(IonSpew_OffThread, "Discarded compilation of %s:%d",
+                script->filename, script->lineno);
+        return;
+    }
+
+    IonContext ictx(cx, cx->compartment, &compilation->temp);
+    types::AutoEnterTypeInference enter(cx, true);
+    AutoCompilerRoots roots(cx->runtime);
+    cx->runtime->ionCompilerRootList = compilation->roots;
+
+    script->isParameterSpecialized = compilation->specialized;
+    if (!GenerateCode(*compilation->builder, compilation->lir)) {
+        IonSpew(IonSpew_Abort, "IM Compilation failed.");
+        script->isParameterSpecialized = false;
+        ForbidCompilation(script);
+        return;
+    }
+
+    IonSpew(IonSpew_OffThread, "Linked compilation of %s:%d", script->filename, script->lineno);
+
+    // Code is attached to the output as when leaving AutoEnterCompilation.
+    co = compilation->recompileInfo.compilerOutput(cx);
+    if (script->hasIonScript())
+        co->out.ion = script->ionScript();
+
+    if (js_IonOptions.ps && script->hasIonScript())
+        NoteCompiledVersion(cx, script, &compilation->versionKey);
+}
+
+void
+AttachFinishedCompilations(JSContext *cx)
+{
+    CompilerThread *thread = cx->runtime->ionCompilerThread;
+    if (!thread)
+        return;
+
+    while (OffThreadCompilation *compilation = thread->takeFinished()) {
+        {
+            SwitchToCompartment sc(cx, compilation->script->compartment());
+            LinkOffThreadCompilation(cx, compilation);
+        }
+        Foreground::delete_(compilation);
+    }
+}
+
+void
+CancelOffThreadCompilations(JSRuntime *rt)
+{
+    if (rt->ionCompilerThread)
+        rt->ionCompilerThread->cancelAll();
+}
+
+void
+FinishCompilerThread(JSRuntime *rt)
+{
+    if (!rt->ionCompilerThread)
+        return;
+
+    rt->ionCompilerThread->finish();
+    Foreground::delete_(rt->ionCompilerThread);
+    rt->ionCompilerThread = NULL;
+}
+
+#endif // JS_THREADSAFE
+
 static bool
 CheckFrame(StackFrame *fp)
 {
@@ -1152,6 +1589,186 @@ CheckScriptSize(JSScript *script)
     return true;
 }
 
+// Whether Ion code of |script| which has not been invalidated is running.
+static bool
+HasLiveIonFrames(JSContext *cx, JSScript *script)
+{
+    for (IonActivationIterator iter(cx); iter.more(); ++iter) {
+        for (IonFrameIterator it(iter.top()); !it.done(); ++it) {
+            if (it.isScripted() && it.script() == script && !it.checkInvalidation())
+                return true;
+        }
+    }
+    return false;
+}
+
+// Detach the current IonScript of |script| and keep it in the script's version
+// cache.
+static bool
+DetachVersion(JSContext *cx, JSScript *script)
+{
+    JS_ASSERT(script->hasIonScript());
+
+    // Ion frames find their IonScript through their script, so a running
+    // version cannot be swapped out. Throw it away instead.
+    if (HasLiveIonFrames(cx, script)) {
+        IonSpew(IonSpew_PS, "Invalidating running version of %s:%d",
+                script->filename, script->lineno);
+        if (script->psVersions)
+            script->psVersions->clearActive();
+        return Invalidate(cx, script, /* resetUses */ false);
+    }
+
+    if (!script->psVersions) {
+        script->psVersions = cx->new_<PSVersionCache>();
+        if (!script->psVersions)
+            return false;
+    }
+
+    IonScript *ion = script->ion;
+    bool generic = !script->isParameterSpecialized;
+    script->ion = NULL;
+    script->isParameterSpecialized = false;
+
+    return script->psVersions->stash(cx, script, ion, generic);
+}
+
+// Whether a new version specialized to the current arguments may be compiled.
+static bool
+CanRespecialize(JSScript *script)
+{
+    return !script->disabledForPS;
+}
+
+// Carry out the decision the PS policy of |script| took at a bailout. The
+// versions which have been specialized too much are thrown away, so that the
+// script is recompiled or falls back on its generic version.
+static bool
+ApplyPSPolicy(JSContext *cx, JSScript *script)
+{
+    PSVersionCache *cache = script->psVersions;
+    if (!cache)
+        return true;
+
+    PSDecision decision = cache->policy().takeDecision();
+    if (decision == PSDecision_Keep)
+        return true;
+
+    if (decision == PSDecision_Generic)
+        script->disabledForPS = true;
+
+    if (script->hasIonScript() && script->isParameterSpecialized && !DetachVersion(cx, script))
+        return false;
+    cache->purgeSpecialized(cx->runtime->defaultFreeOp(), script);
+    return true;
+}
+
+// Make sure the IonScript attached to |script| is valid for the frame being
+// entered, at its start or at the loop header |osrPc|, swapping versions in
+// and out of its version cache. When no suitable version is cached,
+// |script->ion| is left NULL so that a new one gets compiled.
+static bool
+DispatchVersion(JSContext *cx, JSScript *script, jsbytecode *osrPc)
+{
+    StackFrame *fp = cx->fp();
+    if (!fp->isFunctionFrame())
+        return true;
+
+    PSVersionCache::Entry entry(fp, osrPc);
+
+    if (script->hasIonScript()) {
+        PSVersionCache *cache = script->psVersions;
+        if (script->isParameterSpecialized) {
+            // The OSR block of a specialized version may also hold the locals
+            // seen at compile time, which the active key then checks.
+            if (cache->activeMatches(entry))
+                return true;
+        } else if (osrPc) {
+            // Generic versions of other loop headers are only swapped out if
+            // that does not require invalidating them.
+            if (script->ion->osrPc() == osrPc || HasLiveIonFrames(cx, script))
+                return true;
+        } else {
+            if (!cache || !cache->hasMatching(entry))
+                return true;
+        }
+
+        if (!DetachVersion(cx, script))
+            return false;
+    }
+
+    PSVersionCache *cache = script->psVersions;
+    if (script->ion || !cache)
+        return true;
+
+    // Versions compiled at function entry are never specialized, so only
+    // OSR compilations may produce a new specialized version.
+    IonScript *ion = cache->takeSpecialized(entry);
+    bool specialized = !!ion;
+    if (!ion && (!osrPc || !CanRespecialize(script)))
+        ion = cache->takeGeneric(entry);
+    if (!ion)
+        return true;
+
+    IonSpew(IonSpew_PS, "Attaching %s version %p of %s:%d",
+            specialized ? "specialized" : "generic", (void *) ion,
+            script->filename, script->lineno);
+
+    script->ion = ion;
+    script->isParameterSpecialized = specialized;
+    return true;
+}
+
+// Make the key of the version of |script| being compiled for the current
+// frame, which has been specialized to its arguments.
+static bool
+InitVersionKey(JSContext *cx, JSScript *script, jsbytecode *osrPc, PSVersionCache::Key *key)
+{
+    // Specialized versions are compiled at a loop header, and may have baked
+    // the locals of the frame into their OSR block.
+    ParameterSpecialization ps(cx, script);
+    PSVersionCache::Entry entry(cx->fp(), osrPc);
+    if (!PSVersionCache::InitKey(entry, ps.specializableArgs(), ps.canSpecializeLocals(), key)) {
+        js_ReportOutOfMemory(cx);
+        return false;
+    }
+    return true;
+}
+
+// Record the arguments a freshly compiled IonScript of |script| has been
+// specialized to, if any, taking over |key|.
+static bool
+NoteCompiledVersion(JSContext *cx, JSScript *script, PSVersionCache::Key *key)
+{
+    PSVersionCache *cache = script->psVersions;
+    if (!script->isParameterSpecialized) {
+        if (cache)
+            cache->clearActive();
+        return true;
+    }
+
+    if (!cache) {
+        cache = cx->new_<PSVersionCache>();
+        if (!cache) {
+            key->release();
+            Invalidate(cx, script, /* resetUses */ false);
+            return false;
+        }
+        script->psVersions = cache;
+    }
+    cache->setActive(key);
+
+    // Scripts whose argument tuples keep changing would be recompiled over
+    // and over. Past a point, serve them with their generic version.
+    if (cache->noteSpecialization() > 2 * js_IonOptions.psMaxVersions) {
+        IonSpew(IonSpew_PS, "Too many specializations of %s:%d, falling back to generic code.",
+                script->filename, script->lineno);
+        script->disabledForPS = true;
+    }
+
+    return true;
+}
+
 template <bool Compiler(IonBuilder &, MIRGraph &)>
 static MethodStatus
 Compile(JSContext *cx, JSScript *script, JSFunction *fun, jsbytecode *osrPc, bool constructing)
@@ -1169,21 +1786,10 @@ Compile(JSContext *cx, JSScript *script, JSFunction *fun, jsbytecode *osrPc, boo
         return Method_CantCompile;
     }
 
-    // If the script has been specialized to its parameters and is being called once more,
-    // we need to discard the compiled code.
-    if (script->hasArgumentsChangedSinceLastCall(cx) && script->isParameterSpecialized && !script->bailed) {
-        IonSpew(IonSpew_PS, "Deoptimizing %s:%d. Script called more than once.", script->filename, script->lineno);
-
-        // Invalidate the script to force a recompile.
-        if (script->hasIonScript())
-            if (!Invalidate(cx, script, /* resetUses */ false))
-                return Method_CantCompile; // Fatal error during invalidation.
-
-        // We will not try to specialize the script to its parameters again.
-        script->disabledForPS = true;
-
-        script->isParameterSpecialized = false;
-    }
+    // Parameter specialized code is only valid for the arguments it has been
+    // compiled for, so pick the version matching the current frame.
+    if (js_IonOptions.ps && !DispatchVersion(cx, script, osrPc))
+        return Method_CantCompile;
 
     if (script->ion) {
         if (!script->ion->method())
@@ -1191,6 +1797,11 @@ Compile(JSContext *cx, JSScript *script, JSFunction *fun, jsbytecode *osrPc, boo
         return Method_Compiled;
     }
 
+    // The script runs in the other engines until the compilation running off
+    // the main thread is linked.
+    if (script->ionCompilingOffThread)
+        return Method_Skipped;
+
     if (cx->methodJitEnabled) {
         // If JM is enabled we use getUseCount instead of incUseCount to avoid
         // bumping the use count twice.
@@ -1201,9 +1812,30 @@ Compile(JSContext *cx, JSScript *script, JSFunction *fun, jsbytecode *osrPc, boo
             return Method_Skipped;
     }
 
+    script->isParameterSpecialized = false;
+
+#ifdef JS_THREADSAFE
+    if (OffThreadCompilationEnabled(cx)) {
+        if (!IonCompileOffThread(cx, script, fun, osrPc, constructing))
+            return Method_CantCompile;
+        return Method_Skipped;
+    }
+#endif
+
     if (!IonCompile<Compiler>(cx, script, fun, osrPc, constructing))
         return Method_CantCompile;
 
+    if (js_IonOptions.ps && script->hasIonScript()) {
+        PSVersionCache::Key key;
+        key.clear();
+        if (script->isParameterSpecialized && !InitVersionKey(cx, script, osrPc, &key)) {
+            Invalidate(cx, script, /* resetUses */ false);
+            return Method_Error;
+        }
+        if (!NoteCompiledVersion(cx, script, &key))
+            return Method_Error;
+    }
+
     // Compilation succeeded, but we invalidated right away.
     return script->hasIonScript() ? Method_Compiled : Method_Skipped;
 }
@@ -1225,6 +1857,10 @@ ion::CanEnterAtBranch(JSContext *cx, JSScript *script, StackFrame *fp, jsbytecod
     if (script->ion == ION_DISABLED_SCRIPT)
         return Method_Skipped;
 
+    // Bailouts of specialized code may have decided to replace it.
+    if (js_IonOptions.ps && !ApplyPSPolicy(cx, script))
+        return Method_Error;
+
     // Skip if the code is expected to result in a bailout.
     if (script->ion && script->ion->bailoutExpected())
         return Method_Skipped;
@@ -1268,10 +1904,17 @@ ion::CanEnter(JSContext *cx, JSScript *script, StackFrame *fp, bool newType)
 
     IonProfileNewScript(script);
 
+    if (js_IonOptions.ps)
+        script->profileArguments(fp);
+
     // Skip if the script has been disabled.
     if (script->ion == ION_DISABLED_SCRIPT)
         return Method_Skipped;
 
+    // Bailouts of specialized code may have decided to replace it.
+    if (js_IonOptions.ps && !ApplyPSPolicy(cx, script))
+        return Method_Error;
+
     // Skip if the code is expected to result in a bailout.
     if (script->ion && script->ion->bailoutExpected())
         return Method_Skipped;
@@ -1396,6 +2039,14 @@ EnterIon(JSContext *cx, StackFrame *fp, void *jitcode)
     return result.isMagic() ? IonExec_Error : IonExec_Ok;
 }
 
+// Count an entry into the IonScript of |script|, which the PS policy weighs
+// its bailouts against.
+static void
+NoteEntry(JSScript *script)
+{
+    script->ion->noteEntry();
+}
+
 IonExecStatus
 ion::Cannon(JSContext *cx, StackFrame *fp)
 {
@@ -1407,16 +2058,9 @@ ion::Cannon(JSContext *cx, StackFrame *fp)
     IonSpew(IonSpew_Calls, "Function entry call of script %s:%d (%p)",
         script->filename, script->lineno, (void *) script);
 
-    IonExecStatus status = EnterIon(cx, fp, jitcode);
+    NoteEntry(script);
 
-    // We need to know if there was a bailout in order to decide if parameter
-    // specialization will be used again.
-    if (status == IonExec_Bailout)
-        script->bailed = true;
-    else
-        script->bailed = false;
-
-    return status;
+    return EnterIon(cx, fp, jitcode);
 }
 
 IonExecStatus
@@ -1432,17 +2076,9 @@ ion::SideCannon(JSContext *cx, StackFrame *fp, jsbytecode *pc)
     IonSpew(IonSpew_Calls, "OSR entry call of script %s:%d (%p)",
         script->filename, script->lineno, (void *) script);
 
-    IonExecStatus status = EnterIon(cx, fp, osrcode);
-
+    NoteEntry(script);
 
-    // We need to know if there was a bailout in order to decide if parameter
-    // specialization will be used again.
-    if (status == IonExec_Bailout)
-        script->bailed = true;
-    else
-        script->bailed = false;
-
-    return status;
+    return EnterIon(cx, fp, osrcode);
 }
 
 static void
@@ -1649,6 +2285,9 @@ ion::Invalidate(JSContext *cx, JSScript *script, bool resetUses)
 void
 ion::FinishInvalidation(FreeOp *fop, JSScript *script)
 {
+    if (script->psVersions)
+        script->psVersions->purge(fop, script);
+
     if (!script->hasIonScript())
         return;
 
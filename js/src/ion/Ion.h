@@ -41,12 +41,14 @@ struct IonOptions
     // Default: false
     bool linv;
 
-    // Toggles whether loop inversion analysis is performed
+    // Toggles whether the size of blocks is spewed (IONFLAGS=linv), to find
+    // loops worth inverting.
     //
     // Default: false
     bool linvA;
 
-    // Toggles whether OverFlow Tests analysis is performed
+    // Toggles whether overflow and negative zero tests are removed from the
+    // integer arithmetic which is proven not to need them.
     //
     // Default: false
     bool ota;
@@ -56,7 +58,8 @@ struct IonOptions
     // Default: false
     bool bcoal;
 
-    // Toggles whether dead code elimination for conditionals is performed
+    // Toggles whether the constant propagation pass removes the branches of
+    // tests whose condition is a constant, along with the code they reach.
     //
     // Default: false
     bool dcec;
@@ -66,7 +69,20 @@ struct IonOptions
     // Default: false
     bool ps;
 
-    // Toggles whether constant propagation is performed.
+    // Toggles whether parameter specialization also specializes object
+    // arguments to their shape, so that their properties are read directly.
+    //
+    // Default: false
+    bool psShapes;
+
+    // Toggles whether parameter specialization also treats globals which
+    // have never been overwritten as constants.
+    //
+    // Default: false
+    bool psGlobals;
+
+    // Toggles whether sparse conditional constant propagation replaces the
+    // definitions it proves constant.
     //
     // Default: false
     bool cp;
@@ -76,6 +92,42 @@ struct IonOptions
     // Default: false
     bool bce;
 
+    // Toggles whether innermost loops counting up or down are unrolled.
+    //
+    // Default: false
+    bool unroll;
+
+    // Toggles whether object and array literals which do not escape are
+    // replaced by the values of their fields.
+    //
+    // Default: false
+    bool escapeAnalysis;
+
+    // Toggles whether alias analysis tells apart the slots, elements and
+    // types of objects, and whether GVN forwards stored values to loads.
+    //
+    // Default: false
+    bool aliasRefinement;
+
+    // Toggles whether stores to slots and elements which are never read are
+    // removed.
+    //
+    // Default: false
+    bool dse;
+
+    // Toggles whether simple loops over typed arrays are run with packed SSE
+    // instructions, on x64.
+    //
+    // Default: false
+    bool vectorize;
+
+    // Toggles whether compilations are optimized, lowered and register
+    // allocated on a helper thread, while the script keeps running in the
+    // other engines. Requires a threadsafe build.
+    //
+    // Default: false
+    bool parallelCompilation;
+
     // Toggles whether functions may be entered at loop headers.
     //
     // Default: true
@@ -173,6 +225,38 @@ struct IonOptions
     // stop running this function in IonMonkey. (default 512)
     uint32 slowCallLimit;
 
+    // The maximum number of parameter specialized versions kept per script,
+    // not counting its generic version.
+    //
+    // Default: 4
+    uint32 psMaxVersions;
+
+    // The number of consecutive calls an argument which already changed value
+    // must keep its current value before it is specialized again. Arguments
+    // which never changed are specialized right away.
+    //
+    // Default: 8
+    uint32 psStabilityThreshold;
+
+    // The number of bailouts from parameter specialized code, at a single
+    // snapshot or in total, after which its script is specialized again to
+    // fewer constants.
+    //
+    // Default: 3
+    uint32 psBailoutThreshold;
+
+    // The number of bailouts per 100 entries into parameter specialized code
+    // below which they are tolerated, however many there are in total.
+    //
+    // Default: 10
+    uint32 psBailoutRate;
+
+    // The number of times a script is specialized again to fewer constants
+    // before only its generic code is used.
+    //
+    // Default: 2
+    uint32 psMaxRespecializations;
+
     void setEagerCompilation() {
         eagerCompilation = true;
         usesBeforeCompile = usesBeforeCompileNoJaeger = 0;
@@ -191,8 +275,16 @@ struct IonOptions
         bcoal(false),
         dcec(false),
         ps(false),
+        psShapes(false),
+        psGlobals(false),
         cp(false),
         bce(false),
+        unroll(false),
+        escapeAnalysis(false),
+        aliasRefinement(false),
+        dse(false),
+        vectorize(false),
+        parallelCompilation(false),
         osr(true),
         limitScriptSize(true),
         lsra(true),
@@ -209,7 +301,12 @@ struct IonOptions
         polyInlineMax(4),
         inlineMaxTotalBytecodeLength(800),
         eagerCompilation(false),
-        slowCallLimit(512)
+        slowCallLimit(512),
+        psMaxVersions(4),
+        psStabilityThreshold(8),
+        psBailoutThreshold(3),
+        psBailoutRate(10),
+        psMaxRespecializations(2)
     { }
 };
 
@@ -280,6 +377,19 @@ static inline bool IsEnabled(JSContext *cx)
 
 void ForbidCompilation(JSScript *script);
 
+#ifdef JS_THREADSAFE
+// Generates the code of the compilations finished off the main thread, and
+// attaches it to their scripts.
+void AttachFinishedCompilations(JSContext *cx);
+
+// Throws away the compilations running off the main thread, which hold
+// pointers to GC things without tracing them.
+void CancelOffThreadCompilations(JSRuntime *rt);
+
+// Stops the compiler thread of |rt|, if it has one.
+void FinishCompilerThread(JSRuntime *rt);
+#endif
+
 } // namespace ion
 } // namespace js
 
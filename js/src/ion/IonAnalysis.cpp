@@ -129,172 +129,6 @@ ion::CoalesceBlocks(MIRGraph &graph)
     return true;
 }
 
-// Eliminates conditionals with completely folded conditions.
-bool
-ion::DCEConditionals(MIRGraph &graph)
-{
-    bool* deleteBlock = new bool[graph.numBlockIds()];
-
-    for (uint32 i = 0; i < graph.numBlockIds(); i++)
-        deleteBlock[i] = false;
-
-    MBasicBlockIterator itEndBlock = graph.end();
-
-    for (ReversePostorderIterator itBlock = graph.rpoBegin(), itNextBlock = itBlock;
-         itNextBlock++, itBlock != graph.rpoEnd(); itBlock = itNextBlock) {
-        MBasicBlock *block = *itBlock;
-
-        // Skip over blocks marked for deletion.
-        if (deleteBlock[block->id()])
-            continue;
-
-        MControlInstruction *lastIns = block->lastIns();
-        if (lastIns->isTest()) {
-            JS_ASSERT(lastIns->numOperands() == 1);
-            JS_ASSERT(lastIns->getOperand(0)->isDefinition());
-            MDefinition *lastInsOper = lastIns->getOperand(0);
-            if (lastInsOper->isConstant()) {
-                Value boolOperVal = static_cast<MConstant *>(lastInsOper)->value();
-                // May be undefined.
-                if (!boolOperVal.isBoolean())
-                    continue;
-
-                // Block from where the branch for deletion starts.
-                MBasicBlock *deleteBranchStart = block->getSuccessor(boolOperVal.toBoolean());
-                // Block that starts the branch to keep.
-                MBasicBlock *keepBranchStart = block->getSuccessor(!boolOperVal.toBoolean());
-
-                // Rare condition, not worth fixing.
-                if (deleteBranchStart->numSuccessors() <= 2 &&
-                    (deleteBranchStart->isLoopHeader() || deleteBranchStart->isLoopBackedge()))
-                   continue;
-
-                deleteBlock[deleteBranchStart->id()] = true;
-
-                IonSpew(IonSpew_DCEC, "Marking conditional starting at block %d for removal", 
-                        deleteBranchStart->id());
-
-                // Just replace the last instruction, don't update any predecessor lists.
-                block->discardLastIns();
-                block->end(MGoto::New(keepBranchStart));
-
-                ReversePostorderIterator itDel = graph.begin(deleteBranchStart);
-                bool first = true;
-                MBasicBlock *lastBranchBlock = block;
-
-                deleteBlock[block->id()] = true;
-                for (; itDel != graph.rpoEnd(); itDel++) {
-                    MBasicBlock *delBlock = *itDel;
-                    bool branchOver = false;
-                    bool atLeastOneDel = false;
-
-                    for (uint32 i = 0; i < delBlock->numPredecessors(); i++) {
-                        if (!deleteBlock[delBlock->getPredecessor(i)->id()]) {
-                            deleteBlock[delBlock->id()] = false;
-                            branchOver = true;
-                        } else {
-                            atLeastOneDel = true;
-                            if (branchOver)
-                                break;
-                        }
-                    }
-
-                    if (branchOver && atLeastOneDel) {
-                        if (!lastBranchBlock || lastBranchBlock->numSuccessors() == 0)
-                            break;
-
-                        uint32 index = 0;
-
-                        if (!first)
-                            delBlock = lastBranchBlock->getSuccessor(0);
-
-                        for (uint32 i = 0; i < delBlock->numPredecessors(); i++) {
-                            if (delBlock->getPredecessor(i) == lastBranchBlock) {
-                                index = i;
-                                break;
-                            }
-                        }
-
-                        for (MPhiIterator itPhi = delBlock->phisBegin(); 
-                             itPhi != delBlock->phisEnd(); ) {
-                            if (itPhi->numOperands() == 2) {
-                                itPhi->replaceAllUsesWith(itPhi->getOperand(!index));
-                                itPhi = delBlock->discardPhiAt(itPhi);
-                            } else {
-                                itPhi->removeOperand(index);
-                                itPhi++;
-                            }
-                        }
-
-                        if (first) {
-                            deleteBlock[block->id()] = false;
-                        } else {
-                            for (uint32 j = 0; j < delBlock->numPredecessors(); j++) {
-                                 if (delBlock->getPredecessor(j) == lastBranchBlock) {
-                                     delBlock->removePredecessor(j);
-                                     if (delBlock->numPredecessors() == 0)
-                                         deleteBlock[delBlock->id()] = true; 
-                                     break;
-                                 }
-                            }
-                        }
-                        break;
-                    }
-
-                    if (first) {
-                        first = false;
-                        deleteBlock[block->id()] = false;
-                    }
-
-                    if (atLeastOneDel) {
-                        deleteBlock[delBlock->id()] = true;
-                        IonSpew(IonSpew_DCEC, "Marking block %d for removal", delBlock->id());
-                        lastBranchBlock = delBlock;
-                    }
-                }
-
-                for (uint32 j = 0; j < deleteBranchStart->numPredecessors(); j++) {
-                    if (deleteBranchStart->getPredecessor(j) == block) {
-                        deleteBranchStart->removePredecessor(j);
-                        if (deleteBranchStart->numPredecessors() == 0)
-                            deleteBlock[deleteBranchStart->id()] = true; 
-                        break;
-                    }
-                }
-            }
-        }
-    }
-
-    for (MBasicBlockIterator itBlock = graph.begin(), itNextBlock = itBlock; 
-         itNextBlock++, itBlock != itEndBlock; itBlock = itNextBlock) {
-        MBasicBlock *block = *itBlock;
-        if (deleteBlock[block->id()]) {
-            for (MInstructionIterator itIns = block->begin(), itNextIns = itIns; itNextIns++, 
-                 itNextIns != block->end(); itIns = itNextIns)
-                block->discardAt(itIns);
-
-            for (MPhiIterator itPhi = block->phisBegin(); itPhi != block->phisEnd(); )
-                itPhi = block->discardPhiAt(itPhi);
-
-            for (uint32 i = 0; i < block->numSuccessors(); i++) {
-                MBasicBlock *succ = block->getSuccessor(i);
-                for (uint32 j = 0; j < succ->numPredecessors(); j++) {
-                    if (succ->getPredecessor(j) == block) {
-                        succ->removePredecessor(j);
-                        break;
-                    }
-                }
-            }
-
-            block->discardLastIns();
-            graph.removeBlock(block);
-        }
-    }
-
-    delete[] deleteBlock;
-    return true;
-}
-
 // A critical edge is an edge which is neither its successor's only predecessor
 // nor its predecessor's only successor. Critical edges must be split to
 // prevent copy-insertion and code motion from affecting other edges.
@@ -881,6 +715,13 @@ ion::BuildDominatorTree(MIRGraph &graph)
     return true;
 }
 
+void
+ion::ClearDominatorTree(MIRGraph &graph)
+{
+    for (MBasicBlockIterator block(graph.begin()); block != graph.end(); block++)
+        block->clearDominatorInfo();
+}
+
 bool
 ion::BuildPhiReverseMapping(MIRGraph &graph)
 {
@@ -23,9 +23,6 @@ class MBasicBlock;
 bool
 CoalesceBlocks(MIRGraph &graph);
 
-bool
-DCEConditionals(MIRGraph &graph);
-
 bool
 SplitCriticalEdges(MIRGenerator *gen, MIRGraph &graph);
 
@@ -44,6 +41,11 @@ RenumberBlocks(MIRGraph &graph);
 bool
 BuildDominatorTree(MIRGraph &graph);
 
+// Forgets the dominator tree, so that it can be built again once blocks have
+// been added or removed.
+void
+ClearDominatorTree(MIRGraph &graph);
+
 bool
 BuildPhiReverseMapping(MIRGraph &graph);
 
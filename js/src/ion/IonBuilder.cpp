@@ -15,7 +15,6 @@
 
 #include "jsscriptinlines.h"
 #include "jstypedarrayinlines.h"
-#include "LInversion.h"
 #include "ParameterSpecialization.h"
 
 #ifdef JS_THREADSAFE
@@ -39,6 +38,8 @@ IonBuilder::IonBuilder(JSContext *cx, TempAllocator *temp, MIRGraph *graph,
     lazyArguments_(NULL)
 {
     pc = info->startPC();
+    functionCalls = 0;
+    specializedArgs_ = 0;
 }
 
 void
@@ -289,6 +290,12 @@ IonBuilder::build()
 
     // Emit the start instruction, so we can begin real instructions.
     current->makeStart(MStart::New(MStart::StartType_Default));
+
+    // Guard the specialized arguments before anything else, so that a
+    // mismatch resumes in the interpreter at the start of the function.
+    if (!specializeParameters())
+        return false;
+
     if (instrumentedProfiling()) {
         SPSProfiler *profiler = &cx->runtime->spsProfiler;
         const char *string = profiler->profileString(cx, script, script->function());
@@ -299,8 +306,7 @@ IonBuilder::build()
 
     // Parameters have been checked to correspond to the typeset, now we unbox
     // what we can in an infallible manner.
-    if(!js_IonOptions.ps || !script->isParameterSpecialized)
-        rewriteParameters();
+    rewriteParameters();
 
     // It's safe to start emitting actual IR, so now build the scope chain.
     if (!initScopeChain())
@@ -330,10 +336,7 @@ IonBuilder::build()
     // So we attach the initial resume point to each parameter, which the type
     // analysis explicitly checks (this is the same mechanism used for
     // effectful operations).
-    uint32 numArgSlot = 0;
-    if(!js_IonOptions.ps || !script->isParameterSpecialized)
-        numArgSlot = CountArgSlots(info().fun());
-    for (uint32 i = 0; i < numArgSlot; i++) {
+    for (uint32 i = 0; i < CountArgSlots(info().fun()); i++) {
         MInstruction *ins = current->getEntrySlot(i)->toInstruction();
         if (ins->type() == MIRType_Value)
             ins->setResumePoint(current->entryResumePoint());
@@ -513,6 +516,10 @@ IonBuilder::rewriteParameters()
     static const uint32 START_SLOT = 1;
 
     for (uint32 i = START_SLOT; i < CountArgSlots(info().fun()); i++) {
+        // Specialized arguments have already been replaced by constants.
+        if (!current->getSlot(i)->isParameter())
+            continue;
+
         MParameter *param = current->getSlot(i)->toParameter();
         types::TypeSet *types = param->typeSet();
         if (!types)
@@ -562,32 +569,125 @@ IonBuilder::initParameters()
     current->add(param);
     current->initSlot(info().thisSlot(), param);
 
-    if(js_IonOptions.ps && !script->isParameterSpecialized){
-    	this->functionCalls = 0;
+    for (uint32 i = 0; i < info().nargs(); i++) {
+        param = MParameter::New(i, oracle->parameterTypeSet(script, i));
+        current->add(param);
+        current->initSlot(info().argSlot(i), param);
+    }
+
+    // Tries to perform parameter based specialization. Arguments are still
+    // received as parameters, and the specialized ones are replaced by
+    // constants once they have been guarded, in specializeParameters().
+    if (js_IonOptions.ps && !script->isParameterSpecialized) {
         ParameterSpecialization ps(cx, script);
+        if (ps.canSpecialize(info().osrPc())) {
+            specializedArgs_ = ps.specializableArgs();
+            script->isParameterSpecialized = true;
+        }
 
-        // Tries to perform parameter based specialization. If it is not possible,
-        // the script parameters are initializaed using the classic approach.
-        if ( ps.canSpecialize(info().osrPc())) {
-            // Places the arguments values in the graph.
+        // Shapes are only guarded at entry and nothing else is baked in, so
+        // generic compiles specialize them as well.
+        if (js_IonOptions.psShapes && !initSpecializedShapes(ps))
+            return false;
+    }
 
-            for (uint32 i = 0; i < info().nargs(); i++) {
-                MConstant *constant = ps.getConstantArg(i);
+    return true;
+}
 
-                current->add(constant);
-                current->initSlot(info().argSlot(i), constant);
-                IonSpew(IonSpew_PS, "parameter %d turned into constant", i);
-            }
+bool
+IonBuilder::initSpecializedShapes(ParameterSpecialization &ps)
+{
+    uint32 mask = ps.shapeSpecializableArgs();
+    if (!mask)
+        return true;
 
-            script->isParameterSpecialized = true;
-            return true;
+    if (!specializedShapes_.appendN(static_cast<Shape *>(NULL), info().nargs()))
+        return false;
+
+    bool any = false;
+    for (uint32 i = 0; i < info().nargs(); i++) {
+        if (!(mask & (1u << i)))
+            continue;
+
+        // Arguments which are not replaced by a constant are unboxed without
+        // a check, which requires them to be known objects.
+        if (!(specializedArgs_ & (1u << i))) {
+            types::TypeSet *types = current->getSlot(info().argSlot(i))->toParameter()->typeSet();
+            if (!types || types->getKnownTypeTag(cx) != JSVAL_TYPE_OBJECT)
+                continue;
         }
+
+        Shape *shape = ps.getArgShape(i);
+        specializedShapes_[i] = shape;
+        any = true;
+        IonSpew(IonSpew_PS, "parameter %d specialized to shape %p (class %s)",
+                i, (void *) shape, shape->getObjectClass()->name);
     }
 
+    if (!any)
+        specializedShapes_.clear();
+    return true;
+}
+
+// Returns the shape |obj| has been specialized to, if it is the value of an
+// argument. Scripts with shape specialized arguments never assign them, so
+// the argument slots always hold the objects the script was called with.
+Shape *
+IonBuilder::specializedShapeOf(MDefinition *obj)
+{
+    for (uint32 i = 0; i < specializedShapes_.length(); i++) {
+        if (specializedShapes_[i] && current->getSlot(info().argSlot(i)) == obj)
+            return specializedShapes_[i];
+    }
+    return NULL;
+}
+
+// Replace the specialized arguments by the values they had when compilation
+// was triggered. Callers, including Ion code calling the script directly, may
+// pass other values, so each of them is guarded to be unchanged. The entry
+// resume point keeps the original MParameters.
+bool
+IonBuilder::specializeParameters()
+{
+    if (!specializedArgs_ && specializedShapes_.empty())
+        return true;
+
+    ParameterSpecialization ps(cx, script);
+    if (!ps.canSpecializeAtOsr())
+        return abort("Arguments of the specialized frame are unavailable");
+
     for (uint32 i = 0; i < info().nargs(); i++) {
-        param = MParameter::New(i, oracle->parameterTypeSet(script, i));
-        current->add(param);
-        current->initSlot(info().argSlot(i), param);
+        if (!(specializedArgs_ & (1u << i)))
+            continue;
+
+        uint32 slot = info().argSlot(i);
+        MConstant *constant = ps.getConstantArg(i);
+        current->add(constant);
+        current->add(MGuardValue::New(current->getSlot(slot), constant->value()));
+        current->rewriteSlot(slot, constant);
+        IonSpew(IonSpew_PS, "parameter %d turned into constant", i);
+    }
+
+    // A single guard at entry checks the shape of each shape specialized
+    // argument. Property accesses on it still guard the shape, since the
+    // script may modify the object, but these guards are usually redundant
+    // with the entry one and get removed by GVN. All of them fail as parameter
+    // checks, so that the argument profile sees the new shape and the script
+    // is not specialized to the old one again right away.
+    for (uint32 i = 0; i < specializedShapes_.length(); i++) {
+        Shape *shape = specializedShapes_[i];
+        if (!shape)
+            continue;
+
+        uint32 slot = info().argSlot(i);
+        MDefinition *obj = current->getSlot(slot);
+        if (obj->type() == MIRType_Value) {
+            MUnbox *unbox = MUnbox::New(obj, MIRType_Object, MUnbox::Infallible);
+            current->add(unbox);
+            current->rewriteSlot(slot, unbox);
+            obj = unbox;
+        }
+        current->add(MGuardShape::New(obj, shape, Bailout_ParameterCheck));
     }
 
     return true;
@@ -1175,12 +1275,6 @@ IonBuilder::ControlStatus
 IonBuilder::processCfgEntry(CFGState &state)
 {
     switch (state.state) {
-      case CFGState::FAKE_IF:
-        return processFakeIf(state);
-
-      case CFGState::FAKE_IF_END:
-        return processFakeIfEnd(state);
-
       case CFGState::IF_TRUE:
       case CFGState::IF_TRUE_EMPTY_ELSE:
         return processIfEnd(state);
@@ -1191,7 +1285,6 @@ IonBuilder::processCfgEntry(CFGState &state)
       case CFGState::IF_ELSE_FALSE:
         return processIfElseFalseEnd(state);
 
-      case CFGState::WHILE_OR_FOR_INVERTED:
       case CFGState::DO_WHILE_LOOP_BODY:
         return processDoWhileBodyEnd(state);
 
@@ -1228,47 +1321,6 @@ IonBuilder::processCfgEntry(CFGState &state)
     return ControlStatus_Error;
 }
 
-IonBuilder::ControlStatus
-IonBuilder::processFakeIf(CFGState &state) {
-    MBasicBlock *loopEntry = cfgStack_.back().loop.entry;
-    current->end(MGoto::New(loopEntry));
-
-    // FIXME: The loop entry should be created here, instead of in
-    // whileOrForInLoop. That should fix the problem with slots.
-
-    size_t i = 0;
-    for (MPhiIterator itPhi = loopEntry->phisBegin(); itPhi != loopEntry->phisEnd(); itPhi++) {
-        itPhi->replaceOperand(0, current->getSlot(i));
-        i++;
-    }
-
-    MBasicBlock *ifBlock = loopEntry->getPredecessor(0);
-    if (ifBlock != current)
-        loopEntry->replacePredecessor(ifBlock, current);
-
-    MIRGraph& graph = current->graph();
-    graph.removeBlock(loopEntry);
-    graph.addBlock(loopEntry);
-
-    current = loopEntry;
-    pc = cfgStack_.back().loop.bodyStart;
-
-    return ControlStatus_Joined;
-}
-
-IonBuilder::ControlStatus
-IonBuilder::processFakeIfEnd(CFGState &state) {
-    MBasicBlock *loopEntry = cfgStack_.back().loop.entry;
-
-    MBasicBlock *ifBlock = loopEntry->getPredecessor(0);
-
-    ifBlock->discardLastIns();
-    MDefinition *vins = ifBlock->pop();
-    ifBlock->end(MTest::New(vins,loopEntry,current));
-    current->addPredecessor(ifBlock);
-    return ControlStatus_Joined;
-}
-
 IonBuilder::ControlStatus
 IonBuilder::processIfEnd(CFGState &state)
 {
@@ -2077,66 +2129,24 @@ IonBuilder::whileOrForInLoop(JSOp op, jssrcnote *sn)
         current = preheader;
     }
 
-    MBasicBlock *header;
+    MBasicBlock *header = newPendingLoopHeader(current, pc);
+    if (!header)
+        return ControlStatus_Error;
+    current->end(MGoto::New(header));
 
     // Skip past the JSOP_LOOPHEAD for the body start.
     jsbytecode *bodyStart = GetNextPc(GetNextPc(pc));
     jsbytecode *bodyEnd = pc + GetJumpOffset(pc);
     jsbytecode *exitpc = GetNextPc(ifne);
-    jsbytecode *afterLoopHead;
-
-    if (js_IonOptions.linv && !which) {
-        IonSpew(IonSpew_LInv, "inverting a while loop");
-        IonSpew(IonSpew_LInv, "creating surrounding if:");
-        MBasicBlock *ifBlock = newBlock(current, pc);
-        current->end(MGoto::New(ifBlock));
-
-        header = newPendingLoopHeader(ifBlock, pc);
-        if (!header)
-            return ControlStatus_Error;
-
-        CFGState fakeIfEnd;
-        fakeIfEnd.state = CFGState::FAKE_IF_END;
-        fakeIfEnd.stopAt = exitpc;
-        fakeIfEnd.loop.entry = header;
-        cfgStack_.append(fakeIfEnd);
-
-        if (!pushLoop(CFGState::WHILE_OR_FOR_INVERTED, loopEntry, header, bodyStart, bodyEnd, exitpc))
-            return ControlStatus_Error;
-
-        CFGState &state = cfgStack_.back();
-        state.loop.updatepc = loopEntry;
-        state.loop.updateEnd = ifne;
-
-        CFGState fakeIf;
-        fakeIf.state = CFGState::FAKE_IF;
-        fakeIf.stopAt = ifne;
-        fakeIf.loop.entry = header;
-        fakeIf.loop.bodyStart = bodyStart;
-        cfgStack_.append(fakeIf);
-        afterLoopHead = bodyEnd;
-        current = ifBlock;
-
-    }else{
-        header = newPendingLoopHeader(current, pc);
-
-        if (!header)
-            return ControlStatus_Error;
-        current->end(MGoto::New(header));
-
-        if (!pushLoop(CFGState::WHILE_LOOP_COND, ifne, header, bodyStart, bodyEnd, exitpc))
-            return ControlStatus_Error;
-        afterLoopHead = bodyEnd;
-
-        // Parse the condition first.
-        current = header;
-    }
-
+    if (!pushLoop(CFGState::WHILE_LOOP_COND, ifne, header, bodyStart, bodyEnd, exitpc))
+        return ControlStatus_Error;
 
+    // Parse the condition first.
+    current = header;
     if (!jsop_loophead(GetNextPc(pc)))
         return ControlStatus_Error;
 
-    pc = afterLoopHead;
+    pc = bodyEnd;
     return ControlStatus_Jumped;
 }
 
@@ -2952,9 +2962,10 @@ IonBuilder::jsop_call_inline(HandleFunction callee, uint32 argc, bool constructi
     for (int32 i = argc; i >= 0; i--)
         argv[i] = current->pop();
 
-    // Compilation information is allocated for the duration of the current tempLifoAlloc
-    // lifetime.
-    CompileInfo *info = cx->tempLifoAlloc().new_<CompileInfo>(callee->script(), callee,
+    // Compilation information is allocated for the duration of the compilation,
+    // which may outlive the current tempLifoAlloc when it finishes off the
+    // main thread.
+    CompileInfo *info = temp().lifoAlloc()->new_<CompileInfo>(callee->script(), callee,
                                                               (jsbytecode *)NULL, constructing);
     if (!info)
         return false;
@@ -2982,6 +2993,7 @@ IonBuilder::jsop_call_inline(HandleFunction callee, uint32 argc, bool constructi
     // Build the graph.
     if (!inlineBuilder.buildInline(this, inlineResumePoint, thisDefn, argv))
         return false;
+    functionCalls += inlineBuilder.functionCalls;
 
     MIRGraphExits &exits = *inlineBuilder.graph().exitAccumulator();
 
@@ -3042,7 +3054,6 @@ IonBuilder::makeInliningDecision(AutoObjectVector &targets)
         JSScript *script = target->script();
         if(js_IonOptions.ps){
         	IonSpew(IonSpew_Scripts, "Target[%d] has script %s:%d (%p)", i, script->filename, script->lineno, (void *) script);
-        	this->functionCalls++;
         }
         totalSize += script->length;
         if (totalSize > js_IonOptions.inlineMaxTotalBytecodeLength)
@@ -3055,7 +3066,10 @@ IonBuilder::makeInliningDecision(AutoObjectVector &targets)
     if (allFunctionsAreSmall)
         checkUses = js_IonOptions.smallFunctionUsesBeforeInlining;
 
-    if (script->getUseCount() < checkUses) {
+    // Parameter specialized code would lose its specialization if it was
+    // recompiled to inline its calls, so they are inlined right away, which
+    // also carries the specialized values into the callees.
+    if (script->getUseCount() < checkUses && !specializingOuterScript()) {
         IonSpew(IonSpew_Inlining, "Not inlining, caller is not hot");
         return false;
     }
@@ -3803,6 +3817,11 @@ IonBuilder::jsop_call_fun_barrier(AutoObjectVector &targets, uint32_t numTargets
             return inlineScriptedCall(targets, argc, constructing, types, barrier);
     }
 
+    // Calls to known targets which are not inlined keep the recompile checks,
+    // see build().
+    if (numTargets > 0)
+        functionCalls++;
+
     RootedFunction target(cx, numTargets == 1 ? targets[0]->toFunction() : NULL);
     return makeCallBarrier(target, argc, constructing, types, barrier);
 }
@@ -4205,6 +4224,8 @@ IonBuilder::newOsrPreheader(MBasicBlock *predecessor, jsbytecode *loopEntry)
     }
 
     ParameterSpecialization ps(cx, script);
+    bool specializeAtOsr = js_IonOptions.ps && ps.canSpecializeAtOsr();
+    JS_ASSERT_IF(specializedArgs_, specializeAtOsr);
 
     if (info().fun()) {
         // Initialize |this| parameter.
@@ -4215,32 +4236,29 @@ IonBuilder::newOsrPreheader(MBasicBlock *predecessor, jsbytecode *loopEntry)
         osrBlock->add(thisv);
         osrBlock->initSlot(slot, thisv);
 
-        // Tries to perform parameter based specialization. If it is not possible,
-        // the script parameters are initializaed using the classic approach.
-        if (js_IonOptions.ps && ps.canSpecializeAtOsr()) {
-            // Places the arguments values in the graph.
-            for (uint32 i = 0; i < info().nargs(); i++) {
+        // Initialize arguments. The specialized ones are replaced by their
+        // values, which are those of the frame we are about to enter.
+        for (uint32 i = 0; i < info().nargs(); i++) {
+            uint32 slot = info().argSlot(i);
+
+            if (specializedArgs_ & (1u << i)) {
                 MConstant *constant = ps.getConstantArg(i);
- 
                 osrBlock->add(constant);
-                osrBlock->initSlot(info().argSlot(i), constant);
+                osrBlock->initSlot(slot, constant);
                 IonSpew(IonSpew_PS, "[OSR] parameter %d turned into constant", i);
+                continue;
             }
-        } else {
-            // Initialize arguments.
-            for (uint32 i = 0; i < info().nargs(); i++) {
-                uint32 slot = info().argSlot(i);
-                ptrdiff_t offset = StackFrame::offsetOfFormalArg(info().fun(), i);
-
-                MOsrValue *osrv = MOsrValue::New(entry, offset);
-                osrBlock->add(osrv);
-                osrBlock->initSlot(slot, osrv);
-            }
+
+            ptrdiff_t offset = StackFrame::offsetOfFormalArg(info().fun(), i);
+
+            MOsrValue *osrv = MOsrValue::New(entry, offset);
+            osrBlock->add(osrv);
+            osrBlock->initSlot(slot, osrv);
         }
     }
 
     //replace locals by its values FIXME: not working properly
-    if (js_IonOptions.ps && ps.canSpecializeAtOsr()) {
+    if (specializeAtOsr && ps.canSpecializeLocals()) {
         for (uint32 i = 0; i < info().nlocals(); i++) {
             MConstant *constant = ps.getLocalValue(i);
             osrBlock->add(constant);
@@ -4675,6 +4693,20 @@ IonBuilder::jsop_getgname(HandlePropertyName name)
 
     types::TypeSet *barrier = oracle->propertyReadBarrier(script, pc);
     types::TypeSet *types = oracle->propertyRead(script, pc);
+
+    // Globals which have never been overwritten are treated as constants. The
+    // isConstantProperty call will trigger recompilation if that changes.
+    if (types::TrackConstantProperties(cx) && propertyTypes && types && !barrier) {
+        const Value &value = globalObj->getSlot(shape->slot());
+        if (!value.isUndefined() &&
+            types->hasType(types::GetValueType(cx, value)) &&
+            propertyTypes->isConstantProperty(cx))
+        {
+            IonSpew(IonSpew_PS, "global in slot %u turned into constant", shape->slot());
+            return pushConstant(value);
+        }
+    }
+
     if (types) {
         JSObject *singleton = types->getSingleton(cx);
 
@@ -4747,6 +4779,11 @@ IonBuilder::jsop_setgname(HandlePropertyName name)
         return jsop_setprop(name);
     }
 
+    // Until it is first overwritten, the property may have been folded into
+    // other jitcode and stores to it must go through the VM.
+    if (types::TrackConstantProperties(cx) && propertyTypes && propertyTypes->isConstantProperty(cx))
+        return jsop_setprop(name);
+
     MInstruction *global = MConstant::New(ObjectValue(*globalObj));
     current->add(global);
 
@@ -5112,7 +5149,11 @@ IonBuilder::jsop_setelem()
     MDefinition *index = current->pop();
     MDefinition *object = current->pop();
 
-    MInstruction *ins = MCallSetElement::New(object, index, value);
+    MInstruction *ins;
+    if (oracle->elementWriteIsCacheable(script, pc))
+        ins = MSetElementCache::New(object, index, value, script->strictModeCode);
+    else
+        ins = MCallSetElement::New(object, index, value);
     current->add(ins);
     current->push(value);
 
@@ -5640,6 +5681,17 @@ IonBuilder::annotateGetPropertyCache(JSContext *cx, MDefinition *obj, MGetProper
     return true;
 }
 
+// Returns true if the outermost script is being compiled with some of its
+// arguments specialized.
+bool
+IonBuilder::specializingOuterScript()
+{
+    IonBuilder *builder = this;
+    while (builder->callerBuilder_)
+        builder = builder->callerBuilder_;
+    return builder->specializedArgs_ != 0;
+}
+
 // Returns true if an idempotent cache has ever invalidated this script
 // or an outer script.
 bool
@@ -5793,6 +5845,18 @@ IonBuilder::jsop_getprop(HandlePropertyName name)
         if (!barrier && !IsNullOrUndefined(unary.rval))
             rvalType = unary.rval;
 
+        Shape *objShape = specializedShapeOf(obj);
+        if (objShape) {
+            Shape *shape = objShape->search(cx, NameToId(name));
+            if (shape && shape->hasSlot() && shape->hasDefaultGetter()) {
+                MGuardShape *guard = MGuardShape::New(obj, objShape, Bailout_ParameterCheck);
+                current->add(guard);
+
+                spew("Inlining GETPROP on a shape specialized argument");
+                return loadSlot(obj, shape, rvalType);
+            }
+        }
+
         if (Shape *objShape = mjit::GetPICSingleShape(cx, script, pc, info().constructing())) {
             // The JM IC was monomorphic, so we inline the property access.
             MGuardShape *guard = MGuardShape::New(obj, objShape);
@@ -5890,6 +5954,22 @@ IonBuilder::jsop_setprop(HandlePropertyName name)
     if (monitored) {
         ins = MCallSetProperty::New(obj, value, name, script->strictModeCode);
     } else {
+        Shape *objShape = specializedShapeOf(obj);
+        if (objShape) {
+            Shape *shape = objShape->search(cx, NameToId(name));
+            if (shape && shape->hasSlot() && shape->hasDefaultSetter() && shape->writable()) {
+                MGuardShape *guard = MGuardShape::New(obj, objShape, Bailout_ParameterCheck);
+                current->add(guard);
+
+                spew("Inlining SETPROP on a shape specialized argument");
+
+                jsid typeId = types::MakeTypeId(cx, id);
+                bool needsBarrier = oracle->propertyWriteNeedsBarrier(script, pc, typeId);
+
+                return storeSlot(obj, shape, value, needsBarrier);
+            }
+        }
+
         if (Shape *objShape = mjit::GetPICSingleShape(cx, script, pc, info().constructing())) {
             // The JM IC was monomorphic, so we inline the property access.
             MGuardShape *guard = MGuardShape::New(obj, objShape);
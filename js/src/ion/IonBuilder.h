@@ -17,6 +17,8 @@
 namespace js {
 namespace ion {
 
+class ParameterSpecialization;
+
 class IonBuilder : public MIRGenerator
 {
     enum ControlStatus {
@@ -56,15 +58,12 @@ class IonBuilder : public MIRGenerator
     // CFG can be built in a tree-like fashion.
     struct CFGState {
         enum State {
-            FAKE_IF,            // used to create a involving if when inverting a while
-            FAKE_IF_END,
             IF_TRUE,            // if() { }, no else.
             IF_TRUE_EMPTY_ELSE, // if() { }, empty else
             IF_ELSE_TRUE,       // if() { X } else { }
             IF_ELSE_FALSE,      // if() { } else { X }
             DO_WHILE_LOOP_BODY, // do { x } while ()
             DO_WHILE_LOOP_COND, // do { } while (x)
-            WHILE_OR_FOR_INVERTED, //used for inversion of WHILE_LOOP_COND
             WHILE_LOOP_COND,    // while (x) { }
             WHILE_LOOP_BODY,    // while () { x }
             FOR_LOOP_COND,      // for (; x;) { }
@@ -163,6 +162,14 @@ class IonBuilder : public MIRGenerator
 
     //PS
     int functionCalls;
+
+    // Mask of the arguments replaced by the values they had when compilation
+    // was triggered. See ParameterSpecialization::specializableArgs.
+    uint32 specializedArgs_;
+
+    // Shapes the object arguments have been specialized to, indexed by
+    // argument. NULL for arguments whose shape is unknown.
+    Vector<Shape *, 0, IonAllocPolicy> specializedShapes_;
     void eliminateRecompileChecks();
   public:
     IonBuilder(JSContext *cx, TempAllocator *temp, MIRGraph *graph,
@@ -201,8 +208,6 @@ class IonBuilder : public MIRGenerator
     ControlStatus processControlEnd();
     ControlStatus processCfgStack();
     ControlStatus processCfgEntry(CFGState &state);
-    ControlStatus processFakeIf(CFGState &state);
-    ControlStatus processFakeIfEnd(CFGState &state);
     ControlStatus processIfEnd(CFGState &state);
     ControlStatus processIfElseTrueEnd(CFGState &state);
     ControlStatus processIfElseFalseEnd(CFGState &state);
@@ -271,6 +276,9 @@ class IonBuilder : public MIRGenerator
     void insertRecompileCheck();
 
     bool initParameters();
+    bool specializeParameters();
+    bool initSpecializedShapes(ParameterSpecialization &ps);
+    Shape *specializedShapeOf(MDefinition *obj);
     void rewriteParameters();
     bool initScopeChain();
     bool pushConstant(const Value &v);
@@ -295,6 +303,7 @@ class IonBuilder : public MIRGenerator
     JSObject *getNewArrayTemplateObject(uint32 count);
 
     bool invalidatedIdempotentCache();
+    bool specializingOuterScript();
 
     bool loadSlot(MDefinition *obj, Shape *shape, MIRType rvalType);
     bool storeSlot(MDefinition *obj, Shape *shape, MDefinition *value, bool needsBarrier);
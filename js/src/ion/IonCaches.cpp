@@ -6,6 +6,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "jsscope.h"
+#include "jstypedarray.h"
 
 #include "CodeGenerator.h"
 #include "Ion.h"
@@ -14,7 +15,9 @@
 #include "IonSpewer.h"
 #include "VMFunctions.h"
 
+#include "jsinferinlines.h"
 #include "jsinterpinlines.h"
+#include "jstypedarrayinlines.h"
 
 #include "vm/Stack.h"
 #include "IonFrames-inl.h"
@@ -80,6 +83,14 @@ CodeOffsetJump::fixup(MacroAssembler *masm)
 
 static const size_t MAX_STUBS = 16;
 
+// Stubs for properties found on the prototype chain, which the megamorphic
+// table cannot hold, chained after its probe.
+static const size_t MAX_PROTO_STUBS = 4;
+
+// Call cache stubs are tried one after the other before every call, so call
+// sites with more callees take the generic path instead.
+static const size_t MAX_CALL_STUBS = 4;
+
 static void
 GeneratePrototypeGuards(JSContext *cx, MacroAssembler &masm, JSObject *obj, JSObject *holder,
                         Register objectReg, Register scratchReg, Label *failures)
@@ -198,6 +209,122 @@ struct GetNativePropertyStub
     }
 };
 
+void
+MegamorphicCache::add(JSObject *obj, const Shape *shape, PropertyName *name,
+                      types::TypeObject *type)
+{
+    JS_ASSERT(obj->isNative() && !obj->inDictionaryMode());
+    JS_ASSERT(obj->nativeContainsNoAllocation(*shape));
+
+    Entry &entry = entries_[hash(uintptr_t(obj->lastProperty()), uintptr_t(name))];
+    entry.shape = obj->lastProperty();
+    entry.name = name;
+    entry.type = type;
+    if (obj->isFixedSlot(shape->slot()))
+        entry.slot = JSObject::getFixedSlotOffset(shape->slot());
+    else
+        entry.slot = (obj->dynamicSlotIndex(shape->slot()) * sizeof(Value)) | DynamicSlotBit;
+}
+
+// Code probing a MegamorphicCache for the shape of an object and a property
+// name, which is either constant or a string in a boxed register. On a hit,
+// |slotAddress()| is the address of the property's slot.
+//
+// The two registers used by the probe are saved and must be restored by
+// calling |restore| on both the hit and miss paths.
+struct MegamorphicProbe
+{
+    Register entry_;
+    Register slot_;
+
+    // |regs| holds the registers not used by the cache.
+    MegamorphicProbe(RegisterSet regs) {
+        entry_ = regs.takeGeneral();
+        slot_ = regs.takeGeneral();
+    }
+
+    Address slotAddress() const {
+        return Address(slot_, 0);
+    }
+
+    void save(MacroAssembler &masm) {
+        masm.push(entry_);
+        masm.push(slot_);
+    }
+    void restore(MacroAssembler &masm) {
+        masm.pop(slot_);
+        masm.pop(entry_);
+    }
+
+    void generate(MacroAssembler &masm, MegamorphicCache *table, Register object,
+                  PropertyName *name, ValueOperand *nameValue, bool guardType, Label *miss)
+    {
+        JS_ASSERT(!name != !nameValue);
+
+        if (nameValue)
+            masm.branchTestString(Assembler::NotEqual, *nameValue, miss);
+
+        // Compute MegamorphicCache::hash, and the address of the entry.
+        masm.loadPtr(Address(object, JSObject::offsetOfShape()), entry_);
+        masm.rshiftPtr(Imm32(MegamorphicCache::CellShift), entry_);
+        if (name) {
+            uintptr_t nameHash = uintptr_t(name) >> MegamorphicCache::CellShift;
+            masm.addPtr(Imm32(nameHash & (MegamorphicCache::NumEntries - 1)), entry_);
+        } else {
+            masm.unboxValue(*nameValue, AnyRegister(slot_));
+            masm.rshiftPtr(Imm32(MegamorphicCache::CellShift), slot_);
+            masm.addPtr(slot_, entry_);
+        }
+        masm.and32(Imm32(MegamorphicCache::NumEntries - 1), entry_);
+        masm.lshiftPtr(Imm32(MegamorphicCache::EntryShift), entry_);
+        masm.movePtr(ImmWord(table->entries()), slot_);
+        masm.addPtr(slot_, entry_);
+
+        // Check the entry is for this shape, name and type.
+        masm.loadPtr(Address(object, JSObject::offsetOfShape()), slot_);
+        masm.branchPtr(Assembler::NotEqual,
+                       Address(entry_, offsetof(MegamorphicCache::Entry, shape)), slot_, miss);
+        if (name) {
+            masm.branchPtr(Assembler::NotEqual,
+                           Address(entry_, offsetof(MegamorphicCache::Entry, name)),
+                           ImmGCPtr(name), miss);
+        } else {
+            masm.unboxValue(*nameValue, AnyRegister(slot_));
+            masm.branchPtr(Assembler::NotEqual,
+                           Address(entry_, offsetof(MegamorphicCache::Entry, name)), slot_, miss);
+        }
+        if (guardType) {
+            masm.loadPtr(Address(object, JSObject::offsetOfType()), slot_);
+            masm.branchPtr(Assembler::NotEqual,
+                           Address(entry_, offsetof(MegamorphicCache::Entry, type)), slot_, miss);
+        }
+
+        // Compute the address of the slot.
+        Label fixedSlot, done;
+        masm.loadPtr(Address(entry_, offsetof(MegamorphicCache::Entry, slot)), slot_);
+        masm.branchTest32(Assembler::Zero, slot_, Imm32(MegamorphicCache::DynamicSlotBit),
+                          &fixedSlot);
+        masm.loadPtr(Address(object, JSObject::offsetOfSlots()), entry_);
+        masm.addPtr(entry_, slot_);
+        masm.addPtr(Imm32(-int32_t(MegamorphicCache::DynamicSlotBit)), slot_);
+        masm.jump(&done);
+        masm.bind(&fixedSlot);
+        masm.addPtr(object, slot_);
+        masm.bind(&done);
+    }
+};
+
+// Whether the property |shape| of |obj| can be found by MegamorphicProbe.
+static bool
+IsMegamorphicProperty(JSObject *obj, JSObject *holder, const Shape *shape)
+{
+    return obj == holder &&
+           obj->isNative() &&
+           !obj->inDictionaryMode() &&
+           shape &&
+           shape->hasSlot();
+}
+
 bool
 IonCacheGetProperty::attachNative(JSContext *cx, JSObject *obj, JSObject *holder, const Shape *shape)
 {
@@ -229,6 +356,47 @@ IonCacheGetProperty::attachNative(JSContext *cx, JSObject *obj, JSObject *holder
     return true;
 }
 
+bool
+IonCacheGetProperty::attachMegamorphic(JSContext *cx, MegamorphicCache *table)
+{
+    MacroAssembler masm;
+    Label miss;
+
+    RegisterSet regs = RegisterSet::All();
+    regs.maybeTake(object());
+    regs.maybeTake(output());
+    MegamorphicProbe probe(regs);
+
+    probe.save(masm);
+    probe.generate(masm, table, object(), name(), NULL, false, &miss);
+    masm.loadTypedOrValue(probe.slotAddress(), output());
+    probe.restore(masm);
+
+    RepatchLabel rejoin_;
+    CodeOffsetJump rejoinOffset = masm.jumpWithPatch(&rejoin_);
+    masm.bind(&rejoin_);
+
+    masm.bind(&miss);
+    probe.restore(masm);
+
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    rejoinOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    linkMegamorphic(code, CodeLocationJump(code, rejoinOffset), CodeLocationJump(code, exitOffset));
+
+    IonSpew(IonSpew_InlineCaches, "Generated megamorphic GETPROP stub at %p", code->raw());
+    return true;
+}
+
 static bool
 IsCacheableProtoChain(JSObject *obj, JSObject *holder)
 {
@@ -285,6 +453,21 @@ TryAttachNativeStub(JSContext *cx, IonCacheGetProperty &cache, HandleObject obj,
 
         if (!cache.attachNative(cx, obj, holder, shape))
             return false;
+    } else {
+        MegamorphicCache *table = cx->compartment->ionCompartment()->getPropertyTable(cx);
+        if (!table)
+            return false;
+        if (!cache.megamorphic() && !cache.attachMegamorphic(cx, table))
+            return false;
+
+        if (IsMegamorphicProperty(obj, holder, shape)) {
+            table->add(obj, shape, name, NULL);
+        } else if (cache.stubCount() < MAX_STUBS + MAX_PROTO_STUBS) {
+            cache.incrementStubCount();
+
+            if (!cache.attachNative(cx, obj, holder, shape))
+                return false;
+        }
     }
 
     return true;
@@ -310,9 +493,9 @@ js::ion::GetPropertyCache(JSContext *cx, size_t cacheIndex, HandleObject obj, Mu
     if (cache.idempotent())
         adi.disable();
 
-    // For now, just stop generating new stubs once we hit the stub count
-    // limit. Once we can make calls from within generated stubs, a new call
-    // stub will be generated instead and the previous stubs unlinked.
+    // Once the stub count limit is hit, the cache becomes megamorphic and
+    // the previous stubs are unlinked, see MegamorphicCache. Reads from the
+    // prototype chain still get stubs, after the probe.
     bool isCacheableNative = false;
     if (!TryAttachNativeStub(cx, cache, obj, name, &isCacheableNative))
         return false;
@@ -366,6 +549,9 @@ IonCache::updateBaseAddress(IonCode *code, MacroAssembler &masm)
     initialJump_.repoint(code, &masm);
     lastJump_.repoint(code, &masm);
     cacheLabel_.repoint(code, &masm);
+
+    if (kind_ == Call)
+        toCall().updateFallbackLabel(code, masm);
 }
 
 void
@@ -374,7 +560,26 @@ IonCache::reset()
     PatchJump(initialJump_, cacheLabel_);
 
     this->stubCount_ = 0;
+    this->megamorphic_ = false;
     this->lastJump_ = initialJump_;
+
+    if (kind_ == SetElement)
+        toSetElement().resetStubs();
+}
+
+void
+IonCache::linkMegamorphic(IonCode *code, CodeLocationJump rejoinJump, CodeLocationJump exitJump)
+{
+    JS_ASSERT(!megamorphic_);
+
+    // The stubs attached so far are dropped: the initial jump goes straight
+    // to the probe, and misses go back to the cache function.
+    PatchJump(initialJump_, CodeLocationLabel(code));
+    PatchJump(rejoinJump, rejoinLabel());
+    PatchJump(exitJump, cacheLabel());
+    updateLastJump(exitJump);
+
+    megamorphic_ = true;
 }
 
 bool
@@ -517,6 +722,50 @@ IonCacheSetProperty::attachNativeAdding(JSContext *cx, JSObject *obj, const Shap
     return true;
 }
 
+bool
+IonCacheSetProperty::attachMegamorphic(JSContext *cx, MegamorphicCache *table)
+{
+    MacroAssembler masm;
+    Label miss;
+
+    RegisterSet regs = RegisterSet::All();
+    regs.maybeTake(object());
+    if (!value().constant())
+        regs.maybeTake(value().reg());
+    MegamorphicProbe probe(regs);
+
+    probe.save(masm);
+    probe.generate(masm, table, object(), name(), NULL, true, &miss);
+    if (cx->compartment->needsBarrier())
+        masm.callPreBarrier(probe.slotAddress(), MIRType_Value);
+    masm.storeConstantOrRegister(value(), probe.slotAddress());
+    probe.restore(masm);
+
+    RepatchLabel rejoin_;
+    CodeOffsetJump rejoinOffset = masm.jumpWithPatch(&rejoin_);
+    masm.bind(&rejoin_);
+
+    masm.bind(&miss);
+    probe.restore(masm);
+
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    rejoinOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    linkMegamorphic(code, CodeLocationJump(code, rejoinOffset), CodeLocationJump(code, exitOffset));
+
+    IonSpew(IonSpew_InlineCaches, "Generated megamorphic SETPROP stub at %p", code->raw());
+    return true;
+}
+
 static bool
 IsPropertyInlineable(JSObject *obj, IonCacheSetProperty &cache)
 {
@@ -555,6 +804,10 @@ IsPropertySetInlineable(JSContext *cx, HandleObject obj, JSAtom *atom, jsid *pId
     if (!shape->writable())
         return false;
 
+    // Overwriting a constant property must go through the VM to be noticed.
+    if (types::HasConstantProperty(cx, obj, id))
+        return false;
+
     return true;
 }
 
@@ -618,6 +871,17 @@ js::ion::SetPropertyCache(JSContext *cx, size_t cacheIndex, HandleObject obj, Ha
         cache.incrementStubCount();
         if (!cache.attachNativeExisting(cx, obj, shape))
             return false;
+    } else if (!inlinable && cache.stubCount() >= MAX_STUBS && obj->isNative() &&
+               !obj->watched() && !obj->hasSingletonType() &&
+               IsPropertySetInlineable(cx, obj, name, &id, &shape) &&
+               IsMegamorphicProperty(obj, obj, shape))
+    {
+        MegamorphicCache *table = cx->compartment->ionCompartment()->setPropertyTable(cx);
+        if (!table)
+            return false;
+        if (!cache.megamorphic() && !cache.attachMegamorphic(cx, table))
+            return false;
+        table->add(obj, shape, name, obj->type());
     }
 
     uint32_t oldSlots = obj->numDynamicSlots();
@@ -685,6 +949,71 @@ IonCacheGetElement::attachGetProp(JSContext *cx, JSObject *obj, const Value &idv
     return true;
 }
 
+RegisterSet
+IonCacheGetElement::megamorphicRegisters() const
+{
+    RegisterSet regs = RegisterSet::All();
+    regs.maybeTake(object());
+    regs.maybeTake(index().reg());
+    regs.maybeTake(output());
+    return regs;
+}
+
+bool
+IonCacheGetElement::canAttachMegamorphic() const
+{
+    // Named properties are only looked up in the table if the index is boxed.
+    // With a boxed output too, there may not be enough registers left for the
+    // probe on 32 bit platforms.
+    if (index().constant() || !index().reg().hasValue())
+        return false;
+    return megamorphicRegisters().gprs().size() >= 2;
+}
+
+bool
+IonCacheGetElement::attachMegamorphic(JSContext *cx, MegamorphicCache *table)
+{
+    JS_ASSERT(canAttachMegamorphic());
+
+    MacroAssembler masm;
+    Label miss;
+
+    ValueOperand val = index().reg().valueReg();
+    MegamorphicProbe probe(megamorphicRegisters());
+
+    probe.save(masm);
+    probe.generate(masm, table, object(), NULL, &val, false, &miss);
+    masm.loadTypedOrValue(probe.slotAddress(), output());
+    probe.restore(masm);
+
+    RepatchLabel rejoin_;
+    CodeOffsetJump rejoinOffset = masm.jumpWithPatch(&rejoin_);
+    masm.bind(&rejoin_);
+
+    masm.bind(&miss);
+    probe.restore(masm);
+
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    rejoinOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    // The dense array stub, if any, has been unlinked and may be attached
+    // again after the probe.
+    linkMegamorphic(code, CodeLocationJump(code, rejoinOffset), CodeLocationJump(code, exitOffset));
+    u.getelem.hasDenseArrayStub = false;
+
+    IonSpew(IonSpew_InlineCaches, "Generated megamorphic GETELEM stub at %p", code->raw());
+    return true;
+}
+
 // Get the common shape used by all dense arrays with a prototype at globalObj.
 static inline Shape *
 GetDenseArrayShape(JSContext *cx, JSObject *globalObj)
@@ -788,12 +1117,14 @@ js::ion::GetElementCache(JSContext *cx, size_t cacheIndex, JSObject *obj, const
     if (!FetchElementId(cx, obj, idval, id.address(), res))
         return false;
 
+    uint32_t dummy;
+    bool isName = idval.isString() && JSID_IS_ATOM(id) && !JSID_TO_ATOM(id)->isIndex(&dummy);
+
     if (cache.stubCount() < MAX_STUBS) {
         if (obj->isNative() && cache.monitoredResult()) {
             cache.incrementStubCount();
 
-            uint32_t dummy;
-            if (idval.isString() && JSID_IS_ATOM(id) && !JSID_TO_ATOM(id)->isIndex(&dummy)) {
+            if (isName) {
                 if (!cache.attachGetProp(cx, obj, idval, JSID_TO_ATOM(id)->asPropertyName()))
                     return false;
             }
@@ -804,6 +1135,25 @@ js::ion::GetElementCache(JSContext *cx, size_t cacheIndex, JSObject *obj, const
             if (!cache.attachDenseArray(cx, obj, idval))
                 return false;
         }
+    } else if (obj->isNative() && cache.monitoredResult() && isName &&
+               cache.canAttachMegamorphic())
+    {
+        PropertyName *name = JSID_TO_ATOM(id)->asPropertyName();
+        const Shape *shape = obj->nativeLookup(cx, id);
+        if (IsMegamorphicProperty(obj, obj, shape) && shape->hasDefaultGetter()) {
+            MegamorphicCache *table = cx->compartment->ionCompartment()->getPropertyTable(cx);
+            if (!table)
+                return false;
+            if (!cache.megamorphic() && !cache.attachMegamorphic(cx, table))
+                return false;
+            table->add(obj, shape, name, NULL);
+        }
+    } else if (cache.megamorphic() && !cache.hasDenseArrayStub() && obj->isDenseArray() &&
+               idval.isInt32())
+    {
+        // Dense arrays are not in the table, keep a stub for them after the probe.
+        if (!cache.attachDenseArray(cx, obj, idval))
+            return false;
     }
 
     JSScript *script;
@@ -817,24 +1167,118 @@ js::ion::GetElementCache(JSContext *cx, size_t cacheIndex, JSObject *obj, const
     return true;
 }
 
+// Whether holes in dense arrays can be filled and elements appended without
+// looking at the prototype chain, see js_PrototypeHasIndexedProperties.
+static bool
+CanFillDenseArrayHoles(JSObject *obj)
+{
+    for (JSObject *proto = obj->getProto(); proto; proto = proto->getProto()) {
+        if (!proto->isNative() || proto->isIndexed() || proto->hasUncacheableProto())
+            return false;
+    }
+    return true;
+}
+
+// Moves the int32 index of an element to |dest|, after checking its type if
+// it is boxed.
+static void
+GenerateInt32Index(MacroAssembler &masm, TypedOrValueRegister index, Register dest,
+                   Label *failures)
+{
+    if (index.hasValue()) {
+        masm.branchTestInt32(Assembler::NotEqual, index.valueReg(), failures);
+        masm.unboxInt32(index.valueReg(), dest);
+    } else {
+        JS_ASSERT(index.type() == MIRType_Int32);
+        masm.movePtr(index.typedReg().gpr(), dest);
+    }
+}
+
 bool
-IonCacheBindName::attachGlobal(JSContext *cx, JSObject *scopeChain)
+IonCacheSetElement::attachDenseArray(JSContext *cx, JSObject *obj)
 {
-    JS_ASSERT(scopeChain->isGlobal());
+    JS_ASSERT(obj->isDenseArray());
 
+    Label failures, elementFailures, protoFailures;
     MacroAssembler masm;
 
-    // Guard on the scope chain.
-    RepatchLabel exit_;
-    CodeOffsetJump exitOffset = masm.branchPtrWithPatch(Assembler::NotEqual, scopeChainReg(),
-                                                        ImmGCPtr(scopeChain), &exit_);
-    masm.bind(&exit_);
-    masm.movePtr(ImmGCPtr(scopeChain), outputReg());
+    // Guard object is a dense array.
+    RootedShape shape(cx, GetDenseArrayShape(cx, &script->global()));
+    if (!shape)
+        return false;
+    masm.branchTestObjShape(Assembler::NotEqual, object(), shape, &failures);
+
+    // Ensure the index is an int32 value.
+    GenerateInt32Index(masm, index(), temp(), &failures);
+
+    // Load elements vector.
+    masm.push(object());
+    masm.loadPtr(Address(object(), JSObject::offsetOfElements()), object());
+
+    Address initLength(object(), ObjectElements::offsetOfInitializedLength());
+    BaseIndex target(object(), temp(), TimesEight);
+
+    // Overwrite an existing element.
+    Label holeOrAppend, store;
+    masm.branch32(Assembler::BelowOrEqual, initLength, temp(), &holeOrAppend);
+    masm.branchTestMagic(Assembler::Equal, target, &holeOrAppend);
+    if (cx->compartment->needsBarrier())
+        masm.callPreBarrier(target, MIRType_Value);
 
+    masm.bind(&store);
+    masm.storeTypedOrValue(value(), target);
+
+    masm.pop(object());
     RepatchLabel rejoin_;
     CodeOffsetJump rejoinOffset = masm.jumpWithPatch(&rejoin_);
     masm.bind(&rejoin_);
 
+    // Fill a hole or append an element, provided the prototypes still have no
+    // indexed properties.
+    masm.bind(&holeOrAppend);
+    if (CanFillDenseArrayHoles(obj)) {
+        masm.push(temp());
+        for (JSObject *proto = obj->getProto(); proto; proto = proto->getProto()) {
+            masm.movePtr(ImmGCPtr(proto), temp());
+            masm.branchTestObjShape(Assembler::NotEqual, temp(), proto->lastProperty(),
+                                    &protoFailures);
+        }
+        masm.pop(temp());
+
+        masm.branch32(Assembler::Above, initLength, temp(), &store);
+
+        // Only append at the initialized length and within the capacity, see
+        // visitOutOfLineStoreElementHole.
+        masm.branch32(Assembler::NotEqual, initLength, temp(), &elementFailures);
+        masm.branch32(Assembler::BelowOrEqual,
+                      Address(object(), ObjectElements::offsetOfCapacity()), temp(),
+                      &elementFailures);
+
+        masm.add32(Imm32(1), temp());
+        masm.store32(temp(), initLength);
+
+        Label dontUpdate;
+        Address length(object(), ObjectElements::offsetOfLength());
+        masm.branch32(Assembler::AboveOrEqual, length, temp(), &dontUpdate);
+        masm.store32(temp(), length);
+        masm.bind(&dontUpdate);
+
+        masm.sub32(Imm32(1), temp());
+        masm.jump(&store);
+
+        masm.bind(&protoFailures);
+        masm.pop(temp());
+    }
+
+    // All failures flow to here.
+    masm.bind(&elementFailures);
+    masm.pop(object());
+    masm.bind(&failures);
+
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
     Linker linker(masm);
     IonCode *code = linker.newCode(cx);
     if (!code)
@@ -851,53 +1295,401 @@ IonCacheBindName::attachGlobal(JSContext *cx, JSObject *scopeChain)
     PatchJump(exitJump, cacheLabel());
     updateLastJump(exitJump);
 
-    IonSpew(IonSpew_InlineCaches, "Generated BINDNAME global stub at %p", code->raw());
+    setHasDenseArrayStub();
+    IonSpew(IonSpew_InlineCaches, "Generated SETELEM dense array stub at %p", code->raw());
+
     return true;
 }
 
-static inline void
-GenerateScopeChainGuard(MacroAssembler &masm, JSObject *scopeObj,
-                        Register scopeObjReg, Shape *shape, Label *failures)
+bool
+IonCacheSetElement::canAttachTypedArray(int arrayType) const
 {
-    if (scopeObj->isCall()) {
-        // We can skip a guard on the call object if the script's bindings are
-        // guaranteed to be immutable (and thus cannot introduce shadowing
-        // variables).
-        CallObject *callObj = &scopeObj->asCall();
-        if (!callObj->isForEval()) {
-            JSFunction *fun = &callObj->callee();
-            JSScript *script = fun->script();
-            if (!script->bindings.extensibleParents() && !script->funHasExtensibleScope)
-                return;
-        }
-    } else if (scopeObj->isGlobal()) {
-        // If this is the last object on the scope walk, and the property we've
-        // found is not configurable, then we don't need a shape guard because
-        // the shape cannot be removed.
-        if (shape && !shape->configurable())
-            return;
-    }
+    if (hasTypedArrayStub(arrayType))
+        return false;
 
-    Address shapeAddr(scopeObjReg, JSObject::offsetOfShape());
-    masm.branchPtr(Assembler::NotEqual, shapeAddr, ImmGCPtr(scopeObj->lastProperty()), failures);
+    // Bytes are stored from the temp register, which on x86 may not have a
+    // byte form.
+    if (TypedArray::slotWidth(arrayType) == 1)
+        return GeneralRegisterSet(Registers::SingleByteRegs).has(temp());
+    return true;
 }
 
-static void
-GenerateScopeChainGuards(MacroAssembler &masm, JSObject *scopeChain, JSObject *holder,
-                         Register outputReg, Label *failures)
+bool
+IonCacheSetElement::attachTypedArray(JSContext *cx, JSObject *obj)
 {
-    JSObject *tobj = scopeChain;
+    JS_ASSERT(obj->isTypedArray());
 
-    // Walk up the scope chain. Note that IsCacheableScopeChain guarantees the
-    // |tobj == holder| condition terminates the loop.
-    while (true) {
-        JS_ASSERT(IsCacheableNonGlobalScope(tobj) || tobj->isGlobal());
+    int arrayType = TypedArray::type(obj);
+    int width = TypedArray::slotWidth(arrayType);
+    bool isFloat = arrayType == TypedArray::TYPE_FLOAT32 || arrayType == TypedArray::TYPE_FLOAT64;
+    bool isClamped = arrayType == TypedArray::TYPE_UINT8_CLAMPED;
 
-        GenerateScopeChainGuard(masm, tobj, outputReg, NULL, failures);
-        if (tobj == holder)
-            break;
+    Label failures, elementFailures;
+    MacroAssembler masm;
 
-        // Load the next link.
+    // Guard on the class of the array, which determines the element type.
+    masm.branchTestObjClass(Assembler::NotEqual, object(), temp(), obj->getClass(), &failures);
+
+    // Ensure the index is an int32 value within bounds.
+    GenerateInt32Index(masm, index(), temp(), &failures);
+    masm.branch32(Assembler::BelowOrEqual, Address(object(), TypedArray::lengthOffset()), temp(),
+                  &failures);
+
+    // Compute the address of the element in the object register, so that the
+    // temp register can hold the converted value.
+    masm.push(object());
+    masm.loadPtr(Address(object(), TypedArray::dataOffset()), object());
+    if (width > 1)
+        masm.lshiftPtr(Imm32(ScaleFromShift(width)), temp());
+    masm.addPtr(temp(), object());
+    Address target(object(), 0);
+
+    // Convert the value to the element type, in the temp register for integer
+    // arrays and in a float register for float arrays. Typed values are only
+    // converted from their own type.
+    TypedOrValueRegister value = this->value();
+    JS_ASSERT_IF(!value.hasValue(),
+                 value.type() == MIRType_Int32 || value.type() == MIRType_Double);
+    bool maybeInt32 = value.hasValue() || value.type() == MIRType_Int32;
+    bool maybeDouble = value.hasValue() || value.type() == MIRType_Double;
+    FloatRegister floatValue = maybeInt32 ? tempFloat() : value.typedReg().fpu();
+
+    Label isDouble, store;
+    if (maybeInt32) {
+        if (value.hasValue()) {
+            masm.branchTestInt32(Assembler::NotEqual, value.valueReg(), &isDouble);
+            masm.unboxInt32(value.valueReg(), temp());
+        } else {
+            masm.movePtr(value.typedReg().gpr(), temp());
+        }
+        if (isFloat) {
+            masm.convertInt32ToDouble(temp(), tempFloat());
+        } else if (isClamped) {
+            masm.clampIntToUint8(temp(), temp());
+        }
+        masm.jump(&store);
+    }
+
+    masm.bind(&isDouble);
+    if (maybeDouble) {
+        if (value.hasValue()) {
+            masm.branchTestDouble(Assembler::NotEqual, value.valueReg(), &elementFailures);
+            masm.unboxDouble(value.valueReg(), floatValue);
+        }
+        if (isClamped)
+            masm.clampDoubleToUint8(floatValue, temp());
+        else if (!isFloat)
+            masm.branchTruncateDouble(floatValue, temp(), &elementFailures);
+    }
+
+    masm.bind(&store);
+    if (isFloat)
+        masm.storeToTypedFloatArray(arrayType, floatValue, target);
+    else
+        masm.storeToTypedIntArray(arrayType, temp(), target);
+
+    masm.pop(object());
+    RepatchLabel rejoin_;
+    CodeOffsetJump rejoinOffset = masm.jumpWithPatch(&rejoin_);
+    masm.bind(&rejoin_);
+
+    // All failures flow to here.
+    masm.bind(&elementFailures);
+    masm.pop(object());
+    masm.bind(&failures);
+
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    rejoinOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    CodeLocationJump rejoinJump(code, rejoinOffset);
+    CodeLocationJump exitJump(code, exitOffset);
+    CodeLocationJump lastJump_ = lastJump();
+    PatchJump(lastJump_, CodeLocationLabel(code));
+    PatchJump(rejoinJump, rejoinLabel());
+    PatchJump(exitJump, cacheLabel());
+    updateLastJump(exitJump);
+
+    setHasTypedArrayStub(arrayType);
+    IonSpew(IonSpew_InlineCaches, "Generated SETELEM typed array stub at %p", code->raw());
+
+    return true;
+}
+
+static void
+GenerateValueTypeGuard(MacroAssembler &masm, ValueOperand value, JSValueType type,
+                       Label *failures)
+{
+    switch (type) {
+      case JSVAL_TYPE_DOUBLE:
+        masm.branchTestDouble(Assembler::NotEqual, value, failures);
+        break;
+      case JSVAL_TYPE_INT32:
+        masm.branchTestInt32(Assembler::NotEqual, value, failures);
+        break;
+      case JSVAL_TYPE_BOOLEAN:
+        masm.branchTestBoolean(Assembler::NotEqual, value, failures);
+        break;
+      case JSVAL_TYPE_UNDEFINED:
+        masm.branchTestUndefined(Assembler::NotEqual, value, failures);
+        break;
+      case JSVAL_TYPE_NULL:
+        masm.branchTestNull(Assembler::NotEqual, value, failures);
+        break;
+      case JSVAL_TYPE_STRING:
+        masm.branchTestString(Assembler::NotEqual, value, failures);
+        break;
+      case JSVAL_TYPE_OBJECT:
+        masm.branchTestObject(Assembler::NotEqual, value, failures);
+        break;
+      default:
+        JS_NOT_REACHED("Unexpected value type");
+    }
+}
+
+bool
+IonCacheSetElement::attachSetProp(JSContext *cx, JSObject *obj, const Value &idval,
+                                  const Shape *shape, JSValueType valueType)
+{
+    JS_ASSERT(idval.isString());
+
+    Label failures;
+    MacroAssembler masm;
+
+    // Guard on the name, the shape and the type of the object, and on the
+    // type of the value: the stub does not update the property types.
+    if (index().hasValue()) {
+        masm.branchTestValue(Assembler::NotEqual, index().valueReg(), idval, &failures);
+    } else {
+        JS_ASSERT(index().type() == MIRType_String);
+        masm.branchPtr(Assembler::NotEqual, index().typedReg().gpr(),
+                       ImmGCPtr(idval.toString()), &failures);
+    }
+    masm.branchTestObjShape(Assembler::NotEqual, object(), obj->lastProperty(), &failures);
+    masm.branchPtr(Assembler::NotEqual, Address(object(), JSObject::offsetOfType()),
+                   ImmGCPtr(obj->type()), &failures);
+    if (value().hasValue())
+        GenerateValueTypeGuard(masm, value().valueReg(), valueType, &failures);
+    else
+        JS_ASSERT(ValueTypeFromMIRType(value().type()) == valueType);
+
+    if (obj->isFixedSlot(shape->slot())) {
+        Address addr(object(), JSObject::getFixedSlotOffset(shape->slot()));
+
+        if (cx->compartment->needsBarrier())
+            masm.callPreBarrier(addr, MIRType_Value);
+
+        masm.storeTypedOrValue(value(), addr);
+    } else {
+        masm.loadPtr(Address(object(), JSObject::offsetOfSlots()), temp());
+
+        Address addr(temp(), obj->dynamicSlotIndex(shape->slot()) * sizeof(Value));
+
+        if (cx->compartment->needsBarrier())
+            masm.callPreBarrier(addr, MIRType_Value);
+
+        masm.storeTypedOrValue(value(), addr);
+    }
+
+    RepatchLabel rejoin_;
+    CodeOffsetJump rejoinOffset = masm.jumpWithPatch(&rejoin_);
+    masm.bind(&rejoin_);
+
+    masm.bind(&failures);
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    rejoinOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    CodeLocationJump rejoinJump(code, rejoinOffset);
+    CodeLocationJump exitJump(code, exitOffset);
+    CodeLocationJump lastJump_ = lastJump();
+    PatchJump(lastJump_, CodeLocationLabel(code));
+    PatchJump(rejoinJump, rejoinLabel());
+    PatchJump(exitJump, cacheLabel());
+    updateLastJump(exitJump);
+
+    IonSpew(IonSpew_InlineCaches, "Generated SETELEM property stub at %p", code->raw());
+
+    return true;
+}
+
+// Whether a stub may store a value of |valueType| in the property |id| of
+// |obj| without the type information having to be updated.
+static bool
+IsElementSetPropTypeable(JSContext *cx, JSObject *obj, jsid id, const Value &value)
+{
+    if (obj->hasLazyType())
+        return false;
+
+    types::TypeObject *type = obj->type();
+    if (type->unknownProperties())
+        return true;
+
+    types::TypeSet *propTypes = type->maybeGetProperty(cx, id);
+    if (!propTypes)
+        return false;
+
+    // Any object stored must already be covered by the property types.
+    if (value.isObject())
+        return propTypes->unknownObject();
+
+    return propTypes->hasType(types::GetValueType(cx, value));
+}
+
+bool
+js::ion::SetElementCache(JSContext *cx, size_t cacheIndex, HandleObject obj, HandleValue idval,
+                         HandleValue value)
+{
+    IonScript *ion = GetTopIonJSScript(cx)->ionScript();
+    IonCacheSetElement &cache = ion->getCache(cacheIndex).toSetElement();
+
+    RootedId id(cx);
+    const Shape *shape = NULL;
+
+    if (cache.stubCount() < MAX_STUBS) {
+        if (obj->isDenseArray() && idval.isInt32()) {
+            // Generate at most one dense array stub.
+            if (!cache.hasDenseArrayStub()) {
+                cache.incrementStubCount();
+                if (!cache.attachDenseArray(cx, obj))
+                    return false;
+            }
+        } else if (obj->isTypedArray() && idval.isInt32() && value.isNumber()) {
+            // Generate at most one stub per typed array type.
+            if (cache.canAttachTypedArray(TypedArray::type(obj))) {
+                cache.incrementStubCount();
+                if (!cache.attachTypedArray(cx, obj))
+                    return false;
+            }
+        } else if (idval.isString() && obj->isNative() && !obj->watched()) {
+            if (!ValueToId(cx, idval, id.address()))
+                return false;
+
+            uint32_t dummy;
+            if (JSID_IS_ATOM(id) && !JSID_TO_ATOM(id)->isIndex(&dummy)) {
+                jsid unused;
+                if (!IsPropertySetInlineable(cx, obj, JSID_TO_ATOM(id), &unused, &shape))
+                    shape = NULL;
+            }
+        }
+    }
+
+    const Shape *oldShape = obj->lastProperty();
+
+    if (!SetObjectElement(cx, obj, idval, value, cache.strict()))
+        return false;
+
+    // Existing properties are only cached once written, so that the type of
+    // the value has been added to the property types.
+    if (shape && obj->lastProperty() == oldShape && IsElementSetPropTypeable(cx, obj, id, value)) {
+        JSValueType valueType = value.isDouble()
+                                ? JSVAL_TYPE_DOUBLE
+                                : value.get().extractNonDoubleType();
+        cache.incrementStubCount();
+        if (!cache.attachSetProp(cx, obj, idval, shape, valueType))
+            return false;
+    }
+
+    return true;
+}
+
+bool
+IonCacheBindName::attachGlobal(JSContext *cx, JSObject *scopeChain)
+{
+    JS_ASSERT(scopeChain->isGlobal());
+
+    MacroAssembler masm;
+
+    // Guard on the scope chain.
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.branchPtrWithPatch(Assembler::NotEqual, scopeChainReg(),
+                                                        ImmGCPtr(scopeChain), &exit_);
+    masm.bind(&exit_);
+    masm.movePtr(ImmGCPtr(scopeChain), outputReg());
+
+    RepatchLabel rejoin_;
+    CodeOffsetJump rejoinOffset = masm.jumpWithPatch(&rejoin_);
+    masm.bind(&rejoin_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    rejoinOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    CodeLocationJump rejoinJump(code, rejoinOffset);
+    CodeLocationJump exitJump(code, exitOffset);
+    CodeLocationJump lastJump_ = lastJump();
+    PatchJump(lastJump_, CodeLocationLabel(code));
+    PatchJump(rejoinJump, rejoinLabel());
+    PatchJump(exitJump, cacheLabel());
+    updateLastJump(exitJump);
+
+    IonSpew(IonSpew_InlineCaches, "Generated BINDNAME global stub at %p", code->raw());
+    return true;
+}
+
+static inline void
+GenerateScopeChainGuard(MacroAssembler &masm, JSObject *scopeObj,
+                        Register scopeObjReg, Shape *shape, Label *failures)
+{
+    if (scopeObj->isCall()) {
+        // We can skip a guard on the call object if the script's bindings are
+        // guaranteed to be immutable (and thus cannot introduce shadowing
+        // variables).
+        CallObject *callObj = &scopeObj->asCall();
+        if (!callObj->isForEval()) {
+            JSFunction *fun = &callObj->callee();
+            JSScript *script = fun->script();
+            if (!script->bindings.extensibleParents() && !script->funHasExtensibleScope)
+                return;
+        }
+    } else if (scopeObj->isGlobal()) {
+        // If this is the last object on the scope walk, and the property we've
+        // found is not configurable, then we don't need a shape guard because
+        // the shape cannot be removed.
+        if (shape && !shape->configurable())
+            return;
+    }
+
+    Address shapeAddr(scopeObjReg, JSObject::offsetOfShape());
+    masm.branchPtr(Assembler::NotEqual, shapeAddr, ImmGCPtr(scopeObj->lastProperty()), failures);
+}
+
+static void
+GenerateScopeChainGuards(MacroAssembler &masm, JSObject *scopeChain, JSObject *holder,
+                         Register outputReg, Label *failures)
+{
+    JSObject *tobj = scopeChain;
+
+    // Walk up the scope chain. Note that IsCacheableScopeChain guarantees the
+    // |tobj == holder| condition terminates the loop.
+    while (true) {
+        JS_ASSERT(IsCacheableNonGlobalScope(tobj) || tobj->isGlobal());
+
+        GenerateScopeChainGuard(masm, tobj, outputReg, NULL, failures);
+        if (tobj == holder)
+            break;
+
+        // Load the next link.
         tobj = &tobj->asScope().enclosingScope();
         masm.extractObject(Address(outputReg, ScopeObject::offsetOfEnclosingScope()), outputReg);
     }
@@ -1158,3 +1950,186 @@ js::ion::GetNameCache(JSContext *cx, size_t cacheIndex, HandleObject scopeChain,
     return true;
 }
 
+void
+IonCacheCall::updateFallbackLabel(IonCode *code, MacroAssembler &masm)
+{
+    CodeLocationLabel fallback;
+    fallback = CodeOffsetLabel(size_t(u.call.fallback));
+    fallback.repoint(code, &masm);
+    u.call.fallback = fallback.raw();
+}
+
+bool
+IonCacheCall::attachIon(JSContext *cx, JSFunction *fun)
+{
+    JS_ASSERT(fun->isInterpreted());
+    JS_ASSERT(fun->nargs <= numStackArgs());
+
+    Label failures;
+    MacroAssembler masm;
+
+    JSScript *script = fun->script();
+    IonScript *ion = script->ion;
+
+    masm.branchPtr(Assembler::NotEqual, callee(), ImmGCPtr(fun), &failures);
+
+    // Guard that the script still has the IonScript whose code is baked below.
+    masm.loadPtr(AbsoluteAddress(&script->ion), output());
+    masm.branchPtr(Assembler::NotEqual, output(), ImmWord(ion), &failures);
+    masm.branch32(Assembler::NotEqual, Address(output(), IonScript::offsetOfId()),
+                  Imm32(ion->id()), &failures);
+
+    masm.movePtr(ImmWord(ion->method()->raw()), output());
+
+    RepatchLabel rejoin_;
+    CodeOffsetJump rejoinOffset = masm.jumpWithPatch(&rejoin_);
+    masm.bind(&rejoin_);
+
+    masm.bind(&failures);
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    rejoinOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    CodeLocationJump rejoinJump(code, rejoinOffset);
+    CodeLocationJump exitJump(code, exitOffset);
+    CodeLocationJump lastJump_ = lastJump();
+    PatchJump(lastJump_, CodeLocationLabel(code));
+    PatchJump(rejoinJump, rejoinLabel());
+    PatchJump(exitJump, cacheLabel());
+    updateLastJump(exitJump);
+
+    IonSpew(IonSpew_InlineCaches, "Generated CALL stub for %s:%d at %p",
+            fun->script()->filename, fun->script()->lineno, code->raw());
+
+    return true;
+}
+
+bool
+IonCacheCall::attachFallback(JSContext *cx, JSFunction *fun)
+{
+    Label failures;
+    MacroAssembler masm;
+
+    masm.branchPtr(Assembler::NotEqual, callee(), ImmGCPtr(fun), &failures);
+
+    RepatchLabel fallback_;
+    CodeOffsetJump fallbackOffset = masm.jumpWithPatch(&fallback_);
+    masm.bind(&fallback_);
+
+    masm.bind(&failures);
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    fallbackOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    CodeLocationJump fallbackJump(code, fallbackOffset);
+    CodeLocationJump exitJump(code, exitOffset);
+    CodeLocationJump lastJump_ = lastJump();
+    PatchJump(lastJump_, CodeLocationLabel(code));
+    PatchJump(fallbackJump, fallbackLabel());
+    PatchJump(exitJump, cacheLabel());
+    updateLastJump(exitJump);
+
+    IonSpew(IonSpew_InlineCaches, "Generated CALL fallback stub at %p", code->raw());
+
+    return true;
+}
+
+bool
+IonCacheCall::attachUncompiled(JSContext *cx, JSFunction *fun)
+{
+    JS_ASSERT(fun->isInterpreted());
+
+    Label failures;
+    MacroAssembler masm;
+
+    JSScript *script = fun->script();
+
+    masm.branchPtr(Assembler::NotEqual, callee(), ImmGCPtr(fun), &failures);
+
+    // Once the script has an IonScript, the next call misses and attaches a
+    // stub for its code.
+    masm.loadPtr(AbsoluteAddress(&script->ion), output());
+    masm.branchPtr(Assembler::Above, output(), ImmWord(ION_COMPILING_SCRIPT), &failures);
+
+    RepatchLabel fallback_;
+    CodeOffsetJump fallbackOffset = masm.jumpWithPatch(&fallback_);
+    masm.bind(&fallback_);
+
+    masm.bind(&failures);
+    RepatchLabel exit_;
+    CodeOffsetJump exitOffset = masm.jumpWithPatch(&exit_);
+    masm.bind(&exit_);
+
+    Linker linker(masm);
+    IonCode *code = linker.newCode(cx);
+    if (!code)
+        return false;
+
+    fallbackOffset.fixup(&masm);
+    exitOffset.fixup(&masm);
+
+    CodeLocationJump fallbackJump(code, fallbackOffset);
+    CodeLocationJump exitJump(code, exitOffset);
+    CodeLocationJump lastJump_ = lastJump();
+    PatchJump(lastJump_, CodeLocationLabel(code));
+    PatchJump(fallbackJump, fallbackLabel());
+    PatchJump(exitJump, cacheLabel());
+    updateLastJump(exitJump);
+
+    IonSpew(IonSpew_InlineCaches, "Generated CALL stub for uncompiled %s:%d at %p",
+            script->filename, script->lineno, code->raw());
+
+    return true;
+}
+
+void
+IonCacheCall::disable()
+{
+    PatchJump(lastJump(), fallbackLabel());
+    IonSpew(IonSpew_InlineCaches, "Disabled CALL cache");
+}
+
+bool
+js::ion::CallCache(JSContext *cx, size_t cacheIndex, HandleFunction fun)
+{
+    IonScript *ion = GetTopIonJSScript(cx)->ionScript();
+    IonCacheCall &cache = ion->getCache(cacheIndex).toCall();
+
+    if (cache.stubCount() >= MAX_CALL_STUBS) {
+        cache.disable();
+    } else if (fun->isNative() || fun->nargs > cache.numStackArgs() ||
+               fun->script()->ion == ION_DISABLED_SCRIPT)
+    {
+        // These callees need the VM or the arguments rectifier.
+        cache.incrementStubCount();
+        if (!cache.attachFallback(cx, fun))
+            return false;
+    } else if (fun->script()->hasIonScript()) {
+        cache.incrementStubCount();
+        if (!cache.attachIon(cx, fun))
+            return false;
+    } else {
+        cache.incrementStubCount();
+        if (!cache.attachUncompiled(cx, fun))
+            return false;
+    }
+
+    // The call itself is made by the generic path, on return.
+    return true;
+}
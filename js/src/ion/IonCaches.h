@@ -21,8 +21,11 @@ namespace ion {
 class IonCacheGetProperty;
 class IonCacheSetProperty;
 class IonCacheGetElement;
+class IonCacheSetElement;
 class IonCacheBindName;
 class IonCacheName;
+class IonCacheCall;
+class MegamorphicCache;
 
 // Common structure encoding the state of a polymorphic inline cache contained
 // in the code for an IonScript. IonCaches are used for polymorphic operations
@@ -39,7 +42,10 @@ class IonCacheName;
 //
 // Eventually, if too many stubs are generated the cache function may disable
 // the cache, by generating a stub to make a call and perform the operation
-// within the VM.
+// within the VM. Property caches instead become megamorphic: their stubs are
+// replaced by a single stub probing a table shared by the whole compartment,
+// see MegamorphicCache. Stubs for the properties which the table cannot hold
+// may still be chained after the probe.
 //
 // While calls may be made to the cache function and other VM functions, the
 // cache may still be treated as pure during optimization passes, such that
@@ -85,15 +91,18 @@ class IonCache
         GetProperty,
         SetProperty,
         GetElement,
+        SetElement,
         BindName,
         Name,
-        NameTypeOf
+        NameTypeOf,
+        Call
     };
 
   protected:
     Kind kind_ : 8;
     bool pure_ : 1;
     bool idempotent_ : 1;
+    bool megamorphic_ : 1;
     size_t stubCount_ : 6;
 
     CodeLocationJump initialJump_;
@@ -125,6 +134,17 @@ class IonCache
             bool monitoredResult : 1;
             bool hasDenseArrayStub : 1;
         } getelem;
+        struct {
+            Register object;
+            TypedOrValueRegisterSpace index;
+            TypedOrValueRegisterSpace value;
+            Register temp;
+            FloatRegister tempFloat;
+            bool strict : 1;
+            bool hasDenseArrayStub : 1;
+            // One bit per TypedArray::TYPE_* with an attached stub.
+            uint16 typedArrayStubs;
+        } setelem;
         struct {
             Register scopeChain;
             PropertyName *name;
@@ -135,6 +155,12 @@ class IonCache
             PropertyName *name;
             TypedOrValueRegisterSpace output;
         } name;
+        struct {
+            Register callee;
+            Register output;
+            uint32 numStackArgs;
+            uint8 *fallback;
+        } call;
     } u;
 
     // Registers live after the cache, excluding output registers. The initial
@@ -145,6 +171,9 @@ class IonCache
     JSScript *script;
     jsbytecode *pc;
 
+    // Replace all stubs with |code|, which probes a MegamorphicCache.
+    void linkMegamorphic(IonCode *code, CodeLocationJump rejoinJump, CodeLocationJump exitJump);
+
     void init(Kind kind, RegisterSet liveRegs,
               CodeOffsetJump initialJump,
               CodeOffsetLabel rejoinLabel,
@@ -193,6 +222,10 @@ class IonCache
         idempotent_ = true;
     }
 
+    bool megamorphic() const {
+        return megamorphic_;
+    }
+
     void updateLastJump(CodeLocationJump jump) {
         lastJump_ = jump;
     }
@@ -218,6 +251,10 @@ class IonCache
         JS_ASSERT(kind_ == GetElement);
         return *(IonCacheGetElement *)this;
     }
+    IonCacheSetElement &toSetElement() {
+        JS_ASSERT(kind_ == SetElement);
+        return *(IonCacheSetElement *)this;
+    }
     IonCacheBindName &toBindName() {
         JS_ASSERT(kind_ == BindName);
         return *(IonCacheBindName *)this;
@@ -226,6 +263,10 @@ class IonCache
         JS_ASSERT(kind_ == Name || kind_ == NameTypeOf);
         return *(IonCacheName *)this;
     }
+    IonCacheCall &toCall() {
+        JS_ASSERT(kind_ == Call);
+        return *(IonCacheCall *)this;
+    }
 
     void setScriptedLocation(JSScript *script, jsbytecode *pc) {
         JS_ASSERT(!idempotent_);
@@ -269,6 +310,7 @@ class IonCacheGetProperty : public IonCache
     TypedOrValueRegister output() const { return u.getprop.output.data(); }
 
     bool attachNative(JSContext *cx, JSObject *obj, JSObject *holder, const Shape *shape);
+    bool attachMegamorphic(JSContext *cx, MegamorphicCache *table);
 };
 
 class IonCacheSetProperty : public IonCache
@@ -297,6 +339,7 @@ class IonCacheSetProperty : public IonCache
     bool attachNativeExisting(JSContext *cx, JSObject *obj, const Shape *shape);
     bool attachNativeAdding(JSContext *cx, JSObject *obj, const Shape *oldshape, const Shape *newshape,
                             const Shape *propshape);
+    bool attachMegamorphic(JSContext *cx, MegamorphicCache *table);
 };
 
 class IonCacheGetElement : public IonCache
@@ -339,6 +382,76 @@ class IonCacheGetElement : public IonCache
 
     bool attachGetProp(JSContext *cx, JSObject *obj, const Value &idval, PropertyName *name);
     bool attachDenseArray(JSContext *cx, JSObject *obj, const Value &idval);
+
+    RegisterSet megamorphicRegisters() const;
+    bool canAttachMegamorphic() const;
+    bool attachMegamorphic(JSContext *cx, MegamorphicCache *table);
+};
+
+class IonCacheSetElement : public IonCache
+{
+  public:
+    IonCacheSetElement(CodeOffsetJump initialJump,
+                       CodeOffsetLabel rejoinLabel,
+                       CodeOffsetLabel cacheLabel,
+                       RegisterSet liveRegs,
+                       Register object, TypedOrValueRegister index,
+                       TypedOrValueRegister value, Register temp, FloatRegister tempFloat,
+                       bool strict)
+    {
+        init(SetElement, liveRegs, initialJump, rejoinLabel, cacheLabel);
+        u.setelem.object = object;
+        u.setelem.index.data() = index;
+        u.setelem.value.data() = value;
+        u.setelem.temp = temp;
+        u.setelem.tempFloat = tempFloat;
+        u.setelem.strict = strict;
+        u.setelem.hasDenseArrayStub = false;
+        u.setelem.typedArrayStubs = 0;
+    }
+
+    Register object() const {
+        return u.setelem.object;
+    }
+    TypedOrValueRegister index() const {
+        return u.setelem.index.data();
+    }
+    TypedOrValueRegister value() const {
+        return u.setelem.value.data();
+    }
+    Register temp() const {
+        return u.setelem.temp;
+    }
+    FloatRegister tempFloat() const {
+        return u.setelem.tempFloat;
+    }
+    bool strict() const {
+        return u.setelem.strict;
+    }
+    bool hasDenseArrayStub() const {
+        return u.setelem.hasDenseArrayStub;
+    }
+    void setHasDenseArrayStub() {
+        JS_ASSERT(!hasDenseArrayStub());
+        u.setelem.hasDenseArrayStub = true;
+    }
+    bool hasTypedArrayStub(int arrayType) const {
+        return u.setelem.typedArrayStubs & (1 << arrayType);
+    }
+    bool canAttachTypedArray(int arrayType) const;
+    void setHasTypedArrayStub(int arrayType) {
+        JS_ASSERT(!hasTypedArrayStub(arrayType));
+        u.setelem.typedArrayStubs |= (1 << arrayType);
+    }
+    void resetStubs() {
+        u.setelem.hasDenseArrayStub = false;
+        u.setelem.typedArrayStubs = 0;
+    }
+
+    bool attachDenseArray(JSContext *cx, JSObject *obj);
+    bool attachTypedArray(JSContext *cx, JSObject *obj);
+    bool attachSetProp(JSContext *cx, JSObject *obj, const Value &idval, const Shape *shape,
+                       JSValueType valueType);
 };
 
 class IonCacheBindName : public IonCache
@@ -404,6 +517,111 @@ class IonCacheName : public IonCache
     bool attach(JSContext *cx, HandleObject scopeChain, HandleObject obj, Shape *shape);
 };
 
+// Cache for calls to unknown targets. Stubs check for a particular callee and
+// leave the start of its Ion code, baked into the stub, in the output register,
+// then rejoin a call passing the arguments as they are. Callees whose Ion code
+// expects more arguments, and natives, are sent to the generic call path
+// instead.
+//
+// The Ion code of a callee stays valid as long as its script keeps the same
+// IonScript. As an IonScript may be freed and another one allocated at the same
+// address, stubs check both its address and its id. Callees which are not
+// compiled yet get a stub sending them to the generic call path until they
+// are, after which the cache attaches a stub for their Ion code.
+class IonCacheCall : public IonCache
+{
+  public:
+    IonCacheCall(CodeOffsetJump initialJump,
+                 CodeOffsetLabel rejoinLabel,
+                 CodeOffsetLabel cacheLabel,
+                 CodeOffsetLabel fallbackLabel,
+                 Register callee, Register output, uint32 numStackArgs)
+    {
+        init(Call, RegisterSet(), initialJump, rejoinLabel, cacheLabel);
+        u.call.callee = callee;
+        u.call.output = output;
+        u.call.numStackArgs = numStackArgs;
+
+        // Made absolute by updateBaseAddress, see CodeLocationLabel.
+        u.call.fallback = (uint8 *) fallbackLabel.offset();
+    }
+
+    Register callee() const {
+        return u.call.callee;
+    }
+    Register output() const {
+        return u.call.output;
+    }
+    uint32 numStackArgs() const {
+        return u.call.numStackArgs;
+    }
+    CodeLocationLabel fallbackLabel() const {
+        return CodeLocationLabel(u.call.fallback);
+    }
+    void updateFallbackLabel(IonCode *code, MacroAssembler &masm);
+
+    bool attachIon(JSContext *cx, JSFunction *fun);
+    bool attachFallback(JSContext *cx, JSFunction *fun);
+    bool attachUncompiled(JSContext *cx, JSFunction *fun);
+
+    // Send all callees without a stub to the generic call path.
+    void disable();
+};
+
+// Table shared by the megamorphic property caches of a compartment, mapping a
+// shape and a property name to the slot holding the property in objects with
+// that shape.
+//
+// Entries are only made for own data properties of objects which are not in
+// dictionary mode, whose shapes are never modified in place. Entries made by
+// property writes also hold the type of the object, which must match as well:
+// the write has only been checked against the type information of that type.
+// The table does not keep anything alive and is purged on GC.
+class MegamorphicCache
+{
+  public:
+    struct Entry
+    {
+        const Shape *shape;
+        PropertyName *name;
+        types::TypeObject *type;
+
+        // Offset of the slot from the start of the object, or from its
+        // dynamic slots if the low bit is set.
+        uintptr_t slot;
+    };
+
+    static const size_t NumEntries = 256;
+
+    // Log2 of sizeof(Entry), four words, to index the table from jitcode.
+    static const uint32 EntryShift = JS_BITS_PER_WORD_LOG2 - 3 + 2;
+
+    // Slots are Value-aligned, and cells are aligned to more than that.
+    static const uintptr_t DynamicSlotBit = 1;
+    static const uint32 CellShift = 3;
+
+    static size_t hash(uintptr_t shape, uintptr_t name) {
+        return ((shape >> CellShift) + (name >> CellShift)) & (NumEntries - 1);
+    }
+
+  private:
+    Entry entries_[NumEntries];
+
+  public:
+    MegamorphicCache() {
+        purge();
+    }
+
+    const Entry *entries() const {
+        return entries_;
+    }
+
+    void add(JSObject *obj, const Shape *shape, PropertyName *name, types::TypeObject *type);
+    void purge() {
+        PodArrayZero(entries_);
+    }
+};
+
 bool
 GetPropertyCache(JSContext *cx, size_t cacheIndex, HandleObject obj, MutableHandleValue vp);
 
@@ -415,6 +633,13 @@ bool
 GetElementCache(JSContext *cx, size_t cacheIndex, JSObject *obj, const Value &idval,
                 MutableHandleValue vp);
 
+bool
+SetElementCache(JSContext *cx, size_t cacheIndex, HandleObject obj, HandleValue idval,
+                HandleValue value);
+
+bool
+CallCache(JSContext *cx, size_t cacheIndex, HandleFunction fun);
+
 JSObject *
 BindNameCache(JSContext *cx, size_t cacheIndex, HandleObject scopeChain);
 
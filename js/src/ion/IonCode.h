@@ -31,6 +31,7 @@ static const uint32 SNAPSHOT_MAX_STACK = 127;
 
 class MacroAssembler;
 class CodeOffsetLabel;
+class SnapshotBailoutCounts;
 
 class IonCode : public gc::Cell
 {
@@ -201,9 +202,23 @@ struct IonScript
     // Number of references from invalidation records.
     size_t refcount_;
 
+    // Distinguishes this IonScript from those previously allocated at the
+    // same address in the compartment.
+    uint32 id_;
+
     // Number of times this function has tried to call a non-IM compileable function
     uint32 slowCallCount;
 
+    // Number of times this script has been entered from the interpreter or
+    // JM. Calls from other Ion code are not counted.
+    uint32 numEntries_;
+
+    // Bailouts taken from this script, in total, per kind and per snapshot.
+    // The per snapshot counts are allocated on the first bailout.
+    uint32 numBailouts_;
+    uint32 bailoutKindCounts_[NUM_BAILOUT_KINDS];
+    SnapshotBailoutCounts *snapshotBailouts_;
+
     SnapshotOffset *bailoutTable() {
         return (SnapshotOffset *)(reinterpret_cast<uint8 *>(this) + bailoutTable_);
     }
@@ -249,11 +264,17 @@ struct IonScript
     static inline size_t offsetOfOsrEntryOffset() {
         return offsetof(IonScript, osrEntryOffset_);
     }
+    static inline size_t offsetOfId() {
+        return offsetof(IonScript, id_);
+    }
 
   public:
     IonCode *method() const {
         return method_;
     }
+    uint32 id() const {
+        return id_;
+    }
     void setMethod(IonCode *code) {
         JS_ASSERT(!invalidated());
         method_ = code;
@@ -304,6 +325,22 @@ struct IonScript
     bool bailoutExpected() const {
         return bailoutExpected_;
     }
+    void noteEntry() {
+        numEntries_++;
+    }
+    uint32 numEntries() const {
+        return numEntries_;
+    }
+    // Counts a bailout of |kind| taken at |snapshot|.
+    void noteBailout(SnapshotOffset snapshot, BailoutKind kind);
+    uint32 numBailouts() const {
+        return numBailouts_;
+    }
+    uint32 numBailouts(BailoutKind kind) const {
+        JS_ASSERT(uint32(kind) < NUM_BAILOUT_KINDS);
+        return bailoutKindCounts_[kind];
+    }
+    uint32 numBailoutsAt(SnapshotOffset snapshot) const;
     const uint8 *snapshots() const {
         return reinterpret_cast<const uint8 *>(this) + snapshots_;
     }
@@ -23,6 +23,7 @@ typedef void (*EnterIonCode)(void *code, int argc, Value *argv, StackFrame *fp,
                              CalleeToken calleeToken, Value *vp);
 
 class IonActivation;
+class MegamorphicCache;
 
 class IonCompartment
 {
@@ -55,6 +56,13 @@ class IonCompartment
     // Map VMFunction addresses to the IonCode of the wrapper.
     VMWrapperMap *functionWrappers_;
 
+    // Tables probed by megamorphic property caches, for reads and writes.
+    MegamorphicCache *getPropertyTable_;
+    MegamorphicCache *setPropertyTable_;
+
+    // Identifier given to the next IonScript, see IonScript::id.
+    uint32 nextScriptId_;
+
   private:
     IonCode *generateEnterJIT(JSContext *cx);
     IonCode *generateReturnError(JSContext *cx);
@@ -131,6 +139,14 @@ class IonCompartment
         return enterJIT_.get()->as<EnterIonCode>();
     }
 
+    uint32 nextScriptId() {
+        return nextScriptId_++;
+    }
+
+    // Fallible; allocates the table on first use.
+    MegamorphicCache *getPropertyTable(JSContext *cx);
+    MegamorphicCache *setPropertyTable(JSContext *cx);
+
     IonCode *preBarrier(JSContext *cx) {
         if (!preBarrier_) {
             preBarrier_ = generatePreBarrier(cx);
@@ -192,6 +208,9 @@ class IonActivation
         JS_ASSERT(bailout_);
         return bailout_;
     }
+    BailoutClosure *maybeBailout() const {
+        return bailout_;
+    }
     JSCompartment *compartment() const {
         return compartment_;
     }
@@ -194,6 +194,7 @@ class IonActivationIterator
 
 class IonJSFrameLayout;
 class IonBailoutIterator;
+class MaterializedObjects;
 
 // Reads frame information in snapshot-encoding order (that is, outermost frame
 // to innermost frame).
@@ -203,6 +204,10 @@ class SnapshotIterator : public SnapshotReader
     MachineState machine_;
     IonScript *ionScript_;
 
+    // Receives the objects removed by escape analysis. Without it, such
+    // objects read as undefined.
+    MaterializedObjects *materialized_;
+
   private:
     bool hasLocation(const SnapshotReader::Location &loc);
     uintptr_t fromLocation(const SnapshotReader::Location &loc);
@@ -219,6 +224,13 @@ class SnapshotIterator : public SnapshotReader
     SnapshotIterator(const IonBailoutIterator &iter);
     SnapshotIterator();
 
+    void setMaterializedObjects(MaterializedObjects *materialized) {
+        materialized_ = materialized;
+    }
+    MaterializedObjects *materializedObjects() const {
+        return materialized_;
+    }
+
     Value read() {
         return slotValue(readSlot());
     }
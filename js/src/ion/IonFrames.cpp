@@ -20,6 +20,7 @@
 #include "SnapshotReader.h"
 #include "Safepoints.h"
 #include "VMFunctions.h"
+#include "Bailouts.h"
 
 using namespace js;
 using namespace js::ion;
@@ -583,8 +584,11 @@ MarkIonActivation(JSTracer *trc, const IonActivationIterator &activations)
 void
 ion::MarkIonActivations(JSRuntime *rt, JSTracer *trc)
 {
-    for (IonActivationIterator activations(rt); activations.more(); ++activations)
+    for (IonActivationIterator activations(rt); activations.more(); ++activations) {
+        if (BailoutClosure *br = activations.activation()->maybeBailout())
+            br->trace(trc);
         MarkIonActivation(trc, activations);
+    }
 }
 
 void
@@ -633,7 +637,8 @@ SnapshotIterator::SnapshotIterator(IonScript *ionScript, SnapshotOffset snapshot
                    ionScript->snapshots() + ionScript->snapshotsSize()),
     fp_(fp),
     machine_(machine),
-    ionScript_(ionScript)
+    ionScript_(ionScript),
+    materialized_(NULL)
 {
     JS_ASSERT(snapshotOffset < ionScript->snapshotsSize());
 }
@@ -643,14 +648,16 @@ SnapshotIterator::SnapshotIterator(const IonFrameIterator &iter)
                    iter.ionScript()->snapshots() + iter.ionScript()->snapshotsSize()),
     fp_(iter.jsFrame()),
     machine_(iter.machineState()),
-    ionScript_(iter.ionScript())
+    ionScript_(iter.ionScript()),
+    materialized_(NULL)
 {
 }
 
 SnapshotIterator::SnapshotIterator()
   : SnapshotReader(NULL, NULL),
     fp_(NULL),
-    ionScript_(NULL)
+    ionScript_(NULL),
+    materialized_(NULL)
 {
 }
 
@@ -750,6 +757,25 @@ SnapshotIterator::slotValue(const Slot &slot)
       case SnapshotReader::CONSTANT:
         return ionScript_->getConstant(slot.constantIndex());
 
+      case SnapshotReader::MATERIALIZED:
+      {
+        // The object only exists once the frames have been converted, so
+        // give back a placeholder which the bailout patches afterwards.
+        if (!materialized_)
+            return UndefinedValue();
+
+        uint32 number = slot.objectNumber();
+        if (!materialized_->has(number)) {
+            JSObject *templateObject = &ionScript_->getConstant(slot.templateIndex()).toObject();
+            materialized_->startObject(number, templateObject);
+
+            CompactBufferReader fields = slot.fieldsReader();
+            for (uint32 i = 0; i < slot.numFields(); i++)
+                materialized_->addField(slotValue(ReadSlot(fields)));
+        }
+        return materialized_->placeholder(number);
+      }
+
       default:
         JS_NOT_REACHED("huh?");
         return UndefinedValue();
@@ -7,6 +7,7 @@
 
 #ifdef DEBUG
 
+#include "Ion.h"
 #include "IonSpewer.h"
 
 #ifndef ION_SPEW_DIR
@@ -39,28 +40,40 @@ ion::EnableIonDebugLogging()
     ionspewer.init();
 }
 
+// The spewer is shared by the whole process, so graphs are only spewed for
+// compilations on the main thread, which are the ones with a context.
+static bool
+OnMainThread()
+{
+    return GetIonContext()->cx != NULL;
+}
+
 void
 ion::IonSpewNewFunction(MIRGraph *graph, JSScript *function)
 {
-    ionspewer.beginFunction(graph, function);
+    if (OnMainThread())
+        ionspewer.beginFunction(graph, function);
 }
 
 void
 ion::IonSpewPass(const char *pass)
 {
-    ionspewer.spewPass(pass);
+    if (OnMainThread())
+        ionspewer.spewPass(pass);
 }
 
 void
 ion::IonSpewPass(const char *pass, LinearScanAllocator *ra)
 {
-    ionspewer.spewPass(pass, ra);
+    if (OnMainThread())
+        ionspewer.spewPass(pass, ra);
 }
 
 void
 ion::IonSpewEndFunction()
 {
-    ionspewer.endFunction();
+    if (OnMainThread())
+        ionspewer.endFunction();
 }
 
 
@@ -180,6 +193,12 @@ ion::CheckLogging()
             "  ps         Parameter Specialization\n"
             "  cp         Constant propagation\n"
             "  bce        Bounds check elimination\n"
+            "  ota        Overflow test elimination\n"
+            "  unroll     Loop unrolling\n"
+            "  escape     Escape analysis\n"
+            "  dse        Dead store elimination\n"
+            "  vectorize  Loop vectorization\n"
+            "  offthread  Compilations off the main thread\n"
             "  calls      IonMonkey compiled function calls\n"
             "  regalloc   Register allocation\n"
             "  inline     Inlining\n"
@@ -224,6 +243,18 @@ ion::CheckLogging()
         EnableChannel(IonSpew_CP);
     if (ContainsFlag(env, "bce"))
         EnableChannel(IonSpew_BCE);
+    if (ContainsFlag(env, "ota"))
+        EnableChannel(IonSpew_OTA);
+    if (ContainsFlag(env, "unroll"))
+        EnableChannel(IonSpew_Unroll);
+    if (ContainsFlag(env, "escape"))
+        EnableChannel(IonSpew_Escape);
+    if (ContainsFlag(env, "dse"))
+        EnableChannel(IonSpew_DSE);
+    if (ContainsFlag(env, "vectorize"))
+        EnableChannel(IonSpew_Vectorize);
+    if (ContainsFlag(env, "offthread"))
+        EnableChannel(IonSpew_OffThread);
     if (ContainsFlag(env, "calls"))
         EnableChannel(IonSpew_Calls);
     if (ContainsFlag(env, "regalloc"))
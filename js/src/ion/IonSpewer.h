@@ -44,6 +44,18 @@ namespace ion {
     _(PS)                                                 \
     /* Information during Bounds Check Elimination */     \
     _(BCE)                                                 \
+    /* Information during Overflow Test Elimination */    \
+    _(OTA)                                                \
+    /* Information during Loop Unrolling */               \
+    _(Unroll)                                             \
+    /* Information during Escape Analysis */              \
+    _(Escape)                                             \
+    /* Information during Dead Store Elimination */       \
+    _(DSE)                                                \
+    /* Information during Loop Vectorization */           \
+    _(Vectorize)                                          \
+    /* Information about off thread compilations */       \
+    _(OffThread)                                          \
     /* Information during LSRA */                         \
     _(RegAlloc)                                           \
     /* Information during inlining */                     \
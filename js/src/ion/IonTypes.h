@@ -53,9 +53,15 @@ enum BailoutKind
     Bailout_BoundsCheck,
 
     // Like Bailout_Normal, but invalidate the current IonScript.
-    Bailout_Invalidate
+    Bailout_Invalidate,
+
+    // A bailout at the very start of a function, from the guards checking
+    // that the arguments match the values the code was specialized to.
+    Bailout_ParameterCheck
 };
 
+static const uint32 NUM_BAILOUT_KINDS = Bailout_ParameterCheck + 1;
+
 #ifdef DEBUG
 // Track the pipeline of opcodes which has produced a snapshot.
 #define TRACK_SNAPSHOTS 1
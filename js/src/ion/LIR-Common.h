@@ -2285,6 +2285,34 @@ class LGetElementCacheV : public LInstructionHelper<BOX_PIECES, 1 + BOX_PIECES,
     }
 };
 
+class LSetElementCacheV : public LInstructionHelper<0, 1 + 2 * BOX_PIECES, 2>
+{
+  public:
+    LIR_HEADER(SetElementCacheV);
+
+    static const size_t Index = 1;
+    static const size_t Value = 1 + BOX_PIECES;
+
+    LSetElementCacheV(const LAllocation &object, const LDefinition &temp,
+                      const LDefinition &tempFloat) {
+        setOperand(0, object);
+        setTemp(0, temp);
+        setTemp(1, tempFloat);
+    }
+    const LAllocation *object() {
+        return getOperand(0);
+    }
+    const LDefinition *temp() {
+        return getTemp(0);
+    }
+    const LDefinition *tempFloat() {
+        return getTemp(1);
+    }
+    const MSetElementCache *mir() const {
+        return mir_->toSetElementCache();
+    }
+};
+
 class LBindNameCache : public LInstructionHelper<1, 1, 0>
 {
   public:
@@ -2745,6 +2773,19 @@ class LGuardClass : public LInstructionHelper<0, 1, 1>
     }
 };
 
+// Guard that a value is the constant the code has been specialized to.
+class LGuardValue : public LInstructionHelper<0, BOX_PIECES, 0>
+{
+  public:
+    LIR_HEADER(GuardValue);
+
+    static const size_t Input = 0;
+
+    const MGuardValue *mir() const {
+        return mir_->toGuardValue();
+    }
+};
+
 class MPhi;
 
 // Phi is a pseudo-instruction that emits no code, and is an annotation for the
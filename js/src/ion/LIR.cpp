@@ -92,12 +92,25 @@ LBlock::getExitMoveGroup()
     return exitMoveGroup_;
 }
 
+// Object states take one entry, followed by one for each of their operands.
 static size_t
-TotalOperandCount(MResumePoint *mir)
+ResumePointEntryCount(MResumePoint *mir)
 {
     size_t accum = mir->numOperands();
+    for (size_t i = 0; i < mir->numOperands(); i++) {
+        MDefinition *def = mir->getOperand(i);
+        if (def->isObjectState())
+            accum += def->numOperands();
+    }
+    return accum;
+}
+
+static size_t
+TotalOperandCount(MResumePoint *mir)
+{
+    size_t accum = ResumePointEntryCount(mir);
     while ((mir = mir->caller()))
-        accum += mir->numOperands();
+        accum += ResumePointEntryCount(mir);
     return accum;
 }
 
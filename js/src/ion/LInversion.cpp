@@ -8,125 +8,527 @@
  */
 
 
-#include "MIR.h"
-#include "MIRGraph.h"
+#include "IonAnalysis.h"
 #include "IonSpewer.h"
 #include "LInversion.h"
-#include <fstream>
 
 using namespace js;
 using namespace js::ion;
-using namespace std;
 
-LInversion::LInversion(MIRGraph &graph): isLIR(false){
-    this->graph.mir = &graph;
+LInversion::LInversion(MIRGraph &graph)
+  : graph(graph)
+{
 }
 
-LInversion::LInversion(LIRGraph &graph): isLIR(true){
-    this->graph.lir = &graph;
+static inline bool
+IsLoopCheck(MInstruction *ins)
+{
+    return ins->isInterruptCheck() || ins->isRecompileCheck();
 }
 
+// Constants stay in the guard, which dominates the loop and its exit, so only
+// the other instructions of the header are copied.
+static inline bool
+IsCopied(MInstruction *ins)
+{
+    return !IsLoopCheck(ins) && !ins->isConstant();
+}
+
+// Block at which a use takes place. Phis use their operands at the end of the
+// corresponding predecessors.
+static MBasicBlock *
+UseBlock(MUse *use)
+{
+    MNode *node = use->node();
+    if (node->isDefinition() && node->toDefinition()->isPhi())
+        return node->block()->getPredecessor(use->index());
+    return node->block();
+}
+
+static uint32
+SlotOf(MResumePoint *resumePoint, MDefinition *def)
+{
+    for (size_t i = 0; i < resumePoint->numOperands(); i++) {
+        if (resumePoint->getOperand(i) == def)
+            return i;
+    }
+    return 0;
+}
 
-/*
 bool
-LInversion::checkLoopCondition(MInstruction *cond){
-    JS_ASSERT(cond->isCompare() || cond->isConstant());
-    return false;
+LInversion::usesAreInvertible(const Loop &loop, MDefinition *def)
+{
+    for (MUseIterator use(def->usesBegin()); use != def->usesEnd(); use++) {
+        // Phis of the header are removed.
+        MNode *node = use->node();
+        if (node->isDefinition() && node->toDefinition()->isPhi() &&
+            node->block() == loop.header)
+        {
+            continue;
+        }
+
+        // Definitions of the header reach the blocks after the loop through
+        // the copies of its exit, which are merged at the beginning of the
+        // exit block.
+        MBasicBlock *block = UseBlock(*use);
+        if (block->id() >= loop.header->id() && block->id() <= loop.backedge->id())
+            continue;
+        if (!loop.exit->dominates(block)) {
+            IonSpew(IonSpew_LInv, "Definition %d of loop %d is used in block %d after the loop",
+                    def->id(), loop.header->id(), block->id());
+            return false;
+        }
+    }
+    return true;
 }
-*/
-void
-LInversion::analyzeEmptyBlocks(){
-    fstream fp_in("/tmp/ionlinv", ios::out | ios::app);
-    MBasicBlockIterator end = graph.mir->end();
-    for(MBasicBlockIterator it = graph.mir->begin(); it != end; it++){
-        MBasicBlock *block = *it;
-        MInstructionIterator iItEnd = block->end();
-        int numInst = 0;
-        for(MInstructionIterator iIt = block->begin(); iIt != iItEnd; iIt++){
-            numInst++;
+
+bool
+LInversion::findLoop(MBasicBlock *header, Loop *loop)
+{
+    if (header->numPredecessors() != 2)
+        return false;
+
+    MBasicBlock *backedge = header->backedge();
+    if (!backedge->lastIns()->isGoto())
+        return false;
+
+    // The blocks of a loop follow its header in reverse postorder.
+    blocks.clear();
+    for (MBasicBlockIterator block(graph.begin(header)); ; block++) {
+        if (block == graph.end())
+            return false;
+        if (block->id() != header->id() + blocks.length())
+            return false;
+        if (!header->dominates(*block))
+            return false;
+        if (!blocks.append(*block))
+            return false;
+        if (*block == backedge)
+            break;
+    }
+
+    // Loops whose header does not test the loop condition, e.g. do-while
+    // loops, have nothing to invert.
+    if (!header->lastIns()->isTest())
+        return false;
+
+    MTest *test = header->lastIns()->toTest();
+    MBasicBlock *ifTrue = test->ifTrue();
+    MBasicBlock *ifFalse = test->ifFalse();
+    bool trueInLoop = ifTrue->id() > header->id() && ifTrue->id() <= backedge->id();
+    bool falseInLoop = ifFalse->id() > header->id() && ifFalse->id() <= backedge->id();
+    if (trueInLoop == falseInLoop)
+        return false;
+
+    loop->header = header;
+    loop->backedge = backedge;
+    loop->body = trueInLoop ? ifTrue : ifFalse;
+    loop->exit = trueInLoop ? ifFalse : ifTrue;
+
+    // Critical edges are split, so both successors are only reached from
+    // the header.
+    if (loop->body->numPredecessors() != 1 || loop->exit->numPredecessors() != 1)
+        return false;
+    if (loop->exit->id() <= backedge->id())
+        return false;
+
+    uint32 size = 0;
+    for (MInstructionIterator iter(header->begin()); *iter != header->lastIns(); iter++) {
+        if (!IsCopied(*iter))
+            continue;
+        if (!iter->canClone()) {
+            if (IonSpewEnabled(IonSpew_LInv)) {
+                IonSpewHeader(IonSpew_LInv);
+                fprintf(IonSpewFile, "Loop %d tests ", header->id());
+                iter->printName(IonSpewFile);
+                fprintf(IonSpewFile, ", which cannot be cloned\n");
+            }
+            return false;
         }
-        fp_in << graph.mir->begin()->info().filename() << ":" << graph.mir->begin()->info().lineno()
-            << "," << block->id() << "," << numInst << "," << block->numPredecessors()
-            << "," << block->numSuccessors() << "\n";
+        // Phis cannot merge values of these types.
+        if (iter->type() == MIRType_Undefined || iter->type() == MIRType_Null)
+            return false;
+        if (++size > MaxHeaderInstructions)
+            return false;
     }
 
-    fp_in.close();
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); phi++) {
+        if (!usesAreInvertible(*loop, *phi))
+            return false;
+    }
+    for (MInstructionIterator iter(header->begin()); *iter != header->lastIns(); iter++) {
+        if (IsCopied(*iter) && !usesAreInvertible(*loop, *iter))
+            return false;
+    }
+
+    return true;
+}
+
+MDefinition *
+LInversion::copyOf(MDefinition *def)
+{
+    if (def->id() >= copies.length() || !copies[def->id()])
+        return def;
+    return copies[def->id()];
 }
 
-/*
- * Try to ensure that the loop will be executed at least one.
- * If so eliminate the surrounding if.
- * only enabled with --ion-ps
- *
- */
 void
-LInversion::eliminateUnnecessaryIf(){
+LInversion::remapResumePoint(MResumePoint *resumePoint)
+{
+    for (size_t i = 0; i < resumePoint->numOperands(); i++) {
+        MDefinition *def = resumePoint->getOperand(i);
+        MDefinition *copy = copyOf(def);
+        if (copy != def)
+            resumePoint->replaceOperand(i, copy);
+    }
+}
 
+// Creates a block jumping to |target|, with the state |target| has on entry.
+MBasicBlock *
+LInversion::newEdge(MBasicBlock *target)
+{
+    MBasicBlock *block = MBasicBlock::NewCopy(graph, target);
+    if (!block)
+        return NULL;
+
+    remapResumePoint(block->entryResumePoint());
+    block->end(MGoto::New(target));
+    return block;
 }
 
-/*
-void
-LInversion::eliminateEmptyLIRBlocks(){
-    //graph.lir->
+// Copies the header, but for its phis and loop checks, at the end of the
+// loop. The copy is not ended.
+MBasicBlock *
+LInversion::copyHeader(const Loop &loop)
+{
+    MBasicBlock *header = loop.header;
+    MBasicBlock *copy = MBasicBlock::NewCopy(graph, header);
+    if (!copy)
+        return NULL;
+    graph.insertBlockAfter(loop.backedge, copy);
+    copy->mark();
+
+    remapResumePoint(copy->entryResumePoint());
+
+    MDefinitionVector operands;
+    for (MInstructionIterator iter(header->begin()); *iter != header->lastIns(); iter++) {
+        if (!IsCopied(*iter))
+            continue;
+
+        operands.clear();
+        for (size_t i = 0; i < iter->numOperands(); i++) {
+            if (!operands.append(copyOf(iter->getOperand(i))))
+                return NULL;
+        }
+
+        MInstruction *ins = iter->clone(operands.begin());
+        copy->add(ins);
+        copies[iter->id()] = ins;
+
+        if (iter->resumePoint()) {
+            MResumePoint *resumePoint = MResumePoint::Copy(copy, iter->resumePoint());
+            if (!resumePoint)
+                return NULL;
+            remapResumePoint(resumePoint);
+            ins->setResumePoint(resumePoint);
+        }
+    }
+
+    return copy;
 }
 
-void
-LInversion::eliminateEmptyMIRBlocks(){
-    MBasicBlockIterator end = graph.mir->end();
-    FixedList<MBasicBlock*> blocksToDelete;
-    int numBlocksToDelete=0;
-    blocksToDelete.init(graph.mir->numBlockIds());
-    for(MBasicBlockIterator it = graph.mir->begin(); it != end; it++){
-        MBasicBlock *block = *it;
-        IonSpew(IonSpew_LInv, "Analyzing block %d", block->id());
-        MInstructionIterator iIt = block->begin();
-        MPhiIterator itPhis = block->phisBegin();
-        //if block has only one instruction
-        iIt++;
-        if(iIt == block->end() && itPhis == block->phisEnd()){
-            IonSpew(IonSpew_LInv, "block %d has only one instruction and no phis", block->id());
-            if(block->lastIns()->isGoto()){
-                for(uint32 i = 0; i < block->numPredecessors(); i++){
-                    MBasicBlock *pred = block->getPredecessor(i);
-                    MBasicBlock *succ = block->getSuccessor(0);
-                    MInstruction *lastIns = pred->lastIns();
-                    if(lastIns->isGoto()){
-                        //replace last instruction with a goto to succ
-                        pred->discardLastIns();
-                        pred->end(MGoto::New(succ));
-                    }else if(lastIns->isTest()){
-                        //replace last instruction with a copy that replace block with succ
-                        MTest *oldLastIns = lastIns->toTest();
-                        MTest *newLastIns;// = MTest::New(NULL, oldLastIns->if)
-                        if(oldLastIns->ifTrue() == block) {
-                            newLastIns = MTest::New(oldLastIns->getOperand(0), succ ,oldLastIns->ifFalse());
-                        } else {
-                            JS_ASSERT(oldLastIns->ifFalse() == block);
-                            newLastIns = MTest::New(oldLastIns->getOperand(0), oldLastIns->ifTrue(), succ);
-                        }
-                        pred->discardLastIns();
-                        pred->end(newLastIns);
-                    }
-                    //replace block by pred in succ list of predecessors
-                    succ->replacePredecessor(block,pred);
-                    blocksToDelete[numBlocksToDelete++] = block;
-                }
-            }else
-                JS_NOT_REACHED("FIXME: unexpected behavior");
+// Returns the phi of |block| merging the values of a definition of the
+// header, creating it if needed.
+MPhi *
+LInversion::phiFor(Vector<MPhi *, 0, IonAllocPolicy> &phis, MBasicBlock *block, MDefinition *def)
+{
+    if (phis[def->id()])
+        return phis[def->id()];
+
+    MPhi *phi;
+    if (def->isPhi()) {
+        phi = MPhi::NewCopy(def->toPhi());
+    } else {
+        phi = MPhi::New(SlotOf(block->entryResumePoint(), def));
+        phi->specialize(def->type());
+    }
+    block->addPhi(phi);
+    phis[def->id()] = phi;
+    return phi;
+}
+
+// Collects the uses of a definition of the header, with the values they have
+// once the loop is inverted. The guard keeps the definitions of the header,
+// but for its phis, which are replaced by their values on entry. The loop and
+// the blocks after it use the phis merging the values computed by the guard
+// and by the copy of the header.
+bool
+LInversion::replaceUses(const Loop &loop, MDefinition *def, MBasicBlock *guardEntry,
+                        MBasicBlock *guardExit)
+{
+    for (MUseIterator use(def->usesBegin()); use != def->usesEnd(); use++) {
+        MNode *node = use->node();
+        if (node->isDefinition() && node->toDefinition()->isPhi() &&
+            node->block() == loop.header)
+        {
+            continue;
+        }
+
+        MBasicBlock *block = UseBlock(*use);
+        MDefinition *value;
+        if (block == loop.header || block == guardEntry || block == guardExit) {
+            if (!def->isPhi())
+                continue;
+            value = def->getOperand(0);
+        } else if (block->isMarked()) {
+            value = phiFor(bodyPhis, loop.body, def);
+        } else {
+            value = phiFor(exitPhis, loop.exit, def);
         }
+
+        UseReplacement replacement = { node, use->index(), value };
+        if (!replacements.append(replacement))
+            return false;
     }
+    return true;
+}
+
+// Gives their inputs to the phis merging the values of a definition of the
+// header. The values computed by the copy of the header are those of the
+// iteration which ends, so definitions of the header flowing around the loop
+// are taken from the phis of the new header.
+bool
+LInversion::addPhiInputs(const Loop &loop, MDefinition *def)
+{
+    MDefinition *entryValue = def->isPhi() ? def->getOperand(0) : def;
+    MDefinition *backedgeValue = copyOf(def);
+    if (backedgeValue->block() == loop.header)
+        backedgeValue = bodyPhis[backedgeValue->id()];
 
-    for(int i = 0; i < numBlocksToDelete; i++) {
-        MBasicBlock *toDelete = blocksToDelete[i];
-        IonSpew(IonSpew_LInv, "block %d was discarded", toDelete->id());
-        graph.mir->removeBlock(toDelete);
+    if (MPhi *phi = bodyPhis[def->id()]) {
+        if (!phi->addInput(entryValue) || !phi->addInput(backedgeValue))
+            return false;
+    }
+    if (MPhi *phi = exitPhis[def->id()]) {
+        if (!phi->addInput(entryValue) || !phi->addInput(backedgeValue))
+            return false;
     }
+    return true;
 }
 
-void
-LInversion::eliminateEmptyBlocks() {
-    if(isLIR)
-        eliminateEmptyLIRBlocks();
+bool
+LInversion::invert(const Loop &loop)
+{
+    MBasicBlock *header = loop.header;
+    MBasicBlock *body = loop.body;
+    MBasicBlock *exit = loop.exit;
+    uint32 loopDepth = header->loopDepth();
+
+    // Edges leaving the guard, with the values the phis of the header have
+    // when the loop is entered.
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); phi++)
+        copies[phi->id()] = phi->getOperand(0);
+
+    MBasicBlock *guardEntry = newEdge(body);
+    if (!guardEntry)
+        return false;
+    graph.insertBlockAfter(header, guardEntry);
+    guardEntry->setLoopDepth(loopDepth - 1);
+
+    MBasicBlock *guardExit = newEdge(exit);
+    if (!guardExit)
+        return false;
+
+    // Copy of the header testing the condition at the end of each iteration,
+    // with the values the phis of the header have on the backedge.
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); phi++)
+        copies[phi->id()] = phi->getOperand(1);
+
+    MBasicBlock *test = copyHeader(loop);
+    if (!test)
+        return false;
+    test->setLoopDepth(loopDepth);
+
+    MBasicBlock *backedge = newEdge(body);
+    if (!backedge)
+        return false;
+    graph.insertBlockAfter(test, backedge);
+    backedge->mark();
+    backedge->setLoopDepth(loopDepth);
+
+    MBasicBlock *testExit = newEdge(exit);
+    if (!testExit)
+        return false;
+    graph.insertBlockAfter(backedge, testExit);
+    testExit->mark();
+    testExit->setLoopDepth(loopDepth - 1);
+
+    graph.insertBlockAfter(testExit, guardExit);
+    guardExit->setLoopDepth(loopDepth - 1);
+
+    MTest *cond = header->lastIns()->toTest();
+    if (cond->ifTrue() == body)
+        test->end(MTest::New(copyOf(cond->getOperand(0)), backedge, testExit));
     else
-        eliminateEmptyMIRBlocks();
-}*/
+        test->end(MTest::New(copyOf(cond->getOperand(0)), testExit, backedge));
+
+    if (!guardEntry->addPredecessorWithoutPhis(header) ||
+        !guardExit->addPredecessorWithoutPhis(header) ||
+        !backedge->addPredecessorWithoutPhis(test) ||
+        !testExit->addPredecessorWithoutPhis(test))
+    {
+        return false;
+    }
+
+    IonSpew(IonSpew_LInv, "Inverting loop %d, tested again in block %d",
+            header->id(), test->id());
+
+    // Definitions of the header flowing around the loop need a phi in the new
+    // header, even when they are not used in the loop.
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); phi++) {
+        MDefinition *value = phi->getOperand(1);
+        if (value->block() == header)
+            phiFor(bodyPhis, body, value);
+    }
+
+    replacements.clear();
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); phi++) {
+        if (!replaceUses(loop, *phi, guardEntry, guardExit))
+            return false;
+    }
+    for (MInstructionIterator iter(header->begin()); *iter != header->lastIns(); iter++) {
+        if (IsCopied(*iter) && !replaceUses(loop, *iter, guardEntry, guardExit))
+            return false;
+    }
+    for (size_t i = 0; i < replacements.length(); i++) {
+        const UseReplacement &use = replacements[i];
+        use.node->replaceOperand(use.index, use.value);
+    }
+
+    // The header only guards the loop, whose header is now its body.
+    for (size_t i = 0; i < cond->numSuccessors(); i++) {
+        if (cond->getSuccessor(i) == body)
+            cond->replaceSuccessor(i, guardEntry);
+        else
+            cond->replaceSuccessor(i, guardExit);
+    }
+    body->replacePredecessor(header, guardEntry);
+    if (!body->addPredecessorWithoutPhis(backedge))
+        return false;
+    body->makeLoopHeader();
+
+    exit->replacePredecessor(header, guardExit);
+    if (!exit->addPredecessorWithoutPhis(testExit))
+        return false;
+
+    loop.backedge->lastIns()->replaceSuccessor(0, test);
+    if (!test->addPredecessorWithoutPhis(loop.backedge))
+        return false;
+
+    header->removePredecessor(1);
+    header->clearLoopHeader();
+    header->setLoopDepth(loopDepth - 1);
+
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); phi++) {
+        if (!addPhiInputs(loop, *phi))
+            return false;
+    }
+    for (MInstructionIterator iter(header->begin()); *iter != header->lastIns(); iter++) {
+        if (IsCopied(*iter) && !addPhiInputs(loop, *iter))
+            return false;
+    }
+
+    // Loop checks move to the new header, so that they still run once per
+    // iteration.
+    MInstruction *first = *body->begin();
+    for (MInstructionIterator iter(header->begin()); *iter != header->lastIns(); ) {
+        if (!IsLoopCheck(*iter)) {
+            copies[iter->id()] = NULL;
+            bodyPhis[iter->id()] = NULL;
+            exitPhis[iter->id()] = NULL;
+            iter++;
+            continue;
+        }
+
+        if (iter->isInterruptCheck())
+            body->insertBefore(first, MInterruptCheck::New());
+        else
+            body->insertBefore(first, MRecompileCheck::New());
+        iter = header->discardAt(iter);
+    }
+
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); ) {
+        copies[phi->id()] = NULL;
+        bodyPhis[phi->id()] = NULL;
+        exitPhis[phi->id()] = NULL;
+        phi = header->discardPhiAt(phi);
+    }
+
+    return true;
+}
+
+
+bool
+LInversion::analyze()
+{
+    IonSpew(IonSpew_LInv, "Beginning loop inversion pass.");
+
+    // The headers of the loops are collected first, as inverting a loop adds
+    // blocks to the graph.
+    Vector<MBasicBlock *, 4, IonAllocPolicy> headers;
+    for (MBasicBlockIterator block(graph.begin()); block != graph.end(); block++) {
+        if (block->isLoopHeader() && !headers.append(*block))
+            return false;
+    }
+
+    // Only the definitions of the original headers are looked up.
+    uint32 numIds = graph.getMaxInstructionId() + 1;
+    if (!copies.appendN(NULL, numIds))
+        return false;
+    if (!bodyPhis.appendN(NULL, numIds) || !exitPhis.appendN(NULL, numIds))
+        return false;
+
+    // Phi successors are found again once the graph has been changed.
+    for (MBasicBlockIterator block(graph.begin()); block != graph.end(); block++)
+        block->setSuccessorWithPhis(NULL, 0);
+
+    for (size_t i = 0; i < headers.length(); i++) {
+        Loop loop;
+        if (!findLoop(headers[i], &loop))
+            continue;
+
+        graph.unmarkBlocks();
+        for (size_t j = 0; j < blocks.length(); j++)
+            blocks[j]->mark();
+
+        if (!invert(loop))
+            return false;
+        graph.unmarkBlocks();
+
+        // The next loops are found with the new numbering and dominator tree.
+        ClearDominatorTree(graph);
+        if (!RenumberBlocks(graph))
+            return false;
+        if (!BuildDominatorTree(graph))
+            return false;
+    }
+
+    return BuildPhiReverseMapping(graph);
+}
+
+void
+LInversion::analyzeEmptyBlocks()
+{
+    if (!IonSpewEnabled(IonSpew_LInv))
+        return;
+
+    for (MBasicBlockIterator block(graph.begin()); block != graph.end(); block++) {
+        uint32 numInstructions = 0;
+        for (MInstructionIterator ins(block->begin()); ins != block->end(); ins++)
+            numInstructions++;
+
+        IonSpew(IonSpew_LInv, "%s:%d block %d: %d instructions, %d predecessors, %d successors",
+                block->info().filename(), block->info().lineno(), block->id(),
+                numInstructions, block->numPredecessors(), block->numSuccessors());
+    }
+}
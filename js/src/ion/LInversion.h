@@ -9,31 +9,105 @@
 #ifndef jsion_linversion_h__
 #define jsion_linversion_h__
 
+#include "IonAllocPolicy.h"
+#include "MIR.h"
+#include "MIRGraph.h"
+
 // This file represents Loop Inversion optimization pass
 namespace js {
 namespace ion {
 
-class MIRGraph;
-class LIRGraph;
-class MBasicBlock;
-
-class LInversion {
-    union{
-        MIRGraph *mir;
-        LIRGraph *lir;
-    }graph;
-
-    bool isLIR;
-    /*
-    void eliminateEmptyLIRBlocks();
-    void eliminateEmptyMIRBlocks();
-    */
-public:
+// Turns loops whose header tests the loop condition, i.e. while and for
+// loops, into do-while loops guarded by the condition:
+//
+//   header:                        guard:
+//     i = phi(i0, i1)                c0 = i0 < n
+//     c = i < n                      test c0, preheader, skip
+//     test c, body, exit           preheader:
+//   body:                            goto body
+//     ...                   =>     body:
+//     i1 = i + 1                     i = phi(i0, i1)
+//     goto header                    ...
+//                                    i1 = i + 1
+//                                    c1 = i1 < n
+//                                    test c1, backedge, exit
+//
+// The header becomes the guard, which runs once, and the condition is
+// computed again at the end of each iteration, so that the back edge carries
+// it. The first block of the body becomes the loop header. Interrupt checks
+// are moved to it.
+//
+// The copies of the condition have resume points at the pc of the loop
+// head, so bailing out from them evaluates the condition again in the
+// interpreter. OSR entries, which enter the loop through its preheader, run
+// the guard as well.
+//
+// Only the instructions of headers which can be cloned, and which are used
+// after the loop only in places the loop exit dominates, are inverted. The
+// pass relies on the dominator tree and on the numbering of blocks, and it
+// leaves both up to date.
+class LInversion
+{
+    // Number of instructions a header may have to be copied to the end of
+    // the loop.
+    static const uint32 MaxHeaderInstructions = 16;
+
+    struct Loop
+    {
+        MBasicBlock *header;
+        MBasicBlock *backedge;
+
+        // Successors of the header test in and out of the loop.
+        MBasicBlock *body;
+        MBasicBlock *exit;
+    };
+
+    // Use of a definition of the header, and the value it is given once the
+    // loop is inverted.
+    struct UseReplacement
+    {
+        MNode *node;
+        size_t index;
+        MDefinition *value;
+    };
+
+    MIRGraph &graph;
+
+    // Blocks of the loop being inverted, in reverse postorder.
+    Vector<MBasicBlock *, 8, IonAllocPolicy> blocks;
+
+    // Values of the definitions of the header in the copy being built,
+    // indexed by definition id.
+    Vector<MDefinition *, 0, IonAllocPolicy> copies;
+
+    // Phis merging the values of the definitions of the header in the new
+    // header and at the loop exit, indexed by definition id.
+    Vector<MPhi *, 0, IonAllocPolicy> bodyPhis;
+    Vector<MPhi *, 0, IonAllocPolicy> exitPhis;
+
+    Vector<UseReplacement, 8, IonAllocPolicy> replacements;
+
+    bool findLoop(MBasicBlock *header, Loop *loop);
+    bool usesAreInvertible(const Loop &loop, MDefinition *def);
+
+    MDefinition *copyOf(MDefinition *def);
+    void remapResumePoint(MResumePoint *resumePoint);
+    MBasicBlock *newEdge(MBasicBlock *target);
+    MBasicBlock *copyHeader(const Loop &loop);
+
+    MPhi *phiFor(Vector<MPhi *, 0, IonAllocPolicy> &phis, MBasicBlock *block, MDefinition *def);
+    bool replaceUses(const Loop &loop, MDefinition *def, MBasicBlock *guardEntry,
+                     MBasicBlock *guardExit);
+    bool addPhiInputs(const Loop &loop, MDefinition *def);
+
+    bool invert(const Loop &loop);
+
+  public:
     LInversion(MIRGraph &graph);
-    LInversion(LIRGraph &graph);
-//  static bool checkLoopCondition(MInstruction *cond);
-//  void eliminateEmptyBlocks();
-    void eliminateUnnecessaryIf();
+    bool analyze();
+
+    // Spews the number of instructions, predecessors and successors of each
+    // block to the linv channel.
     void analyzeEmptyBlocks();
 };
 
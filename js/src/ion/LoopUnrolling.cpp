@@ -0,0 +1,705 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "jsanalyze.h"
+
+#include "Ion.h"
+#include "IonAnalysis.h"
+#include "IonSpewer.h"
+#include "LoopUnrolling.h"
+
+using namespace js;
+using namespace js::ion;
+
+LoopUnrolling::LoopUnrolling(MIRGraph &graph)
+  : graph(graph),
+    indVars(graph),
+    lastBlock(NULL)
+{
+}
+
+static inline bool
+IsInt32(int64_t value)
+{
+    return value >= JSVAL_INT_MIN && value <= JSVAL_INT_MAX;
+}
+
+// Computes the number of values of the sequence first, first + step, ...
+// for which "value <op> bound" holds before it fails for the first time.
+static bool
+ComputeTripCount(JSOp op, int64_t first, int32 step, int64_t bound, int64_t *count)
+{
+    if (step == 0)
+        return false;
+
+    switch (op) {
+      case JSOP_LE:
+        bound++;
+        // Fall through.
+      case JSOP_LT:
+        if (first >= bound) {
+            *count = 0;
+            return true;
+        }
+        if (step < 0)
+            return false;
+        *count = (bound - first + step - 1) / step;
+        return true;
+
+      case JSOP_GE:
+        bound--;
+        // Fall through.
+      case JSOP_GT:
+        if (first <= bound) {
+            *count = 0;
+            return true;
+        }
+        if (step > 0)
+            return false;
+        *count = (first - bound - step - 1) / -step;
+        return true;
+
+      case JSOP_NE:
+      case JSOP_STRICTNE:
+        if ((bound - first) % step != 0 || (bound - first) / step < 0)
+            return false;
+        *count = (bound - first) / step;
+        return true;
+
+      case JSOP_EQ:
+      case JSOP_STRICTEQ:
+        *count = (first == bound) ? 1 : 0;
+        return true;
+
+      default:
+        return false;
+    }
+}
+
+bool
+LoopUnrolling::findLoopBlocks(MBasicBlock *header, Loop *loop)
+{
+    if (header->numPredecessors() != 2)
+        return false;
+
+    MBasicBlock *backedge = header->backedge();
+    if (!backedge->lastIns()->isGoto())
+        return false;
+
+    // The blocks of innermost loops follow their header in reverse postorder.
+    blocks.clear();
+    for (MBasicBlockIterator block(graph.begin(header)); ; block++) {
+        if (block == graph.end())
+            return false;
+        if (block->id() != header->id() + blocks.length())
+            return false;
+        if (*block != header && block->isLoopHeader())
+            return false;
+        if (!header->dominates(*block))
+            return false;
+        if (!blocks.append(*block))
+            return false;
+        if (*block == backedge)
+            break;
+    }
+
+    // The loop is left from the test of its header only.
+    if (!header->lastIns()->isTest())
+        return false;
+
+    MTest *test = header->lastIns()->toTest();
+    MBasicBlock *ifTrue = test->ifTrue();
+    MBasicBlock *ifFalse = test->ifFalse();
+    bool trueInLoop = ifTrue->id() > header->id() && ifTrue->id() <= backedge->id();
+    bool falseInLoop = ifFalse->id() > header->id() && ifFalse->id() <= backedge->id();
+    if (trueInLoop == falseInLoop)
+        return false;
+
+    loop->header = header;
+    loop->backedge = backedge;
+    loop->body = trueInLoop ? ifTrue : ifFalse;
+    loop->exit = trueInLoop ? ifFalse : ifTrue;
+    loop->size = 0;
+
+    // The exit is not the target of a break, so no phi merges the values
+    // coming from the header copies.
+    if (loop->exit->numPredecessors() != 1)
+        return false;
+
+    for (size_t i = 0; i < blocks.length(); i++) {
+        MBasicBlock *block = blocks[i];
+
+        for (MPhiIterator phi(block->phisBegin()); phi != block->phisEnd(); phi++)
+            loop->size++;
+
+        for (MInstructionIterator iter(block->begin()); *iter != block->lastIns(); iter++) {
+            if (iter->isInterruptCheck())
+                continue;
+            if (!iter->canClone()) {
+                if (IonSpewEnabled(IonSpew_Unroll)) {
+                    IonSpewHeader(IonSpew_Unroll);
+                    fprintf(IonSpewFile, "Loop %d contains ", header->id());
+                    iter->printName(IonSpewFile);
+                    fprintf(IonSpewFile, ", which cannot be cloned\n");
+                }
+                return false;
+            }
+            loop->size++;
+        }
+
+        if (block == header)
+            continue;
+
+        MControlInstruction *last = block->lastIns();
+        if (!last->isGoto() && !last->isTest())
+            return false;
+        for (size_t j = 0; j < last->numSuccessors(); j++) {
+            MBasicBlock *successor = last->getSuccessor(j);
+            if (successor == header) {
+                if (block != backedge)
+                    return false;
+                continue;
+            }
+            if (successor->id() <= header->id() || successor->id() > backedge->id())
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+LoopUnrolling::analyzeTest(Loop *loop)
+{
+    MTest *test = loop->header->lastIns()->toTest();
+    if (!test->getOperand(0)->isCompare())
+        return false;
+
+    MCompare *compare = test->getOperand(0)->toCompare();
+    if (compare->specialization() != MIRType_Int32)
+        return false;
+
+    // Put the induction variable on the left side, and the comparison in
+    // the form which holds when the loop is entered.
+    MDefinition *lhs = compare->getOperand(0);
+    MDefinition *rhs = compare->getOperand(1);
+    JSOp op = compare->jsop();
+    if (!indVars.recurrence(lhs)) {
+        Swap(lhs, rhs);
+        op = analyze::ReverseCompareOp(op);
+    }
+    if (test->ifTrue() != loop->body)
+        op = analyze::NegateCompareOp(op);
+
+    const InductionVariableAnalysis::Recurrence *rec = indVars.recurrence(lhs);
+    if (!rec || rec->scale != 1)
+        return false;
+
+    const InductionVariableAnalysis::InductionVariable &iv = indVars.basicInductionVariable(*rec);
+    if (iv.phi->block() != loop->header)
+        return false;
+
+    loop->counter = lhs;
+    loop->step = iv.step;
+
+    // The blocks of the loop follow its header, so the bound is defined
+    // before the loop if its block comes first. Constants are also emitted
+    // in the header, and are the same in every iteration.
+    bool increasing = (op == JSOP_LT || op == JSOP_LE) && iv.step > 0;
+    bool decreasing = (op == JSOP_GT || op == JSOP_GE) && iv.step < 0;
+    loop->isMonotonic = (increasing || decreasing) &&
+                        (rhs->isConstant() || rhs->block()->id() < loop->header->id()) &&
+                        IsInt32(int64_t(MaxUnrollFactor - 1) * iv.step);
+
+    loop->hasTripCount = false;
+    if (iv.start->isConstant() && iv.start->toConstant()->value().isInt32() &&
+        rhs->isConstant() && rhs->toConstant()->value().isInt32())
+    {
+        int64_t start = iv.start->toConstant()->value().toInt32();
+        int64_t bound = rhs->toConstant()->value().toInt32();
+        int64_t count;
+
+        // Neither the phi nor the compared value may overflow, which would
+        // make the loop bail out or wrap around before the last iteration.
+        if (ComputeTripCount(op, start + rec->offset, iv.step, bound, &count)) {
+            int64_t last = start + count * iv.step;
+            if (IsInt32(count) && IsInt32(last) && IsInt32(last + rec->offset)) {
+                loop->hasTripCount = true;
+                loop->tripCount = uint32(count);
+            }
+        }
+    }
+
+    return loop->hasTripCount || loop->isMonotonic;
+}
+
+MDefinition *
+LoopUnrolling::copyOf(MDefinition *def)
+{
+    // Definitions made before the loop are shared by every iteration, and
+    // those of the first iteration have not been copied.
+    if (!def->block()->isMarked())
+        return def;
+    if (def->id() >= copiesOfDefinitions.length() || !copiesOfDefinitions[def->id()])
+        return def;
+    return copiesOfDefinitions[def->id()];
+}
+
+MBasicBlock *
+LoopUnrolling::copyOf(MBasicBlock *block)
+{
+    return copies[block->id() - blocks[0]->id()];
+}
+
+void
+LoopUnrolling::remapResumePoint(MResumePoint *resumePoint)
+{
+    for (size_t i = 0; i < resumePoint->numOperands(); i++) {
+        MDefinition *def = resumePoint->getOperand(i);
+        MDefinition *copy = copyOf(def);
+        if (copy != def)
+            resumePoint->replaceOperand(i, copy);
+    }
+}
+
+bool
+LoopUnrolling::copyBlock(const Loop &loop, MBasicBlock *block, MBasicBlock *copy,
+                         HeaderExit exit)
+{
+    // Phis of the header are replaced by their values in this iteration.
+    if (block != loop.header) {
+        for (MPhiIterator iter(block->phisBegin()); iter != block->phisEnd(); iter++) {
+            MPhi *phi = MPhi::NewCopy(*iter);
+            copy->addPhi(phi);
+            copiesOfDefinitions[iter->id()] = phi;
+        }
+        for (MPhiIterator iter(block->phisBegin()); iter != block->phisEnd(); iter++) {
+            MPhi *phi = copyOf(*iter)->toPhi();
+            for (size_t i = 0; i < iter->numOperands(); i++) {
+                if (!phi->addInput(copyOf(iter->getOperand(i))))
+                    return false;
+            }
+        }
+    }
+
+    remapResumePoint(copy->entryResumePoint());
+
+    MDefinitionVector operands;
+    for (MInstructionIterator iter(block->begin()); *iter != block->lastIns(); iter++) {
+        // A single interrupt check per unrolled loop is enough.
+        if (iter->isInterruptCheck())
+            continue;
+
+        operands.clear();
+        for (size_t i = 0; i < iter->numOperands(); i++) {
+            if (!operands.append(copyOf(iter->getOperand(i))))
+                return false;
+        }
+
+        MInstruction *ins = iter->clone(operands.begin());
+        copy->add(ins);
+        copiesOfDefinitions[iter->id()] = ins;
+
+        if (iter->resumePoint()) {
+            MResumePoint *resumePoint = MResumePoint::Copy(copy, iter->resumePoint());
+            if (!resumePoint)
+                return false;
+            remapResumePoint(resumePoint);
+            ins->setResumePoint(resumePoint);
+        }
+    }
+
+    // The copy of the backedge is ended by the next iteration, as its
+    // original now jumps to the first copy of the header, or by the caller.
+    MControlInstruction *last = block->lastIns();
+    if (block == loop.header) {
+        if (exit == TestHolds) {
+            copy->end(MGoto::New(copyOf(loop.body)));
+        } else if (exit == TestFails) {
+            copy->end(MGoto::New(loop.exit));
+        } else {
+            MTest *test = last->toTest();
+            bool bodyIfTrue = test->ifTrue() == loop.body;
+            copy->end(MTest::New(copyOf(test->getOperand(0)),
+                                 bodyIfTrue ? copyOf(loop.body) : loop.exit,
+                                 bodyIfTrue ? loop.exit : copyOf(loop.body)));
+        }
+    } else if (block == loop.backedge) {
+        return true;
+    } else if (last->isGoto()) {
+        copy->end(MGoto::New(copyOf(last->toGoto()->target())));
+    } else {
+        MTest *test = last->toTest();
+        copy->end(MTest::New(copyOf(test->getOperand(0)),
+                             copyOf(test->ifTrue()), copyOf(test->ifFalse())));
+    }
+
+    return true;
+}
+
+bool
+LoopUnrolling::copyIteration(const Loop &loop, MBasicBlock *pred, bool lastIteration)
+{
+    uint32 index = 0;
+    for (MPhiIterator phi(loop.header->phisBegin()); phi != loop.header->phisEnd(); phi++)
+        copiesOfDefinitions[phi->id()] = phiValues[index++];
+
+    // After the last iteration, only the header is executed.
+    size_t numBlocks = lastIteration ? 1 : blocks.length();
+
+    copies.clear();
+    for (size_t i = 0; i < numBlocks; i++) {
+        MBasicBlock *copy = MBasicBlock::NewCopy(graph, blocks[i]);
+        if (!copy || !copies.append(copy))
+            return false;
+        graph.insertBlockAfter(lastBlock, copy);
+        copy->mark();
+        lastBlock = copy;
+    }
+
+    for (size_t i = 0; i < numBlocks; i++) {
+        if (!copyBlock(loop, blocks[i], copies[i], lastIteration ? TestFails : TestHolds))
+            return false;
+    }
+
+    for (size_t i = 1; i < numBlocks; i++) {
+        MBasicBlock *block = blocks[i];
+        for (size_t j = 0; j < block->numPredecessors(); j++) {
+            if (!copies[i]->addPredecessorWithoutPhis(copyOf(block->getPredecessor(j))))
+                return false;
+        }
+    }
+
+    // Chain the iteration to the previous one.
+    MBasicBlock *header = copies[0];
+    if (pred->lastIns())
+        pred->lastIns()->replaceSuccessor(0, header);
+    else
+        pred->end(MGoto::New(header));
+    return header->addPredecessorWithoutPhis(pred);
+}
+
+bool
+LoopUnrolling::computePhiValues(const Loop &loop)
+{
+    MDefinitionVector values;
+    for (MPhiIterator phi(loop.header->phisBegin()); phi != loop.header->phisEnd(); phi++) {
+        if (!values.append(copyOf(phi->getOperand(1))))
+            return false;
+    }
+
+    phiValues.clear();
+    return phiValues.append(values.begin(), values.end());
+}
+
+bool
+LoopUnrolling::collectUsesAfterLoop(MDefinition *def, MDefinition *value)
+{
+    for (MUseIterator use(def->usesBegin()); use != def->usesEnd(); use++) {
+        if (use->node()->block()->isMarked())
+            continue;
+        UseReplacement replacement = { use->node(), use->index(), value };
+        if (!usesAfterLoop.append(replacement))
+            return false;
+    }
+    return true;
+}
+
+bool
+LoopUnrolling::replaceUsesAfterLoop(const Loop &loop)
+{
+    // The copies of the definitions of the header may be other phis of the
+    // header, e.g. when the loop swaps two variables, so the uses are all
+    // collected before any of them is replaced.
+    MBasicBlock *header = loop.header;
+    usesAfterLoop.clear();
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); phi++) {
+        if (!collectUsesAfterLoop(*phi, copyOf(*phi)))
+            return false;
+    }
+    for (MInstructionIterator iter(header->begin()); *iter != header->lastIns(); iter++) {
+        if (!iter->isInterruptCheck() && !collectUsesAfterLoop(*iter, copyOf(*iter)))
+            return false;
+    }
+    for (size_t i = 0; i < usesAfterLoop.length(); i++) {
+        const UseReplacement &use = usesAfterLoop[i];
+        use.node->replaceOperand(use.index, use.value);
+    }
+    return true;
+}
+
+bool
+LoopUnrolling::unrollFully(const Loop &loop)
+{
+    IonSpew(IonSpew_Unroll, "Fully unrolling loop %d: %u iterations of %u instructions",
+            loop.header->id(), loop.tripCount, loop.size);
+
+    MBasicBlock *header = loop.header;
+
+    if (!computePhiValues(loop))
+        return false;
+
+    MBasicBlock *pred = loop.backedge;
+    for (uint32 i = 1; i < loop.tripCount; i++) {
+        if (!copyIteration(loop, pred, false))
+            return false;
+        if (!computePhiValues(loop))
+            return false;
+        pred = copies.back();
+    }
+    if (!copyIteration(loop, pred, true))
+        return false;
+    loop.exit->replacePredecessor(header, copies[0]);
+
+    // The definitions of the header which are used after the loop have the
+    // values computed by its last copy.
+    if (!replaceUsesAfterLoop(loop))
+        return false;
+
+    // The original blocks now run the first iteration only.
+    for (MPhiIterator phi(header->phisBegin()); phi != header->phisEnd(); ) {
+        phi->replaceAllUsesWith(phi->getOperand(0));
+        phi = header->discardPhiAt(phi);
+    }
+    header->discardLastIns();
+    header->end(MGoto::New(loop.body));
+    header->removePredecessor(1);
+    header->clearLoopHeader();
+
+    for (size_t i = 0; i < blocks.length(); i++) {
+        for (MInstructionIterator iter(blocks[i]->begin()); iter != blocks[i]->end(); ) {
+            if (iter->isInterruptCheck())
+                iter = blocks[i]->discardAt(iter);
+            else
+                iter++;
+        }
+    }
+
+    uint32 loopDepth = header->loopDepth();
+    for (MBasicBlockIterator block(graph.begin(header)); block != graph.end(); block++) {
+        if (block->isMarked())
+            block->setLoopDepth(loopDepth - 1);
+    }
+
+    return true;
+}
+
+bool
+LoopUnrolling::copyRemainderLoop(const Loop &loop)
+{
+    MBasicBlock *header = loop.header;
+
+    // The copy is entered from a block of its own, as the header of the
+    // unrolled loop has two successors and the copy of the header has phis.
+    MBasicBlock *entry = MBasicBlock::NewSplitEdge(graph, header->info(), header);
+    if (!entry)
+        return false;
+    graph.insertBlockAfter(lastBlock, entry);
+    entry->mark();
+    entry->setLoopDepth(header->loopDepth() - 1);
+    lastBlock = entry;
+
+    copies.clear();
+    for (size_t i = 0; i < blocks.length(); i++) {
+        MBasicBlock *copy = MBasicBlock::NewCopy(graph, blocks[i]);
+        if (!copy || !copies.append(copy))
+            return false;
+        graph.insertBlockAfter(lastBlock, copy);
+        copy->mark();
+        lastBlock = copy;
+    }
+
+    // The phis of the copy start from the values left by the unrolled loop.
+    MBasicBlock *copyOfHeader = copies[0];
+    for (MPhiIterator iter(header->phisBegin()); iter != header->phisEnd(); iter++) {
+        MPhi *phi = MPhi::NewCopy(*iter);
+        copyOfHeader->addPhi(phi);
+        if (!phi->addInput(*iter))
+            return false;
+        copiesOfDefinitions[iter->id()] = phi;
+    }
+
+    for (size_t i = 0; i < blocks.length(); i++) {
+        if (!copyBlock(loop, blocks[i], copies[i], KeepTest))
+            return false;
+    }
+
+    for (size_t i = 1; i < blocks.length(); i++) {
+        MBasicBlock *block = blocks[i];
+        for (size_t j = 0; j < block->numPredecessors(); j++) {
+            if (!copies[i]->addPredecessorWithoutPhis(copyOf(block->getPredecessor(j))))
+                return false;
+        }
+    }
+
+    for (MPhiIterator iter(header->phisBegin()); iter != header->phisEnd(); iter++) {
+        if (!copyOf(*iter)->toPhi()->addInput(copyOf(iter->getOperand(1))))
+            return false;
+    }
+
+    MBasicBlock *copyOfBackedge = copyOf(loop.backedge);
+    entry->end(MGoto::New(copyOfHeader));
+    copyOfBackedge->end(MGoto::New(copyOfHeader));
+    if (!copyOfHeader->addPredecessorWithoutPhis(entry))
+        return false;
+    if (!copyOfHeader->addPredecessorWithoutPhis(copyOfBackedge))
+        return false;
+    copyOfHeader->makeLoopHeader();
+
+    // The loop now exits to the copy, which exits to the original exit.
+    MTest *test = header->lastIns()->toTest();
+    test->replaceSuccessor(test->ifTrue() == loop.exit ? 0 : 1, entry);
+    loop.exit->replacePredecessor(header, copyOfHeader);
+
+    if (!replaceUsesAfterLoop(loop))
+        return false;
+
+    // The original loop is unrolled next, from its own definitions.
+    for (size_t i = 0; i < blocks.length(); i++) {
+        MBasicBlock *block = blocks[i];
+        for (MPhiIterator iter(block->phisBegin()); iter != block->phisEnd(); iter++)
+            copiesOfDefinitions[iter->id()] = NULL;
+        for (MInstructionIterator iter(block->begin()); iter != block->end(); iter++)
+            copiesOfDefinitions[iter->id()] = NULL;
+    }
+    return true;
+}
+
+void
+LoopUnrolling::guardIterations(const Loop &loop, uint32 factor)
+{
+    // The counter moves toward the bound, so the test holds for the next
+    // |factor| iterations if it holds for the last of them.
+    MTest *test = loop.header->lastIns()->toTest();
+    MCompare *compare = test->getOperand(0)->toCompare();
+
+    MConstant *distance = MConstant::New(Int32Value(int32((factor - 1) * loop.step)));
+    MAdd *counter = MAdd::New(loop.counter, distance, MIRType_Int32);
+
+    MDefinition *operands[2] = { compare->getOperand(0), compare->getOperand(1) };
+    operands[compare->getOperand(0) == loop.counter ? 0 : 1] = counter;
+    MInstruction *guard = compare->clone(operands);
+
+    loop.header->insertBefore(test, distance);
+    loop.header->insertBefore(test, counter);
+    loop.header->insertBefore(test, guard);
+    test->replaceOperand(0, guard);
+}
+
+bool
+LoopUnrolling::unrollPartially(const Loop &loop, uint32 factor)
+{
+    bool needsRemainder = !loop.hasTripCount || loop.tripCount % factor != 0;
+
+    if (loop.hasTripCount) {
+        IonSpew(IonSpew_Unroll, "Unrolling loop %d by %u: %u iterations of %u instructions",
+                loop.header->id(), factor, loop.tripCount, loop.size);
+    } else {
+        IonSpew(IonSpew_Unroll, "Unrolling loop %d by %u: %u instructions",
+                loop.header->id(), factor, loop.size);
+    }
+
+    // The copy of the loop is made first, as unrolling changes the original.
+    if (needsRemainder) {
+        if (!copyRemainderLoop(loop))
+            return false;
+        lastBlock = loop.backedge;
+    }
+
+    if (!computePhiValues(loop))
+        return false;
+
+    MBasicBlock *pred = loop.backedge;
+    for (uint32 i = 1; i < factor; i++) {
+        if (!copyIteration(loop, pred, false))
+            return false;
+        if (!computePhiValues(loop))
+            return false;
+        pred = copies.back();
+    }
+
+    // The last copy of the body becomes the backedge.
+    pred->end(MGoto::New(loop.header));
+    loop.header->replacePredecessor(loop.backedge, pred);
+
+    uint32 index = 0;
+    for (MPhiIterator phi(loop.header->phisBegin()); phi != loop.header->phisEnd(); phi++)
+        phi->replaceOperand(1, phiValues[index++]);
+
+    if (needsRemainder)
+        guardIterations(loop, factor);
+
+    return true;
+}
+
+bool
+LoopUnrolling::analyze()
+{
+    IonSpew(IonSpew_Unroll, "Beginning loop unrolling pass.");
+
+    if (!indVars.analyze())
+        return false;
+
+    // The headers of the loops are collected first, as unrolling adds blocks
+    // to the graph.
+    Vector<MBasicBlock *, 4, IonAllocPolicy> headers;
+    for (MBasicBlockIterator block(graph.begin()); block != graph.end(); block++) {
+        if (block->isLoopHeader() && !headers.append(*block))
+            return false;
+    }
+
+    if (!copiesOfDefinitions.appendN(NULL, graph.getMaxInstructionId() + 1))
+        return false;
+
+    // Phi successors are found again once the graph has been changed.
+    for (MBasicBlockIterator block(graph.begin()); block != graph.end(); block++)
+        block->setSuccessorWithPhis(NULL, 0);
+
+    bool changed = false;
+    for (size_t i = 0; i < headers.length(); i++) {
+        Loop loop;
+        if (!findLoopBlocks(headers[i], &loop) || !analyzeTest(&loop))
+            continue;
+        if (loop.hasTripCount && loop.tripCount == 0)
+            continue;
+
+        graph.unmarkBlocks();
+        for (size_t j = 0; j < blocks.length(); j++)
+            blocks[j]->mark();
+        lastBlock = loop.backedge;
+
+        if (loop.hasTripCount && loop.tripCount * loop.size <= MaxUnrolledInstructions) {
+            if (!unrollFully(loop))
+                return false;
+            changed = true;
+            continue;
+        }
+
+        for (uint32 factor = MaxUnrollFactor; factor >= MinUnrollFactor; factor /= 2) {
+            if (factor * loop.size > MaxUnrolledInstructions)
+                continue;
+            bool divides = loop.hasTripCount && loop.tripCount % factor == 0;
+            if (!divides && !loop.isMonotonic)
+                continue;
+            if (!unrollPartially(loop, factor))
+                return false;
+            changed = true;
+            break;
+        }
+    }
+    graph.unmarkBlocks();
+
+    if (changed) {
+        ClearDominatorTree(graph);
+        if (!RenumberBlocks(graph))
+            return false;
+        if (!BuildDominatorTree(graph))
+            return false;
+    }
+
+    return BuildPhiReverseMapping(graph);
+}
@@ -0,0 +1,138 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef jsion_loop_unrolling_h__
+#define jsion_loop_unrolling_h__
+
+#include "InductionVariable.h"
+#include "IonAllocPolicy.h"
+#include "MIR.h"
+#include "MIRGraph.h"
+
+namespace js {
+namespace ion {
+
+// Unrolls innermost loops whose number of iterations is known at compile
+// time, e.g. because they are bounded by constants or by arguments which
+// parameter specialization turned into constants.
+//
+// Loops whose body fits, once copied for every iteration, in a budget of
+// instructions are fully unrolled: the loop disappears, and the copies of the
+// body are chained one after the other. Loops running for longer are
+// partially unrolled, so that the exit test and the phis are only evaluated
+// once per group of iterations.
+//
+// When the trip count is unknown, or not a multiple of the factor, the test
+// of the unrolled loop checks that the counter stays within its bound for the
+// whole group, e.g. |i + 3 < n| when unrolling |i < n; i++| by 4. The
+// iterations left once it fails are run by a copy of the original loop.
+//
+// The loops must have a single exit, taken from their header, and contain
+// instructions which can be cloned only. Interrupt checks are dropped from
+// the copies of the body.
+//
+// As the analysis of induction variables, this pass relies on the dominator
+// tree and on the numbering of blocks. It leaves both up to date.
+class LoopUnrolling
+{
+    // Number of instructions a loop may have once unrolled.
+    static const uint32 MaxUnrolledInstructions = 200;
+
+    // Factors by which loops which cannot be fully unrolled are unrolled.
+    static const uint32 MaxUnrollFactor = 4;
+    static const uint32 MinUnrollFactor = 2;
+
+    struct Loop
+    {
+        MBasicBlock *header;
+        MBasicBlock *backedge;
+
+        // Successors of the header test in and out of the loop.
+        MBasicBlock *body;
+        MBasicBlock *exit;
+
+        // Number of times the body of the loop is executed, if known at
+        // compile time.
+        bool hasTripCount;
+        uint32 tripCount;
+
+        // Whether the test compares |counter|, which changes by |step| at
+        // each iteration, to a bound defined before the loop, and fails once
+        // the counter crosses it. The test of a group of iterations is then
+        // the test of the last one.
+        bool isMonotonic;
+        MDefinition *counter;
+        int32 step;
+
+        // Number of instructions in the loop.
+        uint32 size;
+    };
+
+    MIRGraph &graph;
+    InductionVariableAnalysis indVars;
+
+    // Blocks of the loop being unrolled, in reverse postorder, and their
+    // copies in the iteration being built.
+    Vector<MBasicBlock *, 4, IonAllocPolicy> blocks;
+    Vector<MBasicBlock *, 4, IonAllocPolicy> copies;
+
+    // Copies of the definitions of the loop in the iteration being built,
+    // indexed by definition id. The header phis are mapped to the values
+    // they have at the beginning of the iteration.
+    Vector<MDefinition *, 0, IonAllocPolicy> copiesOfDefinitions;
+
+    // Values of the header phis at the beginning of the next iteration.
+    MDefinitionVector phiValues;
+
+    // Uses of the definitions of the header after a fully unrolled loop, and
+    // the values they are given.
+    struct UseReplacement
+    {
+        MNode *node;
+        size_t index;
+        MDefinition *value;
+    };
+    Vector<UseReplacement, 8, IonAllocPolicy> usesAfterLoop;
+
+    // Last block added to the graph.
+    MBasicBlock *lastBlock;
+
+    // How the copy of the header ends: its test is known to hold inside an
+    // unrolled loop and to fail after the last iteration, and is kept by the
+    // copy of a whole loop.
+    enum HeaderExit {
+        TestHolds,
+        TestFails,
+        KeepTest
+    };
+
+    bool findLoopBlocks(MBasicBlock *header, Loop *loop);
+    bool analyzeTest(Loop *loop);
+
+    MDefinition *copyOf(MDefinition *def);
+    MBasicBlock *copyOf(MBasicBlock *block);
+    void remapResumePoint(MResumePoint *resumePoint);
+    bool copyBlock(const Loop &loop, MBasicBlock *block, MBasicBlock *copy, HeaderExit exit);
+    bool copyIteration(const Loop &loop, MBasicBlock *pred, bool lastIteration);
+    bool computePhiValues(const Loop &loop);
+    bool collectUsesAfterLoop(MDefinition *def, MDefinition *value);
+    bool replaceUsesAfterLoop(const Loop &loop);
+    bool copyRemainderLoop(const Loop &loop);
+    void guardIterations(const Loop &loop, uint32 factor);
+
+    bool unrollFully(const Loop &loop);
+    bool unrollPartially(const Loop &loop, uint32 factor);
+
+  public:
+    LoopUnrolling(MIRGraph &graph);
+    bool analyze();
+};
+
+} // namespace ion
+} // namespace js
+
+#endif // jsion_loop_unrolling_h__
@@ -0,0 +1,359 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <float.h>
+
+#include "Ion.h"
+#include "IonSpewer.h"
+#include "LoopVectorization.h"
+
+using namespace js;
+using namespace js::ion;
+
+LoopVectorization::LoopVectorization(MIRGraph &graph)
+  : graph(graph)
+{
+}
+
+// Type of the elements of a typed array, once loaded.
+static MIRType
+LaneType(int arrayType)
+{
+    return arrayType == TypedArray::TYPE_INT32 ? MIRType_Int32 : MIRType_Double;
+}
+
+// Whether a double is unchanged when converted to a float. Float32Array
+// loops compute in double precision and round when storing: this is the same
+// as computing in single precision only if the other operand is a float.
+static bool
+IsFloat32Exact(double d)
+{
+    if (d != d)
+        return true;
+    if (d < -FLT_MAX || d > FLT_MAX)
+        return false;
+    return double(float(d)) == d;
+}
+
+bool
+LoopVectorization::isInvariant(Loop &loop, MDefinition *def)
+{
+    return def->block() != loop.header && def->block() != loop.body;
+}
+
+// Whether |def| loads the element of an array of the type stored into, at the
+// index of the loop.
+bool
+LoopVectorization::isLoadAt(Loop &loop, MDefinition *def)
+{
+    if (!def->isLoadTypedArrayElement())
+        return false;
+
+    MLoadTypedArrayElement *load = def->toLoadTypedArrayElement();
+    return load->index() == loop.index &&
+           load->arrayType() == loop.store->arrayType() &&
+           load->type() == LaneType(load->arrayType()) &&
+           load->elements()->isTypedArrayElements() &&
+           isInvariant(loop, load->elements());
+}
+
+// Whether |def| has the same value in every iteration. Constants and
+// conversions left in the body are copied before the loop.
+bool
+LoopVectorization::isScalar(Loop &loop, MDefinition *def, bool exactFloat32)
+{
+    if (def->isConstant()) {
+        const Value &v = def->toConstant()->value();
+        if (!v.isNumber())
+            return false;
+        return !exactFloat32 || IsFloat32Exact(v.toNumber());
+    }
+    if (def->isToDouble() && def->block() == loop.body) {
+        MDefinition *input = def->toToDouble()->input();
+        return input->type() == MIRType_Int32 && isScalar(loop, input, exactFloat32);
+    }
+    return !exactFloat32 && isInvariant(loop, def);
+}
+
+bool
+LoopVectorization::matchOperand(Loop &loop, MDefinition *def, MDefinition **value,
+                                bool *isArray)
+{
+    int arrayType = loop.store->arrayType();
+
+    if (isLoadAt(loop, def)) {
+        *value = def->toLoadTypedArrayElement()->elements();
+        *isArray = true;
+        return true;
+    }
+
+    bool exactFloat32 = arrayType == TypedArray::TYPE_FLOAT32;
+    if (def->type() == LaneType(arrayType) && isScalar(loop, def, exactFloat32)) {
+        *value = def;
+        *isArray = false;
+        return true;
+    }
+    return false;
+}
+
+// The header must only compare the index, which is its only phi, to a loop
+// invariant bound, and branch to the body or out of the loop. The body must
+// be a single block, which increments the index by one.
+bool
+LoopVectorization::matchHeader(Loop &loop)
+{
+    MBasicBlock *header = loop.header;
+    MBasicBlock *body = header->backedge();
+    if (body->numPredecessors() != 1 || body->getPredecessor(0) != header)
+        return false;
+    loop.body = body;
+
+    MPhiIterator phi(header->phisBegin());
+    if (phi == header->phisEnd())
+        return false;
+    loop.index = *phi;
+    if (++phi != header->phisEnd())
+        return false;
+    if (loop.index->type() != MIRType_Int32 || loop.index->numOperands() != 2)
+        return false;
+
+    MCompare *compare = NULL;
+    for (MInstructionIterator ins(header->begin()); ins != header->end(); ins++) {
+        if (ins->isInterruptCheck())
+            continue;
+        if (ins->isCompare() && !compare) {
+            compare = ins->toCompare();
+            continue;
+        }
+        if (*ins == header->lastIns())
+            break;
+        return false;
+    }
+    if (!compare || compare->jsop() != JSOP_LT || compare->specialization() != MIRType_Int32)
+        return false;
+    if (compare->lhs() != loop.index || !isInvariant(loop, compare->rhs()))
+        return false;
+    loop.bound = compare->rhs();
+
+    MControlInstruction *test = header->lastIns();
+    if (!test->isTest() || test->getOperand(0) != compare || test->toTest()->ifTrue() != body)
+        return false;
+
+    MDefinition *increment = loop.index->getOperand(1);
+    if (!increment->isAdd() || increment->block() != body)
+        return false;
+    MAdd *add = increment->toAdd();
+    if (add->specialization() != MIRType_Int32)
+        return false;
+    MDefinition *step = add->lhs() == loop.index ? add->rhs() : add->lhs();
+    if (add->lhs() != loop.index && add->rhs() != loop.index)
+        return false;
+    return step->isConstant() && step->toConstant()->value() == Int32Value(1);
+}
+
+// The body must store into a typed array at the index of the loop.
+bool
+LoopVectorization::matchStore(Loop &loop)
+{
+    loop.store = NULL;
+    for (MInstructionIterator ins(loop.body->begin()); ins != loop.body->end(); ins++) {
+        if (!ins->isStoreTypedArrayElement())
+            continue;
+        if (loop.store)
+            return false;
+        loop.store = ins->toStoreTypedArrayElement();
+    }
+
+    MStoreTypedArrayElement *store = loop.store;
+    if (!store || store->index() != loop.index)
+        return false;
+    if (!store->elements()->isTypedArrayElements() || !isInvariant(loop, store->elements()))
+        return false;
+
+    int arrayType = store->arrayType();
+    if (arrayType != TypedArray::TYPE_INT32 &&
+        arrayType != TypedArray::TYPE_FLOAT32 &&
+        arrayType != TypedArray::TYPE_FLOAT64)
+    {
+        return false;
+    }
+
+    MDefinition *value = store->value();
+    if (value->type() != LaneType(arrayType))
+        return false;
+
+    if (isLoadAt(loop, value)) {
+        loop.operation = MTypedArrayVectorLoop::Copy;
+        loop.lhs = loop.rhs = value->toLoadTypedArrayElement()->elements();
+        loop.lhsIsArray = loop.rhsIsArray = true;
+        return true;
+    }
+
+    if (value->isAdd() || value->isSub() || value->isMul()) {
+        if (value->block() != loop.body)
+            return false;
+
+        // Products of integers are not truncated like the product of their
+        // doubles, which loses precision.
+        MBinaryArithInstruction *arith = static_cast<MBinaryArithInstruction *>(value);
+        if (arith->specialization() != LaneType(arrayType))
+            return false;
+        if (value->isMul() && arrayType == TypedArray::TYPE_INT32)
+            return false;
+
+        if (!matchOperand(loop, arith->lhs(), &loop.lhs, &loop.lhsIsArray) ||
+            !matchOperand(loop, arith->rhs(), &loop.rhs, &loop.rhsIsArray))
+        {
+            return false;
+        }
+        if (!loop.lhsIsArray && !loop.rhsIsArray)
+            return false;
+
+        if (value->isAdd())
+            loop.operation = MTypedArrayVectorLoop::Add;
+        else if (value->isSub())
+            loop.operation = MTypedArrayVectorLoop::Sub;
+        else
+            loop.operation = MTypedArrayVectorLoop::Mul;
+        return true;
+    }
+
+    if (isScalar(loop, value, false)) {
+        loop.operation = MTypedArrayVectorLoop::Fill;
+        loop.lhs = loop.rhs = value;
+        loop.lhsIsArray = loop.rhsIsArray = false;
+        return true;
+    }
+
+    return false;
+}
+
+// Besides the store, its value and the increment, the body may only load
+// elements at the index, convert them, and check the index against lengths.
+// None of these has effects, and the vector loop never runs past the end of
+// an array.
+bool
+LoopVectorization::matchBody(Loop &loop)
+{
+    MDefinition *increment = loop.index->getOperand(1);
+
+    for (MInstructionIterator iter(loop.body->begin()); iter != loop.body->end(); iter++) {
+        MInstruction *ins = *iter;
+        if (ins == loop.store || ins == increment || ins == loop.store->value())
+            continue;
+        if (ins == loop.body->lastIns()) {
+            JS_ASSERT(ins->isGoto());
+            continue;
+        }
+
+        switch (ins->op()) {
+          case MDefinition::Op_Constant:
+          case MDefinition::Op_ToDouble:
+            break;
+          case MDefinition::Op_LoadTypedArrayElement:
+            if (!isLoadAt(loop, ins))
+                return false;
+            break;
+          case MDefinition::Op_BoundsCheck:
+            if (ins->toBoundsCheck()->index() != loop.index)
+                return false;
+            break;
+          case MDefinition::Op_BoundsCheckLower:
+            if (ins->toBoundsCheckLower()->index() != loop.index)
+                return false;
+            break;
+          default:
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copies a scalar computed in the body before the loop.
+MDefinition *
+LoopVectorization::hoistScalar(Loop &loop, MDefinition *def)
+{
+    if (isInvariant(loop, def))
+        return def;
+
+    MBasicBlock *preheader = loop.header->loopPredecessor();
+    MInstruction *copy;
+    if (def->isConstant()) {
+        copy = MConstant::New(def->toConstant()->value());
+    } else {
+        JS_ASSERT(def->isToDouble());
+        copy = MToDouble::New(hoistScalar(loop, def->toToDouble()->input()));
+    }
+    preheader->insertBefore(preheader->lastIns(), copy);
+    return copy;
+}
+
+MDefinition *
+LoopVectorization::lengthOf(Loop &loop, MDefinition *elements)
+{
+    MBasicBlock *preheader = loop.header->loopPredecessor();
+    MTypedArrayLength *length =
+        MTypedArrayLength::New(elements->toTypedArrayElements()->object());
+    preheader->insertBefore(preheader->lastIns(), length);
+    return length;
+}
+
+bool
+LoopVectorization::vectorize(Loop &loop)
+{
+    MBasicBlock *preheader = loop.header->loopPredecessor();
+    MDefinition *elements = loop.store->elements();
+    MDefinition *length = lengthOf(loop, elements);
+
+    MDefinition *lhs = loop.lhsIsArray ? loop.lhs : hoistScalar(loop, loop.lhs);
+    MDefinition *lhsLength = loop.lhsIsArray ? lengthOf(loop, lhs) : length;
+
+    MDefinition *rhs = lhs;
+    MDefinition *rhsLength = lhsLength;
+    if (loop.operation != MTypedArrayVectorLoop::Copy &&
+        loop.operation != MTypedArrayVectorLoop::Fill)
+    {
+        rhs = loop.rhsIsArray ? loop.rhs : hoistScalar(loop, loop.rhs);
+        rhsLength = loop.rhsIsArray ? lengthOf(loop, rhs) : length;
+    }
+
+    MTypedArrayVectorLoop *kernel =
+        MTypedArrayVectorLoop::New(loop.operation, loop.store->arrayType(),
+                                   loop.index->getOperand(0), loop.bound, elements, length,
+                                   lhs, lhsLength, loop.lhsIsArray,
+                                   rhs, rhsLength, loop.rhsIsArray);
+    preheader->insertBefore(preheader->lastIns(), kernel);
+
+    // The loop continues from the first iteration the kernel did not run.
+    loop.index->replaceOperand(0, kernel);
+    return true;
+}
+
+bool
+LoopVectorization::analyze()
+{
+    IonSpew(IonSpew_Vectorize, "Beginning loop vectorization pass.");
+
+    for (ReversePostorderIterator block(graph.rpoBegin()); block != graph.rpoEnd(); block++) {
+        if (!block->isLoopHeader())
+            continue;
+
+        Loop loop;
+        loop.header = *block;
+        if (!matchHeader(loop) || !matchStore(loop) || !matchBody(loop)) {
+            IonSpew(IonSpew_Vectorize, "Loop %d cannot be vectorized", block->id());
+            continue;
+        }
+
+        IonSpew(IonSpew_Vectorize, "Vectorizing loop %d: operation %d on array type %d",
+                block->id(), int(loop.operation), loop.store->arrayType());
+        if (!vectorize(loop))
+            return false;
+    }
+
+    return true;
+}
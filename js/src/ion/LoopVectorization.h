@@ -0,0 +1,72 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef jsion_loop_vectorization_h__
+#define jsion_loop_vectorization_h__
+
+#include "MIR.h"
+#include "MIRGraph.h"
+
+namespace js {
+namespace ion {
+
+// Runs simple loops over typed arrays several elements at a time, with packed
+// SSE instructions.
+//
+// The loops must consist of a header comparing an Int32 induction variable,
+// incremented by one, to a loop invariant bound, and of a single block storing
+// into an Int32Array, a Float32Array or a Float64Array at that index. The
+// value stored is either a scalar (fill), an element of another array of the
+// same type at the same index (copy), or the sum, difference or product of two
+// such operands, one of them at least being an array.
+//
+// An MTypedArrayVectorLoop is inserted before the loop, and the loop starts
+// at the index it returns: the original loop then runs the last iterations,
+// which do not fill a vector, as a scalar epilogue.
+//
+// Reductions, such as sums and dot products, are left alone: their floating
+// point results depend on the order in which the elements are added.
+class LoopVectorization
+{
+    struct Loop
+    {
+        MBasicBlock *header;
+        MBasicBlock *body;
+        MPhi *index;
+        MDefinition *bound;
+        MStoreTypedArrayElement *store;
+
+        MTypedArrayVectorLoop::Operation operation;
+        MDefinition *lhs;
+        MDefinition *rhs;
+        bool lhsIsArray;
+        bool rhsIsArray;
+    };
+
+    MIRGraph &graph;
+
+    bool isInvariant(Loop &loop, MDefinition *def);
+    bool isLoadAt(Loop &loop, MDefinition *def);
+    bool isScalar(Loop &loop, MDefinition *def, bool exactFloat32);
+    bool matchOperand(Loop &loop, MDefinition *def, MDefinition **value, bool *isArray);
+    bool matchHeader(Loop &loop);
+    bool matchStore(Loop &loop);
+    bool matchBody(Loop &loop);
+
+    MDefinition *hoistScalar(Loop &loop, MDefinition *def);
+    MDefinition *lengthOf(Loop &loop, MDefinition *elements);
+    bool vectorize(Loop &loop);
+
+  public:
+    LoopVectorization(MIRGraph &graph);
+    bool analyze();
+};
+
+} // namespace ion
+} // namespace js
+
+#endif // jsion_loop_vectorization_h__
@@ -119,6 +119,13 @@ LIRGenerator::visitNewObject(MNewObject *ins)
     return define(lir, ins) && assignSafepoint(lir, ins);
 }
 
+bool
+LIRGenerator::visitObjectState(MObjectState *ins)
+{
+    // Only snapshots refer to object states, and they record the operands.
+    return true;
+}
+
 bool
 LIRGenerator::visitNewCallObject(MNewCallObject *ins)
 {
@@ -1584,6 +1591,22 @@ LIRGenerator::visitGetElementCache(MGetElementCache *ins)
     return assignSafepoint(lir, ins);
 }
 
+bool
+LIRGenerator::visitSetElementCache(MSetElementCache *ins)
+{
+    JS_ASSERT(ins->object()->type() == MIRType_Object);
+    JS_ASSERT(ins->index()->type() == MIRType_Value);
+    JS_ASSERT(ins->value()->type() == MIRType_Value);
+
+    LSetElementCacheV *lir = new LSetElementCacheV(useRegister(ins->object()), temp(),
+                                                   tempFloat());
+    if (!useBox(lir, LSetElementCacheV::Index, ins->index()))
+        return false;
+    if (!useBox(lir, LSetElementCacheV::Value, ins->value()))
+        return false;
+    return add(lir, ins) && assignSafepoint(lir, ins);
+}
+
 bool
 LIRGenerator::visitBindNameCache(MBindNameCache *ins)
 {
@@ -1602,6 +1625,15 @@ LIRGenerator::visitGuardClass(MGuardClass *ins)
     return assignSnapshot(guard) && add(guard, ins);
 }
 
+bool
+LIRGenerator::visitGuardValue(MGuardValue *ins)
+{
+    LGuardValue *guard = new LGuardValue();
+    if (!useBox(guard, LGuardValue::Input, ins->input()))
+        return false;
+    return assignSnapshot(guard, Bailout_ParameterCheck) && add(guard, ins);
+}
+
 bool
 LIRGenerator::visitGuardObject(MGuardObject *ins)
 {
@@ -80,6 +80,7 @@ class LIRGenerator : public LIRGeneratorSpecific
     bool visitNewSlots(MNewSlots *ins);
     bool visitNewArray(MNewArray *ins);
     bool visitNewObject(MNewObject *ins);
+    bool visitObjectState(MObjectState *ins);
     bool visitNewCallObject(MNewCallObject *ins);
     bool visitInitProp(MInitProp *ins);
     bool visitCheckOverRecursed(MCheckOverRecursed *ins);
@@ -156,8 +157,10 @@ class LIRGenerator : public LIRGeneratorSpecific
     bool visitStoreFixedSlot(MStoreFixedSlot *ins);
     bool visitGetPropertyCache(MGetPropertyCache *ins);
     bool visitGetElementCache(MGetElementCache *ins);
+    bool visitSetElementCache(MSetElementCache *ins);
     bool visitBindNameCache(MBindNameCache *ins);
     bool visitGuardClass(MGuardClass *ins);
+    bool visitGuardValue(MGuardValue *ins);
     bool visitGuardObject(MGuardObject *ins);
     bool visitCallGetProperty(MCallGetProperty *ins);
     bool visitDeleteProperty(MDeleteProperty *ins);
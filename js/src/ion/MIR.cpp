@@ -43,19 +43,28 @@ EqualValues(bool useGVN, MDefinition *left, MDefinition *right)
     return left->id() == right->id();
 }
 
-static MConstant *
-EvaluateConstantOperands(MBinaryInstruction *ins)
+bool
+ion::EvaluateBinaryOperation(MBinaryInstruction *ins, const Value &lhs, const Value &rhs,
+                             Value *result)
 {
-    MDefinition *left = ins->getOperand(0);
-    MDefinition *right = ins->getOperand(1);
-
-    if (!left->isConstant() || !right->isConstant())
-        return NULL;
-
-    Value lhs = left->toConstant()->value();
-    Value rhs = right->toConstant()->value();
     Value ret = UndefinedValue();
 
+    switch (ins->op()) {
+      case MDefinition::Op_BitAnd:
+      case MDefinition::Op_BitOr:
+      case MDefinition::Op_BitXor:
+      case MDefinition::Op_Lsh:
+      case MDefinition::Op_Rsh:
+      case MDefinition::Op_Ursh:
+        if (!lhs.isInt32() || !rhs.isInt32())
+            return false;
+        break;
+      default:
+        if (!lhs.isNumber() || !rhs.isNumber())
+            return false;
+        break;
+    }
+
     switch (ins->op()) {
       case MDefinition::Op_BitAnd:
         ret = Int32Value(lhs.toInt32() & rhs.toInt32());
@@ -94,6 +103,26 @@ EvaluateConstantOperands(MBinaryInstruction *ins)
         break;
       default:
         JS_NOT_REACHED("NYI");
+        return false;
+    }
+
+    *result = ret;
+    return true;
+}
+
+static MConstant *
+EvaluateConstantOperands(MBinaryInstruction *ins)
+{
+    MDefinition *left = ins->getOperand(0);
+    MDefinition *right = ins->getOperand(1);
+
+    if (!left->isConstant() || !right->isConstant())
+        return NULL;
+
+    Value ret;
+    if (!EvaluateBinaryOperation(ins, left->toConstant()->value(), right->toConstant()->value(),
+                                 &ret))
+    {
         return NULL;
     }
 
@@ -171,23 +200,6 @@ MDefinition::analyzeTruncateBackward()
     return;
 }
 
-MDefinition *
-MTest::foldsToConstant(){
-    MDefinition *op = getOperand(0);
-    if(op->isConstant()){
-        Value v = op->toConstant()->value();
-        if(v.isNullOrUndefined() || v.isObjectOrNull()){
-            bool cond = true;
-            if(v.isNullOrUndefined())
-                cond = false;
-            MConstant *condition = MConstant::New(BooleanValue(cond));
-            this->block()->insertBefore(this,condition);
-            this->replaceOperand(0, condition);
-        }
-    }
-    return foldsTo(0);
-}
-
 MDefinition *
 MTest::foldsTo(bool useValueNumbers)
 {
@@ -199,20 +211,6 @@ MTest::foldsTo(bool useValueNumbers)
     return this;
 }
 
-MDefinition *
-MDefinition::foldsToConstant()
-{
-    // In the default case, this function returns a simple definition fold.
-    return foldsTo(0);
-}
-
-void 
-MDefinition::replaceWithInstruction(MInstruction *instruction)
-{
-    // There is not default case for this function.
-    return;
-}
-
 void
 MDefinition::printOpcode(FILE *fp)
 {
@@ -287,22 +285,6 @@ IsPowerOfTwo(uint32 n)
     return (n > 0) && ((n & (n - 1)) == 0);
 }
 
-void
-MInstruction::replaceWithInstruction(MInstruction *instruction)
-{
-    MBasicBlock *block = block_;
-
-    // If the new instruction does not have a block, it should be inserted in the graph.
-    if (!(instruction->block()))
-        block->insertBefore(this, instruction);
-
-    replaceAllUsesWith(instruction);
-
-    // Eliminates the dead instruction.
-    if (!hasUses() && !isGuard() && !isControlInstruction())
-        block->discard(this);
-}
-
 MConstant *
 MConstant::New(const Value &v)
 {
@@ -418,19 +400,22 @@ MCall::New(JSFunction *target, size_t maxArgc, size_t numActualArgs, bool constr
     return ins;
 }
 
-MApplyArgs *
-MApplyArgs::New(JSFunction *target, MDefinition *fun, MDefinition *argc, MDefinition *self)
+MObjectState *
+MObjectState::New(JSObject *templateObject, uint32 objectId, MDefinition **fields,
+                  size_t numFields)
 {
-    return new MApplyArgs(target, fun, argc, self);
+    MObjectState *state = new MObjectState(templateObject, objectId);
+    if (!state->init(numFields))
+        return NULL;
+    for (size_t i = 0; i < numFields; i++)
+        state->initOperand(i, fields[i]);
+    return state;
 }
 
-MDefinition *
-MUnbox::foldsToConstant()
+MApplyArgs *
+MApplyArgs::New(JSFunction *target, MDefinition *fun, MDefinition *argc, MDefinition *self)
 {
-    if((input()->isConstant()) && (input()->type() == type()))
-        return input();
-    else
-        return this;
+    return new MApplyArgs(target, fun, argc, self);
 }
 
 MDefinition*
@@ -498,12 +483,22 @@ MPhi::New(uint32 slot)
     return new MPhi(slot);
 }
 
+MPhi *
+MPhi::NewCopy(MPhi *model)
+{
+    MPhi *phi = new MPhi(model->slot());
+    if (model->triedToSpecialize())
+        phi->specialize(model->type());
+    phi->hasBytecodeUses_ = model->hasBytecodeUses_;
+    phi->isIterator_ = model->isIterator_;
+    return phi;
+}
+
 void
 MPhi::removeOperand(size_t index) {
     MDefinition *opr = *(inputs_.begin()+index);
     for (MUseIterator itUse = opr->usesBegin(); itUse != opr->usesEnd(); itUse++) {
-        if (static_cast<MDefinition *>(itUse->node())->id() == this->id() && 
-            itUse->index() == index) {
+        if (itUse->node() == this && itUse->index() == index) {
             opr->removeUse(itUse);
              break;
          }
@@ -512,7 +507,7 @@ MPhi::removeOperand(size_t index) {
     for (size_t i = index; i < inputs_.length(); i++) {
         MDefinition *opri = *(inputs_.begin()+i);
         for (MUseIterator itUse = opri->usesBegin(); itUse != opri->usesEnd(); itUse++) {
-            if (static_cast<MDefinition *>(itUse->node())->id() == this->id()) {
+            if (itUse->node() == this) {
                 if (itUse->index() == i + 1) {
                     MNode *node = itUse->node();
                     opri->removeUse(itUse);
@@ -541,57 +536,6 @@ MPhi::foldsTo(bool useValueNumbers)
     return first;
 }
 
-MDefinition *
-MPhi::foldsToConstant()
-{
-    JS_ASSERT(numOperands() != 0);
-    
-    MDefinition *first = getOperand(0);
-    
-    if(!first->isConstant())
-        return this;
-    
-    Value firstValue = first->toConstant()->value();
-   
-    // If all operands have the same value of the first one, the phi can be
-    // folded to a constant.
-    for (size_t i = 1; i < numOperands(); i++) {
-        MDefinition *operand = getOperand(i);
-        
-        if(!operand->isConstant())
-            return this;
-        
-        Value value = operand->toConstant()->value();        
-        
-        if (value != firstValue)
-            return this;
-    }
-    
-    MConstant *constant = MConstant::New(firstValue);
-    
-    return constant; 
-}
-
-void 
-MPhi::replaceWithInstruction(MInstruction *instruction)
-{
-    MBasicBlock *block = block_;
-    
-    // We cannot place instructions between phis.
-    MInstruction *insertPoint = *block->begin();
-    
-    // If the new instruction does not have a block, it should be insertedi in
-    // the graph.
-    if(!(instruction->block()))
-        block->insertBefore(insertPoint, instruction);
-    
-    replaceAllUsesWith(instruction);
-                                                                                                                                                                                          
-    // Eliminates the dead phi.
-    if(!hasUses()) 
-        block->discardPhi(this);
-}
-
 bool
 MPhi::congruentTo(MDefinition *const &ins) const
 {
@@ -800,28 +744,6 @@ NeedNegativeZeroCheck(MDefinition *def)
     return false;
 }
 
-MDefinition *
-MBinaryArithInstruction::foldsToConstant()
-{
-    MDefinition *lhs = getOperand(0);
-    if(!lhs->isConstant() || !lhs->toConstant()->value().isNumber())
-        return this;
-    MDefinition *rhs = getOperand(1);
-    if(!rhs->isConstant() || !rhs->toConstant()->value().isNumber())
-        return this;
-    return foldsTo(0);
-}
-
-MDefinition *
-MBinaryBitwiseInstruction::foldsToConstant()
-{
-    MDefinition *lhs = getOperand(0);
-    MDefinition *rhs = getOperand(1);
-    if(!lhs->isToInt32() || !rhs->isToInt32())
-        return this;
-    return foldsTo(0);
-}
-
 MDefinition *
 MBinaryArithInstruction::foldsTo(bool useValueNumbers)
 {
@@ -1227,37 +1149,6 @@ MBitNot::foldsTo(bool useValueNumbers)
     return this;
 }
 
-MDefinition *
-MTypeOf::foldsToConstant()
-{
-    if(!input()->isConstant())
-        return this;
-
-    Value val = input()->toConstant()->value();
-
-    if(val.isBoolean())
-        return MConstant::New(StringValue(JS_NewStringCopyZ(GetIonContext()->cx, "boolean")));
-
-    if(val.isNumber())
-        return MConstant::New(StringValue(JS_NewStringCopyZ(GetIonContext()->cx, "number")));
-
-    if(val.isString())
-        return MConstant::New(StringValue(JS_NewStringCopyZ(GetIonContext()->cx, "string")));
-
-    if(val.isObject()){
-        JSObject *obj = val.toObjectOrNull();
-        if(obj->isFunction())
-            return MConstant::New(StringValue(JS_NewStringCopyZ(GetIonContext()->cx, "function")));
-        return MConstant::New(StringValue(JS_NewStringCopyZ(GetIonContext()->cx, "object")));
-    }
-
-    if(val.isUndefined())
-        return MConstant::New(StringValue(JS_NewStringCopyZ(GetIonContext()->cx, "undefined")));
-
-    JS_NOT_REACHED("Unexpected type");
-    return this;
-}
-
 MDefinition *
 MTypeOf::foldsTo(bool useValueNumbers)
 {
@@ -1348,6 +1239,27 @@ MResumePoint::MResumePoint(MBasicBlock *block, jsbytecode *pc, MResumePoint *cal
 {
 }
 
+MResumePoint::MResumePoint(MBasicBlock *block, MResumePoint *model)
+  : MNode(block),
+    stackDepth_(model->stackDepth_),
+    pc_(model->pc_),
+    caller_(model->caller_),
+    mode_(model->mode_)
+{
+}
+
+MResumePoint *
+MResumePoint::Copy(MBasicBlock *block, MResumePoint *model)
+{
+    MResumePoint *resume = new MResumePoint(block, model);
+    resume->operands_ = model->block()->graph().allocate<MDefinition *>(resume->stackDepth());
+    if (!resume->operands_)
+        return NULL;
+    for (size_t i = 0; i < resume->stackDepth(); i++)
+        resume->initOperand(i, model->getOperand(i));
+    return resume;
+}
+
 bool
 MResumePoint::init(MBasicBlock *block)
 {
@@ -1415,6 +1327,66 @@ MToDouble::foldsTo(bool useValueNumbers)
     return this;
 }
 
+// Gives the value written by the store a load depends on, if the store writes
+// the location the load reads and dominates it. Alias analysis made the store
+// the last one which may write this location, so no other store intervenes.
+static MDefinition *
+ForwardStoredValue(MDefinition *load, MDefinition *store, MDefinition *value)
+{
+    if (!store->block()->dominates(load->block()))
+        return load;
+    if (value->type() == load->type())
+        return value;
+
+    // Loads of slots whose type is known have that type, other loads give a
+    // boxed value.
+    if (load->type() != MIRType_Value || value->type() > MIRType_Object)
+        return load;
+    return MBox::New(value);
+}
+
+MDefinition *
+MLoadFixedSlot::foldsTo(bool useValueNumbers)
+{
+    if (!js_IonOptions.aliasRefinement || !dependency() || !dependency()->isStoreFixedSlot())
+        return this;
+
+    MStoreFixedSlot *store = dependency()->toStoreFixedSlot();
+    if (store->slot() != slot() || !EqualValues(useValueNumbers, store->object(), object()))
+        return this;
+
+    return ForwardStoredValue(this, store, store->value());
+}
+
+MDefinition *
+MLoadSlot::foldsTo(bool useValueNumbers)
+{
+    if (!js_IonOptions.aliasRefinement || !dependency() || !dependency()->isStoreSlot())
+        return this;
+
+    MStoreSlot *store = dependency()->toStoreSlot();
+    if (store->slot() != slot() || !EqualValues(useValueNumbers, store->slots(), slots()))
+        return this;
+
+    return ForwardStoredValue(this, store, store->value());
+}
+
+MDefinition *
+MLoadElement::foldsTo(bool useValueNumbers)
+{
+    if (!js_IonOptions.aliasRefinement || !dependency() || !dependency()->isStoreElement())
+        return this;
+
+    MStoreElement *store = dependency()->toStoreElement();
+    if (!EqualValues(useValueNumbers, store->elements(), elements()) ||
+        !EqualValues(useValueNumbers, store->index(), index()))
+    {
+        return this;
+    }
+
+    return ForwardStoredValue(this, store, store->value());
+}
+
 MDefinition *
 MToString::foldsTo(bool useValueNumbers)
 {
@@ -1515,8 +1487,50 @@ MCompare::evaluateConstantOperands(bool *result)
     if (!left->isConstant() || !right->isConstant())
         return false;
 
-    Value lhs = left->toConstant()->value();
-    Value rhs = right->toConstant()->value();
+    return evaluateConstantOperands(left->toConstant()->value(), right->toConstant()->value(),
+                                    result);
+}
+
+static bool
+EvaluateNumberComparison(JSOp op, double lhs, double rhs, bool *result)
+{
+    switch (op) {
+      case JSOP_LT:
+        *result = lhs < rhs;
+        return true;
+      case JSOP_LE:
+        *result = lhs <= rhs;
+        return true;
+      case JSOP_GT:
+        *result = lhs > rhs;
+        return true;
+      case JSOP_GE:
+        *result = lhs >= rhs;
+        return true;
+      case JSOP_EQ:
+      case JSOP_STRICTEQ:
+        *result = lhs == rhs;
+        return true;
+      case JSOP_NE:
+      case JSOP_STRICTNE:
+        *result = lhs != rhs;
+        return true;
+      default:
+        return false;
+    }
+}
+
+bool
+MCompare::evaluateConstantOperands(const Value &lhs, const Value &rhs, bool *result)
+{
+    if (type() != MIRType_Boolean)
+        return false;
+
+    // Compilations off the main thread have no context to convert the
+    // operands with, and only fold comparisons of numbers.
+    if (!GetIonContext()->cx)
+        return lhs.isNumber() && rhs.isNumber() &&
+               EvaluateNumberComparison(jsop_, lhs.toNumber(), rhs.toNumber(), result);
 
     switch (jsop_) {
       case JSOP_LT:
@@ -1588,6 +1602,41 @@ MNot::foldsTo(bool useValueNumbers)
     return this;
 }
 
+bool
+MLoadTypedArrayElement::recomputeRange()
+{
+    if (type() != MIRType_Int32)
+        return false;
+
+    // Elements narrower than 32 bits always fit in an int32. Uint32 elements
+    // which do not fit make the load bail out.
+    Range r;
+    switch (arrayType_) {
+      case TypedArray::TYPE_INT8:
+        r.set(-128, 127);
+        break;
+      case TypedArray::TYPE_UINT8:
+      case TypedArray::TYPE_UINT8_CLAMPED:
+        r.set(0, 255);
+        break;
+      case TypedArray::TYPE_INT16:
+        r.set(-32768, 32767);
+        break;
+      case TypedArray::TYPE_UINT16:
+        r.set(0, 65535);
+        break;
+      case TypedArray::TYPE_INT32:
+        r.set(JSVAL_INT_MIN, JSVAL_INT_MAX);
+        break;
+      case TypedArray::TYPE_UINT32:
+        r.set(0, JSVAL_INT_MAX);
+        break;
+      default:
+        return false;
+    }
+    return range()->update(&r);
+}
+
 void
 MBeta::printOpcode(FILE *fp)
 {
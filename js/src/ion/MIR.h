@@ -289,6 +289,23 @@ class MDefinition : public MNode
 #endif
     { }
 
+  protected:
+    // Copies another definition, but for its uses and its position in the
+    // graph. Used when cloning instructions.
+    MDefinition(const MDefinition &other)
+      : MNode(),
+        id_(0),
+        valueNumber_(NULL),
+        range_(other.range_),
+        resultType_(other.resultType_),
+        flags_(other.flags_),
+        dependency_(other.dependency_)
+#ifdef TRACK_SNAPSHOTS
+      , trackedPc_(other.trackedPc_)
+#endif
+    { }
+
+  public:
     virtual Opcode op() const = 0;
     void printName(FILE *fp);
     static void PrintOpcodeName(FILE *fp, Opcode op);
@@ -305,12 +322,6 @@ class MDefinition : public MNode
     bool congruentIfOperandsEqual(MDefinition * const &ins) const;
     virtual MDefinition *foldsTo(bool useValueNumbers);
 
-    //PS
-    // Different from the foldsTo funtion, this one does not take value numbers
-    // into account. In case of success, the new constant is returned.
-    // Otherwise, it returns the instruction itself.
-    virtual MDefinition *foldsToConstant();
-    virtual void replaceWithInstruction(MInstruction *instruction);
     virtual void analyzeEdgeCasesForward();
     virtual void analyzeEdgeCasesBackward();
     virtual void analyzeTruncateBackward();
@@ -519,8 +530,27 @@ class MInstruction
       : resumePoint_(NULL)
     { }
 
+  protected:
+    MInstruction(const MInstruction &other)
+      : MDefinition(other),
+        InlineListNode<MInstruction>(),
+        resumePoint_(NULL)
+    { }
+
+  public:
     virtual bool accept(MInstructionVisitor *visitor) = 0;
 
+    // Instructions which may be duplicated, e.g. by loop unrolling, are
+    // declared with ALLOW_CLONE. The clone takes the given operands, it has
+    // no resume point and is not in any block yet.
+    virtual bool canClone() const {
+        return false;
+    }
+    virtual MInstruction *clone(MDefinition * const *operands) const {
+        JS_NOT_REACHED("Instruction cannot be cloned");
+        return NULL;
+    }
+
     void setResumePoint(MResumePoint *resumePoint) {
         JS_ASSERT(!resumePoint_);
         resumePoint_ = resumePoint;
@@ -528,8 +558,6 @@ class MInstruction
     MResumePoint *resumePoint() const {
         return resumePoint_;
     }
-
-    void replaceWithInstruction(MInstruction *instruction);
 };
 
 #define INSTRUCTION_HEADER(opcode)                                          \
@@ -540,6 +568,17 @@ class MInstruction
         return visitor->visit##opcode(this);                                \
     }
 
+#define ALLOW_CLONE(typename)                                               \
+    bool canClone() const {                                                 \
+        return true;                                                        \
+    }                                                                       \
+    MInstruction *clone(MDefinition * const *operands) const {              \
+        typename *res = new typename(*this);                                \
+        for (size_t i = 0; i < numOperands(); i++)                          \
+            res->initOperand(i, operands[i]);                               \
+        return res;                                                         \
+    }
+
 template <size_t Arity>
 class MAryInstruction : public MInstruction
 {
@@ -617,6 +656,7 @@ class MConstant : public MNullaryInstruction
 
   public:
     INSTRUCTION_HEADER(Constant);
+    ALLOW_CLONE(MConstant)
     static MConstant *New(const Value &v);
 
     const js::Value &value() const {
@@ -899,9 +939,6 @@ class MTest
         return AliasSet::None();
     }
     MDefinition *foldsTo(bool useValueNumbers);
-
-    //PS
-    MDefinition *foldsToConstant();
 };
 
 // Returns from this function to the previous caller.
@@ -1102,6 +1139,45 @@ class MVariadicInstruction : public MInstruction
     }
 };
 
+// Contents of an object or array allocation which escape analysis replaced,
+// as seen by the resume points which refer to it. The operands are the values
+// of the fixed slots of an object, or the initialized elements of an array.
+// No code is generated for it: snapshots record the operands, and bailouts
+// allocate the object from its template.
+class MObjectState : public MVariadicInstruction
+{
+    // Rooted by the allocation this state replaces. Escape analysis may run
+    // off the main thread, where the root list of the runtime is not used.
+    JSObject *templateObject_;
+
+    // Shared by all the states of the same allocation, so that snapshots
+    // referring to it more than once materialize a single object.
+    uint32 objectId_;
+
+    MObjectState(JSObject *templateObject, uint32 objectId)
+      : templateObject_(templateObject),
+        objectId_(objectId)
+    {
+        setResultType(MIRType_Object);
+    }
+
+  public:
+    INSTRUCTION_HEADER(ObjectState);
+
+    static MObjectState *New(JSObject *templateObject, uint32 objectId,
+                             MDefinition **fields, size_t numFields);
+
+    JSObject *templateObject() const {
+        return templateObject_;
+    }
+    uint32 objectId() const {
+        return objectId_;
+    }
+    AliasSet getAliasSet() const {
+        return AliasSet::None();
+    }
+};
+
 class MCall
   : public MVariadicInstruction,
     public CallPolicy
@@ -1303,6 +1379,14 @@ class MBinaryInstruction : public MAryInstruction<2>
     }
 };
 
+// Compute the number the arithmetic or bitwise instruction |ins| produces
+// from the operands |lhs| and |rhs|, regardless of the type it has been
+// specialized to. Returns false if the operands are not numbers, or not int32
+// values for bitwise operations.
+bool
+EvaluateBinaryOperation(MBinaryInstruction *ins, const Value &lhs, const Value &rhs,
+                        Value *result);
+
 class MTernaryInstruction : public MAryInstruction<3>
 {
   protected:
@@ -1363,10 +1447,12 @@ class MCompare
 
   public:
     INSTRUCTION_HEADER(Compare);
+    ALLOW_CLONE(MCompare)
     static MCompare *New(MDefinition *left, MDefinition *right, JSOp op);
 
     bool tryFold(bool *result);
     bool evaluateConstantOperands(bool *result);
+    bool evaluateConstantOperands(const Value &lhs, const Value &rhs, bool *result);
     MDefinition *foldsTo(bool useValueNumbers);
 
     void infer(JSContext *cx, const TypeOracle::BinaryTypes &b);
@@ -1410,6 +1496,7 @@ class MBox : public MUnaryInstruction
 
   public:
     INSTRUCTION_HEADER(Box);
+    ALLOW_CLONE(MBox)
     static MBox *New(MDefinition *ins)
     {
         // Cannot box a box.
@@ -1463,14 +1550,12 @@ class MUnbox : public MUnaryInstruction
 
   public:
     INSTRUCTION_HEADER(Unbox);
+    ALLOW_CLONE(MUnbox)
     static MUnbox *New(MDefinition *ins, MIRType type, Mode mode)
     {
         return new MUnbox(ins, type, mode);
     }
 
-    //PS
-    MDefinition *foldsToConstant();
-
     Mode mode() const {
         return mode_;
     }
@@ -1671,6 +1756,7 @@ class MToDouble
 
   public:
     INSTRUCTION_HEADER(ToDouble);
+    ALLOW_CLONE(MToDouble)
     static MToDouble *New(MDefinition *def)
     {
         return new MToDouble(def);
@@ -1706,6 +1792,7 @@ class MToInt32 : public MUnaryInstruction
 
   public:
     INSTRUCTION_HEADER(ToInt32);
+    ALLOW_CLONE(MToInt32)
     static MToInt32 *New(MDefinition *def)
     {
         return new MToInt32(def);
@@ -1747,6 +1834,7 @@ class MTruncateToInt32 : public MUnaryInstruction
 
   public:
     INSTRUCTION_HEADER(TruncateToInt32);
+    ALLOW_CLONE(MTruncateToInt32)
     static MTruncateToInt32 *New(MDefinition *def)
     {
         return new MTruncateToInt32(def);
@@ -1813,6 +1901,7 @@ class MBitNot
 
   public:
     INSTRUCTION_HEADER(BitNot);
+    ALLOW_CLONE(MBitNot)
     static MBitNot *New(MDefinition *input);
 
     TypePolicy *typePolicy() {
@@ -1862,9 +1951,6 @@ class MTypeOf
     }
     MDefinition *foldsTo(bool useValueNumbers);
 
-    //PS
-    MDefinition *foldsToConstant();
-
     AliasSet getAliasSet() const {
         if (inputType_ <= MIRType_String)
             return AliasSet::None();
@@ -1915,8 +2001,6 @@ class MBinaryBitwiseInstruction
     }
 
     MDefinition *foldsTo(bool useValueNumbers);
-    //PS
-    MDefinition *foldsToConstant();
     virtual MDefinition *foldIfZero(size_t operand) = 0;
     virtual MDefinition *foldIfEqual()  = 0;
     virtual void infer(const TypeOracle::Binary &b);
@@ -1939,6 +2023,7 @@ class MBitAnd : public MBinaryBitwiseInstruction
 
   public:
     INSTRUCTION_HEADER(BitAnd);
+    ALLOW_CLONE(MBitAnd)
     static MBitAnd *New(MDefinition *left, MDefinition *right);
 
     MDefinition *foldIfZero(size_t operand) {
@@ -1958,6 +2043,7 @@ class MBitOr : public MBinaryBitwiseInstruction
 
   public:
     INSTRUCTION_HEADER(BitOr);
+    ALLOW_CLONE(MBitOr)
     static MBitOr *New(MDefinition *left, MDefinition *right);
 
     MDefinition *foldIfZero(size_t operand) {
@@ -1981,6 +2067,7 @@ class MBitXor : public MBinaryBitwiseInstruction
 
   public:
     INSTRUCTION_HEADER(BitXor);
+    ALLOW_CLONE(MBitXor)
     static MBitXor *New(MDefinition *left, MDefinition *right);
 
     MDefinition *foldIfZero(size_t operand) {
@@ -2015,6 +2102,7 @@ class MLsh : public MShiftInstruction
 
   public:
     INSTRUCTION_HEADER(Lsh);
+    ALLOW_CLONE(MLsh)
     static MLsh *New(MDefinition *left, MDefinition *right);
 
     MDefinition *foldIfZero(size_t operand) {
@@ -2042,6 +2130,7 @@ class MRsh : public MShiftInstruction
 
   public:
     INSTRUCTION_HEADER(Rsh);
+    ALLOW_CLONE(MRsh)
     static MRsh *New(MDefinition *left, MDefinition *right);
 
     MDefinition *foldIfZero(size_t operand) {
@@ -2071,6 +2160,7 @@ class MUrsh : public MShiftInstruction
 
   public:
     INSTRUCTION_HEADER(Ursh);
+    ALLOW_CLONE(MUrsh)
     static MUrsh *New(MDefinition *left, MDefinition *right);
 
     MDefinition *foldIfZero(size_t operand) {
@@ -2102,6 +2192,9 @@ class MUrsh : public MShiftInstruction
 
         return canOverflow_;
     }
+    void setCanOverflow(bool val) {
+        canOverflow_ = val;
+    }
 
     bool fallible() {
         return canOverflow();
@@ -2127,8 +2220,6 @@ class MBinaryArithInstruction
     }
 
     MDefinition *foldsTo(bool useValueNumbers);
-    //PS
-    MDefinition *foldsToConstant();
 
     virtual double getIdentity() = 0;
 
@@ -2158,6 +2249,7 @@ class MAbs
 
   public:
     INSTRUCTION_HEADER(Abs);
+    ALLOW_CLONE(MAbs)
     static MAbs *New(MDefinition *num, MIRType type) {
         return new MAbs(num, type);
     }
@@ -2200,6 +2292,7 @@ class MSqrt
 
   public:
     INSTRUCTION_HEADER(Sqrt);
+    ALLOW_CLONE(MSqrt)
     static MSqrt *New(MDefinition *num) {
         return new MSqrt(num);
     }
@@ -2342,17 +2435,23 @@ class MAdd : public MBinaryArithInstruction
 {
     bool implicitTruncate_;
 
-    MAdd(MDefinition *left, MDefinition *right)
+    MAdd(MDefinition *left, MDefinition *right, MIRType type)
       : MBinaryArithInstruction(left, right),
         implicitTruncate_(false)
     {
-        setResultType(MIRType_Value);
+        if (type != MIRType_Value)
+            specialization_ = type;
+        setResultType(type);
     }
 
   public:
     INSTRUCTION_HEADER(Add);
+    ALLOW_CLONE(MAdd)
     static MAdd *New(MDefinition *left, MDefinition *right) {
-        return new MAdd(left, right);
+        return new MAdd(left, right, MIRType_Value);
+    }
+    static MAdd *New(MDefinition *left, MDefinition *right, MIRType type) {
+        return new MAdd(left, right, type);
     }
     void analyzeTruncateBackward();
 
@@ -2383,17 +2482,23 @@ class MAdd : public MBinaryArithInstruction
 class MSub : public MBinaryArithInstruction
 {
     bool implicitTruncate_;
-    MSub(MDefinition *left, MDefinition *right)
+    MSub(MDefinition *left, MDefinition *right, MIRType type)
       : MBinaryArithInstruction(left, right),
         implicitTruncate_(false)
     {
-        setResultType(MIRType_Value);
+        if (type != MIRType_Value)
+            specialization_ = type;
+        setResultType(type);
     }
 
   public:
     INSTRUCTION_HEADER(Sub);
+    ALLOW_CLONE(MSub)
     static MSub *New(MDefinition *left, MDefinition *right) {
-        return new MSub(left, right);
+        return new MSub(left, right, MIRType_Value);
+    }
+    static MSub *New(MDefinition *left, MDefinition *right, MIRType type) {
+        return new MSub(left, right, type);
     }
 
     void analyzeTruncateBackward();
@@ -2437,6 +2542,7 @@ class MMul : public MBinaryArithInstruction
 
   public:
     INSTRUCTION_HEADER(Mul);
+    ALLOW_CLONE(MMul)
     static MMul *New(MDefinition *left, MDefinition *right) {
         return new MMul(left, right, MIRType_Value);
     }
@@ -2457,14 +2563,22 @@ class MMul : public MBinaryArithInstruction
     }
 
     bool canBeNegativeZero() {
-        if (range()->lower() >= 0 && range()->upper() >= 0)
+        // -0 is only produced by multiplying 0 by a negative number.
+        Range *left = lhs()->range();
+        Range *right = rhs()->range();
+        if (left->lower() >= 0 && right->lower() >= 0)
+            return false;
+        if (range()->lower() > 0 || range()->upper() < 0)
             return false;
         return canBeNegativeZero_;
     }
+    void setCanBeNegativeZero(bool val) {
+        canBeNegativeZero_ = val;
+    }
     bool updateForReplacement(MDefinition *ins);
 
     bool fallible() {
-        return canBeNegativeZero_ || canOverflow();
+        return canBeNegativeZero() || canOverflow();
     }
 
     bool recomputeRange() {
@@ -2498,6 +2612,7 @@ class MDiv : public MBinaryArithInstruction
 
   public:
     INSTRUCTION_HEADER(Div);
+    ALLOW_CLONE(MDiv)
     static MDiv *New(MDefinition *left, MDefinition *right) {
         return new MDiv(left, right, MIRType_Value);
     }
@@ -2547,6 +2662,7 @@ class MMod : public MBinaryArithInstruction
 
   public:
     INSTRUCTION_HEADER(Mod);
+    ALLOW_CLONE(MMod)
     static MMod *New(MDefinition *left, MDefinition *right) {
         return new MMod(left, right);
     }
@@ -2612,6 +2728,7 @@ class MCharCodeAt
 
   public:
     INSTRUCTION_HEADER(CharCodeAt);
+    ALLOW_CLONE(MCharCodeAt)
 
     static MCharCodeAt *New(MDefinition *str, MDefinition *index) {
         return new MCharCodeAt(str, index);
@@ -2678,6 +2795,10 @@ class MPhi : public MDefinition, public InlineForwardListNode<MPhi>
     INSTRUCTION_HEADER(Phi);
     static MPhi *New(uint32 slot);
 
+    // Creates a phi for the same slot, with the same type and flags as
+    // |model|, but no inputs.
+    static MPhi *NewCopy(MPhi *model);
+
     MDefinition *getOperand(size_t index) const {
         return inputs_[index];
     }
@@ -2700,15 +2821,6 @@ class MPhi : public MDefinition, public InlineForwardListNode<MPhi>
 
     MDefinition *foldsTo(bool useValueNumbers);
 
-    //PS
-    // Different from the foldsTo function, this function folds a phi to a
-    // constant taking into account only the values of its operands.
-    MDefinition *foldsToConstant();
-
-    // Since other instructions cannot be placed between phis, the new
-    // instruction is inserted right after the last phi of the block.
-    void replaceWithInstruction(MInstruction *instruction);
-
     bool congruentTo(MDefinition * const &ins) const;
 
     bool hasBytecodeUses() const {
@@ -3031,6 +3143,7 @@ class MSlots
 
   public:
     INSTRUCTION_HEADER(Slots);
+    ALLOW_CLONE(MSlots)
 
     static MSlots *New(MDefinition *object) {
         return new MSlots(object);
@@ -3064,6 +3177,7 @@ class MElements
 
   public:
     INSTRUCTION_HEADER(Elements);
+    ALLOW_CLONE(MElements)
 
     static MElements *New(MDefinition *object) {
         return new MElements(object);
@@ -3130,10 +3244,12 @@ class MInitializedLength
     {
         setResultType(MIRType_Int32);
         setMovable();
+        range()->set(0, JSVAL_INT_MAX);
     }
 
   public:
     INSTRUCTION_HEADER(InitializedLength);
+    ALLOW_CLONE(MInitializedLength)
 
     static MInitializedLength *New(MDefinition *elements) {
         return new MInitializedLength(elements);
@@ -3188,9 +3304,11 @@ class MArrayLength
     {
         setResultType(MIRType_Int32);
         setMovable();
+        range()->set(0, JSVAL_INT_MAX);
     }
 
     INSTRUCTION_HEADER(ArrayLength);
+    ALLOW_CLONE(MArrayLength)
 
     MDefinition *elements() const {
         return getOperand(0);
@@ -3213,10 +3331,12 @@ class MTypedArrayLength
     {
         setResultType(MIRType_Int32);
         setMovable();
+        range()->set(0, JSVAL_INT_MAX);
     }
 
   public:
     INSTRUCTION_HEADER(TypedArrayLength);
+    ALLOW_CLONE(MTypedArrayLength)
 
     static MTypedArrayLength *New(MDefinition *obj) {
         return new MTypedArrayLength(obj);
@@ -3252,6 +3372,7 @@ class MTypedArrayElements
 
   public:
     INSTRUCTION_HEADER(TypedArrayElements);
+    ALLOW_CLONE(MTypedArrayElements)
 
     static MTypedArrayElements *New(MDefinition *object) {
         return new MTypedArrayElements(object);
@@ -3285,6 +3406,7 @@ class MNot
     }
 
     INSTRUCTION_HEADER(Not);
+    ALLOW_CLONE(MNot)
 
     MDefinition *foldsTo(bool useValueNumbers);
 
@@ -3324,6 +3446,7 @@ class MBoundsCheck
 
   public:
     INSTRUCTION_HEADER(BoundsCheck);
+    ALLOW_CLONE(MBoundsCheck)
 
     static MBoundsCheck *New(MDefinition *index, MDefinition *length) {
         return new MBoundsCheck(index, length);
@@ -3375,6 +3498,7 @@ class MBoundsCheckLower
 
   public:
     INSTRUCTION_HEADER(BoundsCheckLower);
+    ALLOW_CLONE(MBoundsCheckLower)
 
     static MBoundsCheckLower *New(MDefinition *index) {
         return new MBoundsCheckLower(index);
@@ -3417,6 +3541,7 @@ class MLoadElement
 
   public:
     INSTRUCTION_HEADER(LoadElement);
+    ALLOW_CLONE(MLoadElement)
 
     static MLoadElement *New(MDefinition *elements, MDefinition *index, bool needsHoleCheck) {
         return new MLoadElement(elements, index, needsHoleCheck);
@@ -3437,6 +3562,14 @@ class MLoadElement
     bool fallible() const {
         return needsHoleCheck();
     }
+    bool congruentTo(MDefinition * const &ins) const {
+        if (!ins->isLoadElement())
+            return false;
+        if (needsHoleCheck() != ins->toLoadElement()->needsHoleCheck())
+            return false;
+        return congruentIfOperandsEqual(ins);
+    }
+    MDefinition *foldsTo(bool useValueNumbers);
     AliasSet getAliasSet() const {
         return AliasSet::Load(AliasSet::Element);
     }
@@ -3533,6 +3666,7 @@ class MStoreElement
 
   public:
     INSTRUCTION_HEADER(StoreElement);
+    ALLOW_CLONE(MStoreElement)
 
     static MStoreElement *New(MDefinition *elements, MDefinition *index, MDefinition *value) {
         return new MStoreElement(elements, index, value);
@@ -3701,6 +3835,7 @@ class MLoadTypedArrayElement
 
   public:
     INSTRUCTION_HEADER(LoadTypedArrayElement);
+    ALLOW_CLONE(MLoadTypedArrayElement)
 
     static MLoadTypedArrayElement *New(MDefinition *elements, MDefinition *index, int arrayType) {
         return new MLoadTypedArrayElement(elements, index, arrayType);
@@ -3722,6 +3857,9 @@ class MLoadTypedArrayElement
     AliasSet getAliasSet() const {
         return AliasSet::Load(AliasSet::TypedArrayElement);
     }
+
+    // The result type is only known once the load has been specialized.
+    bool recomputeRange();
 };
 
 // Load a value from a typed array. Out-of-bounds accesses are handled using
@@ -3793,6 +3931,7 @@ class MStoreTypedArrayElement
 
   public:
     INSTRUCTION_HEADER(StoreTypedArrayElement);
+    ALLOW_CLONE(MStoreTypedArrayElement)
 
     static MStoreTypedArrayElement *New(MDefinition *elements, MDefinition *index, MDefinition *value,
                                         int arrayType) {
@@ -3828,6 +3967,112 @@ class MStoreTypedArrayElement
     }
 };
 
+// Runs the first iterations of a loop storing into a typed array, from index
+// |start| up to |bound|, several elements at a time. Each operand is either
+// another typed array of the same type, read at the same index, or a scalar.
+//
+// Returns the index at which the scalar loop continues: the iterations left
+// do not fill a vector, or reach the end of one of the arrays. When the store
+// would overwrite elements which a source reads in the same vector, no
+// iteration is run.
+class MTypedArrayVectorLoop
+  : public MAryInstruction<8>
+{
+  public:
+    enum Operation {
+        Copy,
+        Fill,
+        Add,
+        Sub,
+        Mul
+    };
+
+  private:
+    Operation operation_;
+    int arrayType_;
+    bool lhsIsArray_;
+    bool rhsIsArray_;
+
+    MTypedArrayVectorLoop(Operation operation, int arrayType,
+                          MDefinition *start, MDefinition *bound,
+                          MDefinition *elements, MDefinition *length,
+                          MDefinition *lhs, MDefinition *lhsLength, bool lhsIsArray,
+                          MDefinition *rhs, MDefinition *rhsLength, bool rhsIsArray)
+      : operation_(operation),
+        arrayType_(arrayType),
+        lhsIsArray_(lhsIsArray),
+        rhsIsArray_(rhsIsArray)
+    {
+        initOperand(0, start);
+        initOperand(1, bound);
+        initOperand(2, elements);
+        initOperand(3, length);
+        initOperand(4, lhs);
+        initOperand(5, lhsLength);
+        initOperand(6, rhs);
+        initOperand(7, rhsLength);
+        setResultType(MIRType_Int32);
+        JS_ASSERT(arrayType == TypedArray::TYPE_INT32 ||
+                  arrayType == TypedArray::TYPE_FLOAT32 ||
+                  arrayType == TypedArray::TYPE_FLOAT64);
+    }
+
+  public:
+    INSTRUCTION_HEADER(TypedArrayVectorLoop);
+
+    // Copy and Fill only read |lhs|: |rhs| is then |lhs| again. The length of
+    // a scalar operand is the length of the destination.
+    static MTypedArrayVectorLoop *New(Operation operation, int arrayType,
+                                      MDefinition *start, MDefinition *bound,
+                                      MDefinition *elements, MDefinition *length,
+                                      MDefinition *lhs, MDefinition *lhsLength, bool lhsIsArray,
+                                      MDefinition *rhs, MDefinition *rhsLength, bool rhsIsArray)
+    {
+        return new MTypedArrayVectorLoop(operation, arrayType, start, bound, elements, length,
+                                         lhs, lhsLength, lhsIsArray, rhs, rhsLength, rhsIsArray);
+    }
+
+    Operation operation() const {
+        return operation_;
+    }
+    int arrayType() const {
+        return arrayType_;
+    }
+    bool lhsIsArray() const {
+        return lhsIsArray_;
+    }
+    bool rhsIsArray() const {
+        return rhsIsArray_;
+    }
+    MDefinition *start() const {
+        return getOperand(0);
+    }
+    MDefinition *bound() const {
+        return getOperand(1);
+    }
+    MDefinition *elements() const {
+        return getOperand(2);
+    }
+    MDefinition *length() const {
+        return getOperand(3);
+    }
+    MDefinition *lhs() const {
+        return getOperand(4);
+    }
+    MDefinition *lhsLength() const {
+        return getOperand(5);
+    }
+    MDefinition *rhs() const {
+        return getOperand(6);
+    }
+    MDefinition *rhsLength() const {
+        return getOperand(7);
+    }
+    AliasSet getAliasSet() const {
+        return AliasSet::Store(AliasSet::TypedArrayElement);
+    }
+};
+
 // Clamp input to range [0, 255] for Uint8ClampedArray.
 class MClampToUint8
   : public MUnaryInstruction,
@@ -3843,6 +4088,7 @@ class MClampToUint8
 
   public:
     INSTRUCTION_HEADER(ClampToUint8);
+    ALLOW_CLONE(MClampToUint8)
 
     static MClampToUint8 *New(MDefinition *input) {
         return new MClampToUint8(input);
@@ -3880,6 +4126,7 @@ class MLoadFixedSlot
 
   public:
     INSTRUCTION_HEADER(LoadFixedSlot);
+    ALLOW_CLONE(MLoadFixedSlot)
 
     static MLoadFixedSlot *New(MDefinition *obj, size_t slot) {
         return new MLoadFixedSlot(obj, slot);
@@ -3902,6 +4149,7 @@ class MLoadFixedSlot
             return false;
         return congruentIfOperandsEqual(ins);
     }
+    MDefinition *foldsTo(bool useValueNumbers);
 
     AliasSet getAliasSet() const {
         return AliasSet::Load(AliasSet::Slot);
@@ -3923,6 +4171,7 @@ class MStoreFixedSlot
 
   public:
     INSTRUCTION_HEADER(StoreFixedSlot);
+    ALLOW_CLONE(MStoreFixedSlot)
 
     static MStoreFixedSlot *New(MDefinition *obj, size_t slot, MDefinition *rval) {
         return new MStoreFixedSlot(obj, rval, slot, false);
@@ -4290,6 +4539,45 @@ class MGetElementCache
     }
 };
 
+class MSetElementCache
+  : public MAryInstruction<3>,
+    public CallSetElementPolicy
+{
+    bool strict_;
+
+    MSetElementCache(MDefinition *obj, MDefinition *index, MDefinition *value, bool strict)
+      : strict_(strict)
+    {
+        initOperand(0, obj);
+        initOperand(1, index);
+        initOperand(2, value);
+    }
+
+  public:
+    INSTRUCTION_HEADER(SetElementCache);
+
+    static MSetElementCache *New(MDefinition *obj, MDefinition *index, MDefinition *value,
+                                 bool strict) {
+        return new MSetElementCache(obj, index, value, strict);
+    }
+
+    MDefinition *object() const {
+        return getOperand(0);
+    }
+    MDefinition *index() const {
+        return getOperand(1);
+    }
+    MDefinition *value() const {
+        return getOperand(2);
+    }
+    bool strict() const {
+        return strict_;
+    }
+    TypePolicy *typePolicy() {
+        return this;
+    }
+};
+
 class MBindNameCache
   : public MUnaryInstruction,
     public SingleObjectPolicy
@@ -4335,10 +4623,12 @@ class MGuardShape
     public SingleObjectPolicy
 {
     const Shape *shape_;
+    BailoutKind bailoutKind_;
 
-    MGuardShape(MDefinition *obj, const Shape *shape)
+    MGuardShape(MDefinition *obj, const Shape *shape, BailoutKind bailoutKind)
       : MUnaryInstruction(obj),
-        shape_(shape)
+        shape_(shape),
+        bailoutKind_(bailoutKind)
     {
         setGuard();
         setMovable();
@@ -4346,9 +4636,11 @@ class MGuardShape
 
   public:
     INSTRUCTION_HEADER(GuardShape);
+    ALLOW_CLONE(MGuardShape)
 
-    static MGuardShape *New(MDefinition *obj, const Shape *shape) {
-        return new MGuardShape(obj, shape);
+    static MGuardShape *New(MDefinition *obj, const Shape *shape,
+                            BailoutKind bailoutKind = Bailout_Invalidate) {
+        return new MGuardShape(obj, shape, bailoutKind);
     }
 
     TypePolicy *typePolicy() {
@@ -4360,6 +4652,9 @@ class MGuardShape
     const Shape *shape() const {
         return shape_;
     }
+    BailoutKind bailoutKind() const {
+        return bailoutKind_;
+    }
     bool congruentTo(MDefinition * const &ins) const {
         if (!ins->isGuardShape())
             return false;
@@ -4389,6 +4684,7 @@ class MGuardClass
 
   public:
     INSTRUCTION_HEADER(GuardClass);
+    ALLOW_CLONE(MGuardClass)
 
     static MGuardClass *New(MDefinition *obj, const Class *clasp) {
         return new MGuardClass(obj, clasp);
@@ -4415,6 +4711,42 @@ class MGuardClass
     }
 };
 
+// Guard that a value is the constant the code has been specialized to.
+class MGuardValue
+  : public MUnaryInstruction,
+    public BoxInputsPolicy
+{
+    Value value_;
+
+    MGuardValue(MDefinition *ins, const Value &value)
+      : MUnaryInstruction(ins),
+        value_(value)
+    {
+        setGuard();
+        setResultType(MIRType_None);
+    }
+
+  public:
+    INSTRUCTION_HEADER(GuardValue);
+
+    static MGuardValue *New(MDefinition *ins, const Value &value) {
+        return new MGuardValue(ins, value);
+    }
+
+    TypePolicy *typePolicy() {
+        return this;
+    }
+    MDefinition *input() const {
+        return getOperand(0);
+    }
+    const Value &value() const {
+        return value_;
+    }
+    AliasSet getAliasSet() const {
+        return AliasSet::None();
+    }
+};
+
 // Load from vp[slot] (slots that are not inline in an object).
 class MLoadSlot
   : public MUnaryInstruction,
@@ -4433,6 +4765,7 @@ class MLoadSlot
 
   public:
     INSTRUCTION_HEADER(LoadSlot);
+    ALLOW_CLONE(MLoadSlot)
 
     static MLoadSlot *New(MDefinition *slots, uint32 slot) {
         return new MLoadSlot(slots, slot);
@@ -4454,6 +4787,7 @@ class MLoadSlot
             return false;
         return congruentIfOperandsEqual(ins);
     }
+    MDefinition *foldsTo(bool useValueNumbers);
     AliasSet getAliasSet() const {
         if (slots()->type() == MIRType_Slots)
             return AliasSet::Load(AliasSet::Slot);
@@ -4506,6 +4840,7 @@ class MStoreSlot
 
   public:
     INSTRUCTION_HEADER(StoreSlot);
+    ALLOW_CLONE(MStoreSlot)
 
     static MStoreSlot *New(MDefinition *slots, uint32 slot, MDefinition *value) {
         return new MStoreSlot(slots, slot, value, false);
@@ -4802,9 +5137,11 @@ class MStringLength
     {
         setResultType(MIRType_Int32);
         setMovable();
+        range()->set(0, JSVAL_INT_MAX);
     }
   public:
     INSTRUCTION_HEADER(StringLength);
+    ALLOW_CLONE(MStringLength)
 
     static MStringLength *New(MDefinition *string) {
         return new MStringLength(string);
@@ -4843,6 +5180,7 @@ class MFloor
     }
 
     INSTRUCTION_HEADER(Floor);
+    ALLOW_CLONE(MFloor)
 
     MDefinition *num() const {
         return getOperand(0);
@@ -4869,6 +5207,7 @@ class MRound
     }
 
     INSTRUCTION_HEADER(Round);
+    ALLOW_CLONE(MRound)
 
     MDefinition *num() const {
         return getOperand(0);
@@ -5082,6 +5421,7 @@ class MTypeBarrier : public MUnaryInstruction
 
   public:
     INSTRUCTION_HEADER(TypeBarrier);
+    ALLOW_CLONE(MTypeBarrier)
 
     static MTypeBarrier *New(MDefinition *def, types::TypeSet *types) {
         return new MTypeBarrier(def, types);
@@ -5279,6 +5619,7 @@ class MResumePoint : public MNode
     Mode mode_;
 
     MResumePoint(MBasicBlock *block, jsbytecode *pc, MResumePoint *parent, Mode mode);
+    MResumePoint(MBasicBlock *block, MResumePoint *model);
     bool init(MBasicBlock *state);
     void inherit(MBasicBlock *state);
 
@@ -5292,6 +5633,9 @@ class MResumePoint : public MNode
   public:
     static MResumePoint *New(MBasicBlock *block, jsbytecode *pc, MResumePoint *parent, Mode mode);
 
+    // Creates a resume point for |block| with the same state as |model|.
+    static MResumePoint *Copy(MBasicBlock *block, MResumePoint *model);
+
     MNode::Kind kind() const {
         return MNode::ResumePoint;
     }
@@ -17,6 +17,7 @@
 #include "IonAllocPolicy.h"
 #include "IonCompartment.h"
 #include "CompileInfo.h"
+#include "IonSpewer.h"
 
 namespace js {
 namespace ion {
@@ -60,6 +61,18 @@ class MIRGenerator
         return error_;
     }
 
+    // Set by the main thread to stop a compilation running off the main
+    // thread, which checks it between its passes.
+    void cancel() {
+        cancelBuild_ = true;
+    }
+    bool shouldCancel(const char *why) {
+        if (!cancelBuild_)
+            return false;
+        IonSpew(IonSpew_OffThread, "Cancelled compilation after %s", why);
+        return true;
+    }
+
   public:
     JSCompartment *compartment;
 
@@ -70,6 +83,7 @@ class MIRGenerator
     uint32 nslots_;
     MIRGraph *graph_;
     bool error_;
+    volatile bool cancelBuild_;
 };
 
 } // namespace ion
@@ -22,7 +22,8 @@ MIRGenerator::MIRGenerator(JSCompartment *compartment,
     info_(info),
     temp_(temp),
     graph_(graph),
-    error_(false)
+    error_(false),
+    cancelBuild_(false)
 { }
 
 bool
@@ -116,6 +117,26 @@ MBasicBlock::NewSplitEdge(MIRGraph &graph, CompileInfo &info, MBasicBlock *pred)
     return MBasicBlock::New(graph, info, pred, pred->pc(), SPLIT_EDGE);
 }
 
+MBasicBlock *
+MBasicBlock::NewCopy(MIRGraph &graph, MBasicBlock *model)
+{
+    Kind kind = model->isLoopHeader() ? NORMAL : model->kind_;
+    MBasicBlock *block = new MBasicBlock(graph, model->info(), model->pc(), kind);
+    if (!block->init())
+        return NULL;
+
+    block->entryResumePoint_ = MResumePoint::Copy(block, model->entryResumePoint());
+    if (!block->entryResumePoint_)
+        return NULL;
+
+    block->stackPosition_ = block->entryResumePoint_->numOperands();
+    for (uint32 i = 0; i < block->stackPosition_; i++)
+        block->slots_[i] = block->entryResumePoint_->getOperand(i);
+
+    block->setLoopDepth(model->loopDepth());
+    return block;
+}
+
 MBasicBlock::MBasicBlock(MIRGraph &graph, CompileInfo &info, jsbytecode *pc, Kind kind)
   : graph_(graph),
     info_(info),
@@ -630,6 +651,14 @@ MBasicBlock::addImmediatelyDominatedBlock(MBasicBlock *child)
     return immediatelyDominated_.append(child);
 }
 
+void
+MBasicBlock::clearDominatorInfo()
+{
+    immediateDominator_ = NULL;
+    immediatelyDominated_.clear();
+    numDominated_ = 0;
+}
+
 void
 MBasicBlock::assertUsesAreNotWithin(MUseIterator use, MUseIterator end)
 {
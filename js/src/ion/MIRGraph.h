@@ -79,6 +79,11 @@ class MBasicBlock : public TempObject, public InlineListNode<MBasicBlock>
                                              MBasicBlock *pred, jsbytecode *entryPc);
     static MBasicBlock *NewSplitEdge(MIRGraph &graph, CompileInfo &info, MBasicBlock *pred);
 
+    // Creates a block with the same pc, kind and entry resume point as
+    // |model|, but no predecessors, phis nor instructions. Loop headers are
+    // copied as normal blocks.
+    static MBasicBlock *NewCopy(MIRGraph &graph, MBasicBlock *model);
+
     bool dominates(MBasicBlock *other);
 
     void setId(uint32 id) {
@@ -251,6 +256,18 @@ class MBasicBlock : public TempObject, public InlineListNode<MBasicBlock>
     bool isLoopHeader() const {
         return kind_ == LOOP_HEADER;
     }
+    // Used when the backedge of a loop header has been removed, e.g. because
+    // the loop body always exits.
+    void clearLoopHeader() {
+        JS_ASSERT(isLoopHeader());
+        kind_ = NORMAL;
+    }
+    // Used when a block of a loop body becomes its header, e.g. because the
+    // loop has been inverted.
+    void makeLoopHeader() {
+        JS_ASSERT(!isLoopHeader());
+        kind_ = LOOP_HEADER;
+    }
     MBasicBlock *backedge() const {
         JS_ASSERT(isLoopHeader());
         JS_ASSERT(numPredecessors() == 1 || numPredecessors() == 2);
@@ -324,6 +341,7 @@ class MBasicBlock : public TempObject, public InlineListNode<MBasicBlock>
     }
 
     bool addImmediatelyDominatedBlock(MBasicBlock *child);
+    void clearDominatorInfo();
 
     // This function retrieves the internal instruction associated with a
     // slot, and should not be used for normal stack operations. It is an
@@ -68,6 +68,7 @@ namespace ion {
     _(NewSlots)                                                             \
     _(NewArray)                                                             \
     _(NewObject)                                                            \
+    _(ObjectState)                                                          \
     _(NewCallObject)                                                        \
     _(InitProp)                                                             \
     _(Start)                                                                \
@@ -85,9 +86,11 @@ namespace ion {
     _(MonitorTypes)                                                         \
     _(GetPropertyCache)                                                     \
     _(GetElementCache)                                                      \
+    _(SetElementCache)                                                      \
     _(BindNameCache)                                                        \
     _(GuardShape)                                                           \
     _(GuardClass)                                                           \
+    _(GuardValue)                                                           \
     _(ArrayLength)                                                          \
     _(TypedArrayLength)                                                     \
     _(TypedArrayElements)                                                   \
@@ -105,6 +108,7 @@ namespace ion {
     _(LoadTypedArrayElement)                                                \
     _(LoadTypedArrayElementHole)                                            \
     _(StoreTypedArrayElement)                                               \
+    _(TypedArrayVectorLoop)                                                 \
     _(ClampToUint8)                                                         \
     _(LoadFixedSlot)                                                        \
     _(StoreFixedSlot)                                                       \
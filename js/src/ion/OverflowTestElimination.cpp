@@ -5,46 +5,130 @@
  *      Author: igor
  */
 
+#include "Ion.h"
 #include "MIR.h"
 #include "MIRGraph.h"
 #include "IonSpewer.h"
+#include "InductionVariable.h"
 #include "OverflowTestElimination.h"
-#include <fstream>
 
 using namespace js;
 using namespace js::ion;
-using namespace std;
 
-OverflowTestElimination::OverflowTestElimination(MIRGraph &graph) : graph(graph) {
-	// TODO Auto-generated constructor stub
+OverflowTestElimination::OverflowTestElimination(MIRGraph &graph)
+  : graph(graph),
+    indVars(graph)
+{
+}
+
+void
+OverflowTestElimination::computeLoopPhiRange(MPhi *phi)
+{
+    // The start value and the bounds of the induction variable have been
+    // visited, their ranges are up to date.
+    const Range *range = indVars.recomputeRange(phi);
+    if (!range)
+        return;
+
+    phi->range()->update(Range::intersect(phi->range(), range));
 
+#ifdef DEBUG
+    if (IonSpewEnabled(IonSpew_OTA)) {
+        IonSpewHeader(IonSpew_OTA);
+        fprintf(IonSpewFile, "Induction variable %d has range ", phi->id());
+        phi->range()->printRange(IonSpewFile);
+        fprintf(IonSpewFile, "\n");
+    }
+#endif
 }
 
-OverflowTestElimination::~OverflowTestElimination() {
-	// TODO Auto-generated destructor stub
+void
+OverflowTestElimination::computeRanges()
+{
+    // Operands are visited before their uses, except the operands of loop
+    // phis coming from the backedge.
+    for (ReversePostorderIterator block(graph.rpoBegin()); block != graph.rpoEnd(); block++) {
+        for (MDefinitionIterator iter(*block); iter; iter++) {
+            MDefinition *def = *iter;
+
+            if (def->isPhi() && block->isLoopHeader()) {
+                computeLoopPhiRange(def->toPhi());
+                continue;
+            }
+
+            if (!def->isBeta() && def->type() != MIRType_Int32)
+                continue;
+
+            // Ranges found by RangeAnalysis, if it ran, are kept when they are
+            // tighter.
+            Range current = *def->range();
+            def->recomputeRange();
+            def->range()->update(Range::intersect(&current, def->range()));
+        }
+    }
+}
+
+void
+OverflowTestElimination::eliminateTests()
+{
+    uint32 numEliminated = 0;
+
+    for (MBasicBlockIterator block(graph.begin()); block != graph.end(); block++) {
+        for (MInstructionIterator iter(block->begin()); iter != block->end(); iter++) {
+            MInstruction *ins = *iter;
+            if (ins->type() != MIRType_Int32)
+                continue;
+
+            // The result of x >>> y does not fit in an int32 only when x is
+            // negative.
+            if (ins->isUrsh()) {
+                MUrsh *ursh = ins->toUrsh();
+                if (ursh->canOverflow() && ursh->getOperand(0)->range()->lower() >= 0) {
+                    ursh->setCanOverflow(false);
+                    IonSpew(IonSpew_OTA, "Removed overflow test of ursh %d", ursh->id());
+                    numEliminated++;
+                }
+                continue;
+            }
+
+            if (ins->isMul()) {
+                MMul *mul = ins->toMul();
+                if (!mul->canBeNegativeZero())
+                    mul->setCanBeNegativeZero(false);
+            }
+
+            // Additions, subtractions and multiplications check for overflow
+            // as long as their range is not finite.
+            if ((ins->isAdd() || ins->isSub() || ins->isMul()) && ins->range()->isFinite()) {
+                IonSpew(IonSpew_OTA, "Removed overflow test of %s %d",
+                        ins->isAdd() ? "add" : ins->isSub() ? "sub" : "mul", ins->id());
+                numEliminated++;
+            }
+        }
+    }
+
+    IonSpew(IonSpew_OTA, "%u overflow tests eliminated", numEliminated);
 }
 
-void OverflowTestElimination::eliminateOverflowTests() {
-	fstream fp_in("/tmp/ionote", ios::out | ios::app);
-	MBasicBlockIterator end = graph.end();
-	for(MBasicBlockIterator it = graph.begin(); it != end; it++){
-		MBasicBlock *block = *it;
-		MInstructionIterator iItEnd = block->end();
-		for(MInstructionIterator iIt = block->begin(); iIt != iItEnd; iIt++){
-			MInstruction *inst = *iIt;
-			//FIXME: actually IM only analyzes overflow in this two operations
-			if(inst->isUrsh()){
-				MUrsh* ursh = inst->toUrsh();
-				if(ursh->canOverflow()){
-
-				}
-			}else if(inst->isMul()){
-				MMul* mul = inst->toMul();
-				if(mul->canOverflow()){
-
-				}
-			}
-		}
-	}
-	fp_in << graph.begin()->info().filename() << ":"<<graph.begin()->info().lineno();
+bool
+OverflowTestElimination::analyze()
+{
+    IonSpew(IonSpew_OTA, "Beginning overflow test elimination pass.");
+
+    // Beta nodes tell which range the operands of a comparison have in the
+    // blocks dominated by either of its branches.
+    if (!indVars.analyze())
+        return false;
+
+    RangeAnalysis ranges(graph);
+    if (!ranges.addBetaNobes())
+        return false;
+
+    computeRanges();
+
+    if (!ranges.removeBetaNobes())
+        return false;
+
+    eliminateTests();
+    return true;
 }
@@ -8,22 +8,38 @@
 #ifndef OVERFLOWTESTELIMINATION_H_
 #define OVERFLOWTESTELIMINATION_H_
 
-// This file represents Loop Inversion optimization pass
+#include "InductionVariable.h"
+#include "RangeAnalysis.h"
+
+// This file represents the Overflow Test Elimination optimization pass
 namespace js {
 namespace ion {
 
+// Computes the ranges of integer definitions in one pass over the graph, and
+// removes the overflow and negative zero checks of the arithmetic which is
+// proven not to need them.
+//
+// Unlike RangeAnalysis, the ranges are not iterated to a fixed point: loop
+// headers are the only place where a definition may be used before it is
+// computed, so the ranges of their phis are given up front. Phis which are
+// induction variables get the range implied by their start value, their step
+// and the tests leaving the loop; other loop phis keep their current range.
+// Specialized arguments are constants and have exact ranges.
+class OverflowTestElimination
+{
+    MIRGraph &graph;
+    InductionVariableAnalysis indVars;
 
-class MIRGraph;
+    void computeLoopPhiRange(MPhi *phi);
+    void computeRanges();
+    void eliminateTests();
 
-class OverflowTestElimination {
-	MIRGraph &graph;
-public:
-	OverflowTestElimination(MIRGraph &graph);
-	virtual ~OverflowTestElimination();
-	void eliminateOverflowTests();
+  public:
+    OverflowTestElimination(MIRGraph &graph);
+    bool analyze();
 };
 
-}
-}
+} // namespace ion
+} // namespace js
 
 #endif /* OVERFLOWTESTELIMINATION_H_ */
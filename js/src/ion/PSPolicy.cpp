@@ -0,0 +1,85 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Ion.h"
+#include "IonSpewer.h"
+#include "PSPolicy.h"
+
+using namespace js;
+using namespace js::ion;
+
+PSPolicy::PSPolicy()
+  : level_(0),
+    pending_(PSDecision_Keep)
+{ }
+
+// Whether a bailout of |kind| may come from a value the code has been
+// specialized to. Recompile checks only ask for inlining, and the other kinds
+// come from guards the generic code has as well.
+static bool
+IsSpecializationBailout(BailoutKind kind)
+{
+    switch (kind) {
+      case Bailout_Normal:
+      case Bailout_Invalidate:
+      case Bailout_ParameterCheck:
+        return true;
+      default:
+        return false;
+    }
+}
+
+void
+PSPolicy::noteBailout(JSScript *script, IonScript *ion, SnapshotOffset snapshot, BailoutKind kind)
+{
+    if (!IsSpecializationBailout(kind) || pending_ != PSDecision_Keep)
+        return;
+
+    uint32 bailouts = ion->numBailouts(Bailout_Normal) +
+                      ion->numBailouts(Bailout_Invalidate) +
+                      ion->numBailouts(Bailout_ParameterCheck);
+    uint32 entries = ion->numEntries();
+
+    // A guard which keeps failing at the same place, or bailouts which are
+    // frequent compared to the number of times the version is entered.
+    uint32 threshold = js_IonOptions.psBailoutThreshold;
+    bool hotSnapshot = ion->numBailoutsAt(snapshot) >= threshold;
+    bool frequent = bailouts >= threshold &&
+                    uint64(bailouts) * 100 >= uint64(entries) * js_IonOptions.psBailoutRate;
+    if (!hotSnapshot && !frequent)
+        return;
+
+    if (level_ < js_IonOptions.psMaxRespecializations) {
+        IonSpew(IonSpew_PS, "%u bailouts (%u in total) in %u entries of %s:%d, "
+                "respecializing to fewer constants",
+                bailouts, ion->numBailouts(), entries, script->filename, script->lineno);
+        pending_ = PSDecision_Respecialize;
+        level_++;
+    } else {
+        IonSpew(IonSpew_PS, "%u bailouts (%u in total) in %u entries of %s:%d, "
+                "falling back to generic code",
+                bailouts, ion->numBailouts(), entries, script->filename, script->lineno);
+        pending_ = PSDecision_Generic;
+    }
+}
+
+PSDecision
+PSPolicy::takeDecision()
+{
+    PSDecision decision = pending_;
+    pending_ = PSDecision_Keep;
+    return decision;
+}
+
+uint32
+PSPolicy::stabilityThreshold() const
+{
+    uint32 threshold = js_IonOptions.psStabilityThreshold;
+    for (uint32 i = 0; i < level_ && threshold < (1u << 16); i++)
+        threshold = threshold ? threshold * 2 : 1;
+    return threshold;
+}
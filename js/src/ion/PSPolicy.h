@@ -0,0 +1,78 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined(jsion_pspolicy_h__) && defined(JS_ION)
+#define jsion_pspolicy_h__
+
+#include "IonTypes.h"
+
+namespace js {
+namespace ion {
+
+class IonScript;
+
+enum PSDecision
+{
+    // Keep specializing the script as much as it currently is.
+    PSDecision_Keep,
+
+    // Throw the specialized versions away and specialize the script to fewer
+    // constants.
+    PSDecision_Respecialize,
+
+    // Stop specializing the script and only run its generic version.
+    PSDecision_Generic
+};
+
+// Decides what to do with the parameter specialized versions of a script
+// depending on how often they bail out. A version bails out when the values
+// it has been specialized to lead it to guards which do not hold, e.g. because
+// locals baked into its OSR block changed types later on.
+//
+// Bailouts are counted by the IonScript of each version, per kind and per
+// snapshot. Only the kinds a specialized value can cause are weighed, see
+// IsSpecializationBailout: bounds checks, type barriers and the like fail in
+// generic code as well, so they do not make a version worth replacing.
+//
+// Each level of respecialization bakes fewer constants into the code: locals
+// stop being baked at the first one, and every level doubles the number of
+// calls arguments which already changed value must have kept their current
+// one before being specialized again.
+//
+// Decisions are taken at bailouts, but only applied the next time the script
+// is entered from the interpreter or JM, see ApplyPSPolicy.
+class PSPolicy
+{
+    // Number of times the script has been respecialized.
+    uint32 level_;
+
+    PSDecision pending_;
+
+  public:
+    PSPolicy();
+
+    // Account for a bailout of |kind| at |snapshot| from |ion|, the active
+    // specialized version of |script|, which has already counted it.
+    void noteBailout(JSScript *script, IonScript *ion, SnapshotOffset snapshot, BailoutKind kind);
+
+    // Return the decision taken since the last call, if any.
+    PSDecision takeDecision();
+
+    uint32 level() const {
+        return level_;
+    }
+
+    bool specializesLocals() const {
+        return level_ == 0;
+    }
+    uint32 stabilityThreshold() const;
+};
+
+} // namespace ion
+} // namespace js
+
+#endif // jsion_pspolicy_h__
@@ -0,0 +1,421 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Ion.h"
+#include "IonCode.h"
+#include "IonSpewer.h"
+#include "PSVersionCache.h"
+
+#include "gc/Marking.h"
+
+#include "jsscriptinlines.h"
+
+#include "gc/Barrier-inl.h"
+
+using namespace js;
+using namespace js::ion;
+
+PSVersionCache::Entry::Entry(StackFrame *fp, jsbytecode *osrPc)
+  : args(fp->formals()),
+    nargs(fp->numFormalArgs()),
+    osrPc(osrPc),
+    locals(osrPc ? fp->slots() : NULL),
+    nlocals(osrPc ? fp->script()->nfixed : 0)
+{ }
+
+void
+PSVersionCache::Key::release()
+{
+    // The key values are traced by the script, the incremental GC must know
+    // about the edges removed here.
+    for (uint32 i = 0; i < nargs; i++)
+        HeapValue::writeBarrierPre(args[i]);
+    for (uint32 i = 0; i < nlocals; i++)
+        HeapValue::writeBarrierPre(locals[i]);
+
+    js_free(args);
+    js_free(locals);
+    clear();
+}
+
+PSVersionCache::PSVersionCache()
+  : clock_(0),
+    specializations_(0)
+{
+    active_.clear();
+}
+
+/* static */ bool
+PSVersionCache::argsMatch(const Value *key, uint32 nkey, uint32 mask,
+                          const Value *args, uint32 nargs)
+{
+    if (nkey != nargs)
+        return false;
+
+    // Values are compared bitwise, like the constants baked into the code.
+    for (uint32 i = 0; i < nargs; i++) {
+        if ((mask & (1u << i)) && key[i] != args[i])
+            return false;
+    }
+    return true;
+}
+
+/* static */ bool
+PSVersionCache::keyMatches(const Key &key, const Entry &entry)
+{
+    if (!argsMatch(key.args, key.nargs, key.mask, entry.args, entry.nargs))
+        return false;
+
+    // Entering at the start of the script only goes through the argument
+    // guards. Entering at a loop header skips them and runs the OSR block.
+    if (!entry.osrPc)
+        return true;
+    if (key.osrPc != entry.osrPc)
+        return false;
+    if (!key.locals)
+        return true;
+
+    JS_ASSERT(key.nlocals == entry.nlocals);
+    for (uint32 i = 0; i < key.nlocals; i++) {
+        if (key.locals[i] != entry.locals[i])
+            return false;
+    }
+    return true;
+}
+
+static uint32
+CountBits(uint32 mask)
+{
+    uint32 n = 0;
+    for (; mask; mask &= mask - 1)
+        n++;
+    return n;
+}
+
+// We are about to remove edges from the JSScript to gcthings embedded in a
+// stashed IonScript. Perform one final trace of the IonScript for the
+// incremental GC, as it must know about those edges.
+static void
+TraceBeforeRemoval(JSScript *script, IonScript *ion)
+{
+    JSCompartment *compartment = script->compartment();
+    if (compartment->needsBarrier())
+        IonScript::Trace(compartment->barrierTracer(), ion);
+}
+
+void
+PSVersionCache::destroyVersion(FreeOp *fop, JSScript *script, Version &version)
+{
+    IonSpew(IonSpew_PS, "Destroying %s version %p of %s:%d",
+            version.generic ? "generic" : "specialized", (void *) version.ion,
+            script->filename, script->lineno);
+
+    JS_ASSERT(!version.ion->invalidated());
+    IonScript::Destroy(fop, version.ion);
+    version.key.release();
+}
+
+void
+PSVersionCache::evictLeastRecentlyUsed(FreeOp *fop, JSScript *script)
+{
+    Version *victim = NULL;
+    for (Version *v = versions_.begin(); v != versions_.end(); v++) {
+        if (v->generic)
+            continue;
+        if (!victim || v->lastUse < victim->lastUse)
+            victim = v;
+    }
+
+    if (!victim)
+        return;
+
+    TraceBeforeRemoval(script, victim->ion);
+    destroyVersion(fop, script, *victim);
+    versions_.erase(victim);
+}
+
+/* static */ bool
+PSVersionCache::InitKey(const Entry &entry, uint32 mask, bool bakedLocals, Key *key)
+{
+    // The arguments are always copied, even if there are none, as a non-NULL
+    // |active_.args| tells there is an active key.
+    uint32 nargs = entry.nargs;
+    Value *args = (Value *) js_malloc(Max(nargs, uint32(1)) * sizeof(Value));
+    if (!args)
+        return false;
+    for (uint32 i = 0; i < nargs; i++)
+        args[i] = (mask & (1u << i)) ? entry.args[i] : UndefinedValue();
+
+    Value *locals = NULL;
+    uint32 nlocals = 0;
+    if (bakedLocals && entry.osrPc && entry.nlocals) {
+        nlocals = entry.nlocals;
+        locals = (Value *) js_malloc(nlocals * sizeof(Value));
+        if (!locals) {
+            js_free(args);
+            return false;
+        }
+        for (uint32 i = 0; i < nlocals; i++)
+            locals[i] = entry.locals[i];
+    }
+
+    key->args = args;
+    key->nargs = nargs;
+    key->mask = mask;
+    key->osrPc = entry.osrPc;
+    key->locals = locals;
+    key->nlocals = nlocals;
+    return true;
+}
+
+void
+PSVersionCache::setActive(Key *key)
+{
+    JS_ASSERT(key->args);
+
+    clearActive();
+    active_ = *key;
+    key->clear();
+}
+
+void
+PSVersionCache::clearActive()
+{
+    active_.release();
+}
+
+bool
+PSVersionCache::stash(JSContext *cx, JSScript *script, IonScript *ion, bool generic)
+{
+    FreeOp *fop = cx->runtime->defaultFreeOp();
+
+    JS_ASSERT(!ion->invalidated());
+    JS_ASSERT_IF(!generic, active_.args);
+
+    // A version which is expected to bail out will not be entered anymore.
+    if (ion->bailoutExpected()) {
+        TraceBeforeRemoval(script, ion);
+        IonScript::Destroy(fop, ion);
+        clearActive();
+        return true;
+    }
+
+    Version version;
+    version.ion = ion;
+    version.key.clear();
+    version.key.osrPc = ion->osrPc();
+    version.generic = generic;
+    version.lastUse = clock_++;
+
+    // Only the most recent version for a given key is worth keeping.
+    Version *old = generic
+                   ? findGeneric(ion->osrPc())
+                   : findSameKey(active_);
+    if (old) {
+        TraceBeforeRemoval(script, old->ion);
+        destroyVersion(fop, script, *old);
+        versions_.erase(old);
+    }
+
+    if (!generic) {
+        if (!js_IonOptions.psMaxVersions) {
+            TraceBeforeRemoval(script, ion);
+            IonScript::Destroy(fop, ion);
+            clearActive();
+            return true;
+        }
+
+        size_t specialized = 0;
+        for (Version *v = versions_.begin(); v != versions_.end(); v++) {
+            if (!v->generic)
+                specialized++;
+        }
+        if (specialized >= js_IonOptions.psMaxVersions)
+            evictLeastRecentlyUsed(fop, script);
+
+        // The key is handed over to the stashed version.
+        version.key = active_;
+        active_.clear();
+    }
+
+    if (!versions_.append(version)) {
+        TraceBeforeRemoval(script, ion);
+        destroyVersion(fop, script, version);
+        return false;
+    }
+
+    IonSpew(IonSpew_PS, "Stashed %s version %p of %s:%d (%u versions)",
+            generic ? "generic" : "specialized", (void *) ion,
+            script->filename, script->lineno, (unsigned) versions_.length());
+    return true;
+}
+
+PSVersionCache::Version *
+PSVersionCache::findSpecialized(const Entry &entry)
+{
+    // Prefer the version with the most arguments specialized.
+    Version *best = NULL;
+    for (Version *v = versions_.begin(); v != versions_.end(); v++) {
+        if (v->generic || !keyMatches(v->key, entry))
+            continue;
+        if (!best || CountBits(v->key.mask) > CountBits(best->key.mask))
+            best = v;
+    }
+    return best;
+}
+
+PSVersionCache::Version *
+PSVersionCache::findSameKey(const Key &key)
+{
+    for (Version *v = versions_.begin(); v != versions_.end(); v++) {
+        if (v->generic || v->key.mask != key.mask || v->key.osrPc != key.osrPc)
+            continue;
+        if (!argsMatch(v->key.args, v->key.nargs, key.mask, key.args, key.nargs))
+            continue;
+        return v;
+    }
+    return NULL;
+}
+
+// Find the generic version entering at |osrPc|, or the most recently used
+// one if the script is entered at its start.
+PSVersionCache::Version *
+PSVersionCache::findGeneric(jsbytecode *osrPc)
+{
+    Version *best = NULL;
+    for (Version *v = versions_.begin(); v != versions_.end(); v++) {
+        if (!v->generic)
+            continue;
+        if (osrPc && v->key.osrPc != osrPc)
+            continue;
+        if (!best || v->lastUse > best->lastUse)
+            best = v;
+    }
+    return best;
+}
+
+IonScript *
+PSVersionCache::takeVersion(Version *version)
+{
+    if (!version)
+        return NULL;
+
+    IonScript *ion = version->ion;
+
+    // The key of the version becomes the active one.
+    clearActive();
+    if (!version->generic)
+        active_ = version->key;
+    else
+        version->key.release();
+
+    versions_.erase(version);
+    return ion;
+}
+
+IonScript *
+PSVersionCache::takeSpecialized(const Entry &entry)
+{
+    return takeVersion(findSpecialized(entry));
+}
+
+IonScript *
+PSVersionCache::takeGeneric(const Entry &entry)
+{
+    return takeVersion(findGeneric(entry.osrPc));
+}
+
+bool
+PSVersionCache::hasMatching(const Entry &entry)
+{
+    return !!findSpecialized(entry);
+}
+
+void
+PSVersionCache::discard(FreeOp *fop, JSScript *script, IonScript *ion)
+{
+    for (Version *v = versions_.begin(); v != versions_.end(); v++) {
+        if (v->ion == ion) {
+            TraceBeforeRemoval(script, v->ion);
+            destroyVersion(fop, script, *v);
+            versions_.erase(v);
+            return;
+        }
+    }
+}
+
+void
+PSVersionCache::purge(FreeOp *fop, JSScript *script)
+{
+    for (Version *v = versions_.begin(); v != versions_.end(); v++)
+        destroyVersion(fop, script, *v);
+    versions_.clear();
+}
+
+void
+PSVersionCache::purgeSpecialized(FreeOp *fop, JSScript *script)
+{
+    for (Version *v = versions_.begin(); v != versions_.end(); ) {
+        if (v->generic) {
+            v++;
+            continue;
+        }
+        TraceBeforeRemoval(script, v->ion);
+        destroyVersion(fop, script, *v);
+        versions_.erase(v);
+    }
+}
+
+/* static */ void
+PSVersionCache::traceKey(JSTracer *trc, Key &key)
+{
+    for (uint32 i = 0; i < key.nargs; i++)
+        gc::MarkValueUnbarriered(trc, &key.args[i], "ps version key");
+    for (uint32 i = 0; i < key.nlocals; i++)
+        gc::MarkValueUnbarriered(trc, &key.locals[i], "ps version locals");
+}
+
+void
+PSVersionCache::trace(JSTracer *trc)
+{
+    for (Version *v = versions_.begin(); v != versions_.end(); v++) {
+        IonScript::Trace(trc, v->ion);
+        traceKey(trc, v->key);
+    }
+    traceKey(trc, active_);
+}
+
+void
+PSVersionCache::toggleBarriers(bool enabled)
+{
+    for (Version *v = versions_.begin(); v != versions_.end(); v++)
+        v->ion->toggleBarriers(enabled);
+}
+
+void
+PSVersionCache::purgeCaches()
+{
+    for (Version *v = versions_.begin(); v != versions_.end(); v++)
+        v->ion->purgeCaches();
+}
+
+size_t
+PSVersionCache::sizeOfIncludingThis(JSMallocSizeOfFun mallocSizeOf) const
+{
+    size_t n = mallocSizeOf(this) + versions_.sizeOfExcludingThis(mallocSizeOf);
+    for (const Version *v = versions_.begin(); v != versions_.end(); v++)
+        n += v->ion->size();
+    return n;
+}
+
+/* static */ void
+PSVersionCache::Destroy(FreeOp *fop, JSScript *script, PSVersionCache *cache)
+{
+    cache->purge(fop, script);
+    cache->clearActive();
+    fop->delete_(cache);
+}
@@ -0,0 +1,181 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined(jsion_psversioncache_h__) && defined(JS_ION)
+#define jsion_psversioncache_h__
+
+#include "jscntxt.h"
+
+#include "PSPolicy.h"
+
+namespace js {
+namespace ion {
+
+struct IonScript;
+
+// Parameter specialization produces code which is only valid for the
+// argument values seen at compile time. Instead of throwing a specialized
+// IonScript away as soon as its script is called with other arguments, the
+// script keeps a few of them around, keyed by their argument tuple, together
+// with at most one generic version to fall back on.
+//
+// Versions are also kept per loop header they have been compiled to enter
+// at, so that a script with several hot loops, entered at each of them from
+// the interpreter or JM, does not keep recompiling its OSR entry.
+//
+// Only the version attached to |script->ion| may have frames on the stack.
+// Stashed versions are entered exclusively by being swapped back into
+// |script->ion|, so they can be destroyed at any time.
+class PSVersionCache
+{
+  public:
+    // The state of a frame entering the script, at its start or at the loop
+    // header |osrPc|.
+    struct Entry
+    {
+        const Value *args;
+        uint32 nargs;
+        jsbytecode *osrPc;
+        const Value *locals;
+        uint32 nlocals;
+
+        Entry(StackFrame *fp, jsbytecode *osrPc);
+    };
+
+    // What a version has been compiled for.
+    struct Key
+    {
+        // Argument values the version has been specialized to. Generic
+        // versions have no arguments. Only the arguments in |mask| have been
+        // specialized; the other ones are undefined in |args|.
+        Value *args;
+        uint32 nargs;
+        uint32 mask;
+
+        // Loop header the OSR block of the version enters at, if any, and
+        // the values of the locals baked into it. Versions which did not
+        // bake locals have none.
+        jsbytecode *osrPc;
+        Value *locals;
+        uint32 nlocals;
+
+        void clear() {
+            args = NULL;
+            nargs = 0;
+            mask = 0;
+            osrPc = NULL;
+            locals = NULL;
+            nlocals = 0;
+        }
+        void release();
+    };
+
+    struct Version
+    {
+        IonScript *ion;
+        Key key;
+        bool generic;
+
+        // Clock value of the last time this version was detached from the
+        // script, used for LRU eviction.
+        uint64 lastUse;
+    };
+
+  private:
+    typedef Vector<Version, 4, SystemAllocPolicy> VersionVector;
+
+    VersionVector versions_;
+
+    // Key of the version currently attached to the script, if it is
+    // specialized.
+    Key active_;
+
+    uint64 clock_;
+
+    // Number of specialized versions compiled for the script so far.
+    uint32 specializations_;
+
+    PSPolicy policy_;
+
+    Version *findSpecialized(const Entry &entry);
+    Version *findSameKey(const Key &key);
+    Version *findGeneric(jsbytecode *osrPc);
+    IonScript *takeVersion(Version *version);
+    static bool argsMatch(const Value *key, uint32 nkey, uint32 mask,
+                          const Value *args, uint32 nargs);
+    static bool keyMatches(const Key &key, const Entry &entry);
+    void destroyVersion(FreeOp *fop, JSScript *script, Version &version);
+    void evictLeastRecentlyUsed(FreeOp *fop, JSScript *script);
+    static void traceKey(JSTracer *trc, Key &key);
+
+  public:
+    PSVersionCache();
+
+    // Make the key of a version specialized to |entry|. Bit i of |mask| is
+    // set if argument i was specialized, and the locals of |entry| are
+    // recorded if they were baked into the code.
+    static bool InitKey(const Entry &entry, uint32 mask, bool bakedLocals, Key *key);
+
+    // Record the key the script's current IonScript has been specialized to,
+    // taking it over from |key|.
+    void setActive(Key *key);
+    void clearActive();
+
+    // Whether the script's current IonScript may be entered with |entry|.
+    bool activeMatches(const Entry &entry) const {
+        return active_.args && keyMatches(active_, entry);
+    }
+
+    // Keep |ion|, which is being detached from |script|, for later use. The
+    // key of a specialized version is the currently active one, and replaces
+    // any version stashed under the same key. On failure, |ion| is destroyed.
+    bool stash(JSContext *cx, JSScript *script, IonScript *ion, bool generic);
+
+    // Remove and return a version specialized to |entry|, or a generic
+    // version which can be entered with it. The active key is updated
+    // accordingly.
+    IonScript *takeSpecialized(const Entry &entry);
+    IonScript *takeGeneric(const Entry &entry);
+
+    bool hasMatching(const Entry &entry);
+
+    // Returns the number of specialized versions compiled so far, including
+    // the one being noted.
+    uint32 noteSpecialization() {
+        return ++specializations_;
+    }
+
+    PSPolicy &policy() {
+        return policy_;
+    }
+
+    // Forget a stashed version whose compilation assumptions do not hold
+    // anymore.
+    void discard(FreeOp *fop, JSScript *script, IonScript *ion);
+
+    // Destroy every stashed specialized version, keeping the generic one.
+    void purgeSpecialized(FreeOp *fop, JSScript *script);
+
+    // Destroy every stashed version.
+    void purge(FreeOp *fop, JSScript *script);
+
+    void trace(JSTracer *trc);
+    void toggleBarriers(bool enabled);
+    void purgeCaches();
+    size_t sizeOfIncludingThis(JSMallocSizeOfFun mallocSizeOf) const;
+
+    size_t numVersions() const {
+        return versions_.length();
+    }
+
+    static void Destroy(FreeOp *fop, JSScript *script, PSVersionCache *cache);
+};
+
+} // namespace ion
+} // namespace js
+
+#endif // jsion_psversioncache_h__
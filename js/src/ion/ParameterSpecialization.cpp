@@ -9,7 +9,11 @@
 #include "MIR.h"
 #include "IonSpewer.h"
 #include "ParameterSpecialization.h"
+#include "PSVersionCache.h"
 
+#include "jsanalyze.h"
+
+#include "jsinferinlines.h"
 
 using namespace js;
 using namespace js::ion;
@@ -24,7 +28,9 @@ ParameterSpecialization::ParameterSpecialization(JSContext *cx, JSScript *script
 bool
 ParameterSpecialization::extractArgs()
 {
-    if ((fp->hasArgs()) && (fp->isFunctionFrame())) {
+    // Compilation may be triggered from another script's frame, e.g. when
+    // Ion code calls a script which has not been compiled yet.
+    if (fp->hasArgs() && fp->isFunctionFrame() && fp->script() == script) {
         nargs = fp->numFormalArgs();
         args = fp->formals();
 
@@ -52,8 +58,6 @@ ParameterSpecialization::canSpecialize(jsbytecode *osrPc)
 
     if (!osrPc) {
         IonSpew(IonSpew_PS, "Skipped. The graph does not have an osr block.");
-        
-        script->disabledForPS = true;
         return false;
     }
 
@@ -64,16 +68,86 @@ ParameterSpecialization::canSpecialize(jsbytecode *osrPc)
         return false;
     }
 
-    for (unsigned i = 0; i < nargs; i++) {
-        if (getArg(i).isUndefined()) {
-            IonSpew(IonSpew_PS, "Skipped. A parameter is undefined.");
-            return false;
-        }
+    if (!specializableArgs()) {
+        IonSpew(IonSpew_PS, "Skipped. No parameter is stable enough.");
+        return false;
     }
 
     return true;
 }
 
+uint32
+ParameterSpecialization::stabilityThreshold()
+{
+    if (script->psVersions)
+        return script->psVersions->policy().stabilityThreshold();
+    return js_IonOptions.psStabilityThreshold;
+}
+
+bool
+ParameterSpecialization::canSpecializeLocals()
+{
+    return !script->psVersions || script->psVersions->policy().specializesLocals();
+}
+
+uint32
+ParameterSpecialization::specializableArgs()
+{
+    if (!extractArgs())
+        return 0;
+
+    // Undefined arguments are most often missing ones, and arguments which
+    // keep changing would only make the specialized code bail out, so both
+    // are left as parameters.
+    uint32 mask = 0;
+    for (unsigned i = 0; i < nargs && i < MAX_SPECIALIZED_ARGS; i++) {
+        Value arg = getArg(i);
+        if (arg.isUndefined())
+            continue;
+        if (!script->isArgumentStable(i, arg, stabilityThreshold()))
+            continue;
+        mask |= 1u << i;
+    }
+    return mask;
+}
+
+uint32
+ParameterSpecialization::shapeSpecializableArgs()
+{
+    if (!extractArgs())
+        return 0;
+
+    // Property reads are only redirected for arguments which hold the object
+    // they were called with during the whole script.
+    if (!script->hasAnalysis() || script->argumentsHasVarBinding() ||
+        script->analysis()->modifiesArguments())
+    {
+        return 0;
+    }
+
+    uint32 mask = 0;
+    for (unsigned i = 0; i < nargs && i < MAX_SPECIALIZED_ARGS; i++) {
+        Value arg = getArg(i);
+        if (!arg.isObject() || !arg.toObject().isNative())
+            continue;
+        // Stores to singletons must be seen by the VM, see HasConstantProperty.
+        if (types::TrackConstantProperties(cx) && arg.toObject().hasSingletonType())
+            continue;
+        if (!script->isArgumentShapeStable(i, getArgShape(i), stabilityThreshold()))
+            continue;
+        mask |= 1u << i;
+    }
+    return mask;
+}
+
+Shape *
+ParameterSpecialization::getArgShape(unsigned i)
+{
+    Value value = getArg(i);
+    JS_ASSERT(value.isObject());
+    return value.toObject().lastProperty();
+}
+
 bool
 ParameterSpecialization::canSpecializeAtOsr()
 {
@@ -25,6 +25,10 @@ class ParameterSpecialization{
     bool extractArgs();
     Value getArg(unsigned i);
 
+    // Calls an argument which changed value must have kept its current one
+    // to be specialized, as required by the PS policy of the script.
+    uint32 stabilityThreshold();
+
   public:
     ParameterSpecialization(JSContext *cx, JSScript *script);
     
@@ -33,6 +37,22 @@ class ParameterSpecialization{
     bool canSpecialize(jsbytecode *osrPc);
     bool canSpecializeAtOsr();
 
+    // Whether the values of locals may be baked into the OSR block.
+    bool canSpecializeLocals();
+
+    // Only the first arguments of a function may be specialized, so that the
+    // set of specialized arguments fits in a mask.
+    static const uint32 MAX_SPECIALIZED_ARGS = 32;
+
+    // Returns a mask of the arguments which are worth replacing by their
+    // current value. The other ones are kept as parameters.
+    uint32 specializableArgs();
+
+    // Returns a mask of the object arguments whose shape is worth
+    // specializing to, so that their own properties can be read directly.
+    uint32 shapeSpecializableArgs();
+    Shape *getArgShape(unsigned i);
+
     void disable() {
         script->disabledForPS = true;
     }
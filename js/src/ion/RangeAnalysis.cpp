@@ -75,7 +75,8 @@ using namespace js::ion;
 // encounter beta nodes.
 
 RangeAnalysis::RangeAnalysis(MIRGraph &graph)
-  : graph_(graph)
+  : graph_(graph),
+    computed_(NULL)
 {
 }
 
@@ -156,7 +157,7 @@ RangeAnalysis::addBetaNobes()
             if (jsop == JSOP_LT) {
                 smaller = left;
                 greater = right;
-            } else if (JSOP_GT) {
+            } else if (jsop == JSOP_GT) {
                 smaller = right;
                 greater = left;
             }
@@ -371,48 +372,148 @@ PopFromWorklist(MDefinitionVector &worklist)
 }
 
 
+// Phis of loop headers merge the ranges of the operands computed so far, and
+// only ever grow. Once a phi has grown WideningThreshold times, the bounds
+// which still grow are widened to infinity, so that the ranges of the
+// definitions in the loop, which all depend on the phis of its header, are
+// stable after a bounded number of steps.
 bool
-RangeAnalysis::analyze()
+RangeAnalysis::recomputeLoopPhiRange(MPhi *phi)
 {
-    IonSpew(IonSpew_Range, "Doing range propagation");
-    MDefinitionVector worklist;
+    if (phi->type() != MIRType_Int32)
+        return false;
+
+    Range r;
+    bool first = true;
+    for (size_t i = 0; i < phi->numOperands(); i++) {
+        MDefinition *op = phi->getOperand(i);
+        if (!computed_->contains(op->id()))
+            continue;
+        if (first)
+            r.update(op->range());
+        else
+            r.unionWith(op->range());
+        first = false;
+    }
+    if (first)
+        return false;
+
+    if (computed_->contains(phi->id())) {
+        Range old = *phi->range();
+        r.unionWith(&old);
+
+        Range grown = old;
+        if (grown.update(&r) && ++updates_[phi->id()] > WideningThreshold) {
+            if (r.lower() < old.lower())
+                r.makeLowerInfinite();
+            if (r.upper() > old.upper())
+                r.makeUpperInfinite();
+            IonSpew(IonSpew_Range, "Widening range of %d", phi->id());
+        }
+    }
 
-    for (ReversePostorderIterator block(graph_.rpoBegin()); block != graph_.rpoEnd(); block++) {
-        for (MDefinitionIterator iter(*block); iter; iter++) {
-            MDefinition *def = *iter;
+    return phi->range()->update(&r);
+}
 
-            if (!def->isPhi() && !def->isBeta())
-                continue;
-            AddToWorklist(worklist, def);
+// Once ranges are stable, the infinite bounds of the phis of loop headers are
+// narrowed to the bounds of their operands. Each bound is narrowed at most
+// once.
+bool
+RangeAnalysis::narrowLoopPhiRange(MPhi *phi)
+{
+    if (phi->type() != MIRType_Int32)
+        return false;
 
-        }
+    Range r;
+    r.update(phi->getOperand(0)->range());
+    for (size_t i = 1; i < phi->numOperands(); i++)
+        r.unionWith(phi->getOperand(i)->range());
+
+    Range narrowed = *phi->range();
+    if (narrowed.isLowerInfinite() && !r.isLowerInfinite() && r.lower() <= narrowed.upper())
+        narrowed.setLower(r.lower());
+    if (narrowed.isUpperInfinite() && !r.isUpperInfinite() && r.upper() >= narrowed.lower())
+        narrowed.setUpper(r.upper());
+
+    return phi->range()->update(&narrowed);
+}
+
+bool
+RangeAnalysis::recomputeRange(MDefinition *def, bool narrowing)
+{
+    if (def->isPhi() && def->block()->isLoopHeader()) {
+        if (narrowing)
+            return narrowLoopPhiRange(def->toPhi());
+        return recomputeLoopPhiRange(def->toPhi());
     }
-    size_t iters = 0;
-#define MAX_ITERS 4096
-    // XXX: hack: range analysis iloops on jit-test/tests/basic/fannkuch.js
-    // To circumvent this and land the pass, we just run for a fixed number of
-    // iterations.
-    //
-    // (Bug 765119)
-    while (!worklist.empty() /* && iters < MAX_ITERS*/) {
+    return def->recomputeRange();
+}
+
+bool
+RangeAnalysis::propagate(MDefinitionVector &worklist, bool narrowing)
+{
+    while (!worklist.empty()) {
         MDefinition *def = PopFromWorklist(worklist);
         IonSpew(IonSpew_Range, "recomputing range on %d", def->id());
+        if (!recomputeRange(def, narrowing))
+            continue;
+
         SpewRange(def);
-        if (def->recomputeRange()) {
-            JS_ASSERT(def->range()->lower() <= def->range()->upper());
-            IonSpew(IonSpew_Range, "Range changed; adding consumers");
+        JS_ASSERT(def->range()->lower() <= def->range()->upper());
+        IonSpew(IonSpew_Range, "Range changed; adding consumers");
+        for (MUseDefIterator use(def); use; use++) {
+            if (!AddToWorklist(worklist, use.def()))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool
+RangeAnalysis::analyze()
+{
+    IonSpew(IonSpew_Range, "Doing range propagation");
+
+    computed_ = BitSet::New(graph_.getMaxInstructionId());
+    if (!computed_)
+        return false;
+    if (!updates_.appendN(0, graph_.getMaxInstructionId() + 1))
+        return false;
+
+    // Definitions are first computed in reverse postorder, so that their
+    // operands are computed before them, but for the operands of loop phis
+    // coming from the backedge. Ranges given when definitions are created,
+    // e.g. those of constants, lengths and typed array loads, flow to their
+    // uses from there.
+    MDefinitionVector worklist;
+    for (ReversePostorderIterator block(graph_.rpoBegin()); block != graph_.rpoEnd(); block++) {
+        for (MDefinitionIterator iter(*block); iter; iter++) {
+            MDefinition *def = *iter;
+            recomputeRange(def, false);
+            computed_->insert(def->id());
+
+            // Loop phis using this definition have been computed without it.
             for (MUseDefIterator use(def); use; use++) {
-                if(!AddToWorklist(worklist, use.def()))
+                if (computed_->contains(use.def()->id()) && !AddToWorklist(worklist, use.def()))
                     return false;
             }
         }
-        iters++;
     }
-    // Cleanup (in case we stopped due to MAX_ITERS)
-    for(size_t i = 0; i < worklist.length(); i++)
-        worklist[i]->setNotInWorklist();
 
-#undef MAX_ITERS
+    if (!propagate(worklist, false))
+        return false;
+
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        if (!block->isLoopHeader())
+            continue;
+        for (MPhiIterator phi(block->phisBegin()); phi != block->phisEnd(); phi++) {
+            if (!AddToWorklist(worklist, *phi))
+                return false;
+        }
+    }
+
+    if (!propagate(worklist, true))
+        return false;
 
 #ifdef DEBUG
     for (ReversePostorderIterator block(graph_.rpoBegin()); block != graph_.rpoEnd(); block++) {
@@ -426,3 +527,119 @@ RangeAnalysis::analyze()
 #endif
     return true;
 }
+
+// Int32 value a double operand has been converted from, if any.
+static MDefinition *
+Int32Input(MDefinition *def)
+{
+    if (def->type() == MIRType_Int32)
+        return def;
+    if (def->isToDouble() && def->getOperand(0)->type() == MIRType_Int32)
+        return def->getOperand(0);
+    return NULL;
+}
+
+static bool
+IsInt32DoubleConstant(MDefinition *def, int32_t *value)
+{
+    if (!def->isConstant() || def->type() != MIRType_Double)
+        return false;
+    return MOZ_DOUBLE_IS_INT32(def->toConstant()->value().toDouble(), value);
+}
+
+// Returns the int32 version of an operand of a double operation, creating
+// it before |at| if the operand is a constant.
+static MDefinition *
+Int32Operand(MDefinition *def, MInstruction *at)
+{
+    if (MDefinition *input = Int32Input(def))
+        return input;
+
+    int32_t value;
+    if (!IsInt32DoubleConstant(def, &value))
+        return NULL;
+    MConstant *constant = MConstant::New(Int32Value(value));
+    at->block()->insertBefore(at, constant);
+    return constant;
+}
+
+// Range of an operand of a double operation which has an int32 version.
+static bool
+Int32OperandRange(MDefinition *def, Range *range)
+{
+    if (MDefinition *input = Int32Input(def)) {
+        range->update(input->range());
+        return true;
+    }
+
+    int32_t value;
+    if (!IsInt32DoubleConstant(def, &value))
+        return false;
+    range->set(value, value);
+    return true;
+}
+
+bool
+RangeAnalysis::eliminateConversions()
+{
+    IonSpew(IonSpew_Range, "Eliminating int32 conversions");
+
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        for (MInstructionIterator iter(block->begin()); iter != block->end(); iter++) {
+            MInstruction *ins = *iter;
+            if (!ins->isToInt32() && !ins->isTruncateToInt32())
+                continue;
+
+            // Converting an int32 to a double and back gives the same int32.
+            MDefinition *input = ins->getOperand(0);
+            if (MDefinition *value = Int32Input(input)) {
+                IonSpew(IonSpew_Range, "Replacing conversion %d by %d", ins->id(), value->id());
+                ins->replaceAllUsesWith(value);
+                continue;
+            }
+
+            // Additions and subtractions of int32 values are exact in double
+            // arithmetic. Truncating their result gives the result of the
+            // int32 operation once it wraps around, and converting it without
+            // truncation does when the operation cannot overflow.
+            if (!input->isAdd() && !input->isSub())
+                continue;
+            MIRType specialization = input->isAdd()
+                                     ? input->toAdd()->specialization()
+                                     : input->toSub()->specialization();
+            if (specialization != MIRType_Double)
+                continue;
+
+            Range left, right;
+            if (!Int32OperandRange(input->getOperand(0), &left) ||
+                !Int32OperandRange(input->getOperand(1), &right))
+            {
+                continue;
+            }
+            Range r = input->isAdd() ? Range::add(&left, &right) : Range::sub(&left, &right);
+            bool truncated = ins->isTruncateToInt32();
+            if (!truncated && !r.isFinite())
+                continue;
+
+            MDefinition *lhs = Int32Operand(input->getOperand(0), ins);
+            MDefinition *rhs = Int32Operand(input->getOperand(1), ins);
+            MBinaryArithInstruction *arith;
+            if (input->isAdd()) {
+                MAdd *add = MAdd::New(lhs, rhs, MIRType_Int32);
+                add->setTruncated(truncated);
+                arith = add;
+            } else {
+                MSub *sub = MSub::New(lhs, rhs, MIRType_Int32);
+                sub->setTruncated(truncated);
+                arith = sub;
+            }
+            arith->range()->update(&r);
+            block->insertBefore(ins, arith);
+
+            IonSpew(IonSpew_Range, "Replacing conversion %d by int32 %s %d", ins->id(),
+                    input->isAdd() ? "add" : "sub", arith->id());
+            ins->replaceAllUsesWith(arith);
+        }
+    }
+    return true;
+}
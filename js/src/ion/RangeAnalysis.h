@@ -9,6 +9,8 @@
 #define jsion_range_analysis_h__
 
 #include "wtf/Platform.h"
+#include "BitSet.h"
+#include "IonAllocPolicy.h"
 #include "MIR.h"
 #include "CompileInfo.h"
 
@@ -16,7 +18,9 @@ namespace js {
 namespace ion {
 
 class MBasicBlock;
+class MDefinition;
 class MIRGraph;
+class MPhi;
 
 class RangeAnalysis
 {
@@ -25,14 +29,34 @@ class RangeAnalysis
 	void replaceDominatedUsesWith(MDefinition *orig, MDefinition *dom,
 	                              MBasicBlock *block);
 
+    // Number of times the range of a loop phi may grow before the bounds
+    // which keep growing are widened to infinity.
+    static const uint32 WideningThreshold = 3;
+
+    bool recomputeLoopPhiRange(MPhi *phi);
+    bool narrowLoopPhiRange(MPhi *phi);
+    bool recomputeRange(MDefinition *def, bool narrowing);
+    bool propagate(Vector<MDefinition *, 8, IonAllocPolicy> &worklist, bool narrowing);
+
   protected:
     MIRGraph &graph_;
 
+    // Definitions whose range has been computed at least once.
+    BitSet *computed_;
+
+    // Number of times the range of each loop phi has grown.
+    Vector<uint32, 0, IonAllocPolicy> updates_;
+
   public:
     RangeAnalysis(MIRGraph &graph);
     bool addBetaNobes();
     bool analyze();
     bool removeBetaNobes();
+
+    // Replaces the int32 conversions of double additions and subtractions
+    // of int32 values by int32 operations, which are truncated, or which
+    // cannot overflow according to their range.
+    bool eliminateConversions();
 };
 
 class Range {
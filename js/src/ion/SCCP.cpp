@@ -0,0 +1,560 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Ion.h"
+#include "IonSpewer.h"
+#include "SCCP.h"
+#include "jsnum.h"
+
+using namespace js;
+using namespace js::ion;
+
+// Each definition is lowered at most twice, and is visited again only when
+// one of its operands is lowered, or when a new edge reaches its block. This
+// bound is only a safety net for graphs with many operands per definition.
+static const uint32 MAX_VISITS_PER_DEFINITION = 16;
+
+SCCP::SCCP(MIRGraph &graph, bool foldConstants, bool pruneBranches)
+  : graph_(graph),
+    foldConstants_(foldConstants),
+    pruneBranches_(pruneBranches),
+    maxVisits_(0),
+    numVisits_(0)
+{ }
+
+static inline SCCP::Lattice
+ConstantLattice(const Value &v)
+{
+    SCCP::Lattice lattice;
+    lattice.state = SCCP::Constant;
+    lattice.value = v;
+    return lattice;
+}
+
+static inline SCCP::Lattice
+BottomLattice()
+{
+    SCCP::Lattice lattice;
+    lattice.state = SCCP::Bottom;
+    return lattice;
+}
+
+const SCCP::Lattice &
+SCCP::valueOf(MDefinition *def) const
+{
+    JS_ASSERT(def->id() < values_.length());
+    return values_[def->id()];
+}
+
+bool
+SCCP::isFeasibleSuccessor(MBasicBlock *block, size_t index) const
+{
+    if (!block->isMarked())
+        return false;
+
+    MControlInstruction *ins = block->lastIns();
+    if (!pruneBranches_ || !ins->isTest())
+        return true;
+
+    const Lattice &cond = valueOf(ins->getOperand(0));
+    switch (cond.state) {
+      case Top:
+        return false;
+      case Constant:
+        // The first successor of a test is taken when its condition holds.
+        return ToBoolean(cond.value) == (index == 0);
+      case Bottom:
+        return true;
+    }
+
+    JS_NOT_REACHED("Unexpected lattice state");
+    return true;
+}
+
+bool
+SCCP::isFeasibleEdge(MBasicBlock *pred, MBasicBlock *block) const
+{
+    for (size_t i = 0; i < pred->numSuccessors(); i++) {
+        if (pred->getSuccessor(i) == block && isFeasibleSuccessor(pred, i))
+            return true;
+    }
+    return false;
+}
+
+SCCP::Lattice
+SCCP::evaluatePhi(MPhi *phi) const
+{
+    MBasicBlock *block = phi->block();
+    if (phi->numOperands() != block->numPredecessors())
+        return BottomLattice();
+
+    // Only merge the operands flowing through edges which may be taken.
+    Lattice result;
+    for (size_t i = 0; i < phi->numOperands(); i++) {
+        if (!isFeasibleEdge(block->getPredecessor(i), block))
+            continue;
+
+        const Lattice &input = valueOf(phi->getOperand(i));
+        if (input.state == Top)
+            continue;
+        if (input.state == Bottom)
+            return BottomLattice();
+
+        if (result.state == Top)
+            result = ConstantLattice(input.value);
+        else if (result.value != input.value)
+            return BottomLattice();
+    }
+    return result;
+}
+
+// Compute the value of |def| given the constant values of its operands.
+// Returns false if the definition cannot be folded for these values.
+static bool
+Fold(MDefinition *def, const Value *operands, Value *result)
+{
+    switch (def->op()) {
+      case MDefinition::Op_Unbox:
+        // The unbox would bail out if the value has another type.
+        if (MIRTypeFromValue(operands[0]) != def->type())
+            return false;
+        *result = operands[0];
+        return true;
+
+      case MDefinition::Op_ToDouble:
+        if (!operands[0].isNumber())
+            return false;
+        *result = DoubleValue(operands[0].toNumber());
+        return true;
+
+      case MDefinition::Op_ToInt32:
+        if (!operands[0].isInt32())
+            return false;
+        *result = operands[0];
+        return true;
+
+      case MDefinition::Op_TruncateToInt32:
+        if (!operands[0].isNumber())
+            return false;
+        *result = Int32Value(ToInt32(operands[0].toNumber()));
+        return true;
+
+      case MDefinition::Op_BitNot:
+        if (!operands[0].isInt32())
+            return false;
+        *result = Int32Value(~operands[0].toInt32());
+        return true;
+
+      case MDefinition::Op_Not:
+        *result = BooleanValue(!ToBoolean(operands[0]));
+        return true;
+
+      case MDefinition::Op_TypeOf: {
+        // Objects may have a typeof hook. Compilations off the main thread
+        // have no context to call TypeOfValue with.
+        JSContext *cx = GetIonContext()->cx;
+        if (operands[0].isObject() || !cx)
+            return false;
+        JSType type = TypeOfValue(cx, operands[0]);
+        *result = StringValue(cx->runtime->atomState.typeAtoms[type]);
+        return true;
+      }
+
+      case MDefinition::Op_Add:
+      case MDefinition::Op_Sub:
+      case MDefinition::Op_Mul:
+      case MDefinition::Op_Div:
+      case MDefinition::Op_Mod:
+      case MDefinition::Op_BitAnd:
+      case MDefinition::Op_BitOr:
+      case MDefinition::Op_BitXor:
+      case MDefinition::Op_Lsh:
+      case MDefinition::Op_Rsh:
+      case MDefinition::Op_Ursh:
+        return EvaluateBinaryOperation(static_cast<MBinaryInstruction *>(def),
+                                       operands[0], operands[1], result);
+
+      case MDefinition::Op_Compare: {
+        // Comparing objects may call their valueOf method.
+        if (operands[0].isObject() || operands[1].isObject())
+            return false;
+        bool cond;
+        if (!def->toCompare()->evaluateConstantOperands(operands[0], operands[1], &cond))
+            return false;
+        *result = BooleanValue(cond);
+        return true;
+      }
+
+      default:
+        return false;
+    }
+}
+
+SCCP::Lattice
+SCCP::evaluate(MDefinition *def) const
+{
+    switch (def->op()) {
+      case MDefinition::Op_Constant:
+        return ConstantLattice(def->toConstant()->value());
+      case MDefinition::Op_Phi:
+        return evaluatePhi(def->toPhi());
+      default:
+        break;
+    }
+
+    // Other definitions are folded when all their operands are constants.
+    const size_t MaxOperands = 2;
+    if (def->numOperands() == 0 || def->numOperands() > MaxOperands)
+        return BottomLattice();
+
+    Value operands[MaxOperands];
+    bool unknown = false;
+    for (size_t i = 0; i < def->numOperands(); i++) {
+        const Lattice &input = valueOf(def->getOperand(i));
+        if (input.state == Bottom || (input.state == Constant && input.value.isMagic()))
+            return BottomLattice();
+        if (input.state == Top)
+            unknown = true;
+        else
+            operands[i] = input.value;
+    }
+    if (unknown)
+        return Lattice();
+
+    Value result;
+    if (!Fold(def, operands, &result))
+        return BottomLattice();
+    return ConstantLattice(result);
+}
+
+bool
+SCCP::markExecutable(MBasicBlock *block)
+{
+    JS_ASSERT(!block->isMarked());
+    block->mark();
+    return blockWorklist_.append(block);
+}
+
+bool
+SCCP::visitControl(MControlInstruction *ins)
+{
+    MBasicBlock *block = ins->block();
+    for (size_t i = 0; i < ins->numSuccessors(); i++) {
+        if (!isFeasibleSuccessor(block, i))
+            continue;
+
+        MBasicBlock *succ = ins->getSuccessor(i);
+        if (!succ->isMarked()) {
+            if (!markExecutable(succ))
+                return false;
+            continue;
+        }
+
+        // The block has already been visited, but its phis may now merge one
+        // more operand.
+        for (MPhiIterator phi(succ->phisBegin()); phi != succ->phisEnd(); phi++) {
+            if (!visitDefinition(*phi))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool
+SCCP::visitDefinition(MDefinition *def)
+{
+    numVisits_++;
+
+    if (def->isControlInstruction())
+        return visitControl(static_cast<MControlInstruction *>(def));
+
+    Lattice result = evaluate(def);
+    Lattice &current = values_[def->id()];
+
+    // Values can only go down the lattice.
+    if (result.state <= current.state) {
+        if (result.state != Constant || current.state != Constant || result.value == current.value)
+            return true;
+        result = BottomLattice();
+    }
+
+    current.state = result.state;
+    current.value = result.value;
+
+    if (IonSpewEnabled(IonSpew_CP)) {
+        IonSpewHeader(IonSpew_CP);
+        def->printName(IonSpewFile);
+        fprintf(IonSpewFile, " is %s\n", current.state == Constant ? "constant" : "not constant");
+    }
+
+    if (def->isInWorklist())
+        return true;
+    def->setInWorklist();
+    return defWorklist_.append(def);
+}
+
+bool
+SCCP::visitBlock(MBasicBlock *block)
+{
+    for (MPhiIterator phi(block->phisBegin()); phi != block->phisEnd(); phi++) {
+        if (!visitDefinition(*phi))
+            return false;
+    }
+    for (MInstructionIterator ins(block->begin()); ins != block->end(); ins++) {
+        if (!visitDefinition(*ins))
+            return false;
+    }
+    return true;
+}
+
+bool
+SCCP::visitUses(MDefinition *def)
+{
+    for (MUseIterator use(def->usesBegin()); use != def->usesEnd(); use++) {
+        // Resume points do not compute anything.
+        if (!use->node()->isDefinition())
+            continue;
+
+        MDefinition *user = use->node()->toDefinition();
+        if (user->block()->isMarked() && !visitDefinition(user))
+            return false;
+    }
+    return true;
+}
+
+bool
+SCCP::propagate()
+{
+    while (!blockWorklist_.empty() || !defWorklist_.empty()) {
+        if (numVisits_ > maxVisits_)
+            return true;
+
+        // Visit new blocks first, so that the definitions they contain are
+        // evaluated before their uses in other blocks.
+        if (!blockWorklist_.empty()) {
+            if (!visitBlock(blockWorklist_.popCopy()))
+                return false;
+            continue;
+        }
+
+        MDefinition *def = defWorklist_.popCopy();
+        def->setNotInWorklist();
+        if (!visitUses(def))
+            return false;
+    }
+    return true;
+}
+
+void
+SCCP::removeInfeasibleEdges()
+{
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        if (!block->isMarked())
+            continue;
+
+        // The loop body never goes back to the header.
+        if (block->isLoopHeader() && !isFeasibleEdge(block->backedge(), *block)) {
+            IonSpew(IonSpew_DCEC, "Block %d is no longer a loop header", block->id());
+            block->clearLoopHeader();
+        }
+
+        for (size_t i = block->numPredecessors(); i > 0; i--) {
+            MBasicBlock *pred = block->getPredecessor(i - 1);
+            if (isFeasibleEdge(pred, *block))
+                continue;
+
+            IonSpew(IonSpew_DCEC, "Removing edge from block %d to block %d",
+                    pred->id(), block->id());
+
+            for (MPhiIterator phi(block->phisBegin()); phi != block->phisEnd(); phi++) {
+                JS_ASSERT(phi->numOperands() == block->numPredecessors());
+                phi->removeOperand(i - 1);
+            }
+            block->removePredecessor(i - 1);
+        }
+    }
+
+    // The edges are gone, tests on constant conditions can be replaced. This
+    // is done after all edges have been removed, as removing them requires
+    // the tests to find out which of them are taken.
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        if (!block->isMarked() || !block->lastIns()->isTest())
+            continue;
+
+        MTest *test = block->lastIns()->toTest();
+        const Lattice &cond = valueOf(test->getOperand(0));
+        JS_ASSERT(cond.state != Top);
+        if (cond.state != Constant)
+            continue;
+
+        MBasicBlock *target = ToBoolean(cond.value) ? test->ifTrue() : test->ifFalse();
+        IonSpew(IonSpew_DCEC, "Block %d always branches to block %d", block->id(), target->id());
+
+        block->discardLastIns();
+        block->end(MGoto::New(target));
+    }
+}
+
+static void
+DiscardResumePointOperands(MResumePoint *resumePoint)
+{
+    for (size_t i = 0; i < resumePoint->numOperands(); i++) {
+        if (resumePoint->getOperand(i))
+            resumePoint->replaceOperand(i, NULL);
+    }
+}
+
+void
+SCCP::foldConstants()
+{
+    uint32 numFolded = 0;
+
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        if (!block->isMarked())
+            continue;
+
+        // Instructions cannot be placed between phis, constants replacing
+        // phis go at the beginning of the block.
+        for (MPhiIterator phi(block->phisBegin()); phi != block->phisEnd(); ) {
+            Lattice &value = values_[phi->id()];
+            if (value.state != Constant) {
+                phi++;
+                continue;
+            }
+
+            MConstant *constant = MConstant::New(value.value);
+            block->insertBefore(*block->begin(), constant);
+            phi->replaceAllUsesWith(constant);
+            value.replacement = constant;
+            phi = block->discardPhiAt(phi);
+            numFolded++;
+        }
+
+        for (MInstructionIterator ins(block->begin()); ins != block->end(); ) {
+            // Constants inserted above have no lattice value.
+            if (ins->isConstant() || ins->isControlInstruction()) {
+                ins++;
+                continue;
+            }
+
+            // Untyped definitions are kept, their uses expect boxed values.
+            Lattice &value = values_[ins->id()];
+            if (value.state != Constant || MIRTypeFromValue(value.value) != ins->type()) {
+                ins++;
+                continue;
+            }
+
+            MConstant *constant = MConstant::New(value.value);
+            block->insertBefore(*ins, constant);
+            ins->replaceAllUsesWith(constant);
+            value.replacement = constant;
+            if (ins->resumePoint())
+                DiscardResumePointOperands(ins->resumePoint());
+            ins = block->discardAt(ins);
+            numFolded++;
+        }
+    }
+
+    // Blocks created later on, e.g. when splitting critical edges, inherit
+    // the slots of their predecessor.
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        if (!block->isMarked())
+            continue;
+
+        for (uint32 i = 0; i < block->stackDepth(); i++) {
+            MDefinition *def = block->getSlot(i);
+            if (def && def->id() < values_.length() && values_[def->id()].replacement)
+                block->rewriteSlot(i, values_[def->id()].replacement);
+        }
+    }
+
+    IonSpew(IonSpew_CP, "%u definitions folded to constants", numFolded);
+}
+
+void
+SCCP::removeUnreachableBlocks()
+{
+    // Unreachable definitions may use each other, unlink all their operands
+    // before removing any block.
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); block++) {
+        if (block->isMarked())
+            continue;
+
+        for (MPhiIterator phi(block->phisBegin()); phi != block->phisEnd(); )
+            phi = block->discardPhiAt(phi);
+
+        for (MInstructionIterator ins(block->begin()); ins != block->end(); ) {
+            if (ins->resumePoint())
+                DiscardResumePointOperands(ins->resumePoint());
+            ins = block->discardAt(ins);
+        }
+        DiscardResumePointOperands(block->entryResumePoint());
+    }
+
+    for (MBasicBlockIterator block(graph_.begin()); block != graph_.end(); ) {
+        MBasicBlock *current = *block;
+        block++;
+        if (current->isMarked())
+            continue;
+
+        IonSpew(IonSpew_DCEC, "Removing unreachable block %d", current->id());
+        graph_.removeBlock(current);
+    }
+}
+
+void
+SCCP::reset()
+{
+    for (size_t i = 0; i < defWorklist_.length(); i++)
+        defWorklist_[i]->setNotInWorklist();
+    defWorklist_.clear();
+    blockWorklist_.clear();
+    graph_.unmarkBlocks();
+}
+
+bool
+SCCP::analyze()
+{
+    IonSpew(IonSpew_CP, "Beginning SCCP pass.");
+
+    // Definition ids are allocated two by two.
+    uint32 numIds = graph_.getMaxInstructionId() + 1;
+    if (!values_.growBy(numIds))
+        return false;
+    maxVisits_ = MAX_VISITS_PER_DEFINITION * (numIds / 2 + graph_.numBlockIds());
+
+    graph_.unmarkBlocks();
+
+    // Both the entry block and the OSR block are executed.
+    if (!markExecutable(*graph_.begin()))
+        return false;
+    if (graph_.osrBlock() && !markExecutable(graph_.osrBlock()))
+        return false;
+
+    if (!propagate())
+        return false;
+
+    if (numVisits_ > maxVisits_) {
+        IonSpew(IonSpew_CP, "Giving up after %u visits", numVisits_);
+        reset();
+        return true;
+    }
+
+    JS_ASSERT(defWorklist_.empty());
+
+    if (pruneBranches_)
+        removeInfeasibleEdges();
+    if (foldConstants_)
+        foldConstants();
+    if (pruneBranches_)
+        removeUnreachableBlocks();
+
+    reset();
+
+    IonSpew(IonSpew_CP, "SCCP done after %u visits", numVisits_);
+    return true;
+}
@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+ * vim: set ts=4 sw=4 et tw=99:
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef jsion_sccp_h__
+#define jsion_sccp_h__
+
+#include "ion/IonAllocPolicy.h"
+#include "ion/MIR.h"
+#include "ion/MIRGraph.h"
+
+// This file represents the Sparse Conditional Constant Propagation pass.
+
+namespace js {
+namespace ion {
+
+// Sparse conditional constant propagation, after Wegman and Zadeck.
+//
+// Definitions are evaluated optimistically: every definition starts at Top and
+// can only be lowered to a constant, and then to Bottom. Blocks are only
+// visited once an edge leading to them is known to be taken, and phis only
+// merge the operands flowing through such edges. This way, constants found in
+// a condition prune the branch which is not taken, and the constants of the
+// branch which is taken reach the code after it in the same run.
+//
+// Once the worklists are empty, definitions which are constant are replaced by
+// MConstants, tests on constant conditions become gotos, and the blocks which
+// were never reached are removed along with the phi operands they provide.
+class SCCP
+{
+  public:
+    enum State {
+        // Not evaluated yet, or only computed from definitions at Top.
+        Top,
+        Constant,
+        // Not known to be a constant.
+        Bottom
+    };
+
+    struct Lattice
+    {
+        State state;
+        Value value;
+
+        // The MConstant which has replaced the definition, if any.
+        MConstant *replacement;
+
+        Lattice()
+          : state(Top),
+            value(UndefinedValue()),
+            replacement(NULL)
+        { }
+    };
+
+  private:
+    MIRGraph &graph_;
+
+    // Whether constant definitions are replaced by MConstants.
+    bool foldConstants_;
+
+    // Whether tests are considered to only take the branch matching their
+    // condition, and the branches which are never taken are removed.
+    bool pruneBranches_;
+
+    // Lattice values, indexed by definition id.
+    Vector<Lattice, 0, IonAllocPolicy> values_;
+
+    Vector<MDefinition *, 16, IonAllocPolicy> defWorklist_;
+    Vector<MBasicBlock *, 8, IonAllocPolicy> blockWorklist_;
+
+    // The pass gives up, leaving the graph untouched, if definitions are
+    // visited more than this many times.
+    uint32 maxVisits_;
+    uint32 numVisits_;
+
+    const Lattice &valueOf(MDefinition *def) const;
+    bool isFeasibleSuccessor(MBasicBlock *block, size_t index) const;
+    bool isFeasibleEdge(MBasicBlock *pred, MBasicBlock *block) const;
+
+    Lattice evaluate(MDefinition *def) const;
+    Lattice evaluatePhi(MPhi *phi) const;
+
+    bool markExecutable(MBasicBlock *block);
+    bool visitDefinition(MDefinition *def);
+    bool visitControl(MControlInstruction *ins);
+    bool visitBlock(MBasicBlock *block);
+    bool visitUses(MDefinition *def);
+    bool propagate();
+
+    void removeInfeasibleEdges();
+    void foldConstants();
+    void removeUnreachableBlocks();
+    void reset();
+
+  public:
+    SCCP(MIRGraph &graph, bool foldConstants, bool pruneBranches);
+    bool analyze();
+};
+
+} // namespace ion
+} // namespace js
+
+#endif // jsion_sccp_h__
@@ -68,7 +68,8 @@ class SnapshotReader
         UNTYPED,            // Type is not known.
         JS_UNDEFINED,       // UndefinedValue()
         JS_NULL,            // NullValue()
-        JS_INT32            // Int32Value(n)
+        JS_INT32,           // Int32Value(n)
+        MATERIALIZED        // An object to allocate from a template.
     };
 
     class Location
@@ -128,6 +129,13 @@ class SnapshotReader
             } unknown_type_;
 #endif
             int32 value_;
+            struct {
+                uint32 number;
+                uint32 templateIndex;
+                uint32 nfields;
+                const uint8 *fields;
+                const uint8 *fieldsEnd;
+            } object_;
         };
 
         Slot(SlotMode mode, JSValueType type, const Location &loc)
@@ -179,6 +187,27 @@ class SnapshotReader
             JS_ASSERT(mode() == TYPED_STACK);
             return known_type_.payload.stackSlot();
         }
+
+        // Number of the object in the snapshot, shared by all the slots
+        // holding it.
+        uint32 objectNumber() const {
+            JS_ASSERT(mode() == MATERIALIZED);
+            return object_.number;
+        }
+        uint32 templateIndex() const {
+            JS_ASSERT(mode() == MATERIALIZED);
+            return object_.templateIndex;
+        }
+        uint32 numFields() const {
+            JS_ASSERT(mode() == MATERIALIZED);
+            return object_.nfields;
+        }
+
+        // Reads the slots giving the values of the fields of the object.
+        CompactBufferReader fieldsReader() const {
+            JS_ASSERT(mode() == MATERIALIZED);
+            return CompactBufferReader(object_.fields, object_.fieldsEnd);
+        }
 #if defined(JS_NUNBOX32)
         Location payload() const {
             JS_ASSERT(mode() == UNTYPED);
@@ -196,6 +225,10 @@ class SnapshotReader
 #endif
     };
 
+  protected:
+    // Decodes a slot, or a field of a materialized object, from |reader|.
+    static Slot ReadSlot(CompactBufferReader &reader);
+
   public:
     SnapshotReader(const uint8 *buffer, const uint8 *end);
 
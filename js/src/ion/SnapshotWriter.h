@@ -23,6 +23,10 @@ class SnapshotWriter
 {
     CompactBufferWriter writer_;
 
+    // Number of slots still to be written for the fields of a materialized
+    // object, which do not count as slots of the frame.
+    uint32 nestedSlots_;
+
     // These are only used to assert sanity.
     uint32 nslots_;
     uint32 slotsWritten_;
@@ -48,6 +52,7 @@ class SnapshotWriter
     void addNullSlot();
     void addInt32Slot(int32 value);
     void addConstantPoolSlot(uint32 index);
+    void addMaterializedObjectSlot(uint32 objectNumber, uint32 templateIndex, uint32 nfields);
 #if defined(JS_NUNBOX32)
     void addSlot(const Register &type, const Register &payload);
     void addSlot(const Register &type, int32 payloadStackIndex);
@@ -74,6 +74,14 @@ using namespace js::ion;
 //              [vwu] reg2 (0-29)
 //              [vwu] reg2 (31) [vws] stack index
 //
+//         JSVAL_TYPE_MAGIC: (reg value is 31)
+//              An object which escape analysis removed, allocated from a
+//              template when bailing out. Followed by:
+//              [vwu] number of the object in the snapshot
+//              [vwu] index of the template object in ionScript->constants()
+//              [vwu] number of fields F
+//            [slot*] F slot entries, the values of the fields
+//
 //         JSVAL_TYPE_MAGIC:
 //              The type is not statically known. The meaning of this depends
 //              on the boxing style.
@@ -195,7 +203,13 @@ SnapshotReader::readSlot()
     IonSpew(IonSpew_Snapshots, "Reading slot %u", slotsRead_);
     slotsRead_++;
 
-    uint8 b = reader_.readByte();
+    return ReadSlot(reader_);
+}
+
+SnapshotReader::Slot
+SnapshotReader::ReadSlot(CompactBufferReader &reader)
+{
+    uint8 b = reader.readByte();
 
     JSValueType type = JSValueType(b & 0x7);
     uint32 code = b >> 3;
@@ -204,7 +218,7 @@ SnapshotReader::readSlot()
       case JSVAL_TYPE_DOUBLE:
         if (code != FloatRegisters::Invalid)
             return Slot(FloatRegister::FromCode(code));
-        return Slot(TYPED_STACK, type, Location::From(reader_.readSigned()));
+        return Slot(TYPED_STACK, type, Location::From(reader.readSigned()));
 
       case JSVAL_TYPE_INT32:
       case JSVAL_TYPE_STRING:
@@ -212,33 +226,45 @@ SnapshotReader::readSlot()
       case JSVAL_TYPE_BOOLEAN:
         if (code != Registers::Invalid)
             return Slot(TYPED_REG, type, Location::From(Register::FromCode(code)));
-        return Slot(TYPED_STACK, type, Location::From(reader_.readSigned()));
+        return Slot(TYPED_STACK, type, Location::From(reader.readSigned()));
 
       case JSVAL_TYPE_NULL:
         if (code == ESC_REG_FIELD_CONST)
             return Slot(JS_NULL);
         if (code == ESC_REG_FIELD_INDEX)
-            return Slot(JS_INT32, reader_.readSigned());
+            return Slot(JS_INT32, reader.readSigned());
         return Slot(JS_INT32, code);
 
       case JSVAL_TYPE_UNDEFINED:
         if (code == ESC_REG_FIELD_CONST)
             return Slot(JS_UNDEFINED);
         if (code == ESC_REG_FIELD_INDEX)
-            return Slot(CONSTANT, reader_.readUnsigned());
+            return Slot(CONSTANT, reader.readUnsigned());
         return Slot(CONSTANT, code);
 
       default:
       {
         JS_ASSERT(type == JSVAL_TYPE_MAGIC);
 
+        if (code == ESC_REG_FIELD_INDEX) {
+            Slot slot(MATERIALIZED);
+            slot.object_.number = reader.readUnsigned();
+            slot.object_.templateIndex = reader.readUnsigned();
+            slot.object_.nfields = reader.readUnsigned();
+            slot.object_.fields = reader.currentPosition();
+            for (uint32 i = 0; i < slot.object_.nfields; i++)
+                JS_ALWAYS_TRUE(ReadSlot(reader).mode() != MATERIALIZED);
+            slot.object_.fieldsEnd = reader.currentPosition();
+            return slot;
+        }
+
         if (code == ESC_REG_FIELD_CONST) {
-            uint8 reg2 = reader_.readUnsigned();
+            uint8 reg2 = reader.readUnsigned();
             Location loc;
             if (reg2 != ESC_REG_FIELD_INDEX)
                 loc = Location::From(Register::FromCode(reg2));
             else
-                loc = Location::From(reader_.readSigned());
+                loc = Location::From(reader.readSigned());
             return Slot(TYPED_REG, type, loc);
         }
 
@@ -246,28 +272,28 @@ SnapshotReader::readSlot()
 #ifdef JS_NUNBOX32
         switch (code) {
           case NUNBOX32_STACK_STACK:
-            slot.unknown_type_.type = Location::From(reader_.readSigned());
-            slot.unknown_type_.payload = Location::From(reader_.readSigned());
+            slot.unknown_type_.type = Location::From(reader.readSigned());
+            slot.unknown_type_.payload = Location::From(reader.readSigned());
             return slot;
           case NUNBOX32_STACK_REG:
-            slot.unknown_type_.type = Location::From(reader_.readSigned());
-            slot.unknown_type_.payload = Location::From(Register::FromCode(reader_.readByte()));
+            slot.unknown_type_.type = Location::From(reader.readSigned());
+            slot.unknown_type_.payload = Location::From(Register::FromCode(reader.readByte()));
             return slot;
           case NUNBOX32_REG_STACK:
-            slot.unknown_type_.type = Location::From(Register::FromCode(reader_.readByte()));
-            slot.unknown_type_.payload = Location::From(reader_.readSigned());
+            slot.unknown_type_.type = Location::From(Register::FromCode(reader.readByte()));
+            slot.unknown_type_.payload = Location::From(reader.readSigned());
             return slot;
           default:
             JS_ASSERT(code == NUNBOX32_REG_REG);
-            slot.unknown_type_.type = Location::From(Register::FromCode(reader_.readByte()));
-            slot.unknown_type_.payload = Location::From(Register::FromCode(reader_.readByte()));
+            slot.unknown_type_.type = Location::From(Register::FromCode(reader.readByte()));
+            slot.unknown_type_.payload = Location::From(Register::FromCode(reader.readByte()));
             return slot;
         }
 #elif JS_PUNBOX64
         if (code != Registers::Invalid)
             slot.unknown_type_.value = Location::From(Register::FromCode(code));
         else
-            slot.unknown_type_.value = Location::From(reader_.readSigned());
+            slot.unknown_type_.value = Location::From(reader.readSigned());
         return slot;
 #endif
       }
@@ -291,6 +317,8 @@ SnapshotWriter::startSnapshot(uint32 frameCount, BailoutKind kind, bool resumeAf
     JS_ASSERT(frameCount < (1 << BAILOUT_FRAMECOUNT_BITS));
     JS_ASSERT(uint32(kind) < (1 << BAILOUT_KIND_BITS));
 
+    nestedSlots_ = 0;
+
     uint32 bits = (uint32(kind) << BAILOUT_KIND_SHIFT) |
                   (frameCount << BAILOUT_FRAMECOUNT_SHIFT);
     if (resumeAfter)
@@ -364,6 +392,11 @@ SnapshotWriter::writeSlotHeader(JSValueType type, uint32 regCode)
     uint8 byte = uint32(type) | (regCode << 3);
     writer_.writeByte(byte);
 
+    if (nestedSlots_) {
+        nestedSlots_--;
+        return;
+    }
+
     slotsWritten_++;
     JS_ASSERT(slotsWritten_ <= nslots_);
 }
@@ -541,3 +574,19 @@ SnapshotWriter::addConstantPoolSlot(uint32 index)
     }
 }
 
+void
+SnapshotWriter::addMaterializedObjectSlot(uint32 objectNumber, uint32 templateIndex,
+                                          uint32 nfields)
+{
+    IonSpew(IonSpew_Snapshots, "    slot %u: object %u (template %u, %u fields)",
+            slotsWritten_, objectNumber, templateIndex, nfields);
+
+    // Fields are never materialized objects themselves.
+    JS_ASSERT(!nestedSlots_);
+
+    writeSlotHeader(JSVAL_TYPE_MAGIC, ESC_REG_FIELD_INDEX);
+    writer_.writeUnsigned(objectNumber);
+    writer_.writeUnsigned(templateIndex);
+    writer_.writeUnsigned(nfields);
+    nestedSlots_ = nfields;
+}
@@ -425,6 +425,16 @@ TypeInferenceOracle::elementWriteIsPacked(JSScript *script, jsbytecode *pc)
     return !types->hasObjectFlags(cx, types::OBJECT_FLAG_NON_PACKED_ARRAY);
 }
 
+bool
+TypeInferenceOracle::elementWriteIsCacheable(JSScript *script, jsbytecode *pc)
+{
+    MIRType obj = getMIRType(script->analysis()->poppedTypes(pc, 2));
+    MIRType id = getMIRType(script->analysis()->poppedTypes(pc, 1));
+
+    return obj == MIRType_Object &&
+           (id == MIRType_Value || id == MIRType_Int32 || id == MIRType_String);
+}
+
 bool
 TypeInferenceOracle::setElementHasWrittenHoles(JSScript *script, jsbytecode *pc)
 {
@@ -123,6 +123,9 @@ class TypeOracle
     virtual bool elementWriteIsPacked(JSScript *script, jsbytecode *pc) {
         return false;
     }
+    virtual bool elementWriteIsCacheable(JSScript *script, jsbytecode *pc) {
+        return false;
+    }
     virtual bool propertyWriteCanSpecialize(JSScript *script, jsbytecode *pc) {
         return true;
     }
@@ -248,6 +251,7 @@ class TypeInferenceOracle : public TypeOracle
     bool elementWriteIsDenseArray(JSScript *script, jsbytecode *pc);
     bool elementWriteIsTypedArray(JSScript *script, jsbytecode *pc, int *arrayType);
     bool elementWriteIsPacked(JSScript *script, jsbytecode *pc);
+    bool elementWriteIsCacheable(JSScript *script, jsbytecode *pc);
     bool setElementHasWrittenHoles(JSScript *script, jsbytecode *pc);
     bool propertyWriteCanSpecialize(JSScript *script, jsbytecode *pc);
     bool propertyWriteNeedsBarrier(JSScript *script, jsbytecode *pc, jsid id);
@@ -219,6 +219,7 @@ GenerateBailoutTail(MacroAssembler &masm)
     Label osr;
     Label recompile;
     Label boundsCheck;
+    Label paramCheck;
 
     // The return value from Bailout is tagged as:
     // - 0x0: done (thunk to interpreter)
@@ -229,6 +230,7 @@ GenerateBailoutTail(MacroAssembler &masm)
     // - 0x5: recompile to inline calls
     // - 0x6: bounds check failure
     // - 0x7: force invalidation
+    // - 0x8: parameter check failure
 
     masm.ma_cmp(r0, Imm32(BAILOUT_RETURN_FATAL_ERROR));
     masm.ma_b(&interpret, Assembler::LessThan);
@@ -240,6 +242,7 @@ GenerateBailoutTail(MacroAssembler &masm)
 
     masm.ma_cmp(r0, Imm32(BAILOUT_RETURN_INVALIDATE));
     masm.ma_b(&boundsCheck, Assembler::LessThan);
+    masm.ma_b(&paramCheck, Assembler::GreaterThan);
 
     // Force invalidation.
     {
@@ -252,6 +255,18 @@ GenerateBailoutTail(MacroAssembler &masm)
         masm.ma_b(&interpret);
     }
 
+    // Parameter check failure.
+    masm.bind(&paramCheck);
+    {
+        masm.setupAlignedABICall(0);
+        masm.callWithABI(JS_FUNC_TO_DATA_PTR(void *, ParameterCheckFailure));
+
+        masm.ma_cmp(r0, Imm32(0));
+        masm.ma_b(&exception, Assembler::Equal);
+
+        masm.ma_b(&interpret);
+    }
+
     // Bounds check failure.
     masm.bind(&boundsCheck);
     {
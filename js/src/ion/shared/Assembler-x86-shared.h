@@ -1058,6 +1058,93 @@ class AssemblerX86Shared
     void andpd(const FloatRegister &src, const FloatRegister &dest) {
         masm.andpd_rr(src.code(), dest.code());
     }
+    void movups(const Operand &src, const FloatRegister &dest) {
+        switch (src.kind()) {
+          case Operand::SCALE:
+            masm.movups_mr(src.disp(), src.base(), src.index(), src.scale(), dest.code());
+            break;
+          default:
+            JS_NOT_REACHED("unexpected operand kind");
+        }
+    }
+    void movups(const FloatRegister &src, const Operand &dest) {
+        switch (dest.kind()) {
+          case Operand::SCALE:
+            masm.movups_rm(src.code(), dest.disp(), dest.base(), dest.index(), dest.scale());
+            break;
+          default:
+            JS_NOT_REACHED("unexpected operand kind");
+        }
+    }
+    void movupd(const Operand &src, const FloatRegister &dest) {
+        switch (src.kind()) {
+          case Operand::SCALE:
+            masm.movupd_mr(src.disp(), src.base(), src.index(), src.scale(), dest.code());
+            break;
+          default:
+            JS_NOT_REACHED("unexpected operand kind");
+        }
+    }
+    void movupd(const FloatRegister &src, const Operand &dest) {
+        switch (dest.kind()) {
+          case Operand::SCALE:
+            masm.movupd_rm(src.code(), dest.disp(), dest.base(), dest.index(), dest.scale());
+            break;
+          default:
+            JS_NOT_REACHED("unexpected operand kind");
+        }
+    }
+    void movdqu(const Operand &src, const FloatRegister &dest) {
+        switch (src.kind()) {
+          case Operand::SCALE:
+            masm.movdqu_mr(src.disp(), src.base(), src.index(), src.scale(), dest.code());
+            break;
+          default:
+            JS_NOT_REACHED("unexpected operand kind");
+        }
+    }
+    void movdqu(const FloatRegister &src, const Operand &dest) {
+        switch (dest.kind()) {
+          case Operand::SCALE:
+            masm.movdqu_rm(src.code(), dest.disp(), dest.base(), dest.index(), dest.scale());
+            break;
+          default:
+            JS_NOT_REACHED("unexpected operand kind");
+        }
+    }
+    void movaps(const FloatRegister &src, const FloatRegister &dest) {
+        masm.movaps_rr(src.code(), dest.code());
+    }
+    void addps(const FloatRegister &src, const FloatRegister &dest) {
+        masm.addps_rr(src.code(), dest.code());
+    }
+    void subps(const FloatRegister &src, const FloatRegister &dest) {
+        masm.subps_rr(src.code(), dest.code());
+    }
+    void mulps(const FloatRegister &src, const FloatRegister &dest) {
+        masm.mulps_rr(src.code(), dest.code());
+    }
+    void addpd(const FloatRegister &src, const FloatRegister &dest) {
+        masm.addpd_rr(src.code(), dest.code());
+    }
+    void subpd(const FloatRegister &src, const FloatRegister &dest) {
+        masm.subpd_rr(src.code(), dest.code());
+    }
+    void mulpd(const FloatRegister &src, const FloatRegister &dest) {
+        masm.mulpd_rr(src.code(), dest.code());
+    }
+    void paddd(const FloatRegister &src, const FloatRegister &dest) {
+        masm.paddd_rr(src.code(), dest.code());
+    }
+    void psubd(const FloatRegister &src, const FloatRegister &dest) {
+        masm.psubd_rr(src.code(), dest.code());
+    }
+    void unpcklpd(const FloatRegister &src, const FloatRegister &dest) {
+        masm.unpcklpd_rr(src.code(), dest.code());
+    }
+    void pshufd(uint32_t mask, const FloatRegister &src, const FloatRegister &dest) {
+        masm.pshufd_irr(mask, src.code(), dest.code());
+    }
     void sqrtsd(const FloatRegister &src, const FloatRegister &dest) {
         masm.sqrtsd_rr(src.code(), dest.code());
     }
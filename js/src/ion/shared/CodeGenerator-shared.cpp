@@ -66,6 +66,120 @@ ToStackIndex(LAllocation *a)
     return -a->toArgument()->index();
 }
 
+bool
+CodeGeneratorShared::encodeSlot(LSnapshot *snapshot, MDefinition *mir, uint32 i)
+{
+    if (mir->isPassArg())
+        mir = mir->toPassArg()->getArgument();
+    JS_ASSERT(!mir->isPassArg());
+
+    MIRType type = mir->isUnused()
+                   ? MIRType_Undefined
+                   : mir->type();
+
+    switch (type) {
+      case MIRType_Undefined:
+        snapshots_.addUndefinedSlot();
+        break;
+      case MIRType_Null:
+        snapshots_.addNullSlot();
+        break;
+      case MIRType_Int32:
+      case MIRType_String:
+      case MIRType_Object:
+      case MIRType_Boolean:
+      case MIRType_Double:
+      {
+        LAllocation *payload = snapshot->payloadOfSlot(i);
+        JSValueType type = ValueTypeFromMIRType(mir->type());
+        if (payload->isMemory()) {
+            snapshots_.addSlot(type, ToStackIndex(payload));
+        } else if (payload->isGeneralReg()) {
+            snapshots_.addSlot(type, ToRegister(payload));
+        } else if (payload->isFloatReg()) {
+            snapshots_.addSlot(ToFloatRegister(payload));
+        } else {
+            MConstant *constant = mir->toConstant();
+            const Value &v = constant->value();
+
+            // Don't bother with the constant pool for smallish integers.
+            if (v.isInt32() && v.toInt32() >= -32 && v.toInt32() <= 32) {
+                snapshots_.addInt32Slot(v.toInt32());
+            } else {
+                uint32 index;
+                if (!graph.addConstantToPool(constant->value(), &index))
+                    return false;
+                snapshots_.addConstantPoolSlot(index);
+            }
+        }
+        break;
+      }
+      case MIRType_Magic:
+      {
+        uint32 index;
+        if (!graph.addConstantToPool(MagicValue(JS_OPTIMIZED_ARGUMENTS), &index))
+            return false;
+        snapshots_.addConstantPoolSlot(index);
+        break;
+      }
+      default:
+      {
+        JS_ASSERT(mir->type() == MIRType_Value);
+        LAllocation *payload = snapshot->payloadOfSlot(i);
+#ifdef JS_NUNBOX32
+        LAllocation *type = snapshot->typeOfSlot(i);
+        if (type->isRegister()) {
+            if (payload->isRegister())
+                snapshots_.addSlot(ToRegister(type), ToRegister(payload));
+            else
+                snapshots_.addSlot(ToRegister(type), ToStackIndex(payload));
+        } else {
+            if (payload->isRegister())
+                snapshots_.addSlot(ToStackIndex(type), ToRegister(payload));
+            else
+                snapshots_.addSlot(ToStackIndex(type), ToStackIndex(payload));
+        }
+#elif JS_PUNBOX64
+        if (payload->isRegister())
+            snapshots_.addSlot(ToRegister(payload));
+        else
+            snapshots_.addSlot(ToStackIndex(payload));
+#endif
+        break;
+      }
+    }
+    return true;
+}
+
+// The first state of an allocation met in a snapshot gives it a number, by
+// which the other references of the snapshot to the allocation designate it.
+// All of them record the operands, as the bailout may skip some slots.
+bool
+CodeGeneratorShared::encodeObjectState(LSnapshot *snapshot, MObjectState *state, uint32 *index)
+{
+    uint32 objectNumber = 0;
+    while (objectNumber < snapshotObjects_.length() &&
+           snapshotObjects_[objectNumber] != state->objectId())
+    {
+        objectNumber++;
+    }
+    if (objectNumber == snapshotObjects_.length() && !snapshotObjects_.append(state->objectId()))
+        return false;
+
+    uint32 templateIndex;
+    if (!graph.addConstantToPool(ObjectValue(*state->templateObject()), &templateIndex))
+        return false;
+
+    snapshots_.addMaterializedObjectSlot(objectNumber, templateIndex, state->numOperands());
+    (*index)++;
+
+    for (size_t i = 0; i < state->numOperands(); i++) {
+        if (!encodeSlot(snapshot, state->getOperand(i), (*index)++))
+            return false;
+    }
+    return true;
+}
+
 bool
 CodeGeneratorShared::encodeSlots(LSnapshot *snapshot, MResumePoint *resumePoint,
                                  uint32 *startIndex)
@@ -73,91 +187,18 @@ CodeGeneratorShared::encodeSlots(LSnapshot *snapshot, MResumePoint *resumePoint,
     IonSpew(IonSpew_Codegen, "Encoding %u of resume point %p's operands starting from %u",
             resumePoint->numOperands(), (void *) resumePoint, *startIndex);
     for (uint32 slotno = 0; slotno < resumePoint->numOperands(); slotno++) {
-        uint32 i = slotno + *startIndex;
         MDefinition *mir = resumePoint->getOperand(slotno);
 
-        if (mir->isPassArg())
-            mir = mir->toPassArg()->getArgument();
-        JS_ASSERT(!mir->isPassArg());
-
-        MIRType type = mir->isUnused()
-                       ? MIRType_Undefined
-                       : mir->type();
-
-        switch (type) {
-          case MIRType_Undefined:
-            snapshots_.addUndefinedSlot();
-            break;
-          case MIRType_Null:
-            snapshots_.addNullSlot();
-            break;
-          case MIRType_Int32:
-          case MIRType_String:
-          case MIRType_Object:
-          case MIRType_Boolean:
-          case MIRType_Double:
-          {
-            LAllocation *payload = snapshot->payloadOfSlot(i);
-            JSValueType type = ValueTypeFromMIRType(mir->type());
-            if (payload->isMemory()) {
-                snapshots_.addSlot(type, ToStackIndex(payload));
-            } else if (payload->isGeneralReg()) {
-                snapshots_.addSlot(type, ToRegister(payload));
-            } else if (payload->isFloatReg()) {
-                snapshots_.addSlot(ToFloatRegister(payload));
-            } else {
-                MConstant *constant = mir->toConstant();
-                const Value &v = constant->value();
-
-                // Don't bother with the constant pool for smallish integers.
-                if (v.isInt32() && v.toInt32() >= -32 && v.toInt32() <= 32) {
-                    snapshots_.addInt32Slot(v.toInt32());
-                } else {
-                    uint32 index;
-                    if (!graph.addConstantToPool(constant->value(), &index))
-                        return false;
-                    snapshots_.addConstantPoolSlot(index);
-                }
-            }
-            break;
-          }
-          case MIRType_Magic:
-          {
-            uint32 index;
-            if (!graph.addConstantToPool(MagicValue(JS_OPTIMIZED_ARGUMENTS), &index))
+        if (mir->isObjectState()) {
+            if (!encodeObjectState(snapshot, mir->toObjectState(), startIndex))
                 return false;
-            snapshots_.addConstantPoolSlot(index);
-            break;
-          }
-          default:
-          {
-            JS_ASSERT(mir->type() == MIRType_Value);
-            LAllocation *payload = snapshot->payloadOfSlot(i);
-#ifdef JS_NUNBOX32
-            LAllocation *type = snapshot->typeOfSlot(i);
-            if (type->isRegister()) {
-                if (payload->isRegister())
-                    snapshots_.addSlot(ToRegister(type), ToRegister(payload));
-                else
-                    snapshots_.addSlot(ToRegister(type), ToStackIndex(payload));
-            } else {
-                if (payload->isRegister())
-                    snapshots_.addSlot(ToStackIndex(type), ToRegister(payload));
-                else
-                    snapshots_.addSlot(ToStackIndex(type), ToStackIndex(payload));
-            }
-#elif JS_PUNBOX64
-            if (payload->isRegister())
-                snapshots_.addSlot(ToRegister(payload));
-            else
-                snapshots_.addSlot(ToStackIndex(payload));
-#endif
-            break;
-          }
-      }
+            continue;
+        }
+
+        if (!encodeSlot(snapshot, mir, (*startIndex)++))
+            return false;
     }
 
-    *startIndex += resumePoint->numOperands();
     return true;
 }
 
@@ -178,6 +219,7 @@ CodeGeneratorShared::encode(LSnapshot *snapshot)
 
     SnapshotOffset offset = snapshots_.startSnapshot(frameCount, snapshot->bailoutKind(),
                                                      resumeAfter);
+    snapshotObjects_.clear();
 
     FlattenedMResumePointIter mirOperandIter(snapshot->mir());
     if (!mirOperandIter.init())
@@ -64,6 +64,10 @@ class CodeGeneratorShared : public LInstructionVisitor
     // List of stack slots that have been pushed as arguments to an MCall.
     js::Vector<uint32, 0, SystemAllocPolicy> pushedArgumentSlots_;
 
+    // Allocations whose states the snapshot being encoded refers to, indexed
+    // by their number in the snapshot.
+    js::Vector<uint32, 0, SystemAllocPolicy> snapshotObjects_;
+
   protected:
     // The offset of the first instruction of the OSR entry block from the
     // beginning of the code buffer.
@@ -163,6 +167,8 @@ class CodeGeneratorShared : public LInstructionVisitor
     // false on failure.
     bool encode(LSnapshot *snapshot);
     bool encodeSlots(LSnapshot *snapshot, MResumePoint *resumePoint, uint32 *startIndex);
+    bool encodeSlot(LSnapshot *snapshot, MDefinition *mir, uint32 i);
+    bool encodeObjectState(LSnapshot *snapshot, MObjectState *state, uint32 *index);
 
     // Attempts to assign a BailoutId to a snapshot, if one isn't already set.
     // If the bailout table is full, this returns false, which is not a fatal
@@ -60,57 +60,58 @@ LIRGeneratorShared::lowerTypedPhiInput(MPhi *phi, uint32 inputPosition, LBlock *
 }
 
 #ifdef JS_NUNBOX32
-LSnapshot *
-LIRGeneratorShared::buildSnapshot(LInstruction *ins, MResumePoint *rp, BailoutKind kind)
+bool
+LIRGeneratorShared::buildSnapshotEntry(LSnapshot *snapshot, size_t i, MDefinition *ins)
 {
-    LSnapshot *snapshot = LSnapshot::New(gen, rp, kind);
-    if (!snapshot)
-        return NULL;
+    LAllocation *type = snapshot->typeOfSlot(i);
+    LAllocation *payload = snapshot->payloadOfSlot(i);
+
+    if (ins->isPassArg())
+        ins = ins->toPassArg()->getArgument();
+    JS_ASSERT(!ins->isPassArg());
+
+    // Guards should never be eliminated.
+    JS_ASSERT_IF(ins->isUnused(), !ins->isGuard());
+
+    // The register allocation will fill these fields in with actual
+    // register/stack assignments. During code generation, we can restore
+    // interpreter state with the given information. Note that for
+    // constants, including known types, we record a dummy placeholder,
+    // since we can recover the same information, much cleaner, from MIR.
+    if (ins->isConstant() || ins->isUnused() || ins->isObjectState()) {
+        *type = LConstantIndex::Bogus();
+        *payload = LConstantIndex::Bogus();
+    } else if (ins->type() != MIRType_Value) {
+        *type = LConstantIndex::Bogus();
+        *payload = use(ins, LUse::KEEPALIVE);
+    } else {
+        if (!ensureDefined(ins))
+            return false;
+        *type = useType(ins, LUse::KEEPALIVE);
+        *payload = usePayload(ins, LUse::KEEPALIVE);
+    }
+    return true;
+}
 
-    FlattenedMResumePointIter iter(rp);
-    if (!iter.init())
-        return NULL;
+#elif JS_PUNBOX64
 
-    size_t i = 0;
-    for (MResumePoint **it = iter.begin(), **end = iter.end(); it != end; ++it) {
-        MResumePoint *mir = *it;
-        for (size_t j = 0; j < mir->numOperands(); ++i, ++j) {
-            MDefinition *ins = mir->getOperand(j);
-
-            LAllocation *type = snapshot->typeOfSlot(i);
-            LAllocation *payload = snapshot->payloadOfSlot(i);
-
-            if (ins->isPassArg())
-                ins = ins->toPassArg()->getArgument();
-            JS_ASSERT(!ins->isPassArg());
-
-            // Guards should never be eliminated.
-            JS_ASSERT_IF(ins->isUnused(), !ins->isGuard());
-
-            // The register allocation will fill these fields in with actual
-            // register/stack assignments. During code generation, we can restore
-            // interpreter state with the given information. Note that for
-            // constants, including known types, we record a dummy placeholder,
-            // since we can recover the same information, much cleaner, from MIR.
-            if (ins->isConstant() || ins->isUnused()) {
-                *type = LConstantIndex::Bogus();
-                *payload = LConstantIndex::Bogus();
-            } else if (ins->type() != MIRType_Value) {
-                *type = LConstantIndex::Bogus();
-                *payload = use(ins, LUse::KEEPALIVE);
-            } else {
-                if (!ensureDefined(ins))
-                    return NULL;
-                *type = useType(ins, LUse::KEEPALIVE);
-                *payload = usePayload(ins, LUse::KEEPALIVE);
-            }
-        }
+bool
+LIRGeneratorShared::buildSnapshotEntry(LSnapshot *snapshot, size_t i, MDefinition *def)
+{
+    if (def->isPassArg())
+        def = def->toPassArg()->getArgument();
+
+    LAllocation *a = snapshot->getEntry(i);
+
+    if (def->isUnused() || def->isObjectState()) {
+        *a = LConstantIndex::Bogus();
+        return true;
     }
 
-    return snapshot;
+    *a = useKeepaliveOrConstant(def);
+    return true;
 }
-
-#elif JS_PUNBOX64
+#endif
 
 LSnapshot *
 LIRGeneratorShared::buildSnapshot(LInstruction *ins, MResumePoint *rp, BailoutKind kind)
@@ -126,26 +127,24 @@ LIRGeneratorShared::buildSnapshot(LInstruction *ins, MResumePoint *rp, BailoutKi
     size_t i = 0;
     for (MResumePoint **it = iter.begin(), **end = iter.end(); it != end; ++it) {
         MResumePoint *mir = *it;
-        for (size_t j = 0; j < mir->numOperands(); ++i, ++j) {
+        for (size_t j = 0; j < mir->numOperands(); ++j) {
             MDefinition *def = mir->getOperand(j);
-
-            if (def->isPassArg())
-                def = def->toPassArg()->getArgument();
-
-            LAllocation *a = snapshot->getEntry(i);
-
-            if (def->isUnused()) {
-                *a = LConstantIndex::Bogus();
-                continue;
+            if (!buildSnapshotEntry(snapshot, i++, def))
+                return NULL;
+
+            // The operands of object states follow them, so that bailouts can
+            // allocate the objects escape analysis removed.
+            if (def->isObjectState()) {
+                for (size_t k = 0; k < def->numOperands(); k++) {
+                    if (!buildSnapshotEntry(snapshot, i++, def->getOperand(k)))
+                        return NULL;
+                }
             }
-
-            *a = useKeepaliveOrConstant(def);
         }
     }
 
     return snapshot;
 }
-#endif
 
 bool
 LIRGeneratorShared::assignSnapshot(LInstruction *ins, BailoutKind kind)
@@ -151,6 +151,7 @@ class LIRGeneratorShared : public MInstructionVisitor
         return tmp;
     }
 
+    bool buildSnapshotEntry(LSnapshot *snapshot, size_t i, MDefinition *def);
     LSnapshot *buildSnapshot(LInstruction *ins, MResumePoint *rp, BailoutKind kind);
     bool assignPostSnapshot(MInstruction *mir, LInstruction *ins);
 
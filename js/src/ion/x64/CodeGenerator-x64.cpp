@@ -356,3 +356,212 @@ CodeGeneratorX64::visitCompareBAndBranch(LCompareBAndBranch *lir)
     emitBranch(JSOpToCondition(mir->jsop()), lir->ifTrue(), lir->ifFalse());
     return true;
 }
+
+// Lowers the end of the loop to the length of a typed array it accesses.
+static void
+ClampToLength(MacroAssembler &masm, Register end, Register length)
+{
+    Label inBounds;
+    masm.cmpl(end, length);
+    masm.j(Assembler::LessThanOrEqual, &inBounds);
+    masm.movl(length, end);
+    masm.bind(&inBounds);
+}
+
+// Skips the vector loop if storing a vector into |elements| overwrites
+// elements of |source| which are read by a later vector: this is the case
+// when the destination starts less than a vector after the source.
+static void
+CheckOverlap(MacroAssembler &masm, Register elements, Register source, Register temp,
+             Label *skip)
+{
+    masm.movq(elements, temp);
+    masm.subq(source, temp);
+    masm.subq(Imm32(1), temp);
+    masm.cmpq(Imm32(15), temp);
+    masm.j(Assembler::Below, skip);
+}
+
+static void
+LoadVector(MacroAssembler &masm, int arrayType, const Operand &src, const FloatRegister &dest)
+{
+    switch (arrayType) {
+      case TypedArray::TYPE_INT32:
+        masm.movdqu(src, dest);
+        break;
+      case TypedArray::TYPE_FLOAT32:
+        masm.movups(src, dest);
+        break;
+      case TypedArray::TYPE_FLOAT64:
+        masm.movupd(src, dest);
+        break;
+      default:
+        JS_NOT_REACHED("Unexpected array type");
+    }
+}
+
+static void
+StoreVector(MacroAssembler &masm, int arrayType, const FloatRegister &src, const Operand &dest)
+{
+    switch (arrayType) {
+      case TypedArray::TYPE_INT32:
+        masm.movdqu(src, dest);
+        break;
+      case TypedArray::TYPE_FLOAT32:
+        masm.movups(src, dest);
+        break;
+      case TypedArray::TYPE_FLOAT64:
+        masm.movupd(src, dest);
+        break;
+      default:
+        JS_NOT_REACHED("Unexpected array type");
+    }
+}
+
+// Copies a scalar to every lane of |dest|.
+static void
+BroadcastScalar(MacroAssembler &masm, int arrayType, const LAllocation *scalar,
+                const FloatRegister &dest)
+{
+    switch (arrayType) {
+      case TypedArray::TYPE_INT32:
+        masm.movd(ToRegister(scalar), dest);
+        masm.pshufd(0, dest, dest);
+        break;
+      case TypedArray::TYPE_FLOAT32:
+        masm.cvtsd2ss(ToFloatRegister(scalar), dest);
+        masm.pshufd(0, dest, dest);
+        break;
+      case TypedArray::TYPE_FLOAT64:
+        masm.movsd(ToFloatRegister(scalar), dest);
+        masm.unpcklpd(dest, dest);
+        break;
+      default:
+        JS_NOT_REACHED("Unexpected array type");
+    }
+}
+
+// Computes |dest = dest op src| on each lane.
+static void
+ApplyVector(MacroAssembler &masm, MTypedArrayVectorLoop::Operation operation, int arrayType,
+            const FloatRegister &src, const FloatRegister &dest)
+{
+    bool isFloat32 = arrayType == TypedArray::TYPE_FLOAT32;
+    bool isFloat64 = arrayType == TypedArray::TYPE_FLOAT64;
+
+    switch (operation) {
+      case MTypedArrayVectorLoop::Add:
+        if (isFloat32)
+            masm.addps(src, dest);
+        else if (isFloat64)
+            masm.addpd(src, dest);
+        else
+            masm.paddd(src, dest);
+        break;
+      case MTypedArrayVectorLoop::Sub:
+        if (isFloat32)
+            masm.subps(src, dest);
+        else if (isFloat64)
+            masm.subpd(src, dest);
+        else
+            masm.psubd(src, dest);
+        break;
+      case MTypedArrayVectorLoop::Mul:
+        JS_ASSERT(isFloat32 || isFloat64);
+        if (isFloat32)
+            masm.mulps(src, dest);
+        else
+            masm.mulpd(src, dest);
+        break;
+      default:
+        JS_NOT_REACHED("Unexpected operation");
+    }
+}
+
+bool
+CodeGeneratorX64::visitTypedArrayVectorLoop(LTypedArrayVectorLoop *lir)
+{
+    const MTypedArrayVectorLoop *mir = lir->mir();
+    MTypedArrayVectorLoop::Operation operation = mir->operation();
+    int arrayType = mir->arrayType();
+
+    Register index = ToRegister(lir->output());
+    Register elements = ToRegister(lir->elements());
+    Register end = ToRegister(lir->end());
+    Register temp = ToRegister(lir->temp());
+    FloatRegister vector = ToFloatRegister(lir->vector());
+    FloatRegister other = ToFloatRegister(lir->other());
+    JS_ASSERT(index == ToRegister(lir->start()));
+
+    bool lhsIsArray = mir->lhsIsArray();
+    bool rhsIsArray = operation != MTypedArrayVectorLoop::Copy &&
+                      operation != MTypedArrayVectorLoop::Fill &&
+                      mir->rhsIsArray();
+
+    int width = TypedArray::slotWidth(arrayType);
+    int32 lanes = 16 / width;
+    Scale scale = ScaleFromShift(width);
+
+    // The vector loop ends at a multiple of the vector size from the start,
+    // before the bound and the end of each array.
+    Label done;
+    masm.movl(index, index);
+    masm.test32(index, index);
+    masm.j(Assembler::Signed, &done);
+
+    masm.movl(ToRegister(lir->bound()), end);
+    ClampToLength(masm, end, ToRegister(lir->length()));
+    if (lhsIsArray)
+        ClampToLength(masm, end, ToRegister(lir->lhsLength()));
+    if (rhsIsArray)
+        ClampToLength(masm, end, ToRegister(lir->rhsLength()));
+
+    masm.subl(index, end);
+    masm.andl(Imm32(~(lanes - 1)), end);
+    masm.j(Assembler::LessThanOrEqual, &done);
+    masm.addl(index, end);
+
+    if (lhsIsArray)
+        CheckOverlap(masm, elements, ToRegister(lir->lhs()), temp, &done);
+    if (rhsIsArray)
+        CheckOverlap(masm, elements, ToRegister(lir->rhs()), temp, &done);
+
+    // Scalars are the same in every iteration.
+    if (!lhsIsArray)
+        BroadcastScalar(masm, arrayType, lir->lhs(), other);
+    else if (operation != MTypedArrayVectorLoop::Copy && !rhsIsArray)
+        BroadcastScalar(masm, arrayType, lir->rhs(), other);
+
+    FloatRegister result = vector;
+    Label loop;
+    masm.bind(&loop);
+    switch (operation) {
+      case MTypedArrayVectorLoop::Copy:
+        LoadVector(masm, arrayType, Operand(ToRegister(lir->lhs()), index, scale), vector);
+        break;
+      case MTypedArrayVectorLoop::Fill:
+        result = other;
+        break;
+      default:
+        if (!lhsIsArray) {
+            // The broadcast left operand must not be overwritten.
+            masm.movaps(other, vector);
+            LoadVector(masm, arrayType, Operand(ToRegister(lir->rhs()), index, scale),
+                       ScratchFloatReg);
+            ApplyVector(masm, operation, arrayType, ScratchFloatReg, vector);
+            break;
+        }
+        LoadVector(masm, arrayType, Operand(ToRegister(lir->lhs()), index, scale), vector);
+        if (rhsIsArray)
+            LoadVector(masm, arrayType, Operand(ToRegister(lir->rhs()), index, scale), other);
+        ApplyVector(masm, operation, arrayType, other, vector);
+        break;
+    }
+    StoreVector(masm, arrayType, result, Operand(elements, index, scale));
+    masm.addl(Imm32(lanes), index);
+    masm.cmpl(index, end);
+    masm.j(Assembler::LessThan, &loop);
+
+    masm.bind(&done);
+    return true;
+}
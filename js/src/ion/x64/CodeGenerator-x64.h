@@ -50,6 +50,7 @@ class CodeGeneratorX64 : public CodeGeneratorX86Shared
     bool visitInterruptCheck(LInterruptCheck *lir);
     bool visitCompareB(LCompareB *lir);
     bool visitCompareBAndBranch(LCompareBAndBranch *lir);
+    bool visitTypedArrayVectorLoop(LTypedArrayVectorLoop *lir);
 };
 
 typedef CodeGeneratorX64 CodeGeneratorSpecific;
@@ -83,6 +83,78 @@ class LDouble : public LInstructionHelper<1, 0, 0>
     }
 };
 
+// Runs iterations of a typed array loop with packed SSE instructions, and
+// returns the index at which the loop continues.
+class LTypedArrayVectorLoop : public LInstructionHelper<1, 8, 4>
+{
+  public:
+    LIR_HEADER(TypedArrayVectorLoop);
+
+    LTypedArrayVectorLoop(const LAllocation &start, const LAllocation &bound,
+                          const LAllocation &elements, const LAllocation &length,
+                          const LAllocation &lhs, const LAllocation &lhsLength,
+                          const LAllocation &rhs, const LAllocation &rhsLength,
+                          const LDefinition &end, const LDefinition &temp,
+                          const LDefinition &vector, const LDefinition &other)
+    {
+        setOperand(0, start);
+        setOperand(1, bound);
+        setOperand(2, elements);
+        setOperand(3, length);
+        setOperand(4, lhs);
+        setOperand(5, lhsLength);
+        setOperand(6, rhs);
+        setOperand(7, rhsLength);
+        setTemp(0, end);
+        setTemp(1, temp);
+        setTemp(2, vector);
+        setTemp(3, other);
+    }
+
+    const MTypedArrayVectorLoop *mir() const {
+        return mir_->toTypedArrayVectorLoop();
+    }
+    const LAllocation *start() {
+        return getOperand(0);
+    }
+    const LAllocation *bound() {
+        return getOperand(1);
+    }
+    const LAllocation *elements() {
+        return getOperand(2);
+    }
+    const LAllocation *length() {
+        return getOperand(3);
+    }
+    const LAllocation *lhs() {
+        return getOperand(4);
+    }
+    const LAllocation *lhsLength() {
+        return getOperand(5);
+    }
+    const LAllocation *rhs() {
+        return getOperand(6);
+    }
+    const LAllocation *rhsLength() {
+        return getOperand(7);
+    }
+    const LDefinition *end() {
+        return getTemp(0);
+    }
+    const LDefinition *temp() {
+        return getTemp(1);
+    }
+    const LDefinition *vector() {
+        return getTemp(2);
+    }
+    const LDefinition *other() {
+        return getTemp(3);
+    }
+    const LDefinition *output() {
+        return getDef(0);
+    }
+};
+
 } // namespace ion
 } // namespace js
 
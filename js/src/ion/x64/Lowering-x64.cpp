@@ -159,3 +159,18 @@ LIRGeneratorX64::visitStoreTypedArrayElement(MStoreTypedArrayElement *ins)
     LAllocation value = useRegisterOrNonDoubleConstant(ins->value());
     return add(new LStoreTypedArrayElement(elements, index, value), ins);
 }
+
+bool
+LIRGeneratorX64::visitTypedArrayVectorLoop(MTypedArrayVectorLoop *ins)
+{
+    JS_ASSERT(ins->start()->type() == MIRType_Int32);
+    JS_ASSERT(ins->bound()->type() == MIRType_Int32);
+
+    LTypedArrayVectorLoop *lir =
+        new LTypedArrayVectorLoop(useRegisterAtStart(ins->start()), useRegister(ins->bound()),
+                                  useRegister(ins->elements()), useRegister(ins->length()),
+                                  useRegister(ins->lhs()), useRegister(ins->lhsLength()),
+                                  useRegister(ins->rhs()), useRegister(ins->rhsLength()),
+                                  temp(), temp(), tempFloat(), tempFloat());
+    return defineReuseInput(lir, ins, 0);
+}
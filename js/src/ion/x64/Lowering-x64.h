@@ -45,6 +45,7 @@ class LIRGeneratorX64 : public LIRGeneratorX86Shared
     bool visitUnbox(MUnbox *unbox);
     bool visitReturn(MReturn *ret);
     bool visitStoreTypedArrayElement(MStoreTypedArrayElement *ins);
+    bool visitTypedArrayVectorLoop(MTypedArrayVectorLoop *ins);
 };
 
 typedef LIRGeneratorX64 LIRGeneratorSpecific;
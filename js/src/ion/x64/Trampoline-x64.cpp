@@ -175,6 +175,7 @@ GenerateBailoutTail(MacroAssembler &masm)
     Label osr;
     Label recompile;
     Label boundscheck;
+    Label paramcheck;
 
     // The return value from Bailout is tagged as:
     // - 0x0: done (thunk to interpreter)
@@ -185,6 +186,7 @@ GenerateBailoutTail(MacroAssembler &masm)
     // - 0x5: recompile to inline calls
     // - 0x6: bounds check failure
     // - 0x7: force invalidation
+    // - 0x8: parameter check failure
 
     masm.cmpl(rax, Imm32(BAILOUT_RETURN_FATAL_ERROR));
     masm.j(Assembler::LessThan, &interpret);
@@ -196,6 +198,7 @@ GenerateBailoutTail(MacroAssembler &masm)
 
     masm.cmpl(eax, Imm32(BAILOUT_RETURN_INVALIDATE));
     masm.j(Assembler::LessThan, &boundscheck);
+    masm.j(Assembler::GreaterThan, &paramcheck);
 
     // Force invalidation.
     {
@@ -207,6 +210,17 @@ GenerateBailoutTail(MacroAssembler &masm)
         masm.jmp(&interpret);
     }
 
+    // Parameter check failure.
+    masm.bind(&paramcheck);
+    {
+        masm.setupUnalignedABICall(0, rdx);
+        masm.callWithABI(JS_FUNC_TO_DATA_PTR(void *, ParameterCheckFailure));
+
+        masm.testl(rax, rax);
+        masm.j(Assembler::Zero, &exception);
+        masm.jmp(&interpret);
+    }
+
     // Bounds check failure.
     masm.bind(&boundscheck);
     {
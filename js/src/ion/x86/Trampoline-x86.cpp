@@ -169,6 +169,7 @@ GenerateBailoutTail(MacroAssembler &masm)
     Label osr;
     Label recompile;
     Label boundscheck;
+    Label paramcheck;
 
     // The return value from Bailout is tagged as:
     // - 0x0: done (thunk to interpreter)
@@ -179,6 +180,7 @@ GenerateBailoutTail(MacroAssembler &masm)
     // - 0x5: recompile to inline calls
     // - 0x6: bounds check failure
     // - 0x7: force invalidation
+    // - 0x8: parameter check failure
 
     masm.cmpl(eax, Imm32(BAILOUT_RETURN_FATAL_ERROR));
     masm.j(Assembler::LessThan, &interpret);
@@ -190,6 +192,7 @@ GenerateBailoutTail(MacroAssembler &masm)
 
     masm.cmpl(eax, Imm32(BAILOUT_RETURN_INVALIDATE));
     masm.j(Assembler::LessThan, &boundscheck);
+    masm.j(Assembler::GreaterThan, &paramcheck);
 
     // Force invalidation.
     {
@@ -201,6 +204,17 @@ GenerateBailoutTail(MacroAssembler &masm)
         masm.jmp(&interpret);
     }
 
+    // Parameter check failure.
+    masm.bind(&paramcheck);
+    {
+        masm.setupUnalignedABICall(0, edx);
+        masm.callWithABI(JS_FUNC_TO_DATA_PTR(void *, ParameterCheckFailure));
+
+        masm.testl(eax, eax);
+        masm.j(Assembler::Zero, &exception);
+        masm.jmp(&interpret);
+    }
+
     // Bounds check failure.
     masm.bind(&boundscheck);
     {
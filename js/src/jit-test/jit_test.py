@@ -94,6 +94,8 @@ class Test:
                             test.expect_status = int(value, 0);
                         except ValueError:
                             print("warning: couldn't parse exit status %s"%value)
+                    elif name == 'ion-flags':
+                        test.jitflags.extend(value.split())
                     else:
                         print('warning: unrecognized |jit-test| attribute %s'%part)
                 else:
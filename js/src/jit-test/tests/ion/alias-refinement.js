@@ -0,0 +1,61 @@
+// |jit-test| ion-flags: --ion-alias-refine
+// Loads which are only separated by stores to other slots, other indices or
+// objects of other types, and loads of a value just stored.
+function Point(x, y) {
+  this.x = x;
+  this.y = y;
+}
+function Line(a, b) {
+  this.a = a;
+  this.b = b;
+}
+
+function slots(p, q, n) {
+  var sum = 0;
+  for (var i = 0; i < n; i++) {
+    p.y = i;
+    q.a = p.x;
+    sum += p.x + p.y + q.a;
+  }
+  return sum;
+}
+
+function elements(a, n) {
+  var sum = 0;
+  for (var i = 0; i < n; i++) {
+    a[1] = i;
+    sum += a[0] + a[1] + a[0];
+  }
+  return sum;
+}
+
+// Both arguments are the same object, the stores must be seen by the loads.
+function aliased(p, q, n) {
+  var sum = 0;
+  for (var i = 0; i < n; i++) {
+    q.x = i;
+    sum += p.x;
+  }
+  return sum;
+}
+
+function branches(p, c) {
+  var v = p.x;
+  if (c)
+    p.x = 10;
+  else
+    p.y = 20;
+  return v + p.x + p.y;
+}
+
+for (var j = 0; j < 100; j++) {
+  var p = new Point(j, 2);
+  var q = new Line(0, 0);
+  assertEq(slots(p, q, 10), 20 * j + 45);
+  assertEq(q.a, j);
+  assertEq(p.y, 9);
+  assertEq(elements([j, 0], 10), 20 * j + 45);
+  var r = new Point(0, 0);
+  assertEq(aliased(r, r, 10), 45);
+  assertEq(branches(new Point(1, 2), j & 1), (j & 1) ? 13 : 22);
+}
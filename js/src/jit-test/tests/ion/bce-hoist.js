@@ -0,0 +1,48 @@
+// |jit-test| ion-flags: --ion-bce
+// Bounds checks hoisted to loop preheaders, including ones which fail
+// although the loop never accesses out of bounds elements.
+var ta = new Int32Array(32);
+var arr = [];
+for (var k = 0; k < 32; k++) {
+  ta[k] = k;
+  arr[k] = k;
+}
+
+function down(a, n) {
+  var v = 0;
+  for (var i = n; i > 0; i--)
+    v += a[i - 1];
+  return v;
+}
+
+function window(a, from, to) {
+  var v = 0;
+  for (var i = from; i < to; i++)
+    v += a[i] - a[i - 1];
+  return v;
+}
+
+function stopEarly(a, n, stop) {
+  var v = 0;
+  for (var i = 0; i < n; i++) {
+    if (i == stop)
+      break;
+    v += a[i];
+  }
+  return v;
+}
+
+for (var j = 0; j < 2000; j++) {
+  assertEq(down(ta, 32), 496);
+  assertEq(window(arr, 5, 10), 5);
+  assertEq(stopEarly(ta, 10, 100), 45);
+}
+
+// The hoisted checks fail, but none of the accesses does.
+assertEq(stopEarly(ta, 100, 32), 496);
+assertEq(down(ta, 0), 0);
+assertEq(window(arr, 0, 0), 0);
+
+// Out of bounds accesses are still made.
+assertEq(isNaN(down(ta, 33)), true);
+assertEq(isNaN(window(arr, 0, 2)), true);
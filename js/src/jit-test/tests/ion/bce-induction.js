@@ -0,0 +1,80 @@
+// |jit-test| ion-flags: --ion-bce
+// Loops whose induction variables bound the accesses to arrays, and edge
+// cases where the bounds checks must stay.
+var ta = new Int32Array(16);
+for (var k = 0; k < ta.length; k++)
+  ta[k] = k;
+
+function countDown(a) {
+  var v = 0;
+  for (var i = a.length - 1; i >= 0; i--)
+    v += a[i];
+  return v;
+}
+
+function notEqual(a) {
+  var v = 0;
+  for (var i = 0; i != 16; i++)
+    v += a[i];
+  return v;
+}
+
+function strided(a, n) {
+  var v = 0;
+  for (var i = 0; i < n; i += 4)
+    v += a[i] | 0;
+  return v;
+}
+
+function doWhile(a) {
+  var v = 0;
+  var i = 0;
+  do {
+    v += a[i + 1];
+    i++;
+  } while (i < 15);
+  return v;
+}
+
+function twoVariables(a) {
+  var v = 0;
+  for (var i = 0, j = 15; i < j; i++, j--)
+    v += a[i] * a[j];
+  return v;
+}
+
+function derived(a) {
+  var v = 0;
+  for (var i = 0; i < 8; i++)
+    v += a[2 * i + 1];
+  return v;
+}
+
+function pastTheEnd(a) {
+  var v = 0;
+  for (var i = 0; i <= a.length; i++)
+    v += a[i] === undefined ? 100 : a[i];
+  return v;
+}
+
+function earlyExit(a, stop) {
+  var v = 0;
+  for (var i = 0; i < a.length; i++) {
+    if (a[i] == stop)
+      break;
+    v += a[i];
+  }
+  return v;
+}
+
+for (var j = 0; j < 50; j++) {
+  assertEq(countDown(ta), 120);
+  assertEq(notEqual(ta), 120);
+  assertEq(strided(ta, 16), 24);
+  assertEq(strided(ta, 20), 24);
+  assertEq(doWhile(ta), 120);
+  assertEq(twoVariables(ta), 1 * 14 + 2 * 13 + 3 * 12 + 4 * 11 + 5 * 10 + 6 * 9 + 7 * 8);
+  assertEq(derived(ta), 64);
+  assertEq(pastTheEnd(ta), 220);
+  assertEq(earlyExit(ta, 5), 10);
+}
@@ -0,0 +1,126 @@
+// Calls to unknown targets go through a cache with a stub per callee.
+
+function apply(f, x, y) {
+    return f(x, y);
+}
+
+function add(x, y) { return x + y; }
+function sub(x, y) { return x - y; }
+function first(x) { return x; }
+function third(x, y, z) { return z; }
+function count() { return arguments.length; }
+
+function testPolymorphic() {
+    var fs = [add, sub, first, Math.max, third, count];
+    var expected = [5, 1, 3, 3, undefined, 2];
+    for (var n = 0; n < 200; n++) {
+        for (var i = 0; i < fs.length; i++)
+            assertEq(apply(fs[i], 3, 2), expected[i]);
+    }
+}
+testPolymorphic();
+
+// Too many callees for the cache.
+function testMegamorphic() {
+    var fs = [];
+    for (var i = 0; i < 40; i++)
+        fs.push(new Function("x", "y", "return x * " + i + " + y;"));
+    for (var n = 0; n < 50; n++) {
+        for (var i = 0; i < fs.length; i++)
+            assertEq(apply(fs[i], n, 1), n * i + 1);
+        assertEq(apply(third, 1, 2), undefined);
+        assertEq(apply(Math.min, 1, 2), 1);
+    }
+}
+testMegamorphic();
+
+// Callees which are recompiled or invalidated.
+function testInvalidation() {
+    function f(x, y) { return x + y; }
+    for (var n = 0; n < 100; n++)
+        assertEq(apply(f, n, 1), n + 1);
+    assertEq(apply(f, "a", 1), "a1");
+    assertEq(apply(f, 1.5, 1), 2.5);
+    for (var n = 0; n < 100; n++) {
+        assertEq(apply(f, n, 1), n + 1);
+        assertEq(apply(add, n, 2), n + 2);
+    }
+}
+testInvalidation();
+
+function testConstruct() {
+    function A(x) { this.x = x; }
+    function B(x, y) { this.y = y; return 3; }
+    function C() { return { c: true }; }
+    var cs = [A, B, C];
+    function construct(c, x, y) {
+        return new c(x, y);
+    }
+    for (var n = 0; n < 100; n++) {
+        assertEq(construct(A, n).x, n);
+        assertEq(construct(B, 1, n).y, n);
+        assertEq(construct(C).c, true);
+        assertEq(construct(cs[n % 3], n, n) instanceof cs[n % 3], n % 3 != 2);
+    }
+}
+testConstruct();
+
+function testNotFunction() {
+    for (var n = 0; n < 100; n++) {
+        var caught = false;
+        try {
+            apply(n % 10 ? add : {}, 1, 2);
+        } catch (e) {
+            caught = e instanceof TypeError;
+        }
+        assertEq(caught, n % 10 == 0);
+    }
+}
+testNotFunction();
+
+// Stubs are discarded on GC and generated again.
+function testGC() {
+    for (var n = 0; n < 10; n++) {
+        for (var i = 0; i < 20; i++) {
+            assertEq(apply(add, i, n), i + n);
+            assertEq(apply(sub, i, n), i - n);
+        }
+        gc();
+    }
+}
+testGC();
+
+// Exceptions thrown by callees.
+function testThrow() {
+    function thrower(x) { if (x > 50) throw x; return x; }
+    var caught = 0;
+    for (var n = 0; n < 100; n++) {
+        try {
+            assertEq(apply(thrower, n), n);
+            assertEq(apply(first, n), n);
+        } catch (e) {
+            assertEq(e, n);
+            caught++;
+        }
+    }
+    assertEq(caught, 49);
+}
+testThrow();
+
+// Callees which are compiled after the stub sending them to the generic path
+// has been attached, and whose IonScript is then replaced.
+function testCompiledLater() {
+    function call(f, x, y) {
+        return f(x, y);
+    }
+    function late(x, y) { return x * y; }
+    for (var n = 0; n < 20000; n++) {
+        assertEq(call(n % 2 ? late : add, n, 2), n % 2 ? n * 2 : n + 2);
+        if (n % 5000 == 0)
+            gc();
+    }
+    assertEq(call(late, "a", 2), NaN);
+    for (var n = 0; n < 100; n++)
+        assertEq(call(late, n, 3), n * 3);
+}
+testCompiledLater();
@@ -0,0 +1,62 @@
+// |jit-test| ion-flags: --ion-dse
+// Stores which are overwritten before being read, and stores to literals
+// which are never used.
+function Point(x, y) {
+  this.x = x;
+  this.y = y;
+}
+
+function overwrite(p, v) {
+  p.x = v;
+  p.y = v * 2;
+  p.x = v + 1;
+  return p.x + p.y;
+}
+
+function elements(a, v) {
+  a[0] = v;
+  a[0] = v + 1;
+  return a[0];
+}
+
+function read(p, v) {
+  p.x = v;
+  var t = p.x;
+  p.x = t + 1;
+  return p.x;
+}
+
+function literal(v) {
+  ({a: v, b: v + 1});
+  [v, v];
+  return v;
+}
+
+// The load of |a.length| bails out and throws when |a| is null: the first
+// store must have been made.
+function bailout(p, a) {
+  p.x = 1;
+  p.y = 2;
+  var t = a.length;
+  p.x = t;
+}
+
+for (var i = 0; i < 100; i++) {
+  var p = new Point(0, 0);
+  assertEq(overwrite(p, i), 3 * i + 1);
+  assertEq(p.x, i + 1);
+  assertEq(elements([0, 1], i), i + 1);
+  assertEq(read(p, i), i + 1);
+  assertEq(literal(i), i);
+  bailout(p, [1, 2, 3]);
+  assertEq(p.x, 3);
+}
+
+var q = new Point(0, 0);
+try {
+  bailout(q, null);
+} catch (e) {
+  assertEq(e instanceof TypeError, true);
+}
+assertEq(q.x, 1);
+assertEq(q.y, 2);
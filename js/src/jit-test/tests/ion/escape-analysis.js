@@ -0,0 +1,65 @@
+// |jit-test| ion-flags: --ion-escape
+// Object and array literals which do not escape, replaced by the values of
+// their fields, and allocated again when bailing out.
+function point(x, y) {
+  var p = {x: x, y: y};
+  return p.x * 10 + p.y;
+}
+
+function swap(a, b) {
+  var o = {first: a, second: b};
+  var t = o.first;
+  o.first = o.second;
+  o.second = t;
+  return o.first - o.second;
+}
+
+function triple(a) {
+  var t = [a, a + 1, a * 2];
+  return t[0] + t[1] + t[2] + t.length;
+}
+
+function mixed(n) {
+  var v = 0;
+  for (var i = 0; i < n; i++) {
+    var p = {x: i, y: i * 0.5, name: "p"};
+    var pair = [p.x, p.y];
+    v += pair[0] + pair[1] + p.name.length;
+  }
+  return v;
+}
+
+function escapes(a) {
+  var o = {v: a};
+  var list = [o];
+  return list[0].v;
+}
+
+var counter = 0;
+function bump() {
+  counter++;
+}
+
+// The literals are live in the resume point of the call, which the add
+// bails out to when it overflows.
+function bailout(v) {
+  var o = {a: v, b: 2};
+  var t = [v, 3];
+  var alias = o;
+  o.b = v - 2;
+  bump();
+  var r = v + 1;
+  return o.a + alias.b + t[0] + t[1] + r;
+}
+
+for (var j = 0; j < 100; j++) {
+  assertEq(point(j, 3), j * 10 + 3);
+  assertEq(swap(j, 7), 7 - j);
+  assertEq(triple(j), j * 4 + 4);
+  assertEq(mixed(4), 13);
+  assertEq(escapes(j), j);
+  assertEq(bailout(j), j * 4 + 2);
+}
+assertEq(bailout(0x7fffffff), 0x7fffffff * 4 + 2);
+assertEq(bailout(5), 22);
+assertEq(counter, 102);
@@ -0,0 +1,91 @@
+// |jit-test| ion-flags: --ion-linv
+// While and for loops, which are inverted into do-while loops guarded by
+// their condition.
+var ta = new Int32Array(16);
+for (var k = 0; k < ta.length; k++)
+  ta[k] = k;
+
+function sum(a, n) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += a[i];
+  return v;
+}
+
+function whileLoop(n) {
+  var i = 0, v = 1;
+  while (i < n) {
+    v = v * 2 + i;
+    i++;
+  }
+  return v;
+}
+
+// The condition has side effects, and its value is used after the loop.
+function sideEffect(n) {
+  var i = 0, v = 0;
+  while (i++ < n)
+    v += i;
+  return v * 100 + i;
+}
+
+function breakContinue(a) {
+  var v = 0;
+  for (var i = 0; i < a.length; i++) {
+    if (a[i] == 3)
+      continue;
+    if (a[i] == 9)
+      break;
+    v += a[i];
+  }
+  return v * 100 + i;
+}
+
+function swap(n) {
+  var a = 1, b = 2;
+  for (var i = 0; i < n; i++) {
+    var t = a;
+    a = b;
+    b = t;
+  }
+  return a * 10 + b;
+}
+
+function nested(a) {
+  var v = 0;
+  for (var i = 0; i < 4; i++) {
+    var j = i;
+    while (j < 8) {
+      v += a[j] * i;
+      j += 2;
+    }
+  }
+  return v;
+}
+
+function afterLoop(n) {
+  var i = 3;
+  for (; i < n; i++) { }
+  return i;
+}
+
+for (var j = 0; j < 100; j++) {
+  assertEq(sum(ta, 16), 120);
+  assertEq(sum(ta, 0), 0);
+  assertEq(whileLoop(4), 27);
+  assertEq(whileLoop(0), 1);
+  assertEq(sideEffect(4), 1005);
+  assertEq(sideEffect(0), 1);
+  assertEq(breakContinue(ta), 3309);
+  assertEq(swap(3), 21);
+  assertEq(swap(0), 12);
+  assertEq(nested(ta), 85);
+  assertEq(afterLoop(7), 7);
+  assertEq(afterLoop(1), 3);
+}
+
+// Entered through OSR in the middle of the loop.
+var v = 0;
+for (var i = 0; i < 20000; i++)
+  v = (v + i) | 0;
+assertEq(v, 199990000);
@@ -0,0 +1,117 @@
+// |jit-test| ion-flags: --ion-vectorize
+// Typed array loops run several elements at a time, followed by the
+// iterations left over. Each array type is given its own copy of the loops,
+// which are only vectorized when the arrays they access have a single type.
+var source = "({" +
+  "fill: function (a, v, n) {" +
+  "  for (var i = 0; i < n; i++)" +
+  "    a[i] = v;" +
+  "}," +
+  "copy: function (a, b, n) {" +
+  "  for (var i = 0; i < n; i++)" +
+  "    a[i] = b[i];" +
+  "}," +
+  "add: function (a, b, c, n) {" +
+  "  for (var i = 0; i < n; i++)" +
+  "    a[i] = b[i] + c[i];" +
+  "}," +
+  "sub: function (a, b, c, n) {" +
+  "  for (var i = 0; i < n; i++)" +
+  "    a[i] = b[i] - c[i];" +
+  "}," +
+  "mul: function (a, b, c, n) {" +
+  "  for (var i = 0; i < n; i++)" +
+  "    a[i] = b[i] * c[i];" +
+  "}," +
+  "scale: function (a, b, n) {" +
+  "  for (var i = 0; i < n; i++)" +
+  "    a[i] = b[i] * 2.5;" +
+  "}," +
+  "reverseSub: function (a, b, from, n) {" +
+  "  for (var i = from; i < n; i++)" +
+  "    a[i] = 100 - b[i];" +
+  "}" +
+"})";
+
+var loops = {
+  Int32Array: eval("/* Int32Array */" + source),
+  Float32Array: eval("/* Float32Array */" + source),
+  Float64Array: eval("/* Float64Array */" + source)
+};
+
+// Rounds to single precision.
+var round = new Float32Array(1);
+function float32(x) {
+  round[0] = x;
+  return round[0];
+}
+
+function check(Type, length, bound) {
+  var f = loops[Type.name];
+  var exact = Type == Float32Array ? float32 : Type == Int32Array ? function (x) { return x | 0; }
+                                                                  : function (x) { return x; };
+  var a = new Type(length), b = new Type(length), c = new Type(length);
+  for (var k = 0; k < length; k++) {
+    b[k] = k * 3 + 0.5;
+    c[k] = 7 - k * 0.25;
+  }
+  var n = Math.min(length, bound);
+
+  f.fill(a, 9, bound);
+  for (var k = 0; k < length; k++)
+    assertEq(a[k], k < n ? 9 : 0);
+
+  f.copy(a, b, bound);
+  for (var k = 0; k < length; k++)
+    assertEq(a[k], k < n ? b[k] : 0);
+
+  f.add(a, b, c, bound);
+  for (var k = 0; k < n; k++)
+    assertEq(a[k], exact(b[k] + c[k]));
+
+  f.sub(a, b, c, bound);
+  for (var k = 0; k < n; k++)
+    assertEq(a[k], exact(b[k] - c[k]));
+
+  if (Type != Int32Array) {
+    f.mul(a, b, c, bound);
+    for (var k = 0; k < n; k++)
+      assertEq(a[k], exact(b[k] * c[k]));
+
+    f.scale(a, b, bound);
+    for (var k = 0; k < n; k++)
+      assertEq(a[k], exact(b[k] * 2.5));
+  }
+
+  f.reverseSub(a, b, 3, bound);
+  for (var k = 3; k < n; k++)
+    assertEq(a[k], exact(100 - b[k]));
+}
+
+// The destination is a view of the source, shifted by one element: each
+// iteration reads the element the previous one stored.
+function overlap(Type) {
+  var f = loops[Type.name];
+  var buffer = new Type(40);
+  for (var k = 0; k < 40; k++)
+    buffer[k] = k;
+  var dest = buffer.subarray(1);
+  f.add(dest, buffer, buffer, 39);
+  for (var k = 0; k < 40; k++)
+    assertEq(buffer[k], 0);
+
+  for (var k = 0; k < 40; k++)
+    buffer[k] = k;
+  f.copy(buffer, dest, 39);
+  for (var k = 0; k < 39; k++)
+    assertEq(buffer[k], k + 1);
+}
+
+for (var j = 0; j < 30; j++) {
+  check(Int32Array, 37, 37);
+  check(Float32Array, 41, 100);
+  check(Float64Array, 19, 11);
+  check(Float64Array, 3, 3);
+  overlap(Int32Array);
+  overlap(Float64Array);
+}
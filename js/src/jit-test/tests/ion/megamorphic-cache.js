@@ -0,0 +1,132 @@
+// Property caches seeing more shapes than they have stubs probe a table of
+// (shape, name) pairs shared by the compartment.
+
+function makeObjects(n) {
+    var objects = [];
+    for (var i = 0; i < n; i++) {
+        var o = {};
+        for (var j = 0; j < i % 24; j++)
+            o["p" + j] = j;
+        o.x = i;
+        objects.push(o);
+    }
+    return objects;
+}
+
+function getX(o) {
+    return o.x;
+}
+
+function setX(o, v) {
+    o.x = v;
+}
+
+function getElem(o, name) {
+    return o[name];
+}
+
+var objects = makeObjects(48);
+
+function testGet() {
+    for (var n = 0; n < 50; n++) {
+        for (var i = 0; i < objects.length; i++)
+            assertEq(getX(objects[i]), i);
+    }
+}
+testGet();
+
+function testSet() {
+    for (var n = 0; n < 50; n++) {
+        for (var i = 0; i < objects.length; i++) {
+            setX(objects[i], i + n);
+            assertEq(objects[i].x, i + n);
+        }
+    }
+    for (var i = 0; i < objects.length; i++)
+        setX(objects[i], i);
+}
+testSet();
+
+function testGetElem() {
+    for (var n = 0; n < 50; n++) {
+        for (var i = 0; i < objects.length; i++) {
+            assertEq(getElem(objects[i], "x"), i);
+            assertEq(getElem(objects[i], "p0"), i % 24 ? 0 : undefined);
+        }
+        assertEq(getElem([1, 2, 3], 1), 2);
+        assertEq(getElem([1, 2, 3], 5), undefined);
+    }
+}
+testGetElem();
+
+// Properties on the prototype, accessors, dictionary objects and properties
+// which are not writable are not in the table.
+function testMisses() {
+    var proto = { x: "proto" };
+    var inherited = Object.create(proto);
+    var accessor = { get x() { return "getter"; }, set x(v) { this.y = v; } };
+    var dict = { a: 1, x: "dict" };
+    delete dict.a;
+    var frozen = Object.freeze({ x: "frozen" });
+
+    for (var n = 0; n < 50; n++) {
+        assertEq(getX(inherited), "proto");
+        assertEq(getX(accessor), "getter");
+        assertEq(getX(dict), "dict");
+        assertEq(getX(frozen), "frozen");
+        assertEq(getElem(inherited, "x"), "proto");
+
+        setX(accessor, n);
+        assertEq(accessor.y, n);
+        setX(frozen, n);
+        assertEq(frozen.x, "frozen");
+
+        for (var i = 0; i < objects.length; i++)
+            assertEq(getX(objects[i]), i);
+    }
+}
+testMisses();
+
+// Reads from the prototype chain keep their stubs after the probe, and see
+// the prototype change.
+function testProto() {
+    var protos = [];
+    for (var i = 0; i < 4; i++)
+        protos.push({ x: "proto" + i });
+    var inherited = [];
+    for (var i = 0; i < 4; i++)
+        inherited.push(Object.create(protos[i]));
+
+    for (var n = 0; n < 50; n++) {
+        for (var i = 0; i < objects.length; i++)
+            assertEq(getX(objects[i]), i);
+        for (var i = 0; i < inherited.length; i++)
+            assertEq(getX(inherited[i]), "proto" + i);
+    }
+
+    protos[1].y = 0;
+    protos[2].x = "changed";
+    for (var n = 0; n < 10; n++) {
+        assertEq(getX(inherited[1]), "proto1");
+        assertEq(getX(inherited[2]), "changed");
+        inherited[3].x = "own";
+        assertEq(getX(inherited[3]), "own");
+        delete inherited[3].x;
+        assertEq(getX(inherited[3]), "proto3");
+    }
+}
+testProto();
+
+// Shapes and types are forgotten on GC.
+function testGC() {
+    for (var n = 0; n < 10; n++) {
+        var fresh = makeObjects(40);
+        for (var i = 0; i < fresh.length; i++) {
+            assertEq(getX(fresh[i]), i);
+            setX(fresh[i], -i);
+            assertEq(getElem(fresh[i], "x"), -i);
+        }
+        gc();
+    }
+}
+testGC();
@@ -0,0 +1,47 @@
+// |jit-test| ion-flags: --ion-ota --ion-ps
+// Integer arithmetic whose overflow and negative zero tests may only be
+// removed for some of the values it is run with.
+function count(start, n) {
+  var v = 0;
+  for (var i = start; i < n; i++)
+    v += i - start;
+  return v;
+}
+
+function countInclusive(start) {
+  var last = 0;
+  for (var i = start; i <= 2147483647; i++)
+    last = i + 1;
+  return last;
+}
+
+function stride(n) {
+  var v = 0;
+  for (var i = 0; i < n; i += 3)
+    v = (v + i * 2) | 0;
+  return v;
+}
+
+function scale(x, k) {
+  var v = x * k;
+  return v;
+}
+
+function shift(n, s) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += (i - s) >>> 1;
+  return v;
+}
+
+for (var j = 0; j < 50; j++) {
+  assertEq(count(0, 100), 4950);
+  assertEq(count(2147483600, 2147483647), 1081);
+  assertEq(countInclusive(2147483640), 2147483648);
+  assertEq(stride(100), 3366);
+  assertEq(scale(3, 4), 12);
+  assertEq(1 / scale(-3, 0), -Infinity);
+  assertEq(1 / scale(0, -3), -Infinity);
+  assertEq(shift(10, 0), 20);
+  assertEq(shift(4, 2), 4294967294);
+}
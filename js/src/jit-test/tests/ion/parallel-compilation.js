@@ -0,0 +1,42 @@
+// |jit-test| ion-flags: --ion-parallel-compile
+// Scripts compiled off the main thread keep running in the other engines
+// until their code is linked, and are thrown away if the types they depend
+// on change meanwhile.
+function sum(a, n) {
+  var s = 0;
+  for (var i = 0; i < n; i++)
+    s += a[i];
+  return s;
+}
+
+function makeArray(n, f) {
+  var a = [];
+  for (var i = 0; i < n; i++)
+    a.push(f(i));
+  return a;
+}
+
+var ints = makeArray(100, function (i) { return i; });
+var doubles = makeArray(100, function (i) { return i + 0.5; });
+var strings = makeArray(10, function (i) { return String(i); });
+
+for (var j = 0; j < 500; j++) {
+  assertEq(sum(ints, 100), 4950);
+  if (j > 200)
+    assertEq(sum(doubles, 100), 5000);
+  if (j == 400)
+    assertEq(sum(strings, 10), "00123456789");
+}
+
+// Compilations pending when a GC happens are cancelled.
+function f(x) {
+  var r = 0;
+  for (var i = 0; i < 1000; i++)
+    r = (r + x * i) | 0;
+  return r;
+}
+for (var j = 0; j < 200; j++) {
+  assertEq(f(j), (j * 499500) | 0);
+  if (j % 50 == 0)
+    gc();
+}
@@ -0,0 +1,26 @@
+// |jit-test| ion-flags: --ion-ps
+// A specialized script called from Ion code with an argument which changes
+// now and then, making the specialized code bail out.
+function sum(a, n, k) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += a[i] * k;
+  return v;
+}
+
+function run(a, n, m) {
+  var v = 0;
+  for (var j = 0; j < m; j++)
+    v += sum(a, n, j % 8 == 7 ? 3 : 2);
+  return v;
+}
+
+var a = [];
+for (var i = 0; i < 200; i++)
+  a.push(i);
+
+for (var i = 0; i < 30; i++)
+  assertEq(sum(a, 200, 2), 2 * 19900);
+for (var i = 0; i < 10; i++)
+  assertEq(run(a, 200, 96), 19900 * (84 * 2 + 12 * 3));
+assertEq(sum(a, 10, 3), 135);
@@ -0,0 +1,54 @@
+// |jit-test| ion-flags: --ion-ps --ion-ps-globals
+// Globals which are not overwritten after initialization.
+var SCALE = 3;
+var OFFSET = 1;
+var NAME = "x";
+
+function scaled(n) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += i * SCALE + OFFSET;
+  return v;
+}
+
+function setScale(s) {
+  SCALE = s;
+}
+
+function reset(n) {
+  var v = 0;
+  for (var i = 0; i < n; i++) {
+    v += OFFSET;
+    if (i == n - 10)
+      OFFSET = 2;
+  }
+  return v;
+}
+
+function label(n) {
+  var s = "";
+  for (var i = 0; i < n; i++)
+    s = NAME;
+  return s;
+}
+
+for (var i = 0; i < 20; i++)
+  assertEq(scaled(100), 3 * 4950 + 100);
+
+// Overwritten from the interpreter.
+SCALE = 5;
+assertEq(scaled(100), 5 * 4950 + 100);
+
+// Overwritten from jitcode.
+for (var i = 0; i < 100; i++)
+  setScale(i & 1 ? 7 : 2);
+assertEq(scaled(100), 7 * 4950 + 100);
+
+// Overwritten while the reading loop is running.
+assertEq(reset(1000), 991 + 2 * 9);
+assertEq(reset(1000), 2000);
+
+for (var i = 0; i < 20; i++)
+  assertEq(label(100), "x");
+NAME = "y";
+assertEq(label(100), "y");
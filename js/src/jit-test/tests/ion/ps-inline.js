@@ -0,0 +1,37 @@
+// |jit-test| ion-flags: --ion-ps
+// Specialized arguments passed down to inlined callees.
+function clamp(x, lo, hi) {
+  if (lo > hi)
+    return NaN;
+  if (x < lo)
+    return lo;
+  if (x > hi)
+    return hi;
+  return x;
+}
+
+function weight(x, mode) {
+  if (mode == 0)
+    return x;
+  if (mode == 1)
+    return x * 2;
+  return -x;
+}
+
+function sum(a, n, lo, hi, mode) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += weight(clamp(a[i], lo, hi), mode);
+  return v;
+}
+
+var a = [];
+for (var i = 0; i < 100; i++)
+  a.push(i);
+
+for (var i = 0; i < 20; i++) {
+  assertEq(sum(a, 100, 10, 20, 0), 10 * 10 + 165 + 20 * 79);
+  assertEq(sum(a, 50, 0, 99, 1), 2 * 1225);
+}
+assertEq(sum(a, 10, 5, 1, 0), NaN);
+assertEq(sum(a, 10, 0, 99, 2), -45);
@@ -0,0 +1,32 @@
+// |jit-test| ion-flags: --ion-ps
+// A script entered at several loop headers, depending on the loop which
+// gets hot first.
+var state = { mode: 0 };
+
+function f(n, k) {
+  var v = 0;
+  var mode = state.mode;
+  if (mode == 0) {
+    for (var i = 0; i < n; i++)
+      v += i * k;
+  } else if (mode == 1) {
+    for (var i = 0; i < n; i++)
+      v -= i * k;
+  } else {
+    for (var i = n; i > 0; i--)
+      v += k;
+  }
+  return v;
+}
+
+function run(mode, n, k) {
+  state.mode = mode;
+  return f(n, k);
+}
+
+for (var i = 0; i < 40; i++) {
+  assertEq(run(0, 1000, 2), 999000);
+  assertEq(run(1, 1000, 2), -999000);
+  assertEq(run(2, 1000, 3), 3000);
+  assertEq(run(i % 3, 10, i), [45 * i, -45 * i, 10 * i][i % 3]);
+}
@@ -0,0 +1,35 @@
+// |jit-test| ion-flags: --ion-ps --ion-parallel-compile
+// Specialized versions compiled off the main thread are recorded against the
+// arguments of the frame their MIR was built for, not those of the frame
+// running when they are linked.
+function scale(a, n, k) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += a[i] * k;
+  return v;
+}
+
+var a = [];
+for (var i = 0; i < 200; i++)
+  a.push(i);
+
+for (var j = 0; j < 300; j++) {
+  var k = (j >> 5) & 3;
+  assertEq(scale(a, 200, k), 19900 * k);
+  assertEq(scale(a, 10, 2), 90);
+}
+
+// Compilations pending when a GC happens are cancelled, or linked if they
+// are finished.
+function count(x) {
+  var r = 0;
+  for (var i = 0; i < 1000; i++)
+    r = (r + x * i) | 0;
+  return r;
+}
+for (var j = 0; j < 200; j++) {
+  var x = j % 3;
+  assertEq(count(x), (x * 499500) | 0);
+  if (j % 40 == 0)
+    gc();
+}
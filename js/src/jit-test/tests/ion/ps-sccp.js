@@ -0,0 +1,51 @@
+// |jit-test| ion-flags: --ion-ps --ion-cp --ion-dcec
+// Branches on specialized arguments, each containing a loop.
+function f(mode, n, k) {
+  var v = 0;
+  if (mode == 0) {
+    for (var i = 0; i < n; i++)
+      v += i * k;
+  } else if (mode == 1) {
+    for (var i = 0; i < n; i++)
+      v -= i * k;
+  } else {
+    for (var i = n; i > 0; i--)
+      v += k;
+  }
+  return v;
+}
+
+// A loop whose body always exits when specialized.
+function g(stop, n) {
+  var v = 0;
+  for (var i = 0; i < n; i++) {
+    v += i;
+    if (stop)
+      break;
+  }
+  return v;
+}
+
+// Constants flowing through a phi into a test.
+function h(a, n) {
+  var x = a ? 3 : 3;
+  var v = 0;
+  for (var i = 0; i < n; i++) {
+    if (x * 2 == 6)
+      v += 1;
+    else
+      v -= 1;
+  }
+  return v;
+}
+
+for (var i = 0; i < 40; i++) {
+  assertEq(f(0, 1000, 2), 999000);
+  assertEq(f(1, 1000, 2), -999000);
+  assertEq(f(2, 1000, 3), 3000);
+  assertEq(g(true, 100), 0);
+  assertEq(g(false, 100), 4950);
+  assertEq(h(i & 1, 100), 100);
+}
+for (var i = 0; i < 40; i++)
+  assertEq(f(i % 3, 10, i), [45 * i, -45 * i, 10 * i][i % 3]);
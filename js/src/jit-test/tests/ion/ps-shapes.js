@@ -0,0 +1,60 @@
+// |jit-test| ion-flags: --ion-ps --ion-ps-shapes
+// Scripts reading and writing the properties of the same configuration
+// objects on every call. The objects are filled after their creation, so the
+// slots of their properties are not known from their type.
+function makeConf(width, height, depth) {
+  var conf = {};
+  conf.width = width;
+  conf.height = height;
+  conf.depth = depth;
+  return conf;
+}
+
+function area(conf, n) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += conf.width * conf.height + conf.depth;
+  return v;
+}
+
+var conf = makeConf(3, 4, 1);
+for (var i = 0; i < 40; i++)
+  assertEq(area(conf, 50), 50 * 13);
+
+// Same shape, other values.
+var other = makeConf(2, 2, 0);
+assertEq(area(other, 50), 50 * 4);
+
+// Another shape.
+var wide = {depth: 2};
+wide.width = 10;
+wide.height = 1;
+assertEq(area(wide, 50), 50 * 12);
+
+// The object changes shape while the script runs.
+function grow(o, n) {
+  var v = 0;
+  for (var i = 0; i < n; i++) {
+    v += o.x;
+    if (i == n - 10)
+      o.y = 1;
+  }
+  return v;
+}
+for (var i = 0; i < 20; i++) {
+  var o = {};
+  o.x = 2;
+  assertEq(grow(o, 100), 200);
+}
+
+function bump(counter, n) {
+  for (var i = 0; i < n; i++)
+    counter.hits++;
+  return counter.hits;
+}
+var counter = {};
+counter.hits = 0;
+for (var i = 0; i < 30; i++)
+  assertEq(bump(counter, 100), 100 * (i + 1));
+var frozen = Object.freeze({hits: 5});
+assertEq(bump(frozen, 10), 5);
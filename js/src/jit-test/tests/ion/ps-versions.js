@@ -0,0 +1,81 @@
+// |jit-test| ion-flags: --ion-ps
+// Scripts called with a few alternating argument tuples.
+function sum(x, n, k) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += x[i] * k;
+  return v;
+}
+
+var a = [1, 2, 3, 4, 5, 6, 7, 8];
+for (var i = 0; i < 40; i++) {
+  assertEq(sum(a, 5, 1), 15);
+  assertEq(sum(a, 8, 2), 72);
+  assertEq(sum(a, 3, -1), -6);
+}
+for (var i = 0; i < 10; i++)
+  assertEq(sum(a, i % 9, 3), 3 * ((i % 9) * ((i % 9) + 1) / 2));
+
+function concat(s, n) {
+  var r = "";
+  for (var i = 0; i < n; i++)
+    r += s;
+  return r;
+}
+
+for (var i = 0; i < 30; i++) {
+  assertEq(concat("ab", 3), "ababab");
+  assertEq(concat("c", 2), "cc");
+  assertEq(concat(1, 2), "11");
+}
+
+// A stable configuration argument next to an index which keeps changing,
+// including calls from Ion code which bypass the version dispatch.
+function pick(x, j, scale) {
+  var v = 0;
+  for (var i = 0; i < 20; i++)
+    v += x[j] * scale;
+  return v;
+}
+
+function callPick(n) {
+  var t = 0;
+  for (var i = 0; i < n; i++)
+    t += pick(a, i % 8, 2);
+  return t;
+}
+
+for (var i = 0; i < 40; i++) {
+  assertEq(pick(a, i % 8, 2), 40 * a[i % 8]);
+  assertEq(pick(a, undefined, 2), NaN);
+}
+assertEq(callPick(80), 10 * 40 * 36);
+assertEq(pick(a, 3, 1), 20 * 4);
+
+// Ion code calling a specialized version with other arguments.
+function mul(x, k) {
+  var v = 0;
+  for (var i = 0; i < 2000; i++)
+    v += x * k;
+  return v;
+}
+function callMul(n) {
+  var t = 0;
+  for (var i = 0; i < n; i++)
+    t += mul(2, i < 1000 ? 1 : 3);
+  return t;
+}
+assertEq(mul(2, 1), 4000);
+assertEq(mul(2, 1), 4000);
+assertEq(callMul(1200), 1000 * 4000 + 200 * 12000);
+assertEq(mul(2, 5), 20000);
+
+// An argument which settles on a value after changing a few times.
+function scale(x, k) {
+  var v = 0;
+  for (var i = 0; i < 100; i++)
+    v += x[i & 7] * k;
+  return v;
+}
+for (var i = 0; i < 40; i++)
+  assertEq(scale(a, i < 10 ? i : 10), 442 * (i < 10 ? i : 10));
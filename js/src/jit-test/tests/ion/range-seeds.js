@@ -0,0 +1,88 @@
+// |jit-test| ion-flags: --ion-range-analysis=on
+// Ranges given by typed array loads, lengths and constants, propagated
+// through loops.
+var bytes = new Uint8Array(64);
+var shorts = new Int16Array(64);
+var table = new Int32Array(256);
+for (var k = 0; k < 64; k++) {
+  bytes[k] = k * 7;
+  shorts[k] = -k * 500;
+}
+for (var k = 0; k < 256; k++)
+  table[k] = k ^ 0x55;
+
+// Bytes index a 256 entry table.
+function lookup(b, t) {
+  var v = 0;
+  for (var i = 0; i < b.length; i++)
+    v = (v + t[b[i]]) | 0;
+  return v;
+}
+
+function sumShorts(s) {
+  var v = 0;
+  for (var i = 0; i < s.length; i++)
+    v += s[i] + 1;
+  return v;
+}
+
+function mix(b, s) {
+  var v = 0;
+  for (var i = 0; i < b.length; i++)
+    v ^= (b[i] - s[i]) << 2;
+  return v;
+}
+
+// Loop phis which keep growing are widened.
+function grow(n) {
+  var a = 0, b = 1;
+  for (var i = 0; i < n; i++) {
+    var t = (a + b) | 0;
+    a = b;
+    b = t;
+  }
+  return b;
+}
+
+function countDown(n) {
+  var v = 0;
+  while (n > 0) {
+    v += n;
+    n -= 3;
+  }
+  return v * 10 + n;
+}
+
+// Double additions of int32 values, converted back to int32.
+function doubles(a, b) {
+  return (a + b) | 0;
+}
+
+function accumulate(b, v) {
+  for (var i = 0; i < b.length; i++)
+    v = (v + b[i]) | 0;
+  return v;
+}
+
+function strings(s) {
+  var v = 0;
+  for (var i = 0; i < s.length; i++)
+    v = (v + s.charCodeAt(i) - s.length) | 0;
+  return v;
+}
+
+assertEq(doubles(0x7fffffff, 0x7fffffff), -2);
+assertEq(accumulate(bytes, 0x7fffff00), -2147476704);
+for (var j = 0; j < 100; j++) {
+  assertEq(lookup(bytes, table), 7840);
+  assertEq(sumShorts(shorts), -1007936);
+  assertEq(mix(bytes, shorts), 105216);
+  assertEq(grow(10), 89);
+  assertEq(grow(100), -1869596475);
+  assertEq(countDown(10), 218);
+  assertEq(doubles(j, 1), j + 1);
+  assertEq(doubles(-j, 0x7fffffff), 0x7fffffff - j);
+  assertEq(strings("range"), 500);
+  assertEq(accumulate(bytes, j), 7200 + j);
+  assertEq(accumulate(bytes, 0x7ffffff0 + j), -2147476464 + j);
+}
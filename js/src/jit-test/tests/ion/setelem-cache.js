@@ -0,0 +1,172 @@
+// Element writes on objects of varying kinds go through an inline cache with
+// stubs for dense arrays, typed arrays and named properties.
+
+function set(o, i, v) {
+    o[i] = v;
+}
+
+function testDense() {
+    var a = [];
+    for (var i = 0; i < 100; i++) {
+        set(a, i, i);
+        set({}, "x", i);
+    }
+    assertEq(a.length, 100);
+    for (var i = 0; i < 100; i++) {
+        set(a, i, i * 2);
+        assertEq(a[i], i * 2);
+    }
+
+    // Holes are filled, writes past the initialized length go to the VM.
+    var b = [1, , 3];
+    for (var i = 0; i < 50; i++) {
+        set(b, 1, i);
+        assertEq(b[1], i);
+    }
+    set(b, 10, "far");
+    assertEq(b.length, 11);
+    assertEq(b[9], undefined);
+    assertEq(9 in b, false);
+}
+testDense();
+
+// Indexed properties on the prototype must be seen by hole and append writes.
+function testProtoSetter() {
+    var a = [];
+    for (var i = 0; i < 50; i++)
+        set(a, i, i);
+
+    var seen = [];
+    Object.defineProperty(Array.prototype, 50, {
+        set: function (v) { seen.push(v); },
+        configurable: true
+    });
+    set(a, 50, "x");
+    assertEq(seen.length, 1);
+    assertEq(a.length, 50);
+
+    var b = [0, , 2];
+    Object.defineProperty(Array.prototype, 1, {
+        set: function (v) { seen.push(v); },
+        configurable: true
+    });
+    set(b, 1, "y");
+    assertEq(seen.length, 2);
+    assertEq(b.hasOwnProperty(1), false);
+
+    delete Array.prototype[50];
+    delete Array.prototype[1];
+    set(a, 50, "z");
+    assertEq(a[50], "z");
+    assertEq(a.length, 51);
+}
+testProtoSetter();
+
+function testTyped() {
+    var arrays = [new Int8Array(4), new Uint8Array(4), new Uint8ClampedArray(4),
+                  new Int16Array(4), new Uint16Array(4), new Int32Array(4),
+                  new Uint32Array(4), new Float32Array(4), new Float64Array(4)];
+    var values = [1, -1, 300, -300, 1.5, -1.5, 70000.25, 4294967295, NaN, 1e20];
+    for (var n = 0; n < 20; n++) {
+        for (var i = 0; i < arrays.length; i++) {
+            var ta = arrays[i];
+            var expected = new ta.constructor(1);
+            for (var j = 0; j < values.length; j++) {
+                set(ta, j & 3, values[j]);
+                expected[0] = values[j];
+                assertEq(ta[j & 3], expected[0]);
+            }
+
+            // Out of bounds writes are ignored.
+            set(ta, 4, 1);
+            set(ta, -1, 1);
+            assertEq(ta.length, 4);
+            assertEq(ta[4], undefined);
+
+            // Other values are converted by the VM.
+            set(ta, 0, "7");
+            assertEq(ta[0], 7);
+            set(ta, 0, undefined);
+            assertEq(ta[0], (ta instanceof Float32Array || ta instanceof Float64Array) ? NaN : 0);
+        }
+    }
+}
+testTyped();
+
+function testNamed() {
+    var objects = [];
+    for (var i = 0; i < 4; i++) {
+        var o = { a: 0, b: "", c: null };
+        for (var j = 0; j < i; j++)
+            o["p" + j] = j;
+        objects.push(o);
+    }
+
+    for (var n = 0; n < 100; n++) {
+        var o = objects[n & 3];
+        set(o, "a", n);
+        set(o, "b", "s" + n);
+        set(o, "c", n & 1 ? null : {});
+        assertEq(o.a, n);
+        assertEq(o.b, "s" + n);
+        assertEq(o.c === null, !!(n & 1));
+    }
+
+    // Changing the type of a property goes through the VM.
+    set(objects[0], "a", 0.5);
+    assertEq(objects[0].a, 0.5);
+    set(objects[0], "a", "str");
+    assertEq(objects[0].a, "str");
+
+    // Adding properties and writing to non-writable ones.
+    var frozen = Object.freeze({ a: 1 });
+    for (var n = 0; n < 20; n++) {
+        var fresh = {};
+        set(fresh, "q" + n, n);
+        assertEq(fresh["q" + n], n);
+        set(frozen, "a", n);
+        assertEq(frozen.a, 1);
+    }
+}
+testNamed();
+
+function setStrict(o, i, v) {
+    "use strict";
+    o[i] = v;
+}
+
+function testStrict() {
+    var frozen = Object.freeze({ a: 1 });
+    var a = [];
+    for (var i = 0; i < 50; i++) {
+        setStrict(a, i, i);
+        setStrict({ a: 0 }, "a", i);
+        var caught = false;
+        try {
+            setStrict(frozen, "a", i);
+        } catch (e) {
+            caught = e instanceof TypeError;
+        }
+        assertEq(caught, true);
+    }
+}
+testStrict();
+
+// Stubs are discarded on GC and generated again.
+function testGC() {
+    var a = [];
+    var ta = new Int32Array(10);
+    var o = { x: 0 };
+    for (var n = 0; n < 5; n++) {
+        for (var i = 0; i < 10; i++) {
+            set(a, i, n);
+            set(ta, i, n);
+            set(o, "x", n);
+        }
+        gc();
+        assertEq(a[9], n);
+        assertEq(ta[9], n);
+        assertEq(o.x, n);
+    }
+}
+testGC();
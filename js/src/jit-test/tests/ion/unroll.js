@@ -0,0 +1,162 @@
+// |jit-test| ion-flags: --ion-unroll
+// Loops with a constant number of iterations, which may be unrolled fully or
+// partially.
+var ta = new Int32Array(64);
+for (var k = 0; k < ta.length; k++)
+  ta[k] = k;
+
+function sum4() {
+  var v = 0;
+  for (var i = 0; i < 4; i++)
+    v += i;
+  return v;
+}
+
+function sumDown() {
+  var v = 0;
+  for (var i = 10; i >= 0; i -= 2)
+    v = v * 3 + i;
+  return v;
+}
+
+function swap() {
+  var a = 1, b = 2;
+  for (var i = 0; i != 5; i++) {
+    var t = a;
+    a = b;
+    b = t;
+  }
+  return a * 10 + b;
+}
+
+function branches(a) {
+  var v = 0;
+  for (var i = 0; i < 6; i++) {
+    if (a[i] & 1)
+      v += a[i];
+    else
+      v -= 1;
+  }
+  return v;
+}
+
+function stores(a) {
+  for (var i = 0; i < 8; i++)
+    a[i + 8] = a[i] * 2;
+  return a[15];
+}
+
+function afterLoop() {
+  var i = 3;
+  for (; i < 7; i++) { }
+  return i;
+}
+
+function never() {
+  var v = 1;
+  for (var i = 5; i < 5; i++)
+    v = 0;
+  return v;
+}
+
+// Too long to be fully unrolled.
+function long(a) {
+  var v = 0;
+  for (var i = 0; i < 64; i++)
+    v += a[i];
+  return v;
+}
+
+function longOdd(a) {
+  var v = 0;
+  for (var i = 0; i <= 62; i++)
+    v += a[i] ^ i;
+  return v;
+}
+
+function longArith() {
+  var v = 0;
+  for (var i = 0; i < 64; i++)
+    v = (v + i * i) | 0;
+  return v;
+}
+
+function stepped() {
+  var v = 0;
+  for (var i = 0; i < 120; i += 3)
+    v ^= i;
+  return v;
+}
+
+// The constant bound is an argument under parameter specialization.
+function bounded(a, n) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += a[i];
+  return v;
+}
+
+// Loops whose trip count is unknown, or not a multiple of the factor, run
+// their last iterations in a copy of the original loop.
+var ids = new Int32Array(64);
+for (var k = 0; k < ids.length; k++)
+  ids[k] = k;
+
+function unknown(a, n) {
+  var v = 0;
+  for (var i = 0; i < n; i++)
+    v += a[i];
+  return v;
+}
+
+function unknownInclusive(a, lo, hi) {
+  var v = 0;
+  for (var i = lo; i <= hi; i++)
+    v += a[i];
+  return v;
+}
+
+function unknownDown(a, n) {
+  var v = 0;
+  for (var i = n; i > 0; i -= 2)
+    v += a[i];
+  return v * 100 + i;
+}
+
+function remainder() {
+  var v = 0;
+  for (var i = 0; i < 63; i++)
+    v = (v + i * i) | 0;
+  return v;
+}
+
+// The test of a group of iterations overflows before the counter does.
+function nearMax(start) {
+  var count = 0;
+  for (var i = start; i < 2147483647; i++)
+    count++;
+  return count;
+}
+
+for (var j = 0; j < 100; j++) {
+  assertEq(sum4(), 6);
+  assertEq(sumDown(), 3282);
+  assertEq(swap(), 21);
+  assertEq(branches(ta), 1 + 3 + 5 - 3);
+  assertEq(stores(ta), 14);
+  assertEq(afterLoop(), 7);
+  assertEq(never(), 1);
+  assertEq(long(ta), 1980);
+  assertEq(longOdd(ta), 60);
+  assertEq(longArith(), 85344);
+  assertEq(stepped(), 40);
+  assertEq(bounded(ta, 3), 3);
+
+  var n = j % 41, m = j % 20;
+  assertEq(unknown(ids, n), n * (n - 1) / 2 + 0);
+  assertEq(unknownInclusive(ids, m, n), n >= m ? (n - m + 1) * (m + n) / 2 : 0);
+  assertEq(unknownDown(ids, n), (n & 1) ? ((n + 1) / 2) * ((n + 1) / 2) * 100 - 1
+                                        : (n / 2) * (n / 2 + 1) * 100);
+  assertEq(remainder(), 81375);
+  assertEq(nearMax(2147483647 - m), m);
+}
@@ -861,6 +861,9 @@ JSRuntime::JSRuntime()
     ionStackLimit(0),
     ionActivation(NULL),
     ionCompilerRootList(NULL),
+#ifdef JS_THREADSAFE
+    ionCompilerThread(NULL),
+#endif
     ionReturnOverride_(MagicValue(JS_ARG_POISON))
 {
     /* Initialize infallibly first, so we can goto bad and JS_DestroyRuntime. */
@@ -956,6 +959,10 @@ JSRuntime::~JSRuntime()
     sourceCompressorThread.finish();
 #endif
 
+#if defined(JS_ION) && defined(JS_THREADSAFE)
+    ion::FinishCompilerThread(this);
+#endif
+
 #ifdef DEBUG
     /* Don't hurt everyone in leaky ol' Mozilla with a fatal JS_ASSERT! */
     if (!JS_CLIST_IS_EMPTY(&contextList)) {
@@ -43,6 +43,9 @@
 #include "jsscript.h"
 #include "jsstr.h"
 #include "ion/IonFrames.h"
+#ifdef JS_ION
+# include "ion/Ion.h"
+#endif
 
 #ifdef JS_METHODJIT
 # include "assembler/assembler/MacroAssembler.h"
@@ -304,6 +307,11 @@ js::DestroyContext(JSContext *cx, DestroyContextMode mode)
     if (last) {
         JS_ASSERT(!rt->isHeapBusy());
 
+#if defined(JS_ION) && defined(JS_THREADSAFE)
+        /* Ion compilations off the main thread use the common atoms. */
+        ion::CancelOffThreadCompilations(rt);
+#endif
+
         /*
          * Dump remaining type inference results first. This printing
          * depends on atoms still existing.
@@ -929,6 +937,14 @@ js_InvokeOperationCallback(JSContext *cx)
     /* Reset Ion's stack limit. */
     cx->runtime->ionStackLimit = cx->runtime->nativeStackLimit;
 
+#if defined(JS_ION) && defined(JS_THREADSAFE)
+    /*
+     * Link the Ion compilations the compiler thread has finished, before the
+     * GC throws them away.
+     */
+    ion::AttachFinishedCompilations(cx);
+#endif
+
     if (rt->gcIsNeeded)
         GCSlice(rt, GC_NORMAL, rt->gcTriggerReason);
 
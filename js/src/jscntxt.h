@@ -72,6 +72,7 @@ class MathCache;
 
 namespace ion {
 class IonActivation;
+class CompilerThread;
 }
 
 class WeakMapBase;
@@ -887,6 +888,12 @@ struct JSRuntime : js::RuntimeFriendFields
     // Linked list of GCThings rooted for the current compilation.
     JS::CompilerRootNode *ionCompilerRootList;
 
+#ifdef JS_THREADSAFE
+    // Optimizes Ion compilations off the main thread. Created by the first
+    // of them.
+    js::ion::CompilerThread *ionCompilerThread;
+#endif
+
   private:
     // In certain cases, we want to optimize certain opcodes to typed instructions,
     // to avoid carrying an extra register to feed into an unbox. Unfortunately,
@@ -557,6 +557,9 @@ JSCompartment::sweep(FreeOp *fop, bool releaseTypes)
 
         sweepBreakpoints(fop);
 
+        for (CellIterUnderGC i(this, FINALIZE_SCRIPT); !i.done(); i.next())
+            i.get<JSScript>()->sweepArgumentProfiles();
+
         if (global_ && !IsObjectMarked(&global_))
             global_ = NULL;
 
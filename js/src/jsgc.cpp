@@ -82,9 +82,11 @@
 #include "vm/String.h"
 #include "ion/IonCode.h"
 #ifdef JS_ION
+# include "ion/Ion.h"
 # include "ion/IonMacroAssembler.h"
 #endif
 #include "ion/IonFrameIterator.h"
+#include "ion/PSVersionCache.h"
 
 #include "jsinterpinlines.h"
 #include "jsobjinlines.h"
@@ -2678,6 +2680,11 @@ MaybeGC(JSContext *cx)
     JSRuntime *rt = cx->runtime;
     JS_ASSERT(rt->onOwnerThread());
 
+#if defined(JS_ION) && defined(JS_THREADSAFE)
+    /* Link the finished Ion compilations, which a GC would throw away. */
+    ion::AttachFinishedCompilations(cx);
+#endif
+
     if (rt->gcZeal() == ZealAllocValue || rt->gcZeal() == ZealPokeValue) {
         PrepareForFullGC(rt);
         GC(rt, GC_NORMAL, gcreason::MAYBEGC);
@@ -4168,6 +4175,14 @@ GCCycle(JSRuntime *rt, bool incremental, int64_t budget, JSGCInvocationKind gcki
         rt->gcHelperThread.waitBackgroundSweepOrAllocEnd();
     }
 
+#if defined(JS_ION) && defined(JS_THREADSAFE)
+    /*
+     * Ion compilations off the main thread do not trace what they use. The
+     * operation callback and MaybeGC link the finished ones before GCing.
+     */
+    ion::CancelOffThreadCompilations(rt);
+#endif
+
     {
         if (!incremental) {
             /* If non-incremental GC was requested, reset incremental GC. */
@@ -5457,6 +5472,8 @@ PurgeJITCaches(JSCompartment *c)
         /* Discard Ion caches. */
         if (script->hasIonScript())
             script->ion->purgeCaches();
+        if (script->psVersions)
+            script->psVersions->purgeCaches();
 #endif
     }
 #endif
@@ -23,6 +23,7 @@
 
 #include "ion/Ion.h"
 #include "ion/IonCompartment.h"
+#include "ion/PSVersionCache.h"
 #include "frontend/TokenStream.h"
 #include "gc/Marking.h"
 #include "js/MemoryMetrics.h"
@@ -410,6 +411,8 @@ TypeSet::print(JSContext *cx)
         printf(" [own]");
     if (flags & TYPE_FLAG_CONFIGURED_PROPERTY)
         printf(" [configured]");
+    if (flags & TYPE_FLAG_NON_CONSTANT_PROPERTY)
+        printf(" [non-constant]");
 
     if (isDefiniteProperty())
         printf(" [definite:%d]", definiteSlot());
@@ -1677,6 +1680,31 @@ public:
     }
 };
 
+class TypeConstraintFreezeConstantProperty : public TypeConstraint
+{
+public:
+    RecompileInfo info;
+
+    bool updated;
+
+    TypeConstraintFreezeConstantProperty(RecompileInfo info)
+        : TypeConstraint("freezeConstantProperty"),
+          info(info), updated(false)
+    {}
+
+    void newType(JSContext *cx, TypeSet *source, Type type) {}
+
+    void newPropertyState(JSContext *cx, TypeSet *source)
+    {
+        if (updated)
+            return;
+        if (source->isNonConstantProperty()) {
+            updated = true;
+            cx->compartment->types.addPendingRecompile(cx, info);
+        }
+    }
+};
+
 static void
 CheckNewScriptProperties(JSContext *cx, HandleTypeObject type, JSFunction *fun);
 
@@ -1708,6 +1736,17 @@ TypeSet::isOwnProperty(JSContext *cx, TypeObject *object, bool configurable)
     return false;
 }
 
+bool
+TypeSet::isConstantProperty(JSContext *cx)
+{
+    if (isNonConstantProperty())
+        return false;
+
+    add(cx, cx->typeLifoAlloc().new_<TypeConstraintFreezeConstantProperty>(
+                                                      cx->compartment->types.compiledInfo), false);
+    return true;
+}
+
 bool
 TypeSet::knownNonEmpty(JSContext *cx)
 {
@@ -2142,6 +2181,29 @@ TypeCompartment::nukeTypes(FreeOp *fop)
 void
 TypeCompartment::addPendingRecompile(JSContext *cx, CompilerOutput &co)
 {
+#ifdef JS_ION
+    /*
+     * Compilations running off the main thread have no code to invalidate
+     * yet, and are thrown away when they finish.
+     */
+    if (co.isIon() && co.pendingCompile) {
+        co.pendingCompile = false;
+        return;
+    }
+
+    /*
+     * Parameter specialized versions which are not attached to their script
+     * are not running, so they can be dropped right away.
+     */
+    if (co.isIon() && co.out.ion && co.script->psVersions &&
+        co.script->ion != co.out.ion)
+    {
+        co.script->psVersions->discard(cx->runtime->defaultFreeOp(), co.script, co.out.ion);
+        co.invalidate();
+        return;
+    }
+#endif
+
     if (!co.isValid())
         return;
 
@@ -2929,6 +2991,18 @@ TypeObject::markPropertyConfigured(JSContext *cx, jsid id)
         types->setOwnProperty(cx, true);
 }
 
+void
+TypeObject::markPropertyNonConstant(JSContext *cx, jsid id)
+{
+    AutoEnterTypeInference enter(cx);
+
+    id = MakeTypeId(cx, id);
+
+    TypeSet *types = getProperty(cx, id, true);
+    if (types)
+        types->setNonConstantProperty(cx);
+}
+
 void
 TypeObject::markStateChange(JSContext *cx)
 {
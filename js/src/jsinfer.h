@@ -245,6 +245,13 @@ enum {
      */
     TYPE_FLAG_DEFINITE_PROPERTY   = 0x00100000,
 
+    /*
+     * Whether a value the property already had has been overwritten with
+     * another one. Only maintained for properties of singleton objects, where
+     * compiled code may fold reads of properties which never changed.
+     */
+    TYPE_FLAG_NON_CONSTANT_PROPERTY = 0x00200000,
+
     /* If the property is definite, mask and shift storing the slot. */
     TYPE_FLAG_DEFINITE_MASK       = 0x0f000000,
     TYPE_FLAG_DEFINITE_SHIFT      = 24
@@ -363,6 +370,7 @@ class TypeSet
         return flags & (configurable ? TYPE_FLAG_CONFIGURED_PROPERTY : TYPE_FLAG_OWN_PROPERTY);
     }
     bool isDefiniteProperty() const { return flags & TYPE_FLAG_DEFINITE_PROPERTY; }
+    bool isNonConstantProperty() const { return flags & TYPE_FLAG_NON_CONSTANT_PROPERTY; }
     unsigned definiteSlot() const {
         JS_ASSERT(isDefiniteProperty());
         return flags >> TYPE_FLAG_DEFINITE_SHIFT;
@@ -377,6 +385,9 @@ class TypeSet
     /* Mark this type set as representing an own property or configured property. */
     inline void setOwnProperty(JSContext *cx, bool configured);
 
+    /* Mark this type set as representing a property which has been overwritten. */
+    inline void setNonConstantProperty(JSContext *cx);
+
     /*
      * Iterate through the objects in this set. getObjectCount overapproximates
      * in the hash case (see SET_ARRAY_SIZE in jsinferinlines.h), and getObject
@@ -466,6 +477,13 @@ class TypeSet
      */
     bool isOwnProperty(JSContext *cx, TypeObject *object, bool configurable);
 
+    /*
+     * For type sets on a property of a singleton object, return true if the
+     * property still has the first value other than undefined it was given.
+     * Compiled code depending on this is recompiled once it is overwritten.
+     */
+    bool isConstantProperty(JSContext *cx);
+
     /* Get whether this type set is non-empty. */
     bool knownNonEmpty(JSContext *cx);
 
@@ -837,6 +855,7 @@ struct TypeObject : gc::Cell
     void addPropertyType(JSContext *cx, const char *name, Type type);
     void addPropertyType(JSContext *cx, const char *name, const Value &value);
     void markPropertyConfigured(JSContext *cx, jsid id);
+    void markPropertyNonConstant(JSContext *cx, jsid id);
     void markStateChange(JSContext *cx);
     void setFlags(JSContext *cx, TypeObjectFlags flags);
     void markUnknown(JSContext *cx);
@@ -1028,6 +1047,12 @@ struct CompilerOutput
     bool isIonFlag : 1;
     bool constructing : 1;
     bool barriers : 1;
+
+    /*
+     * Set while an Ion compilation of the script runs off the main thread,
+     * and cleared if the types it depends on change before it is linked.
+     */
+    bool pendingCompile : 1;
     uint32_t chunkIndex:30;
 
     union {
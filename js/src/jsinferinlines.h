@@ -14,6 +14,7 @@
 
 #include "gc/Root.h"
 #include "vm/GlobalObject.h"
+#include "ion/Ion.h"
 #include "ion/IonFrames.h"
 
 #include "vm/Stack-inl.h"
@@ -34,6 +35,7 @@ CompilerOutput::CompilerOutput()
     isIonFlag(false),
     constructing(false),
     barriers(false),
+    pendingCompile(false),
     chunkIndex(false)
 {
     out.mjit = NULL;
@@ -45,6 +47,7 @@ CompilerOutput::CompilerOutput(JSScript *script, bool isIonFlag)
     isIonFlag(isIonFlag),
     constructing(false),
     barriers(false),
+    pendingCompile(false),
     chunkIndex(false)
 {
     out.mjit = NULL;
@@ -516,6 +519,64 @@ MarkTypePropertyConfigured(JSContext *cx, JSObject *obj, jsid id)
         obj->type()->markPropertyConfigured(cx, id);
 }
 
+/*
+ * Whether overwrites of properties of singletons are tracked, so that Ion may
+ * fold reads of the ones which never changed. Only done with --ion-ps-globals.
+ */
+inline bool
+TrackConstantProperties(JSContext *cx)
+{
+#ifdef JS_ION
+    return cx->typeInferenceEnabled() && ion::js_IonOptions.ps && ion::js_IonOptions.psGlobals;
+#else
+    return false;
+#endif
+}
+
+/* Mark a property of a singleton object which has been overwritten. */
+inline void
+MarkTypePropertyNonConstant(JSContext *cx, JSObject *obj, jsid id)
+{
+    if (cx->typeInferenceEnabled())
+        id = MakeTypeId(cx, id);
+    if (TrackPropertyTypes(cx, obj, id))
+        obj->type()->markPropertyNonConstant(cx, id);
+}
+
+/*
+ * Note that |value| is about to be stored in the slot of |shape| on |obj|.
+ * Properties of singletons are constant until a value other than undefined
+ * they already had is overwritten.
+ */
+inline void
+MarkTypePropertyWrite(JSContext *cx, JSObject *obj, Shape *shape, const Value &value)
+{
+    if (!TrackConstantProperties(cx) || !obj->hasSingletonType() || !shape->hasSlot())
+        return;
+    const Value &old = obj->getSlot(shape->slot());
+    if (!old.isUndefined() && old != value)
+        MarkTypePropertyNonConstant(cx, obj, shape->propid());
+}
+
+/*
+ * Whether |obj| is a singleton whose property |id| may have never been
+ * overwritten. Jitcode must then not store to the property without calling
+ * into the VM, so that the overwrite is noted.
+ */
+inline bool
+HasConstantProperty(JSContext *cx, JSObject *obj, jsid id)
+{
+    if (!TrackConstantProperties(cx) || !obj->hasSingletonType())
+        return false;
+    if (obj->hasLazyType())
+        return true;
+    if (obj->type()->unknownProperties())
+        return false;
+
+    TypeSet *types = obj->type()->maybeGetProperty(cx, MakeTypeId(cx, id));
+    return !types || !types->isNonConstantProperty();
+}
+
 /* Mark a state change on a particular object. */
 inline void
 MarkObjectStateChange(JSContext *cx, JSObject *obj)
@@ -1309,6 +1370,22 @@ TypeSet::setOwnProperty(JSContext *cx, bool configured)
     }
 }
 
+inline void
+TypeSet::setNonConstantProperty(JSContext *cx)
+{
+    if (flags & TYPE_FLAG_NON_CONSTANT_PROPERTY)
+        return;
+
+    flags |= TYPE_FLAG_NON_CONSTANT_PROPERTY;
+
+    /* Propagate the change to all constraints. */
+    TypeConstraint *constraint = constraintList;
+    while (constraint) {
+        constraint->newPropertyState(cx, this);
+        constraint = constraint->next;
+    }
+}
+
 inline unsigned
 TypeSet::getObjectCount()
 {
@@ -4185,8 +4185,10 @@ DefineNativeProperty(JSContext *cx, HandleObject obj, HandleId id, HandleValue v
     }
 
     /* Store valueCopy before calling addProperty, in case the latter GC's. */
-    if (shape->hasSlot())
+    if (shape->hasSlot()) {
+        MarkTypePropertyWrite(cx, obj, shape, value);
         obj->nativeSetSlot(shape->slot(), value);
+    }
 
     if (!CallAddPropertyHook(cx, clasp, obj, shape, value)) {
         obj->removeProperty(cx, id);
@@ -4590,6 +4592,7 @@ js_NativeSet(JSContext *cx, Handle<JSObject*> obj, Handle<JSObject*> receiver,
              Shape *shape, bool added, bool strict, Value *vp)
 {
     AddTypePropertyId(cx, obj, shape->propid(), *vp);
+    MarkTypePropertyWrite(cx, obj, shape, *vp);
 
     JS_ASSERT(obj->isNative());
 
@@ -4626,6 +4629,7 @@ js_NativeSet(JSContext *cx, Handle<JSObject*> obj, Handle<JSObject*> receiver,
     if (shapeRoot->hasSlot() &&
         (JS_LIKELY(cx->runtime->propertyRemovals == sample) ||
          obj->nativeContains(cx, shapeRoot))) {
+        MarkTypePropertyWrite(cx, obj, shapeRoot, nvp);
         obj->setSlot(shapeRoot->slot(), nvp);
     }
 
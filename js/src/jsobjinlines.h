@@ -950,6 +950,7 @@ JSObject::nativeSetSlot(unsigned slot, const js::Value &value)
 inline void
 JSObject::nativeSetSlotWithType(JSContext *cx, js::Shape *shape, const js::Value &value)
 {
+    js::types::MarkTypePropertyWrite(cx, this, shape, value);
     nativeSetSlot(shape->slot(), value);
     js::types::AddTypePropertyId(cx, this, shape->propid(), value);
 }
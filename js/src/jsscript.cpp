@@ -34,6 +34,7 @@
 #include "js/MemoryMetrics.h"
 #include "methodjit/MethodJIT.h"
 #include "ion/IonCode.h"
+#include "ion/PSVersionCache.h"
 #include "methodjit/Retcon.h"
 #include "vm/Debugger.h"
 #include "vm/Xdr.h"
@@ -816,42 +817,95 @@ template bool
 js::XDRScript(XDRState<XDR_DECODE> *, HandleObject, HandleScript, HandleFunction, JSScript **);
 
 //PS
+void
+JSScript::profileArguments(StackFrame *fp)
+{
+    if (!fp->isNonEvalFunctionFrame())
+        return;
+
+    unsigned nargs = fp->numFormalArgs();
+    Value *args = fp->formals();
+
+    if (numArgsOfLastCall != nargs) {
+        js_free(argsOfLastCall);
+        numArgsOfLastCall = 0;
+        argsOfLastCall = (ArgumentProfile *) js_malloc(nargs * sizeof(ArgumentProfile));
+        if (!argsOfLastCall)
+            return;
+        numArgsOfLastCall = nargs;
+        for (unsigned i = 0; i < nargs; i++) {
+            ArgumentProfile &profile = argsOfLastCall[i];
+            profile.lastValue = args[i];
+            profile.hits = 1;
+            profile.changed = false;
+            profile.lastShape = args[i].isObject() ? args[i].toObject().lastProperty() : NULL;
+            profile.shapeHits = 1;
+            profile.shapeChanged = false;
+        }
+        return;
+    }
+
+    for (unsigned i = 0; i < nargs; i++) {
+        ArgumentProfile &profile = argsOfLastCall[i];
+        if (profile.lastValue == args[i]) {
+            if (profile.hits != UINT32_MAX)
+                profile.hits++;
+        } else {
+            profile.lastValue = args[i];
+            profile.hits = 1;
+            profile.changed = true;
+        }
+
+        Shape *shape = args[i].isObject() ? args[i].toObject().lastProperty() : NULL;
+        if (profile.lastShape == shape) {
+            if (profile.shapeHits != UINT32_MAX)
+                profile.shapeHits++;
+        } else {
+            profile.lastShape = shape;
+            profile.shapeHits = 1;
+            profile.shapeChanged = true;
+        }
+    }
+}
+
 bool
-JSScript::hasArgumentsChangedSinceLastCall(JSContext *cx){
-	if(this->disabledForPS)
-		return true;
-
-	StackFrame* fp = cx->fp();
-	if(!fp->isFunctionFrame())
-		return true;
-
-	//printf("hasArgumentsChangedSinceLastCall\n");
-	Value* args = fp->formals();
-	bool hasChanged = false;
-	if(this->isParameterSpecialized){
-		if(this->numArgsOfLastCall != fp->numFormalArgs()){
-			hasChanged = true;
-//			printf("hasArgumentsChangedSinceLastCall::same number of arguments\n");
-		}else{
-			for(unsigned i = 0; i < numArgsOfLastCall; i++){
-				if(argsOfLastCall[i] != args[i]){
-//					printf("hasArgumentsChangedSinceLastCall::args[%d] are different\n",i);
-					hasChanged = true;
-					break;
-				}//else
-//					printf("hasArgumentsChangedSinceLastCall::args[%d] are equal\n",i);
-			}
-		}
-		if(!hasChanged)
-			return false;
-	}
-	//save the arguments of last call
-	this->numArgsOfLastCall = fp->numFormalArgs();
-	argsOfLastCall.resize(numArgsOfLastCall);
-	for(unsigned i = 0; i < numArgsOfLastCall; i++){
-		argsOfLastCall[i] = args[i];
-	}
-	return hasChanged;
+JSScript::isArgumentStable(unsigned i, const Value &v, uint32_t threshold) const
+{
+    if (i >= numArgsOfLastCall)
+        return false;
+
+    const ArgumentProfile &profile = argsOfLastCall[i];
+    if (profile.lastValue != v)
+        return false;
+    return !profile.changed || profile.hits >= threshold;
+}
+
+bool
+JSScript::isArgumentShapeStable(unsigned i, Shape *shape, uint32_t threshold) const
+{
+    if (i >= numArgsOfLastCall)
+        return false;
+
+    const ArgumentProfile &profile = argsOfLastCall[i];
+    if (!shape || profile.lastShape != shape)
+        return false;
+    return !profile.shapeChanged || profile.shapeHits >= threshold;
+}
+
+void
+JSScript::sweepArgumentProfiles()
+{
+    for (unsigned i = 0; i < numArgsOfLastCall; i++) {
+        ArgumentProfile &profile = argsOfLastCall[i];
+
+        /* Arguments are never magic, so the next call starts a new streak. */
+        if (profile.lastValue.isMarkable() && !IsValueMarked(&profile.lastValue))
+            profile.lastValue = MagicValue(JS_ARG_POISON);
+
+        /* Only object arguments have a shape, which will differ from NULL. */
+        if (profile.lastShape && !IsShapeMarked(&profile.lastShape))
+            profile.lastShape = NULL;
+    }
 }
 
 bool
@@ -1990,9 +2044,13 @@ JSScript::finalize(FreeOp *fop)
 # ifdef JS_ION
     if (hasIonScript())
         ion::IonScript::Destroy(fop, ion);
+    if (psVersions)
+        ion::PSVersionCache::Destroy(fop, this, psVersions);
 # endif
 #endif
 
+    fop->free_(argsOfLastCall);
+
     destroyScriptCounts(fop);
     destroySourceMap(fop);
     destroyDebugScript(fop);
@@ -2677,6 +2735,8 @@ JSScript::markChildren(JSTracer *trc)
 #ifdef JS_ION
     if (hasIonScript())
         ion::IonScript::Trace(trc, ion);
+    if (psVersions)
+        psVersions->trace(trc);
 #endif
 }
 
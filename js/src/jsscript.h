@@ -16,7 +16,6 @@
 #include "jsinfer.h"
 #include "jsopcode.h"
 #include "jsscope.h"
-#include <vector>
 
 
 #include "gc/Barrier.h"
@@ -25,6 +24,7 @@ namespace js {
 
 namespace ion {
     struct IonScript;
+    class PSVersionCache;
 }
 
 # define ION_DISABLED_SCRIPT ((js::ion::IonScript *)0x1)
@@ -346,6 +346,24 @@ typedef HashMap<JSScript *,
 
 struct ScriptSource;
 
+/*
+ * Value profile of a formal argument, used by Ion to decide which arguments
+ * are worth specializing. The value and shape are not traced: once they are
+ * dead, the profile forgets them when the compartment is swept, so that a
+ * thing allocated at the same address does not extend their streak.
+ */
+struct ArgumentProfile
+{
+    Value           lastValue;
+    uint32_t        hits;           /* consecutive calls seen with lastValue */
+    bool            changed;        /* lastValue has been replaced before */
+
+    /* Same as above, for the shape of object arguments. */
+    Shape           *lastShape;
+    uint32_t        shapeHits;
+    bool            shapeChanged;
+};
+
 } /* namespace js */
 
 struct JSScript : public js::gc::Cell
@@ -546,8 +564,8 @@ struct JSScript : public js::gc::Cell
                                            specialize the script to its parameters again */
     bool            isParameterSpecialized:1;    /* The current version of the script
                                                     code is parameter specialized */
-    bool            bailed:1;   /* There was a bailout in the last execution of
-                                   the script*/
+    bool            ionCompilingOffThread:1;     /* an Ion compilation of the script
+                                                    runs off the main thread */
 #ifdef JS_METHODJIT
     bool            debugMode:1;      /* script was compiled in debug mode */
     bool            failedBoundsCheck:1; /* script has had hoisted bounds checks fail */
@@ -570,15 +588,28 @@ struct JSScript : public js::gc::Cell
     bool            needsArgsObj_:1;
 
     //PS
-    unsigned numArgsOfLastCall;
-    std::vector<js::Value> argsOfLastCall;
+    uint32_t        numArgsOfLastCall;
+    js::ArgumentProfile *argsOfLastCall;
     //
     // End of fields.  Start methods.
     //
 
   public:
     //PS
-    bool hasArgumentsChangedSinceLastCall(JSContext *cx);
+    /* Record the formal arguments |fp| is being run with. */
+    void profileArguments(js::StackFrame *fp);
+
+    /*
+     * Whether formal |i| is currently |v|, and either never had another value
+     * or has kept it for at least |threshold| calls.
+     */
+    bool isArgumentStable(unsigned i, const js::Value &v, uint32_t threshold) const;
+
+    /* Same as isArgumentStable, for the shape of an object argument. */
+    bool isArgumentShapeStable(unsigned i, js::Shape *shape, uint32_t threshold) const;
+
+    /* Forget the values and shapes of the profiles which are about to die. */
+    void sweepArgumentProfiles();
 
     static JSScript *Create(JSContext *cx, js::HandleObject enclosingScope, bool savedCallerFun,
                             const JS::CompileOptions &options, unsigned staticLevel,
@@ -632,6 +663,8 @@ struct JSScript : public js::gc::Cell
     }
 
     js::ion::IonScript *ion;          /* Information attached by Ion */
+    js::ion::PSVersionCache *psVersions; /* Ion versions specialized to other
+                                            argument values */
 
 #if defined(JS_METHODJIT) && JS_BITS_PER_WORD == 32
     void *padding_;
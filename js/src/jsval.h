@@ -226,6 +226,7 @@ typedef enum JSWhyMagic
     JS_HASH_KEY_EMPTY,           /* see class js::HashableValue */
     JS_ION_ERROR,                /* error while running Ion code */
     JS_ION_BAILOUT,              /* status code to signal EnterIon will OSR into Interpret */
+    JS_ION_MATERIALIZE,          /* object to allocate after an Ion bailout */
     JS_GENERIC_MAGIC             /* for local use */
 } JSWhyMagic;
 
@@ -935,6 +935,11 @@ IonGetsFirstChance(JSContext *cx, JSScript *script, CompileRequest request)
     if (!script->canIonCompile())
         return false;
 
+    // If the script is being compiled off the main thread, keep running in JM
+    // until its code is linked.
+    if (script->ionCompilingOffThread)
+        return false;
+
     // If we cannot enter Ion because bailouts are expected, let JM take over.
     if (script->hasIonScript() && script->ion->bailoutExpected())
         return false;
@@ -1179,6 +1184,18 @@ mjit::Compiler::generatePrologue()
             hasArgs.linkTo(masm.label(), &masm);
         }
 
+#ifdef JS_ION
+        /*
+         * Calls made by call ICs enter here directly. The arguments of calls
+         * entering through Invoke have been profiled by ion::CanEnter or
+         * UncachedInlineCall already.
+         */
+        if (ion::IsEnabled(cx) && ion::js_IonOptions.ps) {
+            prepareStubCall(Uses(0));
+            INLINE_STUBCALL(stubs::ProfileArguments, REJOIN_NONE);
+        }
+#endif
+
         j.linkTo(masm.label(), &masm);
     }
 
@@ -6442,7 +6459,8 @@ mjit::Compiler::jsop_setgname(PropertyName *name, bool popGuaranteed)
         js::Shape *shape = globalObj->nativeLookup(cx, NameToId(name));
         if (shape && shape->hasDefaultSetter() &&
             shape->writable() && shape->hasSlot() &&
-            !types->isOwnProperty(cx, globalObj->getType(cx), true)) {
+            !types->isOwnProperty(cx, globalObj->getType(cx), true) &&
+            !(types::TrackConstantProperties(cx) && types->isConstantProperty(cx))) {
             watchGlobalReallocation();
             HeapSlot *value = &globalObj->getSlotRef(shape->slot());
             RegisterID reg = frame.allocReg();
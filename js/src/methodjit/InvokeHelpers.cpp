@@ -329,6 +329,11 @@ UncachedInlineCall(VMFrame &f, InitialFrameFlags initial,
     if (!newType) {
         if (JITScript *jit = newscript->getJIT(regs.fp()->isConstructing(), cx->compartment->needsBarrier())) {
             if (jit->invokeEntry) {
+#ifdef JS_ION
+                /* Calls run by the interpreter are profiled by Ion itself. */
+                if (ion::IsEnabled(cx) && ion::js_IonOptions.ps)
+                    newscript->profileArguments(regs.fp());
+#endif
                 *pret = jit->invokeEntry;
 
                 /* Restore the old fp around and let the JIT code repush the new fp. */
@@ -138,6 +138,10 @@ UpdateSetGlobalName(VMFrame &f, ic::SetGlobalNameIC *ic, JSObject *obj, Shape *s
         return Lookup_Uncacheable;
     }
 
+    /* Overwriting a constant global must go through the VM to be noticed. */
+    if (types::HasConstantProperty(f.cx, obj, shape->propid()))
+        return Lookup_Uncacheable;
+
     /* Object is not branded, so we can use the inline path. */
     Repatcher repatcher(f.chunk());
     ic->patchInlineShapeGuard(repatcher, obj->lastProperty());
@@ -1212,8 +1216,11 @@ class CallCompiler : public BaseCompiler
                 disable();
 
             // If the following conditions pass, try to inline a call into
-            // an IonMonkey JIT'd function.
+            // an IonMonkey JIT'd function. Parameter specialized scripts are
+            // always entered through ion::CanEnter, which profiles their
+            // arguments and picks the version to run.
             if (!callingNew &&
+                !ion::js_IonOptions.ps &&
                 fun &&
                 !ic.hasJMStub() &&
                 !ic.hasIonStub() &&
@@ -566,6 +566,10 @@ class SetPropCompiler : public PICStubCompiler
             return disable("setter");
         }
 
+        /* Overwriting a constant property must go through the VM to be noticed. */
+        if (types::HasConstantProperty(cx, obj, shape->propid()))
+            return Lookup_Uncacheable;
+
         JS_ASSERT(obj == holder);
         if (!pic.inlinePathPatched &&
             shape->hasDefaultSetter() &&
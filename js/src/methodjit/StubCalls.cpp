@@ -789,6 +789,13 @@ stubs::RecompileForInline(VMFrame &f)
 {
     JSScript *script = f.script();
 
+#ifdef JS_ION
+    // Keep running this code while Ion compiles the script off the main
+    // thread. The check is hit again once the compilation is linked.
+    if (script->ionCompilingOffThread)
+        return;
+#endif
+
     ExpandInlineFrames(f.cx->compartment);
     Recompiler::clearStackReferences(f.cx->runtime->defaultFreeOp(), script);
 
@@ -1557,6 +1564,14 @@ stubs::CheckArgumentTypes(VMFrame &f)
 #endif
 }
 
+#ifdef JS_ION
+void JS_FASTCALL
+stubs::ProfileArguments(VMFrame &f)
+{
+    f.fp()->script()->profileArguments(f.fp());
+}
+#endif
+
 #ifdef DEBUG
 void JS_FASTCALL
 stubs::AssertArgumentTypes(VMFrame &f)
@@ -154,6 +154,9 @@ void JS_FASTCALL NegZeroHelper(VMFrame &f);
 void JS_FASTCALL StubTypeHelper(VMFrame &f, int32_t which);
 
 void JS_FASTCALL CheckArgumentTypes(VMFrame &f);
+#ifdef JS_ION
+void JS_FASTCALL ProfileArguments(VMFrame &f);
+#endif
 
 #ifdef DEBUG
 void JS_FASTCALL AssertArgumentTypes(VMFrame &f);
@@ -4781,6 +4781,34 @@ ProcessArgs(JSContext *cx, JSObject *obj_, OptionParser *op)
         ion::js_IonOptions.ps = true;
     }
 
+    if (op->getBoolOption("ion-ps-shapes")) {
+        ion::js_IonOptions.psShapes = true;
+    }
+
+    if (op->getBoolOption("ion-ps-globals")) {
+        ion::js_IonOptions.psGlobals = true;
+    }
+
+    int32_t psVersions = op->getIntOption("ion-ps-versions");
+    if (psVersions >= 0)
+        ion::js_IonOptions.psMaxVersions = psVersions;
+
+    int32_t psStability = op->getIntOption("ion-ps-stability");
+    if (psStability >= 0)
+        ion::js_IonOptions.psStabilityThreshold = psStability;
+
+    int32_t psBailouts = op->getIntOption("ion-ps-bailouts");
+    if (psBailouts >= 0)
+        ion::js_IonOptions.psBailoutThreshold = psBailouts;
+
+    int32_t psBailoutRate = op->getIntOption("ion-ps-bailout-rate");
+    if (psBailoutRate >= 0)
+        ion::js_IonOptions.psBailoutRate = psBailoutRate;
+
+    int32_t psRespecializations = op->getIntOption("ion-ps-respecializations");
+    if (psRespecializations >= 0)
+        ion::js_IonOptions.psMaxRespecializations = psRespecializations;
+
     if (op->getBoolOption("ion-ota")) {
         ion::js_IonOptions.ota = true;
     }
@@ -4793,6 +4821,30 @@ ProcessArgs(JSContext *cx, JSObject *obj_, OptionParser *op)
         ion::js_IonOptions.bce = true;
     }
 
+    if (op->getBoolOption("ion-unroll")) {
+        ion::js_IonOptions.unroll = true;
+    }
+
+    if (op->getBoolOption("ion-escape")) {
+        ion::js_IonOptions.escapeAnalysis = true;
+    }
+
+    if (op->getBoolOption("ion-alias-refine")) {
+        ion::js_IonOptions.aliasRefinement = true;
+    }
+
+    if (op->getBoolOption("ion-dse")) {
+        ion::js_IonOptions.dse = true;
+    }
+
+    if (op->getBoolOption("ion-vectorize")) {
+        ion::js_IonOptions.vectorize = true;
+    }
+
+    if (op->getBoolOption("ion-parallel-compile")) {
+        ion::js_IonOptions.parallelCompilation = true;
+    }
+
     if (const char *str = op->getStringOption("ion-edgecase-analysis")) {
         if (strcmp(str, "on") == 0)
             ion::js_IonOptions.edgeCaseAnalysis = true;
@@ -5044,9 +5096,41 @@ main(int argc, char **argv, char **envp)
         || !op.addBoolOption('\0', "ion-bcoal", "Enables Block Coalescing")
         || !op.addBoolOption('\0', "ion-dcec", "Enables DCE for conditionals")
         || !op.addBoolOption('\0', "ion-ps", "Enables Parameter Specialization")
-        || !op.addBoolOption('\0', "ion-ota", "Enables Overflow Analysis")
+        || !op.addBoolOption('\0', "ion-ps-shapes",
+                             "Specialize object arguments to their shape (with --ion-ps)")
+        || !op.addBoolOption('\0', "ion-ps-globals",
+                             "Treat globals never overwritten as constants (with --ion-ps)")
+        || !op.addIntOption('\0', "ion-ps-versions",
+                            "Parameter specialized versions kept per script (default: 4)",
+                            "COUNT", -1)
+        || !op.addIntOption('\0', "ion-ps-stability",
+                            "Calls a changing argument must keep its value before being "
+                            "specialized again (default: 8)",
+                            "COUNT", -1)
+        || !op.addIntOption('\0', "ion-ps-bailouts",
+                            "Bailouts from specialized code after which it is specialized "
+                            "to fewer constants (default: 3)",
+                            "COUNT", -1)
+        || !op.addIntOption('\0', "ion-ps-bailout-rate",
+                            "Bailouts per 100 entries into specialized code which are "
+                            "tolerated (default: 10)",
+                            "COUNT", -1)
+        || !op.addIntOption('\0', "ion-ps-respecializations",
+                            "Times a script is specialized to fewer constants before using "
+                            "generic code only (default: 2)",
+                            "COUNT", -1)
+        || !op.addBoolOption('\0', "ion-ota", "Enables Overflow Test Elimination")
         || !op.addBoolOption('\0', "ion-cp", "Enables Constant Propagation")
         || !op.addBoolOption('\0', "ion-bce", "Enables Array Bounds Check Elimination")
+        || !op.addBoolOption('\0', "ion-unroll", "Enables Loop Unrolling")
+        || !op.addBoolOption('\0', "ion-escape", "Enables Escape Analysis")
+        || !op.addBoolOption('\0', "ion-alias-refine", "Enables type-based alias refinement "
+                             "and store-to-load forwarding")
+        || !op.addBoolOption('\0', "ion-dse", "Enables Dead Store Elimination")
+        || !op.addBoolOption('\0', "ion-vectorize", "Enables Loop Vectorization of typed array "
+                             "loops (x64 only)")
+        || !op.addBoolOption('\0', "ion-parallel-compile", "Compiles scripts on a helper thread, "
+                             "while they keep running in JM (threadsafe builds only)")
         || !op.addStringOption('\0', "ion-edgecase-analysis", "on/off",
                                "Find edge cases where Ion can avoid bailouts (default: on, off to disable)")
         || !op.addStringOption('\0', "ion-range-analysis", "on/off",